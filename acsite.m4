@@ -1782,6 +1782,12 @@ then
 			AC_MSG_CHECKING(if PostgreSQL has PQsetSingleRowMode)
 			FW_TRY_LINK([#include <libpq-fe.h>
 #include <stdlib.h>],[PQsetSingleRowMode(NULL);],[$POSTGRESQLINCLUDES],[$POSTGRESQLLIBS $SOCKETLIBS],[$LD_LIBRARY_PATH:$POSTGRESQLLIBSPATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_POSTGRESQL_PQSETSINGLEROWMODE,1,Some versions of postgresql have PQsetSingleRowMode)],[AC_MSG_RESULT(no)])
+			AC_MSG_CHECKING(if PostgreSQL has PQsetChunkedRowsMode)
+			FW_TRY_LINK([#include <libpq-fe.h>
+#include <stdlib.h>],[PQsetChunkedRowsMode(NULL,0);],[$POSTGRESQLINCLUDES],[$POSTGRESQLLIBS $SOCKETLIBS],[$LD_LIBRARY_PATH:$POSTGRESQLLIBSPATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE,1,Some versions of postgresql have PQsetChunkedRowsMode)],[AC_MSG_RESULT(no)])
+			AC_MSG_CHECKING(if PostgreSQL has PQgetCancel)
+			FW_TRY_LINK([#include <libpq-fe.h>
+#include <stdlib.h>],[PQgetCancel(NULL);],[$POSTGRESQLINCLUDES],[$POSTGRESQLLIBS $SOCKETLIBS],[$LD_LIBRARY_PATH:$POSTGRESQLLIBSPATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_POSTGRESQL_PQGETCANCEL,1,Some versions of postgresql have PQgetCancel)],[AC_MSG_RESULT(no)])
 			AC_MSG_CHECKING(if PostgreSQL has PQdescribePrepared)
 			FW_TRY_LINK([#include <libpq-fe.h>
 #include <stdlib.h>],[PQdescribePrepared(NULL,NULL);],[$POSTGRESQLINCLUDES],[$POSTGRESQLLIBS $SOCKETLIBS],[$LD_LIBRARY_PATH:$POSTGRESQLLIBSPATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_POSTGRESQL_PQDESCRIBEPREPARED,1,Some versions of postgresql have PQdescribePrepared)],[AC_MSG_RESULT(no)])
@@ -1969,6 +1975,14 @@ then
 		FW_TRY_LINK([#include <sqlite3.h>
 #include <stdlib.h>],[sqlite3_prepare_v2(0,0,0,0,0);],[$SQLITESTATIC $SQLITEINCLUDES $PTHREADINCLUDES],[$SQLITELIBS $PTHREADLIB],[$LD_LIBRARY_PATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_SQLITE3_PREPARE_V2,1,SQLite supports sqlite3_prepare_v2)],[AC_MSG_RESULT(no)])
 
+		AC_MSG_CHECKING(for sqlite3_prepare_v3)
+		FW_TRY_LINK([#include <sqlite3.h>
+#include <stdlib.h>],[sqlite3_prepare_v3(0,0,0,0,0,0);],[$SQLITESTATIC $SQLITEINCLUDES $PTHREADINCLUDES],[$SQLITELIBS $PTHREADLIB],[$LD_LIBRARY_PATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_SQLITE3_PREPARE_V3,1,SQLite supports sqlite3_prepare_v3)],[AC_MSG_RESULT(no)])
+
+		AC_MSG_CHECKING(for sqlite3_open_v2)
+		FW_TRY_LINK([#include <sqlite3.h>
+#include <stdlib.h>],[sqlite3_open_v2(0,0,0,0);],[$SQLITESTATIC $SQLITEINCLUDES $PTHREADINCLUDES],[$SQLITELIBS $PTHREADLIB],[$LD_LIBRARY_PATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_SQLITE3_OPEN_V2,1,SQLite supports sqlite3_open_v2)],[AC_MSG_RESULT(no)])
+
 		AC_MSG_CHECKING(for sqlite3_malloc)
 		FW_TRY_LINK([#include <sqlite3.h>
 #include <stdlib.h>],[sqlite3_malloc(0);],[$SQLITESTATIC $SQLITEINCLUDES $PTHREADINCLUDES],[$SQLITELIBS $PTHREADLIB],[$LD_LIBRARY_PATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_SQLITE3_MALLOC,1,SQLite supports sqlite3_malloc)],[AC_MSG_RESULT(no)])
@@ -2088,6 +2102,15 @@ then
 			FW_TRY_LINK([#include <tdsver.h>],[],[$FREETDSINCLUDES $PTHREADINCLUDES],[$FREETDSLIBS $PTHREADLIB],[$LD_LIBRARY_PATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_FREETDS_H,1,Some versions of FreeTDS have tdsver.h)],[AC_MSG_RESULT(no)])
 		fi
 
+		dnl if FREETDSLIBS is defined, check for bulk-copy support
+		if ( test -n "$FREETDSLIBS" )
+		then
+			AC_MSG_CHECKING(whether FreeTDS supports bulk copies)
+			FW_TRY_LINK([#include <ctpublic.h>
+#include <bkpublic.h>
+#include <stdlib.h>],[blk_alloc(NULL,BLK_VERSION_100,NULL);],[$FREETDSINCLUDES $PTHREADINCLUDES],[$FREETDSLIBS $PTHREADLIB],[$LD_LIBRARY_PATH],[AC_MSG_RESULT(yes); AC_DEFINE(HAVE_FREETDS_BLK,1,Some versions of FreeTDS support bulk copies)],[AC_MSG_RESULT(no)])
+		fi
+
 		dnl if FREETDSLIBS isn't defined at this point, then freetds
 		dnl isn't installed or doesn't work
 		if ( test -z "$FREETDSLIBS" )
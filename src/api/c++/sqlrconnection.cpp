@@ -79,6 +79,14 @@ class sqlrconnectionprivate {
 
 		securitycontext	*_ctx;
 
+		// query cancellation
+		uint32_t	_cancelpid;
+		uint32_t	_cancelkey;
+		uint32_t	_cancelqueryid;
+		bool		_cancelkeyvalid;
+		bool		_cancelkeypending;
+		bool		_cancelunsupported;
+
 		// error
 		int64_t		_errorno;
 		char		*_error;
@@ -208,6 +216,14 @@ void sqlrconnection::init(const char *server, uint16_t port,
 
 	pvt->_ctx=NULL;
 
+	// query cancellation
+	pvt->_cancelpid=0;
+	pvt->_cancelkey=0;
+	pvt->_cancelqueryid=0;
+	pvt->_cancelkeyvalid=false;
+	pvt->_cancelkeypending=false;
+	pvt->_cancelunsupported=false;
+
 	// database id
 	pvt->_id=NULL;
 
@@ -677,6 +693,11 @@ bool sqlrconnection::openSession() {
 	// well and we are successfully connected
 	pvt->_connected=true;
 
+	// the cancel key is different for each session
+	pvt->_cancelkeyvalid=false;
+	pvt->_cancelkeypending=false;
+	pvt->_cancelunsupported=false;
+
 	// send protocol info
 	protocol();
 
@@ -981,6 +1002,83 @@ void sqlrconnection::auth() {
 	//flushWriteBuffer();
 }
 
+void sqlrconnection::requestCancelKey() {
+
+	// Queries are only cancelled if they time out, so don't bother unless
+	// there's a response timeout.
+	if (pvt->_responsetimeoutsec<0 || pvt->_cancelunsupported) {
+		return;
+	}
+
+	if (pvt->_debug) {
+		debugPreStart();
+		debugPrint("Requesting cancel key...\n");
+		debugPreEnd();
+	}
+
+	// The request is sent along with each query, and the server responds
+	// to it before running the query, so the key doesn't cost a round
+	// trip of its own, and it identifies the query that it cancels.
+	//
+	// Send an invalid cursor id along with the command.  Older servers
+	// that don't support this command will treat it like a command that
+	// uses a cursor, and return a no-cursors error.
+	pvt->_cs->write((uint16_t)GET_CANCEL_KEY);
+	pvt->_cs->write((uint16_t)0xFFFF);
+	pvt->_cancelkeypending=true;
+}
+
+bool sqlrconnection::getCancelKey() {
+
+	if (!pvt->_cancelkeypending) {
+		return true;
+	}
+	pvt->_cancelkeypending=false;
+	pvt->_cancelkeyvalid=false;
+
+	if (pvt->_debug) {
+		debugPreStart();
+		debugPrint("Getting cancel key...\n");
+		debugPreEnd();
+	}
+
+	if (gotError()) {
+		if (pvt->_errorno==SQLR_ERROR_NOCURSORS) {
+			clearError();
+			pvt->_cancelunsupported=true;
+			return true;
+		}
+		return false;
+	}
+
+	// get the pid, key and query id
+	if (pvt->_cs->read(&pvt->_cancelpid,
+				pvt->_responsetimeoutsec,
+				pvt->_responsetimeoutusec)!=sizeof(uint32_t) ||
+		pvt->_cs->read(&pvt->_cancelkey,
+				pvt->_responsetimeoutsec,
+				pvt->_responsetimeoutusec)!=sizeof(uint32_t) ||
+		pvt->_cs->read(&pvt->_cancelqueryid,
+				pvt->_responsetimeoutsec,
+				pvt->_responsetimeoutusec)!=sizeof(uint32_t)) {
+		setError("Failed to get the cancel key.\n"
+				"A network error may have occurred.");
+		return false;
+	}
+	pvt->_cancelkeyvalid=true;
+
+	if (pvt->_debug) {
+		debugPreStart();
+		debugPrint("Got cancel key for pid ");
+		debugPrint((int64_t)pvt->_cancelpid);
+		debugPrint(", query ");
+		debugPrint((int64_t)pvt->_cancelqueryid);
+		debugPrint("\n");
+		debugPreEnd();
+	}
+	return true;
+}
+
 bool sqlrconnection::getNewPort() {
 
 	// get the size of the unix port string
@@ -1173,6 +1271,68 @@ bool sqlrconnection::ping() {
 	return !gotError();
 }
 
+bool sqlrconnection::cancelQuery() {
+
+	if (!pvt->_cancelkeyvalid) {
+		return false;
+	}
+
+	if (pvt->_debug) {
+		debugPreStart();
+		debugPrint("Cancelling query...\n");
+		debugPreEnd();
+	}
+
+	// The connection that's running the query is busy, so send the cancel
+	// request to the listener over a new socket.  The listener forwards it
+	// straight to the connection, so it doesn't need a session, or a free
+	// connection, of its own.  It's sent before any security context is
+	// established, and the key is all the authentication that it needs.
+	unixsocketclient	ucs;
+	inetsocketclient	ics;
+	socketclient		*cs=NULL;
+	ucs.translateByteOrder();
+	ics.translateByteOrder();
+	if (!charstring::isNullOrEmpty(pvt->_listenerunixport) &&
+		ucs.connect(pvt->_listenerunixport,
+				pvt->_connecttimeoutsec,
+				pvt->_connecttimeoutusec,
+				pvt->_retrytime,pvt->_tries)==RESULT_SUCCESS) {
+		cs=&ucs;
+	} else if (pvt->_listenerinetport &&
+		ics.connect(pvt->_server,pvt->_listenerinetport,
+				pvt->_connecttimeoutsec,
+				pvt->_connecttimeoutusec,
+				pvt->_retrytime,pvt->_tries)==RESULT_SUCCESS) {
+		ics.dontUseNaglesAlgorithm();
+		cs=&ics;
+	}
+	if (!cs) {
+		return false;
+	}
+
+	// send the pid, key and query id, and get the result
+	uint16_t	status=ERROR_OCCURRED;
+	if (cs->write((uint16_t)CANCEL_QUERY)!=sizeof(uint16_t) ||
+		cs->write(pvt->_cancelpid)!=sizeof(uint32_t) ||
+		cs->write(pvt->_cancelkey)!=sizeof(uint32_t) ||
+		cs->write(pvt->_cancelqueryid)!=sizeof(uint32_t) ||
+		cs->read(&status,pvt->_responsetimeoutsec,
+				pvt->_responsetimeoutusec)!=sizeof(uint16_t)) {
+		status=ERROR_OCCURRED;
+	}
+	cs->close();
+
+	if (pvt->_debug) {
+		debugPreStart();
+		debugPrint((status==NO_ERROR_OCCURRED)?
+				"Cancelled query\n":
+				"Failed to cancel query\n");
+		debugPreEnd();
+	}
+	return (status==NO_ERROR_OCCURRED);
+}
+
 const char *sqlrconnection::identify() {
 
 	if (!openSession()) {
@@ -52,6 +52,30 @@
 #define OPTIMISTIC_RESULT_SET_GROWTH_SIZE OPTIMISTIC_COLUMN_COUNT*4*\
 					OPTIMISTIC_AVERAGE_FIELD_LENGTH
 
+// if the server underreports the length of a lob, then we'll have to grow the
+// buffer, but we'll at least start with 32k and double it from there
+#define OPTIMISTIC_LOB_GROWTH_SIZE 32768
+
+static char *growLobBuffer(char *buffer, uint64_t offset,
+				uint64_t *buffersize, uint64_t needed) {
+
+	// grow the buffer geometrically, rather than to exactly the size
+	// needed, so a lob whose length was underreported doesn't cost a
+	// reallocation and copy for every segment that arrives
+	uint64_t	newsize=*buffersize;
+	if (newsize<OPTIMISTIC_LOB_GROWTH_SIZE) {
+		newsize=OPTIMISTIC_LOB_GROWTH_SIZE;
+	}
+	while (newsize<needed) {
+		newsize=newsize*2;
+	}
+	char	*newbuffer=new char[newsize+1];
+	bytestring::copy(newbuffer,buffer,offset);
+	delete[] buffer;
+	*buffersize=newsize;
+	return newbuffer;
+}
+
 
 
 class sqlrclientrow {
@@ -265,6 +289,18 @@ class sqlrcursorprivate {
 
 		bool		_returnnulls;
 
+		// lob streaming
+		bool		(*_lobstreamfunction)(sqlrcursor *,
+							uint64_t,
+							uint32_t,
+							uint64_t,
+							const char *,
+							uint32_t,
+							void *);
+		void		*_lobstreamdata;
+		char		*_lobstreambuffer;
+		uint32_t	_lobstreambuffersize;
+
 		// result set caching
 		bool		_cacheon;
 		int32_t		_cachettl;
@@ -387,6 +423,12 @@ void sqlrcursor::init(sqlrconnection *sqlrc, bool copyreferences) {
 
 	pvt->_returnnulls=false;
 
+	// lob streaming
+	pvt->_lobstreamfunction=NULL;
+	pvt->_lobstreamdata=NULL;
+	pvt->_lobstreambuffer=NULL;
+	pvt->_lobstreambuffersize=0;
+
 	// cache file
 	pvt->_cachesource=NULL;
 	pvt->_cachesourceind=NULL;
@@ -458,6 +500,7 @@ sqlrcursor::~sqlrcursor() {
 		delete[] pvt->_rows;
 	}
 	delete pvt->_rowstorage;
+	delete[] pvt->_lobstreambuffer;
 
 	// it's possible for the connection to be deleted before the 
 	// cursor is, in that case, don't do any of this stuff
@@ -2744,6 +2787,9 @@ bool sqlrcursor::sendQueryInternal() {
 	// refresh socket client
 	pvt->_cs=pvt->_sqlrc->cs();
 
+	// ask for the key needed to cancel the query
+	pvt->_sqlrc->requestCancelKey();
+
 	// send the query to the server.
 	if (!pvt->_reexecute) {
 
@@ -3458,15 +3504,23 @@ bool sqlrcursor::processInitialResultSet() {
 		success=skipAndFetch(true,0);
 	}
 
+	// get the key needed to cancel the query, if it was asked for
+	// (it's sent ahead of everything else)
+	if (success && !pvt->_sqlrc->getCancelKey()) {
+		pvt->_sqlrc->endSession();
+		return false;
+	}
+
 	// check for an error
 	if (success) {
 
 		uint16_t	err=getErrorStatus();
 		if (err!=NO_ERROR_OCCURRED) {
 
-			// if there was a timeout, then end
-			// the session and bail immediately
+			// if there was a timeout, then cancel the query,
+			// end the session and bail immediately
 			if (err==TIMEOUT_GETTING_ERROR_STATUS) {
+				pvt->_sqlrc->cancelQuery();
 				pvt->_sqlrc->endSession();
 				return false;
 			}
@@ -4491,7 +4545,8 @@ bool sqlrcursor::parseOutputBinds() {
 			}
 
 			// create a buffer to hold the data
-			char	*buffer=new char[totallength+1];
+			uint64_t	buffersize=totallength;
+			char		*buffer=new char[buffersize+1];
 
 			uint64_t	offset=0;
 			uint32_t	length;
@@ -4529,6 +4584,13 @@ bool sqlrcursor::parseOutputBinds() {
 					return false;
 				}
 
+				// extend the buffer if necessary
+				if (offset+length>buffersize) {
+					buffer=growLobBuffer(buffer,offset,
+							&buffersize,
+							offset+length);
+				}
+
 				// get the chunk of data
 				if ((uint32_t)getString(buffer+offset,
 							length)!=length) {
@@ -4554,9 +4616,9 @@ bool sqlrcursor::parseOutputBinds() {
 			// since the actual length (which doesn't
 			// include the NULL) is available from
 			// getOutputBindLength.
-			buffer[totallength]='\0';
+			buffer[offset]='\0';
 			(*pvt->_outbindvars)[count].value.lobval=buffer;
-			(*pvt->_outbindvars)[count].resultvaluesize=totallength;
+			(*pvt->_outbindvars)[count].resultvaluesize=offset;
 		}
 
 		if (pvt->_sqlrc->debug()) {
@@ -5022,8 +5084,8 @@ bool sqlrcursor::parseInputOutputBinds() {
 			}
 
 			// create a buffer to hold the data
-			// FIXME: this should be pre-allocated or something...
-			char	*buffer=new char[totallength+1];
+			uint64_t	buffersize=totallength;
+			char		*buffer=new char[buffersize+1];
 
 			uint64_t	offset=0;
 			uint32_t	length;
@@ -5061,6 +5123,13 @@ bool sqlrcursor::parseInputOutputBinds() {
 					return false;
 				}
 
+				// extend the buffer if necessary
+				if (offset+length>buffersize) {
+					buffer=growLobBuffer(buffer,offset,
+							&buffersize,
+							offset+length);
+				}
+
 				// get the chunk of data
 				if ((uint32_t)getString(buffer+offset,
 							length)!=length) {
@@ -5086,10 +5155,9 @@ bool sqlrcursor::parseInputOutputBinds() {
 			// since the actual length (which doesn't
 			// include the NULL) is available from
 			// getOutputBindLength.
-			buffer[totallength]='\0';
+			buffer[offset]='\0';
 			(*pvt->_inoutbindvars)[count].value.lobval=buffer;
-			(*pvt->_inoutbindvars)[count].resultvaluesize=
-								totallength;
+			(*pvt->_inoutbindvars)[count].resultvaluesize=offset;
 		}
 
 		if (pvt->_sqlrc->debug()) {
@@ -5360,12 +5428,13 @@ bool sqlrcursor::parseResults() {
 				return false;
 			}
 
-			// create a buffer to hold the data
-			if (totallength) {
-				buffer=new char[totallength+1];
-			} else {
-				buffer=(char *)pvt->_rowstorage->allocate(1);
-			}
+			// If we're streaming lobs then each segment is read into
+			// the stream buffer and handed off to the stream function.
+			// Otherwise, create a buffer to hold the data.
+			bool		stream=(pvt->_lobstreamfunction!=NULL);
+			bool		streamok=true;
+			uint64_t	buffersize=(stream)?0:totallength;
+			buffer=(buffersize)?new char[buffersize+1]:NULL;
 
 			// handle a long datatype
 			uint64_t	offset=0;
@@ -5394,30 +5463,43 @@ bool sqlrcursor::parseResults() {
 					return false;
 				}
 
-				// Oracle in particular has a function that
-				// returns the number of characters in a CLOB,
-				// but not the number of bytes.  Since
-				// varying-width character data can be stored
-				// in a CLOB, characters may be less than bytes.
-				// AFAIK, there's no way to get the number of
-				// bytes.  So, we use the number of characters
-				// as a starting point, and extend buffer if
-				// necessary.
-				if (offset+length>totallength) {
-					char	*newbuffer=
-						new char[offset+length+1];
-					bytestring::copy(
-						newbuffer,buffer,offset);
-					if (totallength) {
-						delete[] buffer;
+				// pick where to put the chunk
+				char	*chunk;
+				if (stream) {
+
+					// extend the stream buffer if necessary
+					if (length>pvt->_lobstreambuffersize) {
+						delete[] pvt->_lobstreambuffer;
+						pvt->_lobstreambuffersize=length;
+						pvt->_lobstreambuffer=
+							new char[length];
+					}
+					chunk=pvt->_lobstreambuffer;
+
+				} else {
+
+					// Oracle in particular has a function
+					// that returns the number of characters
+					// in a CLOB, but not the number of
+					// bytes.  Since varying-width character
+					// data can be stored in a CLOB,
+					// characters may be less than bytes.
+					// AFAIK, there's no way to get the
+					// number of bytes.  So, we use the
+					// number of characters as a starting
+					// point, and extend buffer if
+					// necessary.
+					if (offset+length>buffersize) {
+						buffer=growLobBuffer(
+							buffer,offset,
+							&buffersize,
+							offset+length);
 					}
-					buffer=newbuffer;
-					totallength=offset+length;
+					chunk=buffer+offset;
 				}
 
 				// get the chunk of data
-				if ((uint32_t)getString(buffer+offset,
-							length)!=length) {
+				if ((uint32_t)getString(chunk,length)!=length) {
 					delete[] buffer;
 					setError("Failed to get chunk data.\n"
 						"A network error may have "
@@ -5425,15 +5507,49 @@ bool sqlrcursor::parseResults() {
 					return false;
 				}
 
+				// hand the chunk off to the stream function,
+				// unless it has already bailed on this lob
+				if (stream && streamok) {
+					streamok=pvt->_lobstreamfunction(this,
+							pvt->_rowcount-1,
+							colindex,offset,
+							chunk,length,
+							pvt->_lobstreamdata);
+				}
+
 				offset=offset+length;
 			}
-			// NULL terminate the buffer.  This makes 
-			// certain operations safer and won't hurt
-			// since the actual length (which doesn't
-			// include the NULL) is available from
-			// getFieldLength.
-			buffer[totallength]='\0';
-			length=totallength;
+
+			// let the stream function know that the lob is done
+			if (stream && streamok) {
+				pvt->_lobstreamfunction(this,
+						pvt->_rowcount-1,
+						colindex,offset,
+						NULL,0,
+						pvt->_lobstreamdata);
+			}
+
+			if (stream || !offset) {
+
+				// Streamed and empty lobs are stored as
+				// empty strings.  clearRows() identifies these
+				// by their 0 length and won't try to delete
+				// them.
+				delete[] buffer;
+				buffer=(char *)pvt->_rowstorage->allocate(1);
+				buffer[0]='\0';
+				length=0;
+
+			} else {
+
+				// NULL terminate the buffer.  This makes 
+				// certain operations safer and won't hurt
+				// since the actual length (which doesn't
+				// include the NULL) is available from
+				// getFieldLength.
+				buffer[offset]='\0';
+				length=offset;
+			}
 		}
 
 		// add the buffer to the current row
@@ -6137,6 +6253,19 @@ void sqlrcursor::getNullsAsNulls() {
 	pvt->_returnnulls=true;
 }
 
+void sqlrcursor::setLobFieldStreamFunction(
+				bool (*streamfunction)(sqlrcursor *cursor,
+							uint64_t row,
+							uint32_t col,
+							uint64_t offset,
+							const char *segment,
+							uint32_t length,
+							void *data),
+				void *data) {
+	pvt->_lobstreamfunction=streamfunction;
+	pvt->_lobstreamdata=data;
+}
+
 char *sqlrcursor::getFieldInternal(uint64_t row, uint32_t col) {
 	if (row<OPTIMISTIC_ROW_COUNT) {
 		return pvt->_rows[row]->getField(col);
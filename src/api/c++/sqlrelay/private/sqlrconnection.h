@@ -21,6 +21,8 @@
 
 		void	protocol();
 		void	auth();
+		void	requestCancelKey();
+		bool	getCancelKey();
 		bool	getNewPort();
 
 		void	clearSessionFlags();
@@ -252,6 +252,14 @@ class SQLRCLIENT_DLLSPEC sqlrconnection {
 		 *  if it's down. */
 		bool		ping();
 
+		/** Cancels the query that is currently running on this
+		 *  connection, by sending a request to the listener.  This is
+		 *  only possible if a response timeout was set before the
+		 *  query was run, and is done automatically if a query times
+		 *  out.  Returns true on success and false on failure, including
+		 *  if the query had already finished. */
+		bool		cancelQuery();
+
 		/** Returns the type of database: 
 		 *  oracle, postgresql, mysql, etc. */
 		const char	*identify();
@@ -771,6 +779,34 @@ class SQLRCLIENT_DLLSPEC sqlrcursor {
 		 *  than as empty strings. */
 		void	getNullsAsNulls();
 
+		/** Tells the cursor to pass LOB fields to "streamfunction",
+		 *  segment by segment, as they are received from the server,
+		 *  rather than buffering each LOB in memory.
+		 *
+		 *  "streamfunction" is called with the cursor, the row and
+		 *  column of the field, the offset of the segment within
+		 *  the LOB, the segment itself, its length and "data".  After
+		 *  the last segment, it is called once more with a NULL
+		 *  segment and a length of 0.  If "streamfunction" returns
+		 *  false then the remainder of the LOB is discarded and it is
+		 *  not called again for that field.  NULL LOBs are not passed
+		 *  to "streamfunction".
+		 *
+		 *  While streaming is enabled, getField() returns an empty
+		 *  string for LOB fields and getFieldLength() returns 0.
+		 *
+		 *  Set "streamfunction" to NULL to disable streaming.  This is
+		 *  the default. */
+		void	setLobFieldStreamFunction(
+				bool (*streamfunction)(sqlrcursor *cursor,
+							uint64_t row,
+							uint32_t col,
+							uint64_t offset,
+							const char *segment,
+							uint32_t length,
+							void *data),
+				void *data);
+
 
 
 		/** Returns the specified field as a string. */
@@ -248,6 +248,7 @@ struct MYSQL_RES {
 	unsigned long		*lengths;
 	MYSQL_STMT		*stmtbackptr;
 	linkedlist< my_ulonglong >	rowcache;
+	bool			unbuffered;
 };
 
 struct MYSQL;
@@ -271,8 +272,12 @@ struct MYSQL {
 	dictionary< int64_t, unsigned int >	*errormap;
 	bool		backendchecked;
 	bool		backendismysql;
+	uint64_t	useresultbuffersize;
 };
 
+// number of rows to buffer at a time for results returned by mysql_use_result
+#define USE_RESULT_BUFFER_SIZE	100
+
 #define NOT_NULL_FLAG		1
 #define PRI_KEY_FLAG		2
 #define UNIQUE_KEY_FLAG		4
@@ -538,6 +543,12 @@ MYSQL *mysql_real_connect(MYSQL *mysql, const char *host, const char *user,
 	}
 	mysql->backendchecked=false;
 	mysql->backendismysql=false;
+	mysql->useresultbuffersize=charstring::toUnsignedInteger(
+			environment::getValue(
+				"SQLR_MYSQL_USE_RESULT_BUFFER_SIZE"));
+	if (!mysql->useresultbuffersize) {
+		mysql->useresultbuffersize=USE_RESULT_BUFFER_SIZE;
+	}
 	mysql->currentstmt=NULL;
 	mysql_select_db(mysql,db);
 	return mysql;
@@ -628,6 +639,7 @@ MYSQL_RES *mysql_list_processes(MYSQL *mysql) {
 	mysql->currentstmt->result->stmtbackptr=NULL;
 	mysql->currentstmt->result->sqlrcur=new sqlrcursor(mysql->sqlrcon,true);
 	mysql->currentstmt->result->errorno=0;
+	mysql->currentstmt->result->unbuffered=false;
 	mysql->currentstmt->result->fields=NULL;
 	mysql->currentstmt->result->lengths=NULL;
 	mysql->currentstmt->result->sqlrcur->sendQuery("SHOW PROCESSLIST");
@@ -834,6 +846,7 @@ MYSQL_RES *mysql_list_dbs(MYSQL *mysql, const char *wild) {
 	mysql->currentstmt->result->stmtbackptr=NULL;
 	mysql->currentstmt->result->sqlrcur=new sqlrcursor(mysql->sqlrcon,true);
 	mysql->currentstmt->result->errorno=0;
+	mysql->currentstmt->result->unbuffered=false;
 	mysql->currentstmt->result->fields=NULL;
 	mysql->currentstmt->result->lengths=NULL;
 	mysql->currentstmt->result->sqlrcur->getDatabaseList(wild,
@@ -856,6 +869,7 @@ MYSQL_RES *mysql_list_tables(MYSQL *mysql, const char *wild) {
 	mysql->currentstmt->result->stmtbackptr=NULL;
 	mysql->currentstmt->result->sqlrcur=new sqlrcursor(mysql->sqlrcon,true);
 	mysql->currentstmt->result->errorno=0;
+	mysql->currentstmt->result->unbuffered=false;
 	mysql->currentstmt->result->fields=NULL;
 	mysql->currentstmt->result->lengths=NULL;
 	mysql->currentstmt->result->sqlrcur->getTableList(wild,
@@ -892,6 +906,7 @@ MYSQL_RES *mysql_list_fields(MYSQL *mysql,
 	stmt->result->stmtbackptr=NULL;
 	stmt->result->sqlrcur=new sqlrcursor(mysql->sqlrcon,true);
 	stmt->result->errorno=0;
+	stmt->result->unbuffered=false;
 	stmt->result->fields=NULL;
 	stmt->result->lengths=NULL;
 	stmt->result->sqlrcur->getColumnList(table,wild,
@@ -1209,6 +1224,14 @@ int mysql_real_query(MYSQL *mysql, const char *query, unsigned long length) {
 	debugFunction();
 	mysql_stmt_close(mysql->currentstmt);
 	mysql->currentstmt=mysql_prepare(mysql,query,length);
+
+	// Don't fetch any rows yet.  We don't know whether the app will call
+	// mysql_store_result() or mysql_use_result(), and the latter should
+	// stream the rows through a bounded buffer rather than buffering the
+	// entire result set.  The rows will be fetched on demand by
+	// whichever of them the app calls.
+	mysql->currentstmt->result->sqlrcur->lazyFetch();
+
 	return mysql_stmt_execute(mysql->currentstmt);
 }
 
@@ -1227,12 +1250,36 @@ MYSQL_RES *mysql_store_result(MYSQL *mysql) {
 	debugFunction();
 	MYSQL_RES	*retval=mysql->currentstmt->result;
 	mysql->currentstmt->result=NULL;
+
+	if (retval && retval->fieldcount) {
+
+		// fetch the entire result set
+		sqlrcursor	*sqlrcur=retval->sqlrcur;
+		sqlrcur->setResultSetBufferSize(0);
+		sqlrcur->getRow(0);
+
+		// now that all of the rows are buffered,
+		// the max lengths of the fields are known
+		for (uint32_t i=0; i<retval->fieldcount; i++) {
+			retval->fields[i].max_length=sqlrcur->getLongest(i);
+		}
+	}
 	return retval;
 }
 
 MYSQL_RES *mysql_use_result(MYSQL *mysql) {
 	debugFunction();
-	return mysql_store_result(mysql);
+	MYSQL_RES	*retval=mysql->currentstmt->result;
+	mysql->currentstmt->result=NULL;
+
+	// stream the result set through a bounded buffer,
+	// rows will be fetched as mysql_fetch_row() needs them
+	if (retval) {
+		retval->sqlrcur->setResultSetBufferSize(
+					mysql->useresultbuffersize);
+		retval->unbuffered=true;
+	}
+	return retval;
 }
 
 void mysql_free_result(MYSQL_RES *result) {
@@ -1330,6 +1377,12 @@ MYSQL_FIELD_OFFSET mysql_field_tell(MYSQL_RES *result) {
 
 my_ulonglong mysql_num_rows(MYSQL_RES *result) {
 	debugFunction();
+	// for unbuffered results, like libmysqlclient, return the number
+	// of rows that have been fetched so far, this is only the total
+	// number of rows after the last row has been fetched
+	if (result->unbuffered) {
+		return result->currentrow;
+	}
 	return result->sqlrcur->rowCount();
 }
 
@@ -1363,6 +1416,9 @@ void mysql_data_seek(MYSQL_RES *result, my_ulonglong offset) {
 
 MYSQL_ROW mysql_fetch_row(MYSQL_RES *result) {
 	debugFunction();
+	// this returns a pointer into the cursor's row buffer, which, for
+	// unbuffered results, only holds the current block of rows and
+	// is refilled from the server when the block has been exhausted
 	MYSQL_ROW	retval=
 		(MYSQL_ROW)result->sqlrcur->getRow(result->currentrow);
 	if (retval) {
@@ -1375,6 +1431,10 @@ MYSQL_ROW mysql_fetch_row(MYSQL_RES *result) {
 my_bool mysql_eof(MYSQL_RES *result) {
 	debugFunction();
 	my_ulonglong	rowcount=(my_ulonglong)result->sqlrcur->rowCount();
+	if (result->unbuffered) {
+		return (result->sqlrcur->endOfResultSet() &&
+					result->currentrow>=rowcount);
+	}
 	return (!rowcount || result->currentrow>=rowcount);
 }
 
@@ -2327,6 +2387,7 @@ MYSQL_STMT *mysql_stmt_init(MYSQL *mysql) {
 	stmt->result->stmtbackptr=stmt;
 	stmt->result->sqlrcur=new sqlrcursor(mysql->sqlrcon,true);
 	stmt->result->errorno=0;
+	stmt->result->unbuffered=false;
 	stmt->result->fields=NULL;
 	stmt->result->lengths=NULL;
 	return stmt;
@@ -1 +1,42 @@
-module.exports = require("./sqlrelay.node");
+var sqlrelay = require("./sqlrelay.node");
+
+// async iteration over a result set, in batches of rows
+if (sqlrelay.SQLRCursor.prototype.getRowsAsync &&
+		typeof Symbol !== "undefined" && Symbol.asyncIterator) {
+
+	sqlrelay.SQLRCursor.prototype.rowBatches = function(batchsize) {
+		var cursor = this;
+		var row = 0;
+		var done = false;
+		var iterator = {
+			next: function() {
+				if (done) {
+					return Promise.resolve({
+						value: undefined,
+						done: true
+					});
+				}
+				return cursor.getRowsAsync(row, batchsize).then(
+					function(rows) {
+						row += rows.length;
+						if (rows.length < batchsize) {
+							done = true;
+						}
+						if (!rows.length) {
+							return {
+								value: undefined,
+								done: true
+							};
+						}
+						return { value: rows, done: false };
+					});
+			}
+		};
+		iterator[Symbol.asyncIterator] = function() {
+			return iterator;
+		};
+		return iterator;
+	};
+}
+
+module.exports = sqlrelay;
@@ -2,6 +2,8 @@
 // See the file COPYING for more information.
 
 #include <sqlrelay/sqlrclient.h>
+#include <rudiments/charstring.h>
+#include <rudiments/bytestring.h>
 #ifdef _WIN32
 	#define _SSIZE_T_DEFINED
 #endif
@@ -125,12 +127,27 @@ using namespace node;
 #endif
 #define toArray(arg) Handle<Array>::Cast(arg);
 
+// the asynchronous (Promise-returning) methods run the blocking client calls
+// on the libuv threadpool, and require a reasonably modern version of node.js
+#if NODE_MAJOR_VERSION >= 10
+	#define ASYNC_API 1
+	#define newStringWithLength(val,len) String::NewFromUtf8(isolate,val,NewStringType::kNormal,len).ToLocalChecked()
+
+	// the synchronous methods can't use the connection
+	// while asynchronous calls are queued or running on it
+	#define checkNotBusy(args) if (busy(args)) { isolate->ThrowException(Exception::Error(newString("An asynchronous call is in progress on this connection"))); return; }
+#else
+	#define checkNotBusy(args)
+#endif
+
 #if NODE_MAJOR_VERSION > 0 || NODE_MINOR_VERSION >= 12
 	#define throwWrongNumberOfArguments() isolate->ThrowException(Exception::TypeError(newString("Wrong number of arguments")))
 	#define throwInvalidArgumentType() isolate->ThrowException(Exception::TypeError(newString("Invalid argument type")))
+	#define throwInvalidArgumentValue() isolate->ThrowException(Exception::RangeError(newString("Invalid argument value")))
 #else
 	#define throwWrongNumberOfArguments() ThrowException(Exception::TypeError(newString("Wrong number of arguments")))
 	#define throwInvalidArgumentType() ThrowException(Exception::TypeError(newString("Invalid argument type")))
+	#define throwInvalidArgumentValue() ThrowException(Exception::RangeError(newString("Invalid argument value")))
 #endif
 
 
@@ -194,6 +211,16 @@ class SQLRConnection : public ObjectWrap {
 
 		static sqlrconnection	*sqlrcon(const ARGS &args);
 		sqlrconnection		*sqlrc;
+		#ifdef ASYNC_API
+		static bool		busy(const ARGS &args);
+
+		// serializes asynchronous calls that use the connection
+		uv_mutex_t		mutex;
+
+		// the number of asynchronous calls that are queued or
+		// running on the connection (only used on the main thread)
+		uint32_t		asyncpending;
+		#endif
 };
 
 Persistent<Function> SQLRConnection::constructor;
@@ -201,6 +228,10 @@ Persistent<Function> SQLRConnection::constructor;
 
 
 // SQLRCursor declarations...
+#ifdef ASYNC_API
+struct asyncwork;
+#endif
+
 class SQLRCursor : public ObjectWrap {
 	public:
 		static void	Init(Handle<Object> exports);
@@ -289,11 +320,28 @@ class SQLRCursor : public ObjectWrap {
 		static RET	resumeResultSet(const ARGS &args);
 		static RET	resumeCachedResultSet(const ARGS &args);
 		static RET	closeResultSet(const ARGS &args);
+		#ifdef ASYNC_API
+		static RET	sendQueryAsync(const ARGS &args);
+		static RET	executeQueryAsync(const ARGS &args);
+		static RET	fetchFromBindCursorAsync(const ARGS &args);
+		static RET	getRowsAsync(const ARGS &args);
+
+		static Local<Promise>	queueAsyncWork(Isolate *isolate,
+							const ARGS &args,
+							asyncwork *work);
+		static void	asyncWork(uv_work_t *request);
+		static void	asyncAfterWork(uv_work_t *request, int status);
+		#endif
 
 		static Persistent<Function>	constructor;
 
 		static sqlrcursor	*sqlrcur(const ARGS &args);
 		sqlrcursor		*sqlrc;
+		#ifdef ASYNC_API
+		static bool		busy(const ARGS &args);
+		SQLRConnection		*sqlrconobj;
+		Persistent<Object>	sqlrconhandle;
+		#endif
 };
 
 Persistent<Function> SQLRCursor::constructor;
@@ -368,9 +416,16 @@ void SQLRConnection::Init(Handle<Object> exports) {
 }
 
 SQLRConnection::SQLRConnection() {
+	#ifdef ASYNC_API
+	uv_mutex_init(&mutex);
+	asyncpending=0;
+	#endif
 }
 
 SQLRConnection::~SQLRConnection() {
+	#ifdef ASYNC_API
+	uv_mutex_destroy(&mutex);
+	#endif
 }
 
 RET SQLRConnection::New(const ARGS &args) {
@@ -407,6 +462,7 @@ RET SQLRConnection::New(const ARGS &args) {
 RET SQLRConnection::setConnectTimeout(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -418,6 +474,7 @@ RET SQLRConnection::setConnectTimeout(const ARGS &args) {
 RET SQLRConnection::setAuthenticationTimeout(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -430,6 +487,7 @@ RET SQLRConnection::setAuthenticationTimeout(const ARGS &args) {
 RET SQLRConnection::setResponseTimeout(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -441,6 +499,7 @@ RET SQLRConnection::setResponseTimeout(const ARGS &args) {
 RET SQLRConnection::setBindVariableDelimiters(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -453,6 +512,7 @@ RET SQLRConnection::getBindVariableDelimiterQuestionMarkSupported(
 							const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -466,6 +526,7 @@ RET SQLRConnection::getBindVariableDelimiterColonSupported(
 							const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -479,6 +540,7 @@ RET SQLRConnection::getBindVariableDelimiterAtSignSupported(
 							const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -492,6 +554,7 @@ RET SQLRConnection::getBindVariableDelimiterDollarSignSupported(
 							const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -504,6 +567,7 @@ RET SQLRConnection::getBindVariableDelimiterDollarSignSupported(
 RET SQLRConnection::enableKerberos(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,3);
 
@@ -517,6 +581,7 @@ RET SQLRConnection::enableKerberos(const ARGS &args) {
 RET SQLRConnection::enableTls(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,7);
 
@@ -534,6 +599,7 @@ RET SQLRConnection::enableTls(const ARGS &args) {
 RET SQLRConnection::disableEncryption(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -545,6 +611,7 @@ RET SQLRConnection::disableEncryption(const ARGS &args) {
 RET SQLRConnection::endSession(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -556,6 +623,7 @@ RET SQLRConnection::endSession(const ARGS &args) {
 RET SQLRConnection::suspendSession(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -567,6 +635,7 @@ RET SQLRConnection::suspendSession(const ARGS &args) {
 RET SQLRConnection::getConnectionPort(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -578,6 +647,7 @@ RET SQLRConnection::getConnectionPort(const ARGS &args) {
 RET SQLRConnection::getConnectionSocket(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -589,6 +659,7 @@ RET SQLRConnection::getConnectionSocket(const ARGS &args) {
 RET SQLRConnection::resumeSession(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -601,6 +672,7 @@ RET SQLRConnection::resumeSession(const ARGS &args) {
 RET SQLRConnection::ping(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -612,6 +684,7 @@ RET SQLRConnection::ping(const ARGS &args) {
 RET SQLRConnection::identify(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -623,6 +696,7 @@ RET SQLRConnection::identify(const ARGS &args) {
 RET SQLRConnection::dbVersion(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -634,6 +708,7 @@ RET SQLRConnection::dbVersion(const ARGS &args) {
 RET SQLRConnection::dbHostName(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -645,6 +720,7 @@ RET SQLRConnection::dbHostName(const ARGS &args) {
 RET SQLRConnection::dbIpAddress(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -656,6 +732,7 @@ RET SQLRConnection::dbIpAddress(const ARGS &args) {
 RET SQLRConnection::serverVersion(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -667,6 +744,7 @@ RET SQLRConnection::serverVersion(const ARGS &args) {
 RET SQLRConnection::clientVersion(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -678,6 +756,7 @@ RET SQLRConnection::clientVersion(const ARGS &args) {
 RET SQLRConnection::bindFormat(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -689,6 +768,7 @@ RET SQLRConnection::bindFormat(const ARGS &args) {
 RET SQLRConnection::selectDatabase(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -700,6 +780,7 @@ RET SQLRConnection::selectDatabase(const ARGS &args) {
 RET SQLRConnection::getCurrentDatabase(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -711,6 +792,7 @@ RET SQLRConnection::getCurrentDatabase(const ARGS &args) {
 RET SQLRConnection::getLastInsertId(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -722,6 +804,7 @@ RET SQLRConnection::getLastInsertId(const ARGS &args) {
 RET SQLRConnection::autoCommitOn(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -733,6 +816,7 @@ RET SQLRConnection::autoCommitOn(const ARGS &args) {
 RET SQLRConnection::autoCommitOff(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -744,6 +828,7 @@ RET SQLRConnection::autoCommitOff(const ARGS &args) {
 RET SQLRConnection::begin(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -755,6 +840,7 @@ RET SQLRConnection::begin(const ARGS &args) {
 RET SQLRConnection::commit(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -766,6 +852,7 @@ RET SQLRConnection::commit(const ARGS &args) {
 RET SQLRConnection::rollback(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -777,6 +864,7 @@ RET SQLRConnection::rollback(const ARGS &args) {
 RET SQLRConnection::errorMessage(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -788,6 +876,7 @@ RET SQLRConnection::errorMessage(const ARGS &args) {
 RET SQLRConnection::errorNumber(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -799,6 +888,7 @@ RET SQLRConnection::errorNumber(const ARGS &args) {
 RET SQLRConnection::debugOn(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -810,6 +900,7 @@ RET SQLRConnection::debugOn(const ARGS &args) {
 RET SQLRConnection::debugOff(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -821,6 +912,7 @@ RET SQLRConnection::debugOff(const ARGS &args) {
 RET SQLRConnection::getDebug(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -832,6 +924,7 @@ RET SQLRConnection::getDebug(const ARGS &args) {
 RET SQLRConnection::setDebugFile(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -843,6 +936,7 @@ RET SQLRConnection::setDebugFile(const ARGS &args) {
 RET SQLRConnection::setClientInfo(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -854,6 +948,7 @@ RET SQLRConnection::setClientInfo(const ARGS &args) {
 RET SQLRConnection::getClientInfo(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -866,6 +961,12 @@ sqlrconnection *SQLRConnection::sqlrcon(const ARGS &args) {
 	return ObjectWrap::Unwrap<SQLRConnection>(args.Holder())->sqlrc;
 }
 
+#ifdef ASYNC_API
+bool SQLRConnection::busy(const ARGS &args) {
+	return ObjectWrap::Unwrap<SQLRConnection>(args.Holder())->asyncpending;
+}
+#endif
+
 
 
 // SQLRCursor methods...
@@ -988,6 +1089,13 @@ void SQLRCursor::Init(Handle<Object> exports) {
 	NODE_SET_PROTOTYPE_METHOD(tpl,"resumeCachedResultSet",
 						resumeCachedResultSet);
 	NODE_SET_PROTOTYPE_METHOD(tpl,"closeResultSet",closeResultSet);
+	#ifdef ASYNC_API
+	NODE_SET_PROTOTYPE_METHOD(tpl,"sendQueryAsync",sendQueryAsync);
+	NODE_SET_PROTOTYPE_METHOD(tpl,"executeQueryAsync",executeQueryAsync);
+	NODE_SET_PROTOTYPE_METHOD(tpl,"fetchFromBindCursorAsync",
+						fetchFromBindCursorAsync);
+	NODE_SET_PROTOTYPE_METHOD(tpl,"getRowsAsync",getRowsAsync);
+	#endif
 
 	resetConstructor(constructor,tpl);
 	set(exports,newString("SQLRCursor"),GetFunction(tpl));
@@ -997,6 +1105,9 @@ SQLRCursor::SQLRCursor() {
 }
 
 SQLRCursor::~SQLRCursor() {
+	#ifdef ASYNC_API
+	sqlrconhandle.Reset();
+	#endif
 }
 
 RET SQLRCursor::New(const ARGS &args) {
@@ -1008,12 +1119,18 @@ RET SQLRCursor::New(const ARGS &args) {
 		checkArgCount(args,1);
 
 		// invoked as constructor: new SQLRCursor(...)
-		sqlrconnection	*sqlrcon=
+		SQLRConnection	*sqlrconobj=
 			node::ObjectWrap::Unwrap<SQLRConnection>(
-						toObject(args[0]))->sqlrc;
+						toObject(args[0]));
+		sqlrconnection	*sqlrcon=sqlrconobj->sqlrc;
 
 		SQLRCursor	*obj=new SQLRCursor();
 		obj->sqlrc=new sqlrcursor(sqlrcon,true);
+		#ifdef ASYNC_API
+		// keep the connection alive as long as the cursor is
+		obj->sqlrconobj=sqlrconobj;
+		obj->sqlrconhandle.Reset(isolate,toObject(args[0]));
+		#endif
 		obj->Wrap(args.This());
 		returnObject(args.This());
 
@@ -1030,6 +1147,7 @@ RET SQLRCursor::New(const ARGS &args) {
 RET SQLRCursor::setResultSetBufferSize(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1041,6 +1159,7 @@ RET SQLRCursor::setResultSetBufferSize(const ARGS &args) {
 RET SQLRCursor::getResultSetBufferSize(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1052,6 +1171,7 @@ RET SQLRCursor::getResultSetBufferSize(const ARGS &args) {
 RET SQLRCursor::dontGetColumnInfo(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1063,6 +1183,7 @@ RET SQLRCursor::dontGetColumnInfo(const ARGS &args) {
 RET SQLRCursor::getColumnInfo(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1074,6 +1195,7 @@ RET SQLRCursor::getColumnInfo(const ARGS &args) {
 RET SQLRCursor::mixedCaseColumnNames(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1085,6 +1207,7 @@ RET SQLRCursor::mixedCaseColumnNames(const ARGS &args) {
 RET SQLRCursor::upperCaseColumnNames(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1096,6 +1219,7 @@ RET SQLRCursor::upperCaseColumnNames(const ARGS &args) {
 RET SQLRCursor::lowerCaseColumnNames(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1107,6 +1231,7 @@ RET SQLRCursor::lowerCaseColumnNames(const ARGS &args) {
 RET SQLRCursor::cacheToFile(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1118,6 +1243,7 @@ RET SQLRCursor::cacheToFile(const ARGS &args) {
 RET SQLRCursor::setCacheTtl(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1129,6 +1255,7 @@ RET SQLRCursor::setCacheTtl(const ARGS &args) {
 RET SQLRCursor::getCacheFileName(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1140,6 +1267,7 @@ RET SQLRCursor::getCacheFileName(const ARGS &args) {
 RET SQLRCursor::cacheOff(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1151,6 +1279,7 @@ RET SQLRCursor::cacheOff(const ARGS &args) {
 RET SQLRCursor::getDatabaseList(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1162,6 +1291,7 @@ RET SQLRCursor::getDatabaseList(const ARGS &args) {
 RET SQLRCursor::getTableList(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1173,6 +1303,7 @@ RET SQLRCursor::getTableList(const ARGS &args) {
 RET SQLRCursor::getColumnList(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1185,6 +1316,7 @@ RET SQLRCursor::getColumnList(const ARGS &args) {
 RET SQLRCursor::sendQuery(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	bool	result=false;
 
@@ -1203,6 +1335,7 @@ RET SQLRCursor::sendQuery(const ARGS &args) {
 RET SQLRCursor::sendFileQuery(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1215,6 +1348,7 @@ RET SQLRCursor::sendFileQuery(const ARGS &args) {
 RET SQLRCursor::prepareQuery(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1233,6 +1367,7 @@ RET SQLRCursor::prepareQuery(const ARGS &args) {
 RET SQLRCursor::prepareFileQuery(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1245,6 +1380,7 @@ RET SQLRCursor::prepareFileQuery(const ARGS &args) {
 RET SQLRCursor::substitution(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	if (args.Length()==2) {
 		if (args[1]->IsString() || args[1]->IsNull()) {
@@ -1271,6 +1407,7 @@ RET SQLRCursor::substitution(const ARGS &args) {
 RET SQLRCursor::substitutions(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	if (args.Length()==2) {
 
@@ -1377,6 +1514,7 @@ RET SQLRCursor::substitutions(const ARGS &args) {
 RET SQLRCursor::inputBind(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	if (args.Length()==2) {
 
@@ -1433,6 +1571,7 @@ RET SQLRCursor::inputBind(const ARGS &args) {
 RET SQLRCursor::inputBindBlob(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,3);
 
@@ -1446,6 +1585,7 @@ RET SQLRCursor::inputBindBlob(const ARGS &args) {
 RET SQLRCursor::inputBindClob(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,3);
 
@@ -1459,6 +1599,7 @@ RET SQLRCursor::inputBindClob(const ARGS &args) {
 RET SQLRCursor::inputBinds(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	if (args.Length()==2) {
 
@@ -1567,6 +1708,7 @@ RET SQLRCursor::inputBinds(const ARGS &args) {
 RET SQLRCursor::defineOutputBindString(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1579,6 +1721,7 @@ RET SQLRCursor::defineOutputBindString(const ARGS &args) {
 RET SQLRCursor::defineOutputBindInteger(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1590,6 +1733,7 @@ RET SQLRCursor::defineOutputBindInteger(const ARGS &args) {
 RET SQLRCursor::defineOutputBindDouble(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1601,6 +1745,7 @@ RET SQLRCursor::defineOutputBindDouble(const ARGS &args) {
 RET SQLRCursor::defineOutputBindBlob(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1612,6 +1757,7 @@ RET SQLRCursor::defineOutputBindBlob(const ARGS &args) {
 RET SQLRCursor::defineOutputBindClob(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1623,6 +1769,7 @@ RET SQLRCursor::defineOutputBindClob(const ARGS &args) {
 RET SQLRCursor::defineOutputBindCursor(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1634,6 +1781,7 @@ RET SQLRCursor::defineOutputBindCursor(const ARGS &args) {
 RET SQLRCursor::clearBinds(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1645,6 +1793,7 @@ RET SQLRCursor::clearBinds(const ARGS &args) {
 RET SQLRCursor::countBindVariables(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1656,6 +1805,7 @@ RET SQLRCursor::countBindVariables(const ARGS &args) {
 RET SQLRCursor::validateBinds(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1667,6 +1817,7 @@ RET SQLRCursor::validateBinds(const ARGS &args) {
 RET SQLRCursor::validBind(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1678,6 +1829,7 @@ RET SQLRCursor::validBind(const ARGS &args) {
 RET SQLRCursor::executeQuery(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1689,6 +1841,7 @@ RET SQLRCursor::executeQuery(const ARGS &args) {
 RET SQLRCursor::fetchFromBindCursor(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1700,6 +1853,7 @@ RET SQLRCursor::fetchFromBindCursor(const ARGS &args) {
 RET SQLRCursor::getOutputBindString(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1712,6 +1866,7 @@ RET SQLRCursor::getOutputBindString(const ARGS &args) {
 RET SQLRCursor::getOutputBindInteger(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1724,6 +1879,7 @@ RET SQLRCursor::getOutputBindInteger(const ARGS &args) {
 RET SQLRCursor::getOutputBindDouble(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1736,6 +1892,7 @@ RET SQLRCursor::getOutputBindDouble(const ARGS &args) {
 RET SQLRCursor::getOutputBindBlob(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1748,6 +1905,7 @@ RET SQLRCursor::getOutputBindBlob(const ARGS &args) {
 RET SQLRCursor::getOutputBindClob(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1760,6 +1918,7 @@ RET SQLRCursor::getOutputBindClob(const ARGS &args) {
 RET SQLRCursor::getOutputBindLength(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1772,6 +1931,7 @@ RET SQLRCursor::getOutputBindLength(const ARGS &args) {
 RET SQLRCursor::getOutputBindCursor(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1784,6 +1944,7 @@ RET SQLRCursor::getOutputBindCursor(const ARGS &args) {
 RET SQLRCursor::openCachedResultSet(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -1796,6 +1957,7 @@ RET SQLRCursor::openCachedResultSet(const ARGS &args) {
 RET SQLRCursor::colCount(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1807,6 +1969,7 @@ RET SQLRCursor::colCount(const ARGS &args) {
 RET SQLRCursor::rowCount(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1818,6 +1981,7 @@ RET SQLRCursor::rowCount(const ARGS &args) {
 RET SQLRCursor::totalRows(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1829,6 +1993,7 @@ RET SQLRCursor::totalRows(const ARGS &args) {
 RET SQLRCursor::affectedRows(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1840,6 +2005,7 @@ RET SQLRCursor::affectedRows(const ARGS &args) {
 RET SQLRCursor::firstRowIndex(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1851,6 +2017,7 @@ RET SQLRCursor::firstRowIndex(const ARGS &args) {
 RET SQLRCursor::endOfResultSet(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1862,6 +2029,7 @@ RET SQLRCursor::endOfResultSet(const ARGS &args) {
 RET SQLRCursor::errorMessage(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1873,6 +2041,7 @@ RET SQLRCursor::errorMessage(const ARGS &args) {
 RET SQLRCursor::errorNumber(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1884,6 +2053,7 @@ RET SQLRCursor::errorNumber(const ARGS &args) {
 RET SQLRCursor::getNullsAsEmptyStrings(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1895,6 +2065,7 @@ RET SQLRCursor::getNullsAsEmptyStrings(const ARGS &args) {
 RET SQLRCursor::getNullsAsNulls(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -1906,6 +2077,7 @@ RET SQLRCursor::getNullsAsNulls(const ARGS &args) {
 RET SQLRCursor::getField(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1927,6 +2099,7 @@ RET SQLRCursor::getField(const ARGS &args) {
 RET SQLRCursor::getFieldAsInteger(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1950,6 +2123,7 @@ RET SQLRCursor::getFieldAsInteger(const ARGS &args) {
 RET SQLRCursor::getFieldAsDouble(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1973,6 +2147,7 @@ RET SQLRCursor::getFieldAsDouble(const ARGS &args) {
 RET SQLRCursor::getFieldLength(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -1996,6 +2171,7 @@ RET SQLRCursor::getFieldLength(const ARGS &args) {
 RET SQLRCursor::getRow(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2013,6 +2189,7 @@ RET SQLRCursor::getRow(const ARGS &args) {
 RET SQLRCursor::getRowLengths(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2031,6 +2208,7 @@ RET SQLRCursor::getRowLengths(const ARGS &args) {
 RET SQLRCursor::getColumnNames(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -2048,6 +2226,7 @@ RET SQLRCursor::getColumnNames(const ARGS &args) {
 RET SQLRCursor::getColumnName(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2060,6 +2239,7 @@ RET SQLRCursor::getColumnName(const ARGS &args) {
 RET SQLRCursor::getColumnType(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2079,6 +2259,7 @@ RET SQLRCursor::getColumnType(const ARGS &args) {
 RET SQLRCursor::getColumnLength(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2098,6 +2279,7 @@ RET SQLRCursor::getColumnLength(const ARGS &args) {
 RET SQLRCursor::getColumnPrecision(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2117,6 +2299,7 @@ RET SQLRCursor::getColumnPrecision(const ARGS &args) {
 RET SQLRCursor::getColumnScale(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2136,6 +2319,7 @@ RET SQLRCursor::getColumnScale(const ARGS &args) {
 RET SQLRCursor::getColumnIsNullable(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2155,6 +2339,7 @@ RET SQLRCursor::getColumnIsNullable(const ARGS &args) {
 RET SQLRCursor::getColumnIsPrimaryKey(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2175,6 +2360,7 @@ RET SQLRCursor::getColumnIsPrimaryKey(const ARGS &args) {
 RET SQLRCursor::getColumnIsUnique(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2194,6 +2380,7 @@ RET SQLRCursor::getColumnIsUnique(const ARGS &args) {
 RET SQLRCursor::getColumnIsPartOfKey(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2213,6 +2400,7 @@ RET SQLRCursor::getColumnIsPartOfKey(const ARGS &args) {
 RET SQLRCursor::getColumnIsUnsigned(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2232,6 +2420,7 @@ RET SQLRCursor::getColumnIsUnsigned(const ARGS &args) {
 RET SQLRCursor::getColumnIsZeroFilled(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2251,6 +2440,7 @@ RET SQLRCursor::getColumnIsZeroFilled(const ARGS &args) {
 RET SQLRCursor::getColumnIsBinary(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2270,6 +2460,7 @@ RET SQLRCursor::getColumnIsBinary(const ARGS &args) {
 RET SQLRCursor::getColumnIsAutoIncrement(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2291,6 +2482,7 @@ RET SQLRCursor::getColumnIsAutoIncrement(const ARGS &args) {
 RET SQLRCursor::getLongest(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2310,6 +2502,7 @@ RET SQLRCursor::getLongest(const ARGS &args) {
 RET SQLRCursor::suspendResultSet(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -2321,6 +2514,7 @@ RET SQLRCursor::suspendResultSet(const ARGS &args) {
 RET SQLRCursor::getResultSetId(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -2332,6 +2526,7 @@ RET SQLRCursor::getResultSetId(const ARGS &args) {
 RET SQLRCursor::resumeResultSet(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,1);
 
@@ -2343,6 +2538,7 @@ RET SQLRCursor::resumeResultSet(const ARGS &args) {
 RET SQLRCursor::resumeCachedResultSet(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,2);
 
@@ -2356,6 +2552,7 @@ RET SQLRCursor::resumeCachedResultSet(const ARGS &args) {
 RET SQLRCursor::closeResultSet(const ARGS &args) {
 
 	initLocalScope();
+	checkNotBusy(args);
 
 	checkArgCount(args,0);
 
@@ -2364,10 +2561,294 @@ RET SQLRCursor::closeResultSet(const ARGS &args) {
 	returnVoid();
 }
 
+#ifdef ASYNC_API
+enum asynccommand {
+	ASYNC_SENDQUERY,
+	ASYNC_EXECUTEQUERY,
+	ASYNC_FETCHFROMBINDCURSOR,
+	ASYNC_GETROWS
+};
+
+struct asyncwork {
+	uv_work_t			request;
+	Persistent<Promise::Resolver>	resolver;
+	SQLRCursor			*obj;
+	asynccommand			command;
+	char				*query;
+	uint32_t			querylength;
+	uint64_t			firstrow;
+	uint64_t			rowcount;
+	bool				result;
+	uint32_t			colcount;
+	uint64_t			rowsfetched;
+	char				**fields;
+	uint32_t			*lengths;
+};
+
+Local<Promise> SQLRCursor::queueAsyncWork(Isolate *isolate,
+					const ARGS &args,
+					asyncwork *work) {
+
+	Local<Promise::Resolver>	resolver=Promise::Resolver::New(
+				isolate->GetCurrentContext()).ToLocalChecked();
+	work->resolver.Reset(isolate,resolver);
+
+	// don't let the cursor be garbage collected while
+	// the work is in progress
+	work->obj=ObjectWrap::Unwrap<SQLRCursor>(args.Holder());
+	work->obj->Ref();
+
+	work->request.data=(void *)work;
+	if (!uv_queue_work(uv_default_loop(),&work->request,
+					asyncWork,asyncAfterWork)) {
+		work->obj->sqlrconobj->asyncpending++;
+	} else {
+		// if the work couldn't be queued then
+		// clean up and reject the promise
+		work->obj->Unref();
+		work->resolver.Reset();
+		delete[] work->query;
+		delete work;
+		resolver->Reject(isolate->GetCurrentContext(),
+				Exception::Error(newString(
+				"Failed to queue asynchronous work"))).FromJust();
+	}
+
+	return resolver->GetPromise();
+}
+
+static asyncwork *newAsyncWork(asynccommand command) {
+	asyncwork	*work=new asyncwork;
+	work->command=command;
+	work->query=NULL;
+	work->querylength=0;
+	work->firstrow=0;
+	work->rowcount=0;
+	work->result=false;
+	work->colcount=0;
+	work->rowsfetched=0;
+	work->fields=NULL;
+	work->lengths=NULL;
+	return work;
+}
+
+void SQLRCursor::asyncWork(uv_work_t *request) {
+
+	// this runs on a threadpool thread, so it must not touch v8 at all
+
+	asyncwork	*work=(asyncwork *)request->data;
+	sqlrcursor	*cur=work->obj->sqlrc;
+	uint64_t	capacity=0;
+
+	// only one thread at a time may use the connection
+	uv_mutex_lock(&work->obj->sqlrconobj->mutex);
+
+	switch (work->command) {
+		case ASYNC_SENDQUERY:
+			work->result=cur->sendQuery(work->query,
+							work->querylength);
+			break;
+		case ASYNC_EXECUTEQUERY:
+			work->result=cur->executeQuery();
+			break;
+		case ASYNC_FETCHFROMBINDCURSOR:
+			work->result=cur->fetchFromBindCursor();
+			break;
+		case ASYNC_GETROWS:
+			// Copy the rows out of the cursor.  The batch might
+			// span several blocks of rows, and each block
+			// replaces the previous one in the cursor's buffer.
+			// The count may run past the end of the result set,
+			// so the array of fields grows as rows are copied,
+			// rather than being allocated up front.
+			work->colcount=cur->colCount();
+			if (!work->colcount) {
+				work->result=true;
+				break;
+			}
+			for (uint64_t i=0; i<work->rowcount; i++) {
+				uint64_t	row=work->firstrow+i;
+				const char * const	*fields=cur->getRow(row);
+				if (!fields) {
+					break;
+				}
+				if (i==capacity) {
+					uint64_t	newcapacity=
+							(capacity)?capacity*2:64;
+					if (newcapacity>work->rowcount) {
+						newcapacity=work->rowcount;
+					}
+					char	**newfields=new char *[
+						newcapacity*work->colcount];
+					bytestring::copy(newfields,work->fields,
+						capacity*work->colcount*
+							sizeof(char *));
+					delete[] work->fields;
+					work->fields=newfields;
+					uint32_t	*newlengths=new uint32_t[
+						newcapacity*work->colcount];
+					bytestring::copy(newlengths,
+						work->lengths,
+						capacity*work->colcount*
+							sizeof(uint32_t));
+					delete[] work->lengths;
+					work->lengths=newlengths;
+					capacity=newcapacity;
+				}
+				uint32_t	*lengths=cur->getRowLengths(row);
+				char	**dest=work->fields+i*work->colcount;
+				uint32_t	*destlengths=
+						work->lengths+i*work->colcount;
+				for (uint32_t j=0; j<work->colcount; j++) {
+					dest[j]=(fields[j])?
+						charstring::duplicate(
+							fields[j],lengths[j]):
+						NULL;
+					destlengths[j]=lengths[j];
+				}
+				work->rowsfetched++;
+			}
+			work->result=true;
+			break;
+	}
+
+	uv_mutex_unlock(&work->obj->sqlrconobj->mutex);
+}
+
+void SQLRCursor::asyncAfterWork(uv_work_t *request, int status) {
+
+	// this runs on the main thread
+
+	initLocalScope();
+
+	asyncwork	*work=(asyncwork *)request->data;
+
+	// run any callbacks that the promise resolution
+	// triggers when the scope exits
+	node::async_context	asynccontext={0,0};
+	node::CallbackScope	callbackscope(isolate,
+						work->obj->handle(),
+						asynccontext);
+
+	Local<Promise::Resolver>	resolver=
+			Local<Promise::Resolver>::New(isolate,work->resolver);
+
+	// the connection is free again by the time the promise resolves
+	work->obj->sqlrconobj->asyncpending--;
+
+	if (work->command==ASYNC_GETROWS) {
+		Handle<Array>	rows=newArray(work->rowsfetched);
+		for (uint64_t i=0; i<work->rowsfetched; i++) {
+			char	**fields=work->fields+i*work->colcount;
+			uint32_t	*lengths=work->lengths+i*work->colcount;
+			Handle<Array>	row=newArray(work->colcount);
+			for (uint32_t j=0; j<work->colcount; j++) {
+				if (fields[j]) {
+					// (fields may contain nulls)
+					set(row,newInteger(j),
+						newStringWithLength(fields[j],
+								lengths[j]));
+					delete[] fields[j];
+				} else {
+					set(row,newInteger(j),Null(isolate));
+				}
+			}
+			set(rows,newNumber(i),row);
+		}
+		resolver->Resolve(isolate->GetCurrentContext(),rows).FromJust();
+	} else {
+		resolver->Resolve(isolate->GetCurrentContext(),
+				newBoolean(work->result)).FromJust();
+	}
+
+	work->obj->Unref();
+	work->resolver.Reset();
+	delete[] work->query;
+	delete[] work->fields;
+	delete[] work->lengths;
+	delete work;
+}
+
+RET SQLRCursor::sendQueryAsync(const ARGS &args) {
+
+	initLocalScope();
+
+	asyncwork	*work=newAsyncWork(ASYNC_SENDQUERY);
+
+	// copy the query, the string won't survive past this call
+	if (args.Length()==1) {
+		work->query=charstring::duplicate(toString(args[0]));
+		work->querylength=charstring::length(work->query);
+	} else if (args.Length()==2) {
+		work->querylength=toUint32(args[1]);
+		work->query=charstring::duplicate(toString(args[0]),
+							work->querylength);
+	} else {
+		delete work;
+		throwWrongNumberOfArguments();
+		return;
+	}
+
+	returnObject(queueAsyncWork(isolate,args,work));
+}
+
+RET SQLRCursor::executeQueryAsync(const ARGS &args) {
+
+	initLocalScope();
+
+	checkArgCount(args,0);
+
+	returnObject(queueAsyncWork(isolate,args,
+				newAsyncWork(ASYNC_EXECUTEQUERY)));
+}
+
+RET SQLRCursor::fetchFromBindCursorAsync(const ARGS &args) {
+
+	initLocalScope();
+
+	checkArgCount(args,0);
+
+	returnObject(queueAsyncWork(isolate,args,
+				newAsyncWork(ASYNC_FETCHFROMBINDCURSOR)));
+}
+
+RET SQLRCursor::getRowsAsync(const ARGS &args) {
+
+	initLocalScope();
+
+	checkArgCount(args,2);
+
+	// The row count can't be checked against rowCount() here, because
+	// with a result set buffer size, rowCount() only counts the rows
+	// that have been fetched so far, and another asynchronous call might
+	// be using the cursor.  Reject obviously invalid values here, and
+	// asyncWork() stops at the end of the result set.
+	int64_t	firstrow=toInteger(args[0]);
+	int64_t	rowcount=toInteger(args[1]);
+	if (firstrow<0 || rowcount<0) {
+		throwInvalidArgumentValue();
+		return;
+	}
+
+	asyncwork	*work=newAsyncWork(ASYNC_GETROWS);
+	work->firstrow=firstrow;
+	work->rowcount=rowcount;
+
+	returnObject(queueAsyncWork(isolate,args,work));
+}
+#endif
+
 sqlrcursor *SQLRCursor::sqlrcur(const ARGS &args) {
 	return ObjectWrap::Unwrap<SQLRCursor>(args.Holder())->sqlrc;
 }
 
+#ifdef ASYNC_API
+bool SQLRCursor::busy(const ARGS &args) {
+	return ObjectWrap::Unwrap<SQLRCursor>(args.Holder())->
+						sqlrconobj->asyncpending;
+}
+#endif
+
 
 
 // module functions...
@@ -901,4 +901,55 @@ class SQLRCursor {
 		 *  no more data may be fetched.  Server side resources
 		 *  for the result set are freed as well. */
 		function closeResultSet();
+
+
+
+		/** Sends "query" directly and gets a result set, without
+		 *  blocking the event loop.  Returns a Promise that
+		 *  resolves to true on success and false on failure.
+		 *
+		 *  The query runs on the libuv threadpool.  Other
+		 *  asynchronous calls on cursors that share the same
+		 *  connection wait for it to finish.  Synchronous calls
+		 *  on the cursor, its connection, or other cursors of
+		 *  the connection throw an Error until the Promise has
+		 *  resolved.
+		 *
+		 *  Requires node.js 10 or later. */
+		function sendQueryAsync(var query);
+
+		/** Sends "query" with length "length" directly and gets
+		 *  a result set, without blocking the event loop.  Returns
+		 *  a Promise that resolves to true on success and false
+		 *  on failure. */
+		function sendQueryAsync(var query, var length);
+
+		/** Executes the query that was previously prepared and
+		 *  bound, without blocking the event loop.  Returns a
+		 *  Promise that resolves to true on success and false
+		 *  on failure. */
+		function executeQueryAsync();
+
+		/** Fetches from a cursor that was returned as an output
+		 *  bind variable, without blocking the event loop.
+		 *  Returns a Promise that resolves to true on success and
+		 *  false on failure. */
+		function fetchFromBindCursorAsync();
+
+		/** Fetches up to "count" rows, starting at "firstrow",
+		 *  without blocking the event loop.  Returns a Promise
+		 *  that resolves to an array of rows, each of which is an
+		 *  array of field values, with NULL fields represented as
+		 *  null.  Fewer than "count" rows are returned if the end
+		 *  of the result set is reached.
+		 *
+		 *  The cursor's result set buffer size determines how many
+		 *  rows are fetched from the server per round trip. */
+		function getRowsAsync(var firstrow, var count);
+
+		/** Returns an async iterator over the rows of the current
+		 *  result set, yielding arrays of up to "batchsize" rows
+		 *  fetched using getRowsAsync(), for use with
+		 *  "for await (const rows of cursor.rowBatches(100))". */
+		function rowBatches(var batchsize);
 };
@@ -18,6 +18,8 @@ THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING, B
 #include <rudiments/environment.h>
 #include <rudiments/character.h>
 #include <rudiments/process.h>
+#include <rudiments/file.h>
+#include <rudiments/thread.h>
 #include <rudiments/stdio.h>
 //#define DEBUG_MESSAGES 1
 #include <rudiments/debugprint.h>
@@ -50,7 +52,9 @@ typedef enum {
 	PGRES_COPY_IN,
 	PGRES_BAD_RESPONSE,
 	PGRES_NONFATAL_ERROR,
-	PGRES_FATAL_ERROR
+	PGRES_FATAL_ERROR,
+	PGRES_COPY_BOTH,
+	PGRES_SINGLE_TUPLE
 } ExecStatusType;
 
 typedef enum {
@@ -75,8 +79,30 @@ struct pg_result {
 	pg_conn		*conn;
 	int		previousnonblockingmode;
 	int		queryisnotselect;
+
+	// In single-row mode, all of the results of a query share the
+	// same sqlrcur, which is deleted when the last of them is cleared.
+	// Each PGRES_SINGLE_TUPLE result carries a copy of its row.
+	uint32_t	*sharedcount;
+	char		**tuple;
+	uint32_t	*tuplelengths;
 };
 
+// states of a query sent with PQsendQuery
+typedef enum {
+	// no query is in progress
+	PQASYNC_IDLE=0,
+	// the query has been sent but hasn't been started yet
+	PQASYNC_PENDING,
+	// the query is running in the background
+	PQASYNC_RUNNING,
+	// the query has finished and its results can be gotten
+	PQASYNC_DONE
+} PGAsyncStatusType;
+
+// in single-row mode, rows are fetched from the server this many at a time
+#define SINGLE_ROW_MODE_BUFFER_SIZE	100
+
 struct pg_conn {
 
 	sqlrconnection	*sqlrcon;
@@ -107,6 +133,17 @@ struct pg_conn {
 	int		removetrailingsemicolons;
 
 	PGVerbosity	errorverbosity;
+
+	PGAsyncStatusType	asyncstatus;
+	char			*asyncquery;
+	int			asyncsinglerowmode;
+	PGresult		*asyncresult;
+	uint64_t		asyncrow;
+	thread			asyncthread;
+	int			asyncthreadspawned;
+	filedescriptor		asyncreadfd;
+	filedescriptor		asyncwritefd;
+	int			asyncpipecreated;
 };
 
 struct pg_cancel {
@@ -288,6 +325,14 @@ PGconn *allocatePGconn(const char *conninfo,
 	conn->currentresult=NULL;
 	conn->nonblockingmode=0;
 
+	conn->asyncstatus=PQASYNC_IDLE;
+	conn->asyncquery=NULL;
+	conn->asyncsinglerowmode=0;
+	conn->asyncresult=NULL;
+	conn->asyncrow=0;
+	conn->asyncthreadspawned=0;
+	conn->asyncpipecreated=0;
+
 	conn->noticeprocessor=defaultNoticeProcessor;
 	conn->noticeprocessorarg=(void *)NULL;
 
@@ -309,6 +354,10 @@ PGconn *allocatePGconn(const char *conninfo,
 	return conn;
 }
 
+static void finishAsyncQuery(PGconn *conn);
+static void clearAsyncQuery(PGconn *conn);
+static void discardAsyncQuery(PGconn *conn);
+
 void freePGconn(PGconn *conn) {
 	debugFunction();
 
@@ -316,6 +365,10 @@ void freePGconn(PGconn *conn) {
 		return;
 	}
 
+	// wait for any query running in the background to finish
+	finishAsyncQuery(conn);
+	clearAsyncQuery(conn);
+
 	delete conn->sqlrcon;
 	conn->sqlrcon=NULL;
 	conn->sqlrcur=NULL;
@@ -467,9 +520,21 @@ char *PQerrorMessage(const PGconn *conn) {
 	return (conn->error)?conn->error:(char *)"";
 }
 
+static bool createAsyncPipe(PGconn *conn);
+
 int PQsocket(const PGconn *conn) {
 	debugFunction();
-	return -1;
+
+	// The sqlrclient socket itself isn't usable here, as it isn't even
+	// connected until the first query is run, and the protocol is driven
+	// synchronously by the sqlrconnection/sqlrcursor classes.  Instead,
+	// return the read end of a pipe that becomes readable when there's
+	// something for PQconsumeInput() to consume.
+	PGconn	*c=const_cast<PGconn *>(conn);
+	if (!createAsyncPipe(c)) {
+		return -1;
+	}
+	return c->asyncreadfd.getFileDescriptor();
 }
 
 int PQbackendPID(const PGconn *conn) {
@@ -644,30 +709,54 @@ PGresult *PQmakeEmptyPGresult(PGconn *conn, ExecStatusType status) {
 	result->conn=conn;
 	result->previousnonblockingmode=conn->nonblockingmode;
 	result->queryisnotselect=1;
+	result->sharedcount=NULL;
+	result->tuple=NULL;
+	result->tuplelengths=NULL;
 	return result;
 }
 
-void PQclear(PGresult *res) {
-	debugFunction();
+static void deletePGresult(PGresult *res) {
 	if (res) {
-		res->conn->nonblockingmode=res->previousnonblockingmode;
-		delete res->sqlrcur;
+		if (res->tuple) {
+			uint32_t	colcount=res->sqlrcur->colCount();
+			for (uint32_t i=0; i<colcount; i++) {
+				delete[] res->tuple[i];
+			}
+			delete[] res->tuple;
+			delete[] res->tuplelengths;
+		}
+		if (res->sharedcount) {
+			(*res->sharedcount)--;
+			if (!*res->sharedcount) {
+				delete res->sqlrcur;
+				delete res->sharedcount;
+			}
+		} else {
+			delete res->sqlrcur;
+		}
 		delete res;
 	}
 }
 
-PGresult *PQprepare(PGconn *conn,
-			const char *stmtname,
-			const char *query,
-			int paramcount,
-			const Oid *paramtypes) {
+void PQclear(PGresult *res) {
 	debugFunction();
-	debugPrintf("%s\n",query);
+	if (res) {
+		res->conn->nonblockingmode=res->previousnonblockingmode;
+		deletePGresult(res);
+	}
+}
 
-	PGresult	*result=PQmakeEmptyPGresult(conn,PGRES_EMPTY_QUERY);
+// The internal versions of PQprepare() and PQexecPrepared() below are also
+// run by the background thread that runs queries sent by PQsendQuery().  They
+// don't touch conn->error or conn->nonblockingmode, which the app may use
+// while the query runs.  Instead, they return any error in "error", and the
+// caller creates the result that prepareQuery() fills in.
 
-	delete[] conn->error;
-	conn->error=NULL;
+static PGresult *prepareQuery(PGconn *conn,
+				PGresult *result,
+				const char *query,
+				char **error) {
+	debugPrintf("%s\n",query);
 
 	if (!charstring::isNullOrEmpty(query)) {
 
@@ -677,9 +766,9 @@ PGresult *PQprepare(PGconn *conn,
 
 			const char	*dbtype=conn->sqlrcon->identify();
 			if (!dbtype) {
-				charstring::printf(&conn->error,"%s\n",
+				charstring::printf(error,"%s\n",
 						conn->sqlrcur->errorMessage());
-				PQclear(result);
+				deletePGresult(result);
 				return NULL;
 			}
 
@@ -709,29 +798,22 @@ PGresult *PQprepare(PGconn *conn,
 	// Copy the result so it can be passed on to PQexecPrepared.
 	// We need to copy it because the app might delete the result
 	// returned from this method.
-	if (conn->currentresult) {
-		PQclear(conn->currentresult);
-	}
+	deletePGresult(conn->currentresult);
 	conn->currentresult=new PGresult(*result);
 
 	return result;
 }
 
-PGresult *PQexecPrepared(PGconn *conn,
-				const char *stmtname,
+static PGresult *execPrepared(PGconn *conn,
 				int paramcount,
 				const char * const *paramvalues,
 				const int *paramlengths,
 				const int *paramformats,
-				int resultformat) {
-	debugFunction();
+				char **error) {
 
 	PGresult	*result=conn->currentresult;
 	conn->currentresult=NULL;
 
-	delete[] conn->error;
-	conn->error=NULL;
-
 	if (result->execstatus!=PGRES_EMPTY_QUERY) {
 
 		result->sqlrcur=conn->sqlrcur;
@@ -765,9 +847,9 @@ PGresult *PQexecPrepared(PGconn *conn,
 				result->execstatus=PGRES_TUPLES_OK;
 			}
 		} else {
-			charstring::printf(&conn->error,"%s\n",
+			charstring::printf(error,"%s\n",
 					result->sqlrcur->errorMessage());
-			PQclear(result);
+			deletePGresult(result);
 			result=NULL;
 		}
 	}
@@ -775,6 +857,35 @@ PGresult *PQexecPrepared(PGconn *conn,
 	return result;
 }
 
+PGresult *PQprepare(PGconn *conn,
+			const char *stmtname,
+			const char *query,
+			int paramcount,
+			const Oid *paramtypes) {
+	debugFunction();
+	discardAsyncQuery(conn);
+	delete[] conn->error;
+	conn->error=NULL;
+	return prepareQuery(conn,PQmakeEmptyPGresult(conn,PGRES_EMPTY_QUERY),
+							query,&conn->error);
+}
+
+PGresult *PQexecPrepared(PGconn *conn,
+				const char *stmtname,
+				int paramcount,
+				const char * const *paramvalues,
+				const int *paramlengths,
+				const int *paramformats,
+				int resultformat) {
+	debugFunction();
+	discardAsyncQuery(conn);
+	delete[] conn->error;
+	conn->error=NULL;
+	return execPrepared(conn,paramcount,
+				paramvalues,paramlengths,paramformats,
+				&conn->error);
+}
+
 PGresult *PQexecParams(PGconn *conn, const char *query,
 				int paramcount,
 				const Oid *paramtypes,
@@ -836,12 +947,19 @@ char *PQresStatus(ExecStatusType status) {
 		return (char *)"PGRES_NONFATAL_ERROR";
 	} else if (status==PGRES_FATAL_ERROR) {
 		return (char *)"PGRES_FATAL_ERROR";
+	} else if (status==PGRES_COPY_BOTH) {
+		return (char *)"PGRES_COPY_BOTH";
+	} else if (status==PGRES_SINGLE_TUPLE) {
+		return (char *)"PGRES_SINGLE_TUPLE";
 	}
 	return NULL;
 }
 
 char *PQresultErrorMessage(const PGresult *res) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return PQerrorMessage(res->conn);
+	}
 	return const_cast<char *>(res->sqlrcur->errorMessage());
 }
 
@@ -849,22 +967,40 @@ char *PQresultErrorField(const PGresult *res, int fieldcode) {
 	debugFunction();
 	// FIXME: SQL Relay doesn't have error fields, so for now,
 	// I guess we'll return the error message for every field
+	if (!res->sqlrcur) {
+		return PQerrorMessage(res->conn);
+	}
 	return const_cast<char *>(res->sqlrcur->errorMessage());
 }
 
 
 int PQntuples(const PGresult *res) {
 	debugFunction();
+	// in single-row mode, each PGRES_SINGLE_TUPLE result contains 1 row
+	// and the final PGRES_TUPLES_OK result contains none
+	if (res->sharedcount) {
+		return (res->tuple)?1:0;
+	}
+	// empty and error results don't have a cursor
+	if (!res->sqlrcur) {
+		return 0;
+	}
 	return res->sqlrcur->rowCount();
 }
 
 int PQnfields(const PGresult *res) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return 0;
+	}
 	return res->sqlrcur->colCount();
 }
 
 int PQbinaryTuples(const PGresult *res) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return 0;
+	}
 	// return 1 if result set contains binary data, 0 otherwise
 	for (uint32_t i=0; i<res->sqlrcur->colCount(); i++) {
 		if (res->sqlrcur->getColumnIsBinary(i)) {
@@ -876,11 +1012,17 @@ int PQbinaryTuples(const PGresult *res) {
 
 char *PQfname(const PGresult *res, int field_num) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return NULL;
+	}
 	return const_cast<char *>(res->sqlrcur->getColumnName(field_num));
 }
 
 int PQfnumber(const PGresult *res, const char *field_name) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return -1;
+	}
 	for (uint32_t i=0; i<res->sqlrcur->colCount(); i++) {
 		if (!charstring::compare(field_name,
 					res->sqlrcur->getColumnName(i))) {
@@ -906,7 +1048,7 @@ int PQftablecol(const PGresult *res, int column_number) {
 
 int PQfformat(const PGresult *res, int column_number) {
 	debugFunction();
-	if (res->sqlrcur->getColumnIsBinary(column_number)) {
+	if (res->sqlrcur && res->sqlrcur->getColumnIsBinary(column_number)) {
 		return 1;
 	}
 	return 0;
@@ -1286,6 +1428,10 @@ static Oid postgresqltypemap[]={
 Oid PQftype(const PGresult *res, int field_num) {
 	debugFunction();
 
+	if (!res->sqlrcur) {
+		return InvalidOid;
+	}
+
 	// if the type is numeric then we're using a postgresql database and
 	// typemangling is turned off, so we'll just return the type
 	const char	*columntype=res->sqlrcur->getColumnType(field_num);
@@ -1308,6 +1454,9 @@ Oid PQftype(const PGresult *res, int field_num) {
 }
 
 int PQfsize(const PGresult *res, int field_num) {
+	if (!res->sqlrcur) {
+		return 0;
+	}
 	// for char/varchar fields, return -1,
 	// otherwise, return the column length
 	Oid	oid=PQftype(res,field_num);
@@ -1317,6 +1466,9 @@ int PQfsize(const PGresult *res, int field_num) {
 
 int PQfmod(const PGresult *res, int field_num) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return -1;
+	}
 	// for char/varchar fields, return the column length,
 	// otherwise, return -1
 	Oid	oid=PQftype(res,field_num);
@@ -1347,21 +1499,42 @@ Oid PQoidValue(const PGresult *res) {
 
 char *PQcmdTuples(PGresult *res) {
 	debugFunction();
+	if (!res->sqlrcur) {
+		return (char *)"";
+	}
 	return charstring::parseNumber(res->sqlrcur->affectedRows());
 }
 
 char *PQgetvalue(const PGresult *res, int tup_num, int field_num) {
 	debugFunction();
+	if (res->tuple) {
+		return (tup_num)?NULL:res->tuple[field_num];
+	}
+	if (!res->sqlrcur) {
+		return NULL;
+	}
 	return const_cast<char *>(res->sqlrcur->getField(tup_num,field_num));
 }
 
 int PQgetlength(const PGresult *res, int tup_num, int field_num) {
 	debugFunction();
+	if (res->tuple) {
+		return (tup_num)?0:res->tuplelengths[field_num];
+	}
+	if (!res->sqlrcur) {
+		return 0;
+	}
 	return res->sqlrcur->getFieldLength(tup_num,field_num);
 }
 
 int PQgetisnull(const PGresult *res, int tup_num, int field_num) {
 	debugFunction();
+	if (res->tuple) {
+		return (tup_num)?1:(res->tuple[field_num]==(char *)NULL);
+	}
+	if (!res->sqlrcur) {
+		return 1;
+	}
 	return (res->sqlrcur->getField(tup_num,field_num)==(char *)NULL);
 }
 
@@ -2504,46 +2677,275 @@ int PQcancel(PGcancel *cancel, char *errbuf, int errbufsize) {
 
 int PQrequestCancel(PGconn *conn) {
 	debugFunction();
+	// the connection can't be closed out from
+	// under a query running in the background
+	discardAsyncQuery(conn);
 	delete conn->sqlrcon;
 	conn->sqlrcon=NULL;
 	conn->sqlrcur=NULL;
 	return TRUE;
 }
 
+static bool createAsyncPipe(PGconn *conn) {
+	if (!conn->asyncpipecreated) {
+		if (!file::createPipe(&conn->asyncreadfd,&conn->asyncwritefd)) {
+			return false;
+		}
+		conn->asyncpipecreated=1;
+	}
+	return true;
+}
+
+// the background thread hands the result of a query,
+// and any error, to the app's thread through the pipe
+struct asyncqueryresult {
+	PGresult	*result;
+	char		*error;
+};
+
+static void *asyncQuery(void *attr) {
+	debugFunction();
+
+	PGconn	*conn=(PGconn *)attr;
+
+	// this is essentially PQexec(), but in single-row mode, the result
+	// set buffer size is bounded, so rows will be streamed from the
+	// server as PQgetResult() asks for them rather than buffered
+	// (call the internal versions of PQprepare() and PQexecPrepared(),
+	// the public ones would wait for this query to finish)
+	asyncqueryresult	r;
+	r.error=NULL;
+	r.result=prepareQuery(conn,conn->asyncresult,
+					conn->asyncquery,&r.error);
+	if (r.result && r.result->execstatus!=PGRES_EMPTY_QUERY) {
+		deletePGresult(r.result);
+		if (conn->asyncsinglerowmode) {
+			conn->sqlrcur->setResultSetBufferSize(
+					SINGLE_ROW_MODE_BUFFER_SIZE);
+		}
+		r.result=execPrepared(conn,0,NULL,NULL,NULL,&r.error);
+	}
+
+	// hand the result over, which also makes
+	// the socket returned by PQsocket() readable
+	conn->asyncwritefd.write((const void *)&r,sizeof(r));
+	return NULL;
+}
+
+static void startAsyncQuery(PGconn *conn) {
+
+	if (conn->asyncstatus!=PQASYNC_PENDING) {
+		return;
+	}
+
+	// consume the byte written by PQsendQuery()
+	char	c;
+	conn->asyncreadfd.read(&c);
+
+	conn->asyncstatus=PQASYNC_RUNNING;
+
+	// Create the result here, rather than in the background thread, as it
+	// saves the app's non-blocking mode.  The background thread owns it,
+	// and conn->sqlrcur, until it hands the result back.
+	conn->asyncresult=PQmakeEmptyPGresult(conn,PGRES_EMPTY_QUERY);
+
+	// run the query in the background, or in the foreground if
+	// that isn't possible, either way, when it's done, asyncQuery()
+	// will make the socket readable again
+	conn->asyncthreadspawned=(thread::supported() &&
+			conn->asyncthread.spawn(asyncQuery,(void *)conn,false));
+	if (!conn->asyncthreadspawned) {
+		asyncQuery((void *)conn);
+	}
+}
+
+static void finishAsyncQuery(PGconn *conn) {
+
+	if (conn->asyncstatus!=PQASYNC_RUNNING) {
+		return;
+	}
+
+	// wait for the query to finish and collect its result
+	asyncqueryresult	r;
+	if (conn->asyncreadfd.read((void *)&r,sizeof(r))!=sizeof(r)) {
+		r.result=NULL;
+		r.error=charstring::duplicate(
+				"lost the result of the query\n");
+	}
+	if (conn->asyncthreadspawned) {
+		int32_t	status;
+		conn->asyncthread.wait(&status);
+		conn->asyncthreadspawned=0;
+	}
+	conn->asyncresult=r.result;
+	delete[] conn->error;
+	conn->error=r.error;
+
+	conn->asyncstatus=PQASYNC_DONE;
+}
+
+static void clearAsyncQuery(PGconn *conn) {
+	if (conn->asyncresult) {
+		PQclear(conn->asyncresult);
+		conn->asyncresult=NULL;
+	}
+	delete[] conn->asyncquery;
+	conn->asyncquery=NULL;
+	conn->asyncsinglerowmode=0;
+	conn->asyncrow=0;
+	conn->asyncstatus=PQASYNC_IDLE;
+}
+
+static void discardAsyncQuery(PGconn *conn) {
+
+	// Like libpq, the synchronous query functions silently discard the
+	// results of any query sent with PQsendQuery() that the app hasn't
+	// collected, waiting for it to finish first, so the query and the
+	// background thread aren't both using conn->sqlrcur at once.
+	if (conn->asyncstatus==PQASYNC_IDLE) {
+		return;
+	}
+	debugPrintf("discarding async query results\n");
+	PGresult	*result;
+	while ((result=PQgetResult(conn))) {
+		PQclear(result);
+	}
+}
+
 int PQsendQuery(PGconn *conn, const char *query) {
 	debugFunction();
 
+	delete[] conn->error;
+	conn->error=NULL;
+
+	if (conn->asyncstatus!=PQASYNC_IDLE) {
+		conn->error=charstring::duplicate(
+				"another command is already in progress\n");
+		return FALSE;
+	}
+	if (!createAsyncPipe(conn)) {
+		conn->error=charstring::duplicate(
+				"could not create socket for query\n");
+		return FALSE;
+	}
+
 	// FIXME:
 	// "query" could contain multiple queries,
-	// parse them out and fork a thread to run each query
-	conn->currentresult=PQexec(conn,query);
+	// parse them out and run each query
+
+	// Don't actually start the query until the app calls PQconsumeInput,
+	// PQisBusy, PQgetResult or PQflush.  This gives the app a chance to
+	// call PQsetSingleRowMode first.  Make the socket readable so that
+	// an app waiting on it will call PQconsumeInput and start the query.
+	conn->asyncquery=charstring::duplicate(query);
+	conn->asyncstatus=PQASYNC_PENDING;
+	conn->asyncwritefd.write((char)1);
+	return TRUE;
+}
+
+int PQsetSingleRowMode(PGconn *conn) {
+	debugFunction();
+
+	// this must be called immediately after PQsendQuery
+	if (conn->asyncstatus!=PQASYNC_PENDING) {
+		return FALSE;
+	}
+	conn->asyncsinglerowmode=1;
 	return TRUE;
 }
 
+static PGresult *singleRowModeResult(PGconn *conn) {
+
+	PGresult	*result=conn->asyncresult;
+	sqlrcursor	*sqlrcur=result->sqlrcur;
+
+	if (!result->sharedcount) {
+		result->sharedcount=new uint32_t;
+		*result->sharedcount=1;
+	}
+
+	// fetch the next row
+	const char * const	*row=sqlrcur->getRow(conn->asyncrow);
+	if (!row) {
+
+		// at the end of the result set, return the
+		// (empty) PGRES_TUPLES_OK result itself
+		conn->asyncresult=NULL;
+		clearAsyncQuery(conn);
+		return result;
+	}
+	uint32_t	*lengths=sqlrcur->getRowLengths(conn->asyncrow);
+	conn->asyncrow++;
+
+	// build a PGRES_SINGLE_TUPLE result with a copy of the row,
+	// sharing the sqlrcur with the final PGRES_TUPLES_OK result
+	PGresult	*tupleresult=new PGresult(*result);
+	tupleresult->execstatus=PGRES_SINGLE_TUPLE;
+	(*tupleresult->sharedcount)++;
+
+	uint32_t	colcount=sqlrcur->colCount();
+	tupleresult->tuple=new char *[colcount];
+	tupleresult->tuplelengths=new uint32_t[colcount];
+	for (uint32_t i=0; i<colcount; i++) {
+		tupleresult->tuple[i]=(row[i])?
+				charstring::duplicate(row[i],lengths[i]):NULL;
+		tupleresult->tuplelengths[i]=lengths[i];
+	}
+	return tupleresult;
+}
+
 PGresult *PQgetResult(PGconn *conn) {
 	debugFunction();
 
-	// FIXME:
-	// Should poll to see if one of the queries started in
-	// PQsendQuery is done, if so, return it's result set.
-	// If all queries are done, return NULL
-	PGresult	*retval=conn->currentresult;
-	conn->currentresult=NULL;
+	// return NULL if there's nothing (else) to return
+	if (conn->asyncstatus==PQASYNC_IDLE) {
+		return NULL;
+	}
+
+	// wait for the query to finish (if it hasn't already)
+	startAsyncQuery(conn);
+	finishAsyncQuery(conn);
+
+	// if the query failed, return an error result
+	if (!conn->asyncresult) {
+		clearAsyncQuery(conn);
+		return PQmakeEmptyPGresult(conn,PGRES_FATAL_ERROR);
+	}
+
+	// in single-row mode, return 1 result per row
+	if (conn->asyncsinglerowmode &&
+			conn->asyncresult->execstatus==PGRES_TUPLES_OK) {
+		return singleRowModeResult(conn);
+	}
+
+	// otherwise return the entire result
+	PGresult	*retval=conn->asyncresult;
+	conn->asyncresult=NULL;
+	clearAsyncQuery(conn);
 	return retval;
 }
 
 PGTransactionStatusType PQtransactionStatus(const PGconn *conn) {
 	debugFunction();
-	return PQTRANS_IDLE;
+	return (conn->asyncstatus!=PQASYNC_IDLE)?PQTRANS_ACTIVE:PQTRANS_IDLE;
 }
 
 int PQisBusy(PGconn *conn) {
 	debugFunction();
-	return FALSE;
+	startAsyncQuery(conn);
+	return (conn->asyncstatus==PQASYNC_RUNNING);
 }
 
 int PQconsumeInput(PGconn *conn) {
 	debugFunction();
+
+	startAsyncQuery(conn);
+
+	// if the query has finished, then collect it, without blocking
+	if (conn->asyncstatus==PQASYNC_RUNNING &&
+			conn->asyncreadfd.waitForNonBlockingRead(0,0)>0) {
+		finishAsyncQuery(conn);
+	}
 	return TRUE;
 }
 
@@ -2560,6 +2962,8 @@ int PQisnonblocking(const PGconn *conn) {
 
 int PQflush(PGconn *conn) {
 	debugFunction();
+	// the query is "sent" when it's started
+	startAsyncQuery(conn);
 	// return 0 on success or EOF on failure
 	return 0;
 }
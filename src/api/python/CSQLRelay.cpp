@@ -8,6 +8,7 @@
 #include <Python.h>
 #include <sqlrelay/sqlrclient.h>
 #include <rudiments/character.h>
+#include <rudiments/bytebuffer.h>
 
 #if PY_MAJOR_VERSION >= 2
 #if PY_MINOR_VERSION >= 3
@@ -1382,6 +1383,39 @@ static PyObject *getFieldLength(PyObject *self, PyObject *args) {
   return Py_BuildValue("l", (long)rc);
 }
 
+static PyObject *
+_get_field_object(const char *field, uint32_t length, const char *type)
+{
+  if (!field) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  } else if (usenumeric && isFloatTypeChar(type)) {
+    if (decimal) {
+      PyObject *tuple=PyTuple_New(1);
+      PyTuple_SetItem(tuple, 0, Py_BuildValue("s#", field, length));
+      PyObject *obj=PyObject_CallObject(decimal, tuple);
+      Py_DECREF(tuple);
+      return obj;
+    }
+    return Py_BuildValue("f", (double)charstring::toFloatC(field));
+  } else if (usenumeric && isNumberTypeChar(type)) {
+    return Py_BuildValue("L", charstring::toInteger(field));
+  } else if (isBitTypeChar(type)) {
+    return Py_BuildValue("l", bitStringToLong(field));
+  } else if (isBoolTypeChar(type)) {
+    if (character::toLowerCase(field[0]) == 't') {
+      Py_INCREF(Py_True);
+      return Py_True;
+    } else if (character::toLowerCase(field[0]) == 'f') {
+      Py_INCREF(Py_False);
+      return Py_False;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return Py_BuildValue("s#", field, length);
+}
+
 static PyObject *
 _get_row(sqlrcursor *sqlrcur, uint64_t row)
 {
@@ -1389,10 +1423,8 @@ _get_row(sqlrcursor *sqlrcur, uint64_t row)
   uint32_t counter;
   const char * const *row_data;
   uint32_t *row_lengths;
-  const char *type;
   PyObject *my_list;
   num_cols=sqlrcur->colCount();
-  my_list =  PyList_New(num_cols);
   Py_BEGIN_ALLOW_THREADS
   row_data=sqlrcur->getRow(row);
   row_lengths=sqlrcur->getRowLengths(row);
@@ -1401,39 +1433,11 @@ _get_row(sqlrcursor *sqlrcur, uint64_t row)
     Py_INCREF(Py_None);
     return Py_None;
   }
+  my_list =  PyList_New(num_cols);
   for (counter = 0; counter < num_cols; ++counter) {
-    type=sqlrcur->getColumnType(counter);
-    if (!row_data[counter]) {
-        Py_INCREF(Py_None);
-        PyList_SetItem(my_list, counter, Py_None);
-    } else if (usenumeric && isFloatTypeChar(type)) {
-      PyObject *obj;
-      if (decimal) {
-        PyObject *tuple=PyTuple_New(1);
-        PyTuple_SetItem(tuple, 0, Py_BuildValue("s#", row_data[counter], row_lengths[counter]));
-        obj=PyObject_CallObject(decimal, tuple);
-      } else {
-        obj=Py_BuildValue("f", (double)charstring::toFloatC(row_data[counter]));
-      }
-      PyList_SetItem(my_list, counter, obj);
-    } else if (usenumeric && isNumberTypeChar(type)) {
-      PyList_SetItem(my_list, counter, Py_BuildValue("L", charstring::toInteger(row_data[counter])));
-    } else if (isBitTypeChar(type)) {
-      PyList_SetItem(my_list, counter, Py_BuildValue("l", bitStringToLong(row_data[counter])));
-    } else if (isBoolTypeChar(type)) {
-      if (row_data[counter] && character::toLowerCase(row_data[counter][0]) == 't') {
-        Py_INCREF(Py_True);
-        PyList_SetItem(my_list, counter, Py_True);
-      } else if (row_data[counter] && character::toLowerCase(row_data[counter][0]) == 'f') {
-        Py_INCREF(Py_False);
-        PyList_SetItem(my_list, counter, Py_False);
-      } else {
-        Py_INCREF(Py_None);
-        PyList_SetItem(my_list, counter, Py_None);
-      }
-    } else {
-      PyList_SetItem(my_list, counter, Py_BuildValue("s#", row_data[counter], row_lengths[counter]));
-    }
+    PyList_SetItem(my_list, counter,
+		_get_field_object(row_data[counter], row_lengths[counter],
+					sqlrcur->getColumnType(counter)));
   }
   return my_list;
 }
@@ -1538,6 +1542,143 @@ static PyObject *getRowRange(PyObject *self, PyObject *args) {
   return my_list;
 }
 
+static PyObject *getRowsAsLists(PyObject *self, PyObject *args) {
+  long sqlrcur;
+  uint64_t first_row;
+  uint64_t count;
+  if (!PyArg_ParseTuple(args,
+#ifdef SUPPORTS_UNSIGNED
+	"lKK",
+#else
+	"lLL",
+#endif
+	&sqlrcur, &first_row, &count))
+    return NULL;
+  sqlrcursor *cur=(sqlrcursor *)sqlrcur;
+  // look up the column types once, rather than once per field
+  uint32_t num_cols=cur->colCount();
+  const char **types=new const char *[num_cols];
+  for (uint32_t col=0; col<num_cols; col++) {
+    types[col]=cur->getColumnType(col);
+  }
+  PyObject *my_list=PyList_New(0);
+  for (uint64_t row=first_row; row<first_row+count; row++) {
+    const char * const *row_data;
+    uint32_t *row_lengths;
+    Py_BEGIN_ALLOW_THREADS
+    row_data=cur->getRow(row);
+    row_lengths=cur->getRowLengths(row);
+    Py_END_ALLOW_THREADS
+    if (!row_data) {
+      break;
+    }
+    PyObject *fields=PyList_New(num_cols);
+    for (uint32_t col=0; col<num_cols; col++) {
+      PyList_SET_ITEM(fields, col,
+		_get_field_object(row_data[col], row_lengths[col], types[col]));
+    }
+    PyList_Append(my_list, fields);
+    Py_DECREF(fields);
+  }
+  delete[] types;
+  return my_list;
+}
+
+static PyObject *getColumnAsArray(PyObject *self, PyObject *args) {
+  long sqlrcur;
+  uint32_t col;
+  uint64_t first_row;
+  uint64_t count;
+  if (!PyArg_ParseTuple(args,
+#ifdef SUPPORTS_UNSIGNED
+	"lIKK",
+#else
+	"liLL",
+#endif
+	&sqlrcur, &col, &first_row, &count))
+    return NULL;
+  sqlrcursor *cur=(sqlrcursor *)sqlrcur;
+  if (col>=cur->colCount()) {
+    PyErr_SetString(PyExc_IndexError, "column index out of range");
+    return NULL;
+  }
+
+  // Integer columns are exported as 64-bit integers and other numeric
+  // columns as doubles.  The values are converted and copied into a Python
+  // array, which implements the buffer protocol, so numpy can then use it
+  // directly, with numpy.frombuffer(), without creating an object for each
+  // value.  NULLs are flagged in a separate bytearray, one byte per row.
+  const char *type=cur->getColumnType(col);
+  if (!isNumberTypeChar(type) && !isFloatTypeChar(type) &&
+						!isBitTypeChar(type)) {
+    PyErr_SetString(PyExc_TypeError, "column is not numeric");
+    return NULL;
+  }
+  bool isint=(isNumberTypeChar(type) && !isFloatTypeChar(type)) ||
+						isBitTypeChar(type);
+#if PY_MAJOR_VERSION >= 3
+  const char *typecode=(isint)?"q":"d";
+#else
+  const char *typecode=(isint)?"l":"d";
+#endif
+
+  bytebuffer values;
+  bytebuffer nulls;
+  uint64_t row;
+  Py_BEGIN_ALLOW_THREADS
+  for (row=first_row; row<first_row+count; row++) {
+    const char *field=cur->getField(row, col);
+    if (!field && !cur->getRow(row)) {
+      break;
+    }
+    unsigned char isnull=(field)?0:1;
+    nulls.append(&isnull, sizeof(isnull));
+    if (isint) {
+#if PY_MAJOR_VERSION >= 3
+      long long value=(field)?((isBitTypeChar(type))?
+				bitStringToLong(field):
+				charstring::toInteger(field)):0;
+#else
+      long value=(field)?((isBitTypeChar(type))?
+				bitStringToLong(field):
+				(long)charstring::toInteger(field)):0;
+#endif
+      values.append((const unsigned char *)&value, sizeof(value));
+    } else {
+      double value=(field)?(double)charstring::toFloatC(field):0.0;
+      values.append((const unsigned char *)&value, sizeof(value));
+    }
+  }
+  Py_END_ALLOW_THREADS
+
+  PyObject *arraymodule=PyImport_ImportModule("array");
+  if (!arraymodule) {
+    return NULL;
+  }
+  PyObject *array=PyObject_CallMethod(arraymodule,
+					(char *)"array", (char *)"s", typecode);
+  Py_DECREF(arraymodule);
+  if (!array) {
+    return NULL;
+  }
+#if PY_MAJOR_VERSION >= 3
+  PyObject *rc=PyObject_CallMethod(array, (char *)"frombytes", (char *)"y#",
+#else
+  PyObject *rc=PyObject_CallMethod(array, (char *)"fromstring", (char *)"s#",
+#endif
+				(const char *)values.getBuffer(),
+				(int)values.getSize());
+  if (!rc) {
+    Py_DECREF(array);
+    return NULL;
+  }
+  Py_DECREF(rc);
+  PyObject *nullarray=PyByteArray_FromStringAndSize(
+				(const char *)nulls.getBuffer(),
+				(Py_ssize_t)nulls.getSize());
+  return Py_BuildValue("(NN)", array, nullarray);
+}
+
 static PyObject *
 _get_row_lengths(sqlrcursor *sqlrcur, uint64_t row)
 {
@@ -2081,6 +2222,8 @@ static PyMethodDef SQLRMethods[] = {
   {"getRow", getRow, METH_VARARGS},
   {"getRowDictionary", getRowDictionary, METH_VARARGS},
   {"getRowRange", getRowRange, METH_VARARGS},
+  {"getRowsAsLists", getRowsAsLists, METH_VARARGS},
+  {"getColumnAsArray", getColumnAsArray, METH_VARARGS},
   {"getRowLengths", getRowLengths, METH_VARARGS},
   {"getRowLengthsDictionary", getRowLengthsDictionary, METH_VARARGS},
   {"getRowLengthsRange", getRowLengthsRange, METH_VARARGS},
@@ -951,6 +951,30 @@ class sqlrcursor:
         """
         return CSQLRelay.getRowRange(self.cursor, beg, end)
 
+    def getRowsAsLists(self, first, count):
+        """
+        Returns a list of lists of up to count rows, starting at first.
+        Fewer rows are returned if the end of the result set is reached.
+        The rows are built in a single call, which is much faster than
+        calling getRow() for each row.
+        Note: this function has no equivalent in other SQL Relay API's.
+        """
+        return CSQLRelay.getRowsAsLists(self.cursor, first, count)
+
+    def getColumnAsArray(self, col, first, count):
+        """
+        Returns the values of column col, for up to count rows starting at
+        first, as a tuple of an array.array and a bytearray.  Integer
+        columns are returned as an array of 64-bit integers and other
+        numeric columns as an array of doubles.  A TypeError is raised if
+        the column isn't numeric.  The bytearray contains a 1 for each row
+        where the field is NULL and a 0 otherwise.  The values are copied
+        into the arrays, but both support the buffer protocol, so they can
+        be passed to numpy.frombuffer() without copying them again.
+        Note: this function has no equivalent in other SQL Relay API's.
+        """
+        return CSQLRelay.getColumnAsArray(self.cursor, col, first, count)
+
     def getRowLengths(self, row):
         """
         Returns a list of lengths in the given row.
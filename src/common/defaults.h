@@ -40,6 +40,12 @@
 // that were fired off to handle increased load
 #define DEFAULT_MAXSESSIONCOUNT "0"
 
+// default policy the scaler uses to decide when to start connections
+#define DEFAULT_SCALINGPOLICY "threshold"
+
+// default latency histograms to maintain
+#define DEFAULT_LATENCYHISTOGRAMS "instance"
+
 // default session timeout
 #define DEFAULT_SESSIONTIMEOUT "600"
 
@@ -134,6 +140,9 @@
 // default re-login at start attribute
 #define DEFAULT_RELOGINATSTART "no"
 
+// default query cancellation attribute
+#define DEFAULT_QUERYCANCELLATION "yes"
+
 // default time queries attributes
 #define DEFAULT_TIMEQUERIESSEC "-1"
 #define DEFAULT_TIMEQUERIESUSEC "-1"
@@ -57,6 +57,8 @@ class SQLRUTIL_DLLSPEC sqlrconfig_xmldom : public sqlrconfig, public xmldom {
 		int32_t		getTtl();
 		int32_t		getSoftTtl();
 		uint16_t	getMaxSessionCount();
+		const char	*getScalingPolicy();
+		const char	*getLatencyHistograms();
 		bool		getDynamicScaling();
 		const char	*getEndOfSession();
 		bool		getEndOfSessionCommit();
@@ -107,6 +109,7 @@ class SQLRUTIL_DLLSPEC sqlrconfig_xmldom : public sqlrconfig, public xmldom {
 		int64_t		getMaxListeners();
 		uint32_t	getListenerTimeout();
 		bool		getReLoginAtStart();
+		bool		getQueryCancellation();
 		bool		getFakeInputBindVariables();
 		const char	*getFakeInputBindVariablesDateFormat();
 		bool		getFakeInputBindVariablesUnicodeStrings();
@@ -141,6 +144,7 @@ class SQLRUTIL_DLLSPEC sqlrconfig_xmldom : public sqlrconfig, public xmldom {
 		domnode	*getPasswordEncryptions();
 		domnode	*getAuths();
 		domnode	*getModuleDatas();
+		domnode	*getAdmission();
 
 		linkedlist< connectstringcontainer * >	*getConnectStringList();
 		connectstringcontainer	*getConnectString(
@@ -196,6 +200,8 @@ class SQLRUTIL_DLLSPEC sqlrconfig_xmldom : public sqlrconfig, public xmldom {
 		int32_t		ttl;
 		int32_t		softttl;
 		uint16_t	maxsessioncount;
+		const char	*scalingpolicy;
+		const char	*latencyhistograms;
 		const char	*endofsession;
 		bool		endofsessioncommit;
 		uint32_t	sessiontimeout;
@@ -245,6 +251,7 @@ class SQLRUTIL_DLLSPEC sqlrconfig_xmldom : public sqlrconfig, public xmldom {
 		int64_t		maxlisteners;
 		uint32_t	listenertimeout;
 		bool		reloginatstart;
+		bool		querycancellation;
 		bool		fakeinputbindvariables;
 		const char	*fakeinputbindvariablesdateformat;
 		bool		fakeinputbindvariablesunicodestrings;
@@ -280,6 +287,7 @@ class SQLRUTIL_DLLSPEC sqlrconfig_xmldom : public sqlrconfig, public xmldom {
 		domnode	*pwdencsxml;
 		domnode	*authsxml;
 		domnode	*moduledatasxml;
+		domnode	*admissionxml;
 
 		uint32_t	metrictotal;
 
@@ -344,6 +352,8 @@ void sqlrconfig_xmldom::init() {
 	ttl=charstring::toInteger(DEFAULT_TTL);
 	softttl=charstring::toInteger(DEFAULT_SOFTTTL);
 	maxsessioncount=charstring::toInteger(DEFAULT_MAXSESSIONCOUNT);
+	scalingpolicy=DEFAULT_SCALINGPOLICY;
+	latencyhistograms=DEFAULT_LATENCYHISTOGRAMS;
 	endofsession=DEFAULT_ENDOFSESSION;
 	endofsessioncommit=!charstring::compare(endofsession,"commit");
 	sessiontimeout=charstring::toUnsignedInteger(DEFAULT_SESSIONTIMEOUT);
@@ -402,6 +412,7 @@ void sqlrconfig_xmldom::init() {
 	maxlisteners=charstring::toInteger(DEFAULT_MAXLISTENERS);
 	listenertimeout=charstring::toUnsignedInteger(DEFAULT_LISTENERTIMEOUT);
 	reloginatstart=charstring::isYes(DEFAULT_RELOGINATSTART);
+	querycancellation=charstring::isYes(DEFAULT_QUERYCANCELLATION);
 	fakeinputbindvariables=charstring::isYes(
 					DEFAULT_FAKEINPUTBINDVARIABLES);
 	fakeinputbindvariablesdateformat=NULL;
@@ -530,6 +541,14 @@ uint16_t sqlrconfig_xmldom::getMaxSessionCount() {
 	return maxsessioncount;
 }
 
+const char *sqlrconfig_xmldom::getScalingPolicy() {
+	return scalingpolicy;
+}
+
+const char *sqlrconfig_xmldom::getLatencyHistograms() {
+	return latencyhistograms;
+}
+
 bool sqlrconfig_xmldom::getDynamicScaling() {
 	return (maxconnections>connections && growby>0 && ttl>-1 &&
 		(maxlisteners==-1 || maxqueuelength<=maxlisteners));
@@ -731,6 +750,10 @@ bool sqlrconfig_xmldom::getReLoginAtStart() {
 	return reloginatstart;
 }
 
+bool sqlrconfig_xmldom::getQueryCancellation() {
+	return querycancellation;
+}
+
 bool sqlrconfig_xmldom::getFakeInputBindVariables() {
 	return fakeinputbindvariables;
 }
@@ -859,6 +882,10 @@ domnode *sqlrconfig_xmldom::getModuleDatas() {
 	return moduledatasxml;
 }
 
+domnode *sqlrconfig_xmldom::getAdmission() {
+	return admissionxml;
+}
+
 linkedlist< connectstringcontainer * > *sqlrconfig_xmldom::
 						getConnectStringList() {
 	return &connectstringlist;
@@ -1712,9 +1739,6 @@ void sqlrconfig_xmldom::getTreeValues() {
 	if (!attr->isNullNode()) {
 		connections=atouint32_t(attr->getValue(),
 						DEFAULT_CONNECTIONS,0);
-		if (connections>MAXCONNECTIONS) {
-			connections=MAXCONNECTIONS;
-		}
 		if (maxconnections<connections) {
 			maxconnections=connections;
 		}
@@ -1723,9 +1747,6 @@ void sqlrconfig_xmldom::getTreeValues() {
 	if (!attr->isNullNode()) {
 		maxconnections=atouint32_t(attr->getValue(),
 						DEFAULT_CONNECTIONS,1);
-		if (maxconnections>MAXCONNECTIONS) {
-			maxconnections=MAXCONNECTIONS;
-		}
 		if (maxconnections<connections) {
 			maxconnections=connections;
 		}
@@ -1752,6 +1773,14 @@ void sqlrconfig_xmldom::getTreeValues() {
 		maxsessioncount=atouint32_t(attr->getValue(),
 						DEFAULT_MAXSESSIONCOUNT,0);
 	}
+	attr=instance->getAttribute("scalingpolicy");
+	if (!attr->isNullNode()) {
+		scalingpolicy=attr->getValue();
+	}
+	attr=instance->getAttribute("latencyhistograms");
+	if (!attr->isNullNode()) {
+		latencyhistograms=attr->getValue();
+	}
 	attr=instance->getAttribute("endofsession");
 	if (!attr->isNullNode()) {
 		endofsession=attr->getValue();
@@ -1885,6 +1914,10 @@ void sqlrconfig_xmldom::getTreeValues() {
 	if (!attr->isNullNode()) {
 		reloginatstart=charstring::isYes(attr->getValue());
 	}
+	attr=instance->getAttribute("querycancellation");
+	if (!attr->isNullNode()) {
+		querycancellation=charstring::isYes(attr->getValue());
+	}
 	attr=instance->getAttribute("fakeinputbindvariables");
 	if (!attr->isNullNode()) {
 		fakeinputbindvariables=charstring::isYes(attr->getValue());
@@ -1953,6 +1986,7 @@ void sqlrconfig_xmldom::getTreeValues() {
 	pwdencsxml=instance->getFirstTagChild("passwordencryptions");
 	authsxml=instance->getFirstTagChild("auths");
 	moduledatasxml=instance->getFirstTagChild("moduledatas");
+	admissionxml=instance->getFirstTagChild("admission");
 
 
 	// listeners tag...
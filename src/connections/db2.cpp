@@ -2,7 +2,10 @@
 // See the file COPYING for more information
 
 #include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlrstatementcache.h>
 #include <rudiments/environment.h>
+#include <rudiments/bytestring.h>
+#include <rudiments/character.h>
 
 #include <datatypes.h>
 #include <defines.h>
@@ -64,6 +67,9 @@ class SQLRSERVER_DLLSPEC db2cursor : public sqlrservercursor {
 		bool		close();
 		bool		prepareQuery(const char *query,
 						uint32_t length);
+		bool		reusePreparedStatement(const char *query,
+							uint32_t length);
+		void		invalidatePreparedStatement();
 		void		encodeBlob(stringbuffer *buffer,
 						const char *data,
 						uint32_t datasize);
@@ -172,6 +178,7 @@ class SQLRSERVER_DLLSPEC db2cursor : public sqlrservercursor {
 		uint16_t	getColumnIsAutoIncrement(uint32_t i);
 		const char	*getColumnTable(uint32_t i);
 		uint16_t	getColumnTableLength(uint32_t i);
+		void		sizeFieldBuffer(SQLSMALLINT col);
 		bool		noRowsToReturn();
 		bool		skipRow(bool *error);
 		bool		fetchRow(bool *error);
@@ -197,6 +204,7 @@ class SQLRSERVER_DLLSPEC db2cursor : public sqlrservercursor {
 
 		int32_t		columncount;
 		char		**field;
+		uint32_t	*fieldlength;
 		SQLINTEGER	**loblocator;
 		SQLINTEGER	**loblength;
 		SQLINTEGER	**indicator;
@@ -221,6 +229,10 @@ class SQLRSERVER_DLLSPEC db2cursor : public sqlrservercursor {
 
 		bool		bindformaterror;
 
+		char		*stmtquery;
+		uint32_t	stmtquerylength;
+		uint32_t	stmtgeneration;
+
 		stringbuffer	errormsg;
 
 		db2connection	*db2conn;
@@ -271,6 +283,11 @@ class SQLRSERVER_DLLSPEC db2connection : public sqlrserverconnection {
 		const char	*noopQuery();
 		const char	*bindFormat();
 
+		bool		changesSchema(const char *query);
+		void		cacheStatement(SQLHSTMT stmt,
+							char *query,
+							uint32_t length);
+
 		SQLHENV		env;
 		SQLRETURN	erg;
 		SQLHDBC		dbc;
@@ -285,6 +302,8 @@ class SQLRSERVER_DLLSPEC db2connection : public sqlrserverconnection {
 
 		const char	*identity;
 
+		sqlrstatementcache< SQLHSTMT >	stmtcache;
+
 		char		dbversion[512];
 		uint16_t	dbmajorversion;
 
@@ -295,8 +314,13 @@ class SQLRSERVER_DLLSPEC db2connection : public sqlrserverconnection {
 		stringbuffer	errormsg;
 };
 
+static void freeStatement(SQLHSTMT stmt) {
+	SQLFreeHandle(SQL_HANDLE_STMT,stmt);
+}
+
 db2connection::db2connection(sqlrservercontroller *cont) :
-					sqlrserverconnection(cont) {
+					sqlrserverconnection(cont),
+					stmtcache(freeStatement) {
 
 	maxoutbindlobsize=MAX_OUT_BIND_LOB_SIZE;
 	identity=NULL;
@@ -324,6 +348,9 @@ void db2connection::handleConnectString() {
 	if (maxoutbindlobsize<1) {
 		maxoutbindlobsize=MAX_OUT_BIND_LOB_SIZE;
 	}
+
+	stmtcache.setSize(charstring::toUnsignedInteger(
+			cont->getConnectStringValue("stmtcachesize")));
 }
 
 bool db2connection::mustDetachBeforeLogIn() {
@@ -543,6 +570,7 @@ void db2connection::deleteCursor(sqlrservercursor *curs) {
 }
 
 void db2connection::logOut() {
+	stmtcache.clear();
 	SQLDisconnect(dbc);
 	SQLFreeHandle(SQL_HANDLE_DBC,dbc);
 	SQLFreeHandle(SQL_HANDLE_ENV,env);
@@ -728,6 +756,48 @@ const char *db2connection::selectDatabaseQuery() {
 	return "set schema %s";
 }
 
+bool db2connection::changesSchema(const char *query) {
+
+	// unqualified names in prepared statements are resolved against the
+	// schema (or path) that was current when the statement was prepared,
+	// so look for "set [current] schema/sqlid/path ..."
+	const char	*ptr=cont->skipWhitespaceAndComments(query);
+	if (charstring::compareIgnoringCase(ptr,"set",3) ||
+				!character::isWhitespace(ptr[3])) {
+		return false;
+	}
+	ptr=cont->skipWhitespaceAndComments(ptr+3);
+	if (!charstring::compareIgnoringCase(ptr,"current",7) &&
+				character::isWhitespace(ptr[7])) {
+		ptr=cont->skipWhitespaceAndComments(ptr+7);
+	}
+	return (!charstring::compareIgnoringCase(ptr,"schema",6) ||
+		!charstring::compareIgnoringCase(ptr,"sqlid",5) ||
+		!charstring::compareIgnoringCase(ptr,"path",4));
+}
+
+void db2connection::cacheStatement(SQLHSTMT stmt,
+					char *query, uint32_t length) {
+
+	// close any open result set and release the
+	// column and parameter bindings of the old cursor
+	SQLRETURN	closeerg=SQLFreeStmt(stmt,SQL_CLOSE);
+	SQLRETURN	unbinderg=SQLFreeStmt(stmt,SQL_UNBIND);
+	SQLRETURN	reseterg=SQLFreeStmt(stmt,SQL_RESET_PARAMS);
+
+	// if any of that failed, then the statement
+	// can't be reused, so just free it
+	if ((closeerg!=SQL_SUCCESS && closeerg!=SQL_SUCCESS_WITH_INFO) ||
+		(unbinderg!=SQL_SUCCESS && unbinderg!=SQL_SUCCESS_WITH_INFO) ||
+		(reseterg!=SQL_SUCCESS && reseterg!=SQL_SUCCESS_WITH_INFO)) {
+		SQLFreeHandle(SQL_HANDLE_STMT,stmt);
+		delete[] query;
+		return;
+	}
+
+	stmtcache.put(stmt,query,length);
+}
+
 const char *db2connection::getCurrentDatabaseQuery() {
 	return "values current schema";
 }
@@ -765,6 +835,9 @@ db2cursor::db2cursor(sqlrserverconnection *conn, uint16_t id) :
 	}
 	sqlnulldata=SQL_NULL_DATA;
 	bindformaterror=false;
+	stmtquery=NULL;
+	stmtquerylength=0;
+	stmtgeneration=0;
 	allocateResultSetBuffers(conn->cont->getMaxColumnCount());
 }
 
@@ -775,6 +848,7 @@ db2cursor::~db2cursor() {
 	delete[] outlobbindlen;
 	delete[] outisnullptr;
 	delete[] outisnull;
+	delete[] stmtquery;
 	deallocateResultSetBuffers();
 }
 
@@ -783,6 +857,7 @@ void db2cursor::allocateResultSetBuffers(int32_t columncount) {
 	if (!columncount) {
 		this->columncount=0;
 		field=NULL;
+		fieldlength=NULL;
 		loblocator=NULL;
 		loblength=NULL;
 		indicator=NULL;
@@ -793,18 +868,21 @@ void db2cursor::allocateResultSetBuffers(int32_t columncount) {
 	} else {
 		this->columncount=columncount;
 		field=new char *[columncount];
+		fieldlength=new uint32_t[columncount];
 		loblocator=new SQLINTEGER *[columncount];
 		loblength=new SQLINTEGER *[columncount];
 		indicator=new SQLINTEGER *[columncount];
 		uint32_t	fetchatonce=conn->cont->getFetchAtOnce();
-		uint32_t	maxfieldlength=conn->cont->getMaxFieldLength();
 		#if (DB2VERSION>7)
 		rowstat=new SQLUSMALLINT[fetchatonce];
 		#endif
 		column=new db2column[columncount];
 		for (int32_t i=0; i<columncount; i++) {
 			column[i].name=new char[4096];
-			field[i]=new char[fetchatonce*maxfieldlength];
+			// field buffers are allocated by sizeFieldBuffer(),
+			// once the size of the column is known
+			field[i]=NULL;
+			fieldlength[i]=0;
 			loblocator[i]=new SQLINTEGER[fetchatonce];
 			loblength[i]=new SQLINTEGER[fetchatonce];
 			indicator[i]=new SQLINTEGER[fetchatonce];
@@ -823,6 +901,7 @@ void db2cursor::deallocateResultSetBuffers() {
 		}
 		delete[] column;
 		delete[] field;
+		delete[] fieldlength;
 		delete[] loblocator;
 		delete[] loblength;
 		delete[] indicator;
@@ -884,6 +963,7 @@ bool db2cursor::close() {
 		SQLFreeHandle(SQL_HANDLE_STMT,stmt);
 		stmt=0;
 	}
+	invalidatePreparedStatement();
 
 	if (lobstmt) {
 		// free lob handle
@@ -901,9 +981,99 @@ bool db2cursor::prepareQuery(const char *query, uint32_t length) {
 	// initialize column count
 	ncols=0;
 
-	// prepare the query
+	// prepare the query, unless a statement that already
+	// has this query prepared is available
+	if (reusePreparedStatement(query,length)) {
+		return true;
+	}
+
+	// allocate a new statement, if this cursor's statement was cached
+	if (!open()) {
+		return false;
+	}
+
 	erg=SQLPrepare(stmt,(SQLCHAR *)query,length);
-	return (erg==SQL_SUCCESS || erg==SQL_SUCCESS_WITH_INFO);
+	if (erg!=SQL_SUCCESS && erg!=SQL_SUCCESS_WITH_INFO) {
+		return false;
+	}
+	if (db2conn->stmtcache.getSize()) {
+		stmtquery=charstring::duplicate(query,length);
+		stmtquerylength=length;
+		stmtgeneration=db2conn->stmtcache.getGeneration();
+	}
+	return true;
+}
+
+bool db2cursor::reusePreparedStatement(const char *query, uint32_t length) {
+
+	if (!db2conn->stmtcache.getSize()) {
+		return false;
+	}
+
+	// changing the current schema invalidates any cached statements
+	if (db2conn->changesSchema(query)) {
+		db2conn->stmtcache.clear();
+	}
+	if (stmtquery && stmtgeneration!=db2conn->stmtcache.getGeneration()) {
+		invalidatePreparedStatement();
+	}
+
+	// if this cursor's statement already has this query prepared,
+	// then just use it again
+	if (stmtquery && stmtquerylength==length &&
+			!bytestring::compare(stmtquery,query,length)) {
+		return true;
+	}
+
+	// otherwise, swap this cursor's statement for a cached statement
+	// that has this query prepared, if there is one, and put this
+	// cursor's statement in the cache for use later
+	SQLHSTMT	cachedstmt=0;
+	db2conn->stmtcache.take(query,length,&cachedstmt);
+	if (stmtquery) {
+		db2conn->cacheStatement(stmt,stmtquery,stmtquerylength);
+		stmtquery=NULL;
+		stmtquerylength=0;
+		stmt=0;
+		if (!cachedstmt) {
+			// prepareQuery() will allocate a new
+			// statement to prepare the query with
+			return false;
+		}
+		stmt=cachedstmt;
+	} else if (cachedstmt) {
+		SQLFreeHandle(SQL_HANDLE_STMT,stmt);
+		stmt=cachedstmt;
+	} else {
+		return false;
+	}
+
+	#if (DB2VERSION>7)
+	if (conn->cont->getMaxColumnCount()) {
+		// the cached statement's row status ptr
+		// points into the previous cursor's buffers
+		erg=SQLSetStmtAttr(stmt,SQL_ATTR_ROW_STATUS_PTR,
+					(SQLPOINTER)rowstat,0);
+		if (erg!=SQL_SUCCESS && erg!=SQL_SUCCESS_WITH_INFO) {
+			// if that failed, then evict the cached
+			// statement and prepare the query again
+			SQLFreeHandle(SQL_HANDLE_STMT,stmt);
+			stmt=0;
+			return false;
+		}
+	}
+	#endif
+
+	stmtquery=charstring::duplicate(query,length);
+	stmtquerylength=length;
+	stmtgeneration=db2conn->stmtcache.getGeneration();
+	return true;
+}
+
+void db2cursor::invalidatePreparedStatement() {
+	delete[] stmtquery;
+	stmtquery=NULL;
+	stmtquerylength=0;
 }
 
 void db2cursor::encodeBlob(stringbuffer *buffer,
@@ -1374,6 +1544,9 @@ bool db2cursor::executeQuery(const char *query, uint32_t length) {
 	if (erg!=SQL_SUCCESS &&
 		erg!=SQL_SUCCESS_WITH_INFO &&
 		erg!=SQL_NO_DATA) {
+		// don't reuse the statement, in case it failed
+		// because objects that it refers to have changed
+		invalidatePreparedStatement();
 		return false;
 	}
 
@@ -1505,9 +1678,10 @@ bool db2cursor::executeQuery(const char *query, uint32_t length) {
 						indicator[i]);
 				break;
 			default:
+				sizeFieldBuffer(i);
 				erg=SQLBindCol(stmt,i+1,SQL_C_CHAR,
 					field[i],
-					conn->cont->getMaxFieldLength(),
+					fieldlength[i],
 					indicator[i]);
 				break;
 		}
@@ -1699,6 +1873,32 @@ uint16_t db2cursor::getColumnTableLength(uint32_t i) {
 	return column[i].tablelength;
 }
 
+void db2cursor::sizeFieldBuffer(SQLSMALLINT col) {
+
+	// Size the buffer from the display size of the column, rather than
+	// using maxfieldlength for every column.  Allow up to 4 bytes per
+	// character, in case the data is converted to a multi-byte character
+	// set, and fall back to maxfieldlength if the size isn't known.
+	uint32_t	maxfieldlength=conn->cont->getMaxFieldLength();
+	uint32_t	size=maxfieldlength;
+	int32_t		displaysize=0;
+	SQLRETURN	result=SQLColAttribute(stmt,col+1,
+					SQL_COLUMN_DISPLAY_SIZE,
+					NULL,0,NULL,&displaysize);
+	if ((result==SQL_SUCCESS || result==SQL_SUCCESS_WITH_INFO) &&
+			displaysize>0 &&
+			(uint32_t)displaysize<(maxfieldlength-1)/4) {
+		size=displaysize*4+1;
+	}
+
+	// buffers only grow, so they can be reused by subsequent queries
+	if (size>fieldlength[col]) {
+		delete[] field[col];
+		field[col]=new char[conn->cont->getFetchAtOnce()*size];
+		fieldlength[col]=size;
+	}
+}
+
 bool db2cursor::noRowsToReturn() {
 	// if there are no columns, then there can't be any rows either
 	return (ncols)?false:true;
@@ -1786,7 +1986,7 @@ void db2cursor::getField(uint32_t col,
 	}
 
 	// handle normal datatypes
-	*fld=&field[col][rowgroupindex*conn->cont->getMaxFieldLength()];
+	*fld=&field[col][rowgroupindex*fieldlength[col]];
 	*fldlength=indicator[col][rowgroupindex];
 }
 
@@ -181,6 +181,9 @@ SQLRETURN (*SQLGetSubString)(SQLHSTMT hstmt,
 
 SQLRETURN (*SQLCloseCursor)(SQLHSTMT hStmt);
 
+SQLRETURN (*SQLFreeStmt)(SQLHSTMT hstmt,
+				SQLUSMALLINT fOption);
+
 
 // constants...
 #define	SQL_HANDLE_ENV	1
@@ -212,6 +215,10 @@ SQLRETURN (*SQLCloseCursor)(SQLHSTMT hStmt);
 #define	SQL_ATTR_ROW_STATUS_PTR	25
 #define	SQL_ATTR_ROW_ARRAY_SIZE	27
 
+#define	SQL_CLOSE		0
+#define	SQL_UNBIND		2
+#define	SQL_RESET_PARAMS	3
+
 #define	SQL_PARAM_INPUT		1
 #define	SQL_PARAM_OUTPUT	4
 
@@ -219,6 +226,7 @@ SQLRETURN (*SQLCloseCursor)(SQLHSTMT hStmt);
 #define	SQL_COLUMN_LENGTH		3
 #define	SQL_COLUMN_PRECISION		4
 #define	SQL_COLUMN_SCALE		5
+#define	SQL_COLUMN_DISPLAY_SIZE		6
 #define	SQL_COLUMN_NULLABLE		7
 #define	SQL_COLUMN_UNSIGNED		8
 #define	SQL_COLUMN_AUTO_INCREMENT	11
@@ -537,6 +545,10 @@ static bool loadLibraries(stringbuffer *errormessage, const char *db2path) {
 	SQLCloseCursor=(SQLRETURN (*)(SQLHSTMT hStmt))
 				lib.getSymbol("SQLCloseCursor");
 
+	SQLFreeStmt=(SQLRETURN (*)(SQLHSTMT hstmt,
+					SQLUSMALLINT fOption))
+				lib.getSymbol("SQLFreeStmt");
+
 	// success
 	return true;
 
@@ -13,6 +13,14 @@
 
 #include <ibase.h>
 
+// Firebird 4 and up can hand out OO API interfaces for ISC API statement and
+// transaction handles, so selects can open an IResultSet and fetch groups of
+// rows with fetchNext(), straight into the row group buffer.
+#if defined(FB_API_VER) && FB_API_VER>=40
+	#include <firebird/Interface.h>
+	#define FIREBIRD_FETCHNEXT 1
+#endif
+
 // for pow()
 #include <math.h>
 
@@ -43,6 +51,10 @@ struct fieldstruct {
 	bool		blobisopen;
 
 	short		nullindicator;
+
+	uint32_t	rowoffset;
+	uint32_t	rowlength;
+	uint32_t	rownulloffset;
 };
 
 struct datebind {
@@ -173,7 +185,21 @@ class SQLRSERVER_DLLSPEC firebirdcursor : public sqlrservercursor {
 		const char	*getColumnTable(uint32_t col);
 		uint16_t	getColumnTableLength(uint32_t col);
 		bool		noRowsToReturn();
+		bool		skipRow(bool *error);
 		bool		fetchRow(bool *error);
+		bool		fetchRowGroup(bool *error);
+		void		nextRow();
+		void		restoreField(uint32_t col);
+		void		layOutRowGroup(uint32_t fetchatonce);
+		void		allocateRowGroup(uint32_t fetchatonce);
+		#ifdef FIREBIRD_FETCHNEXT
+		bool		openResultSet(uint32_t fetchatonce);
+		Firebird::IMessageMetadata	*buildMetadata(
+					Firebird::IMessageMetadata *metadata,
+					XSQLDA ISC_FAR *sqlda);
+		bool		checkStatus();
+		#endif
+		void		closeCursor();
 		void		getField(uint32_t col,
 					const char **field,
 					uint64_t *fieldlength,
@@ -207,6 +233,18 @@ class SQLRSERVER_DLLSPEC firebirdcursor : public sqlrservercursor {
 		XSQLDA	ISC_FAR	*outsqlda;
 		fieldstruct	*field;
 
+		unsigned char	*rowgroup;
+		uint32_t	rowgroupsize;
+		uint32_t	rowlength;
+		uint32_t	rowgroupindex;
+		uint32_t	totalinrowgroup;
+
+		#ifdef FIREBIRD_FETCHNEXT
+		Firebird::IStatus		*oostatus;
+		Firebird::CheckStatusWrapper	*status;
+		Firebird::IResultSet		*resultset;
+		#endif
+
 		ISC_LONG	querytype;
 
 		firebirdconnection	*firebirdconn;
@@ -344,9 +382,6 @@ void firebirdconnection::handleConnectString() {
 	}
 
 	identity=cont->getConnectStringValue("identity");
-
-	// firebird doesn't support multi-row fetches
-	cont->setFetchAtOnce(1);
 }
 
 bool firebirdconnection::logIn(const char **err, const char **warning) {
@@ -765,6 +800,18 @@ firebirdcursor::firebirdcursor(sqlrserverconnection *conn, uint16_t id) :
 	outsqlda=NULL;
 	allocateResultSetBuffers(conn->cont->getMaxColumnCount());
 
+	rowgroup=NULL;
+	rowgroupsize=0;
+	rowlength=0;
+	rowgroupindex=0;
+	totalinrowgroup=0;
+
+	#ifdef FIREBIRD_FETCHNEXT
+	oostatus=fb_get_master_interface()->getStatus();
+	status=new Firebird::CheckStatusWrapper(oostatus);
+	resultset=NULL;
+	#endif
+
 	maxbindcount=conn->cont->getConfig()->getMaxBindCount();
 	outbindcount=0;
 
@@ -801,6 +848,12 @@ firebirdcursor::firebirdcursor(sqlrserverconnection *conn, uint16_t id) :
 }
 
 firebirdcursor::~firebirdcursor() {
+	closeCursor();
+	#ifdef FIREBIRD_FETCHNEXT
+	delete status;
+	oostatus->dispose();
+	#endif
+
 	delete[] inbindsqlda;
 	delete[] inbindblobid;
 	delete[] inbindblobhandle;
@@ -811,6 +864,8 @@ firebirdcursor::~firebirdcursor() {
 	delete[] outbindblobisopen;
 	delete[] outdatebind;
 
+	delete[] rowgroup;
+
 	deallocateResultSetBuffers();
 }
 
@@ -860,6 +915,7 @@ bool firebirdcursor::prepareQuery(const char *query, uint32_t length) {
 	bindformaterror=false;
 
 	// free the old statement if it exists
+	closeCursor();
 	if (stmt) {
 		isc_dsql_free_statement(firebirdconn->error,
 						&stmt,DSQL_drop);
@@ -1423,6 +1479,11 @@ void firebirdcursor::closeLobOutputBind(uint16_t index) {
 
 bool firebirdcursor::executeQuery(const char *query, uint32_t length) {
 
+	// reset the row group
+	closeCursor();
+	rowgroupindex=0;
+	totalinrowgroup=0;
+
 	// for commit or rollback, execute the API call and return
 	if (querytype==isc_info_sql_stmt_commit) {
 		return !isc_commit_retaining(firebirdconn->error,
@@ -1616,11 +1677,209 @@ bool firebirdcursor::executeQuery(const char *query, uint32_t length) {
 		}
 	}
 
+	// If we're fetching more than 1 row at a time, then lay out a row
+	// group buffer, large enough to hold fetchatonce rows.  The sqllen of
+	// each non-lob column was capped at maxfieldlength above, so that
+	// bounds the size of each row.
+	uint32_t	fetchatonce=conn->cont->getFetchAtOnce();
+	if (fetchatonce>1) {
+
+		#ifdef FIREBIRD_FETCHNEXT
+		// open selects with the OO API, and fetch
+		// groups of rows using IResultSet::fetchNext()
+		if (querytype==isc_info_sql_stmt_select) {
+			return openResultSet(fetchatonce);
+		}
+		#endif
+
+		layOutRowGroup(fetchatonce);
+	}
+
 	// Execute the query
 	return !isc_dsql_execute(firebirdconn->error,&firebirdconn->tr,
 							&stmt,1,inbindsqlda);
 }
 
+void firebirdcursor::layOutRowGroup(uint32_t fetchatonce) {
+
+	// lay out a copy of each column's data and null indicator, as they
+	// were described into the XSQLDA, one after another
+	rowlength=0;
+	for (uint16_t i=0; i<outsqlda->sqld; i++) {
+		field[i].rowoffset=rowlength;
+		field[i].rowlength=outsqlda->sqlvar[i].sqllen;
+		if ((outsqlda->sqlvar[i].sqltype&~1)==SQL_VARYING) {
+			// the first 2 bytes are the length in
+			// an SQL_VARYING field
+			field[i].rowlength+=sizeof(int16_t);
+		}
+		field[i].rownulloffset=rowlength+field[i].rowlength;
+		rowlength+=field[i].rowlength+sizeof(short);
+	}
+	allocateRowGroup(fetchatonce);
+}
+
+void firebirdcursor::allocateRowGroup(uint32_t fetchatonce) {
+	if (rowlength*fetchatonce>rowgroupsize) {
+		delete[] rowgroup;
+		rowgroupsize=rowlength*fetchatonce;
+		rowgroup=new unsigned char[rowgroupsize];
+	}
+}
+
+#ifdef FIREBIRD_FETCHNEXT
+bool firebirdcursor::openResultSet(uint32_t fetchatonce) {
+
+	// get OO API interfaces for the statement and transaction handles
+	Firebird::IStatement	*ostmt=NULL;
+	if (fb_get_statement_interface(firebirdconn->error,&ostmt,&stmt)) {
+		return false;
+	}
+	Firebird::ITransaction	*otr=NULL;
+	if (fb_get_transaction_interface(firebirdconn->error,
+						&otr,&firebirdconn->tr)) {
+		ostmt->release();
+		return false;
+	}
+
+	// Build messages that match the XSQLDA's.  The output columns were
+	// coerced and capped at maxfieldlength when they were described, and
+	// the input binds were given types when they were bound.
+	Firebird::IMessageMetadata	*inmeta=NULL;
+	Firebird::IMessageMetadata	*outmeta=NULL;
+	unsigned char			*inbuffer=NULL;
+	bool				retval=false;
+
+	status->init();
+	inmeta=buildMetadata(ostmt->getInputMetadata(status),inbindsqlda);
+	if (!inmeta) {
+		goto cleanup;
+	}
+	outmeta=buildMetadata(ostmt->getOutputMetadata(status),outsqlda);
+	if (!outmeta) {
+		goto cleanup;
+	}
+
+	// copy the input binds into the input message
+	inbuffer=new unsigned char[inmeta->getMessageLength(status)];
+	for (uint16_t i=0; i<inbindsqlda->sqld; i++) {
+		XSQLVAR	*var=&inbindsqlda->sqlvar[i];
+		short	nullindicator=(var->sqlind)?*var->sqlind:0;
+		bytestring::copy(inbuffer+inmeta->getOffset(status,i),
+						var->sqldata,var->sqllen);
+		bytestring::copy(inbuffer+inmeta->getNullOffset(status,i),
+						&nullindicator,sizeof(short));
+	}
+
+	// lay out the row group to match the output message,
+	// so fetchNext() can fetch each row straight into it
+	for (uint16_t i=0; i<outsqlda->sqld; i++) {
+		field[i].rowoffset=outmeta->getOffset(status,i);
+		field[i].rowlength=outmeta->getLength(status,i);
+		if ((outsqlda->sqlvar[i].sqltype&~1)==SQL_VARYING) {
+			// the first 2 bytes are the length in
+			// an SQL_VARYING field
+			field[i].rowlength+=sizeof(int16_t);
+		}
+		field[i].rownulloffset=outmeta->getNullOffset(status,i);
+	}
+	rowlength=outmeta->getAlignedLength(status);
+	if (!checkStatus()) {
+		goto cleanup;
+	}
+	allocateRowGroup(fetchatonce);
+
+	// open the cursor
+	resultset=ostmt->openCursor(status,otr,inmeta,inbuffer,outmeta,0);
+	retval=checkStatus();
+
+cleanup:
+	delete[] inbuffer;
+	if (outmeta) {
+		outmeta->release();
+	}
+	if (inmeta) {
+		inmeta->release();
+	}
+	otr->release();
+	ostmt->release();
+	return retval;
+}
+
+Firebird::IMessageMetadata *firebirdcursor::buildMetadata(
+					Firebird::IMessageMetadata *metadata,
+					XSQLDA ISC_FAR *sqlda) {
+	if (!checkStatus()) {
+		return NULL;
+	}
+
+	// start with the statement's own metadata, to keep the names
+	// and character sets, and then override the types and lengths
+	Firebird::IMetadataBuilder	*builder=metadata->getBuilder(status);
+	metadata->release();
+	if (!checkStatus()) {
+		return NULL;
+	}
+	builder->truncate(status,sqlda->sqld);
+	for (uint16_t i=0; i<sqlda->sqld; i++) {
+		XSQLVAR	*var=&sqlda->sqlvar[i];
+		builder->setType(status,i,var->sqltype);
+		builder->setSubType(status,i,var->sqlsubtype);
+		builder->setLength(status,i,var->sqllen);
+		builder->setScale(status,i,var->sqlscale);
+	}
+	Firebird::IMessageMetadata	*result=builder->getMetadata(status);
+	builder->release();
+	if (!checkStatus()) {
+		return NULL;
+	}
+	return result;
+}
+
+bool firebirdcursor::checkStatus() {
+
+	if (!(status->getState()&Firebird::IStatus::STATE_ERRORS)) {
+		return true;
+	}
+
+	// Copy the error into the ISC status vector, where errorMessage()
+	// expects to find it.  Any strings that it refers to stay in
+	// oostatus until it's used again.
+	const intptr_t	*errors=status->getErrors();
+	uint16_t	i=0;
+	for (;;) {
+		uint16_t	itemsize=(errors[i]==isc_arg_end)?1:
+					(errors[i]==isc_arg_cstring)?3:2;
+		if (errors[i]==isc_arg_end ||
+			i+itemsize>=sizeof(firebirdconn->error)/
+						sizeof(ISC_STATUS)) {
+			break;
+		}
+		for (uint16_t j=0; j<itemsize; j++) {
+			firebirdconn->error[i+j]=errors[i+j];
+		}
+		i=i+itemsize;
+	}
+	firebirdconn->error[i]=isc_arg_end;
+	return false;
+}
+#endif
+
+void firebirdcursor::closeCursor() {
+	#ifdef FIREBIRD_FETCHNEXT
+	// close the OO API result set, if one was opened
+	// (close() releases it, unless it fails)
+	if (resultset) {
+		status->init();
+		resultset->close(status);
+		if (status->getState()&Firebird::IStatus::STATE_ERRORS) {
+			resultset->release();
+		}
+		resultset=NULL;
+	}
+	#endif
+}
+
 void firebirdcursor::errorMessage(char *errorbuffer,
 					uint32_t errorbufferlength,
 					uint32_t *errorlength,
@@ -1783,32 +2042,145 @@ bool firebirdcursor::noRowsToReturn() {
 	return (queryisexecsp)?true:!outsqlda->sqld;
 }
 
+bool firebirdcursor::skipRow(bool *error) {
+	if (fetchRow(error)) {
+		nextRow();
+		return true;
+	}
+	return false;
+}
+
 bool firebirdcursor::fetchRow(bool *error) {
 
 	*error=false;
 
-	ISC_STATUS	retcode=isc_dsql_fetch(firebirdconn->error,
+	// fetch 1 row at a time, if we're not fetching groups of rows
+	uint32_t	fetchatonce=conn->cont->getFetchAtOnce();
+	if (fetchatonce<2) {
+
+		ISC_STATUS	retcode=isc_dsql_fetch(firebirdconn->error,
 							&stmt,1,outsqlda);
 
-	// success
-	if (!retcode) {
-		return true;
+		// success
+		if (!retcode) {
+			return true;
+		}
+
+		// no more rows
+		if (retcode==100) {
+			return false;
+		}
+
+		// error
+		*error=true;
+		return false;
 	}
 
-	// no more rows
-	if (retcode==100) {
+	if (rowgroupindex==fetchatonce) {
+		rowgroupindex=0;
+	}
+	if (rowgroupindex>0 && rowgroupindex==totalinrowgroup) {
 		return false;
 	}
+	if (!rowgroupindex) {
+		return fetchRowGroup(error);
+	}
+	return true;
+}
 
-	// error
-	*error=true;
-	return false;
+bool firebirdcursor::fetchRowGroup(bool *error) {
+
+	// Fetch up to fetchatonce rows into the row group buffer.  The data is
+	// converted to strings later, when getField() is called.
+	uint32_t	fetchatonce=conn->cont->getFetchAtOnce();
+	totalinrowgroup=0;
+	while (totalinrowgroup<fetchatonce) {
+
+		unsigned char	*row=rowgroup+totalinrowgroup*rowlength;
+
+		#ifdef FIREBIRD_FETCHNEXT
+		// fetch straight into the row group,
+		// if the OO API opened the result set
+		if (resultset) {
+
+			status->init();
+			int	result=resultset->fetchNext(status,row);
+
+			// no more rows
+			if (result==Firebird::IStatus::RESULT_NO_DATA) {
+				break;
+			}
+
+			// error
+			if (result!=Firebird::IStatus::RESULT_OK) {
+				checkStatus();
+				totalinrowgroup=0;
+				*error=true;
+				return false;
+			}
+
+			totalinrowgroup++;
+			continue;
+		}
+		#endif
+
+		ISC_STATUS	retcode=isc_dsql_fetch(firebirdconn->error,
+							&stmt,1,outsqlda);
+
+		// no more rows
+		if (retcode==100) {
+			break;
+		}
+
+		// error
+		if (retcode) {
+			totalinrowgroup=0;
+			*error=true;
+			return false;
+		}
+
+		// copy the data and null indicator of each
+		// column out of the XSQLDA and into the row group
+		for (uint16_t i=0; i<outsqlda->sqld; i++) {
+			bytestring::copy(row+field[i].rowoffset,
+						outsqlda->sqlvar[i].sqldata,
+						field[i].rowlength);
+			bytestring::copy(row+field[i].rownulloffset,
+						&field[i].nullindicator,
+						sizeof(short));
+		}
+		totalinrowgroup++;
+	}
+	return (totalinrowgroup>0);
+}
+
+void firebirdcursor::nextRow() {
+	rowgroupindex++;
+}
+
+void firebirdcursor::restoreField(uint32_t col) {
+
+	// copy the data and null indicator for the current row
+	// from the row group back to where the XSQLDA points
+	const unsigned char	*row=rowgroup+rowgroupindex*rowlength;
+	bytestring::copy(outsqlda->sqlvar[col].sqldata,
+					row+field[col].rowoffset,
+					field[col].rowlength);
+	bytestring::copy(&field[col].nullindicator,
+					row+field[col].rownulloffset,
+					sizeof(short));
 }
 
 void firebirdcursor::getField(uint32_t col,
 				const char **fld, uint64_t *fldlength,
 				bool *blob, bool *null) {
 
+	// if we fetched a group of rows, then get the
+	// value of this field for the current row
+	if (totalinrowgroup) {
+		restoreField(col);
+	}
+
 	// handle a null field
 	if ((outsqlda->sqlvar[col].sqltype & 1) && 
 			field[col].nullindicator==-1) {
@@ -2089,21 +2461,22 @@ bool firebirdcursor::getLobFieldSegment(uint32_t col,
 		field[col].blobisopen=true;
 	}
 
-	// read a blob segment, at most MAX_LOB_CHUNK_SIZE bytes at a time
+	// Read blob segments, at most MAX_LOB_CHUNK_SIZE bytes at a time,
+	// until the buffer is full or we reach the end of the blob.  Blobs
+	// are often stored in small segments (80 bytes by default) and
+	// isc_get_segment() returns at most 1 segment per call, so keep
+	// reading rather than returning after the first short segment.
 	uint64_t	totalbytesread=0;
 	uint64_t	bytestoread=0;
-	uint64_t	remainingbytestoread=charstoread;
 	ISC_STATUS	status=0;
-	for (;;) {
+	while (totalbytesread<charstoread) {
 
 		// figure out how many bytes to read this time
-		if (remainingbytestoread<MAX_LOB_CHUNK_SIZE) {
-			bytestoread=remainingbytestoread;
-		} else {
+		bytestoread=charstoread-totalbytesread;
+		if (bytestoread>MAX_LOB_CHUNK_SIZE) {
 			bytestoread=MAX_LOB_CHUNK_SIZE;
-			remainingbytestoread=remainingbytestoread-
-						MAX_LOB_CHUNK_SIZE;
 		}
+
 		// read the bytes
 		uint16_t	bytesread=0;
 		status=isc_get_segment(firebirdconn->error,
@@ -2112,7 +2485,7 @@ bool firebirdcursor::getLobFieldSegment(uint32_t col,
 					bytestoread,
 					buffer+totalbytesread);
 
-		// bail on error
+		// bail on error or end of blob
 		if (status && status!=isc_segment) {
 			break;
 		}
@@ -2120,8 +2493,8 @@ bool firebirdcursor::getLobFieldSegment(uint32_t col,
 		// update total bytes read
 		totalbytesread=totalbytesread+bytesread;
 
-		// bail if we're done reading
-		if (bytesread<bytestoread || totalbytesread==charstoread) {
+		// bail if nothing was read
+		if (!bytesread) {
 			break;
 		}
 	}
@@ -2147,7 +2520,10 @@ void firebirdcursor::closeLobField(uint32_t col) {
 }
 
 void firebirdcursor::closeResultSet() {
+	closeCursor();
 	outbindcount=0;
+	rowgroupindex=0;
+	totalinrowgroup=0;
 	if (!conn->cont->getMaxColumnCount()) {
 		deallocateResultSetBuffers();
 	}
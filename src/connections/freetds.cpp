@@ -7,6 +7,7 @@
 #include <rudiments/charstring.h>
 #include <rudiments/character.h>
 #include <rudiments/bytestring.h>
+#include <rudiments/bytebuffer.h>
 #include <rudiments/stdio.h>
 #include <rudiments/snooze.h>
 
@@ -16,6 +17,9 @@
 
 extern "C" {
 	#include <ctpublic.h>
+	#ifdef HAVE_FREETDS_BLK
+		#include <bkpublic.h>
+	#endif
 }
 
 #ifdef HAVE_FREETDS_H
@@ -80,6 +84,14 @@ struct datebind {
 
 class freetdsconnection;
 
+#ifdef HAVE_FREETDS_BLK
+struct blkerror {
+	uint32_t	row;
+	int64_t		errorcode;
+	stringbuffer	error;
+};
+#endif
+
 class SQLRSERVER_DLLSPEC freetdscursor : public sqlrservercursor {
 	friend class freetdsconnection;
 	private:
@@ -157,6 +169,20 @@ class SQLRSERVER_DLLSPEC freetdscursor : public sqlrservercursor {
 		#endif
 		bool		executeQuery(const char *query,
 						uint32_t length);
+		#ifdef HAVE_FREETDS_BLK
+		uint32_t	getArrayBindSize();
+		bool		arrayBindRow();
+		uint32_t	getArrayBindRowCount();
+		bool		executeArrayQuery(const char *query,
+							uint32_t length);
+		uint32_t	getArrayErrorCount();
+		bool		getArrayError(uint32_t index,
+						uint32_t *row,
+						int64_t *errorcode,
+						const char **error,
+						uint32_t *errorlength);
+		bool		getBulkCopyTable();
+		#endif
 		bool		knowsAffectedRows();
 		uint64_t	affectedRows();
 		uint32_t	colCount();
@@ -231,6 +257,19 @@ class SQLRSERVER_DLLSPEC freetdscursor : public sqlrservercursor {
 		bool		prepared;
 		bool		clean;
 
+		#ifdef HAVE_FREETDS_BLK
+		CS_BLKDESC	*blkdesc;
+		stringbuffer	blktable;
+		uint16_t	blkcolcount;
+		CS_INT		*blkcoltype;
+		uint32_t	blkrowcount;
+		bytebuffer	blkvalues;
+		CS_INT		*blklength;
+		CS_SMALLINT	*blkindicator;
+		blkerror	*blkerrors;
+		uint32_t	blkerrorcount;
+		#endif
+
 		freetdsconnection	*freetdsconn;
 };
 
@@ -283,6 +322,9 @@ class SQLRSERVER_DLLSPEC freetdsconnection : public sqlrserverconnection {
 		const char	*language;
 		const char	*hostname;
 		const char	*packetsize;
+		#ifdef HAVE_FREETDS_BLK
+		uint32_t	bcpbatchsize;
+		#endif
 
 		const char	*identity;
 
@@ -316,6 +358,9 @@ freetdsconnection::freetdsconnection(sqlrservercontroller *cont) :
 						sqlrserverconnection(cont) {
 	dbused=false;
 	dbversion=NULL;
+	#ifdef HAVE_FREETDS_BLK
+	bcpbatchsize=0;
+	#endif
 	sybasedb=true;
 
 	identity=NULL;
@@ -338,6 +383,10 @@ void freetdsconnection::handleConnectString() {
 	language=cont->getConnectStringValue("language");
 	hostname=cont->getConnectStringValue("hostname");
 	packetsize=cont->getConnectStringValue("packetsize");
+	#ifdef HAVE_FREETDS_BLK
+	bcpbatchsize=charstring::toUnsignedInteger(
+			cont->getConnectStringValue("bcpbatchsize"));
+	#endif
 
 	// freetds doesn't currently support array fetches
 	cont->setFetchAtOnce(1);
@@ -477,6 +526,18 @@ bool freetdsconnection::logIn(const char **error, const char **warning) {
 		return false;
 	}
 
+	#ifdef HAVE_FREETDS_BLK
+	// enable bulk copies
+	CS_BOOL	bulklogin=CS_TRUE;
+	if (bcpbatchsize>1 &&
+		ct_con_props(dbconn,CS_SET,CS_BULK_LOGIN,
+			(CS_VOID *)&bulklogin,CS_UNUSED,
+			(CS_INT *)NULL)!=CS_SUCCEED) {
+		*error=logInError("Failed to enable bulk copies",5);
+		return false;
+	}
+	#endif
+
 	// set packetsize
 	uint16_t	ps=charstring::toInteger(packetsize);
 	if (!charstring::isNullOrEmpty(packetsize) &&
@@ -907,6 +968,17 @@ freetdscursor::freetdscursor(sqlrserverconnection *conn, uint16_t id) :
 	languagecmd=NULL;
 	cursorcmd=NULL;
 
+	#ifdef HAVE_FREETDS_BLK
+	blkdesc=NULL;
+	blkcolcount=0;
+	blkcoltype=NULL;
+	blkrowcount=0;
+	blklength=NULL;
+	blkindicator=NULL;
+	blkerrors=NULL;
+	blkerrorcount=0;
+	#endif
+
 	cursornamelength=charstring::integerLength(id);
 	cursorname=charstring::parseNumber(id);
 
@@ -950,6 +1022,12 @@ freetdscursor::~freetdscursor() {
 	delete[] outbindints;
 	delete[] outbinddoubles;
 	delete[] outbinddates;
+	#ifdef HAVE_FREETDS_BLK
+	delete[] blkcoltype;
+	delete[] blklength;
+	delete[] blkindicator;
+	delete[] blkerrors;
+	#endif
 
 	deallocateResultSetBuffers();
 }
@@ -1080,6 +1158,12 @@ bool freetdscursor::close() {
 		retval=(retval && (ct_cmd_drop(cursorcmd)==CS_SUCCEED));
 		cursorcmd=NULL;
 	}
+	#ifdef HAVE_FREETDS_BLK
+	if (blkdesc) {
+		retval=(retval && (blk_drop(blkdesc)==CS_SUCCEED));
+		blkdesc=NULL;
+	}
+	#endif
 	cmd=NULL;
 	return retval;
 }
@@ -1789,6 +1873,285 @@ bool freetdscursor::knowsAffectedRows() {
 	return knowsaffectedrows;
 }
 
+#ifdef HAVE_FREETDS_BLK
+uint32_t freetdscursor::getArrayBindSize() {
+	return freetdsconn->bcpbatchsize;
+}
+
+bool freetdscursor::getBulkCopyTable() {
+
+	// get the table from "insert into table values (...)"
+	const char	*ptr=conn->cont->skipWhitespaceAndComments(query);
+	if (charstring::compareIgnoringCase(ptr,"insert",6) ||
+				!character::isWhitespace(ptr[6])) {
+		return false;
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+6);
+	if (charstring::compareIgnoringCase(ptr,"into",4) ||
+				!character::isWhitespace(ptr[4])) {
+		return false;
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+4);
+	const char	*start=ptr;
+	while (*ptr && !character::isWhitespace(*ptr) && *ptr!='(') {
+		ptr++;
+	}
+	if (ptr==start) {
+		return false;
+	}
+	blktable.clear();
+	blktable.append(start,ptr-start);
+
+	// Bulk copies supply every column of the table, in order, from the
+	// bind variables, so only inserts whose values list is made up of
+	// every bind variable, in the order that they were bound, can be
+	// bulk copied.  Inserts with an explicit column list, or with
+	// literals, expressions or reordered bind variables in the values
+	// list, can't be.
+	ptr=conn->cont->skipWhitespaceAndComments(ptr);
+	if (charstring::compareIgnoringCase(ptr,"values",6)) {
+		return false;
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+6);
+	if (*ptr!='(') {
+		return false;
+	}
+	uint16_t		inbindcount=getInputBindCount();
+	sqlrserverbindvar	*inbinds=getInputBinds();
+	if (!inbindcount) {
+		return false;
+	}
+	for (uint16_t i=0; i<inbindcount; i++) {
+
+		// skip the ( or , before the value
+		ptr=conn->cont->skipWhitespaceAndComments(ptr+1);
+
+		// the value must be this bind variable...
+		if (charstring::compare(ptr,inbinds[i].variable,
+						inbinds[i].variablesize)) {
+			return false;
+		}
+		ptr=conn->cont->skipWhitespaceAndComments(
+					ptr+inbinds[i].variablesize);
+
+		// ...and nothing else
+		if (*ptr!=((i<inbindcount-1)?',':')')) {
+			return false;
+		}
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+1);
+	return (!*ptr);
+}
+
+bool freetdscursor::arrayBindRow() {
+
+	uint16_t		inbindcount=getInputBindCount();
+	sqlrserverbindvar	*inbinds=getInputBinds();
+	uint32_t		batchsize=freetdsconn->bcpbatchsize;
+	uint16_t		maxbindcount=
+				conn->cont->getConfig()->getMaxBindCount();
+
+	// bail if the batch is full or if there are too many binds
+	if (blkrowcount==batchsize || inbindcount>maxbindcount) {
+		return false;
+	}
+
+	// allocate buffers on first use
+	if (!blkcoltype) {
+		blkcoltype=new CS_INT[maxbindcount];
+		blklength=new CS_INT[maxbindcount*batchsize];
+		blkindicator=new CS_SMALLINT[maxbindcount*batchsize];
+		blkerrors=new blkerror[batchsize];
+	}
+
+	// on the first row, get the table and the type of each column,
+	// subsequent rows must have the same number of columns
+	if (!blkrowcount) {
+		if (!getBulkCopyTable()) {
+			return false;
+		}
+		blkcolcount=inbindcount;
+		blkvalues.clear();
+		for (uint16_t i=0; i<inbindcount; i++) {
+			blkcoltype[i]=
+				(inbinds[i].type==SQLRSERVERBINDVARTYPE_BLOB)?
+						CS_BINARY_TYPE:CS_CHAR_TYPE;
+		}
+	} else if (inbindcount!=blkcolcount) {
+		return false;
+	}
+
+	// append the values to the batch, as strings, and let
+	// the bulk copy library convert them to the column types
+	for (uint16_t i=0; i<inbindcount; i++) {
+
+		sqlrserverbindvar	*inbind=&(inbinds[i]);
+		uint32_t		index=blkrowcount*maxbindcount+i;
+		size_t			before=blkvalues.getSize();
+
+		if (conn->bindValueIsNull(inbind->isnull)) {
+			blkindicator[index]=-1;
+			blklength[index]=0;
+			continue;
+		}
+
+		char	*str=NULL;
+		char	date[64];
+		switch (inbind->type) {
+			case SQLRSERVERBINDVARTYPE_STRING:
+			case SQLRSERVERBINDVARTYPE_CLOB:
+			case SQLRSERVERBINDVARTYPE_BLOB:
+				blkvalues.append((const unsigned char *)
+						inbind->value.stringval,
+						inbind->valuesize);
+				break;
+			case SQLRSERVERBINDVARTYPE_INTEGER:
+				str=charstring::parseNumber(
+						inbind->value.integerval);
+				blkvalues.append((const unsigned char *)str,
+						charstring::length(str));
+				break;
+			case SQLRSERVERBINDVARTYPE_DOUBLE:
+				str=charstring::parseNumber(
+					inbind->value.doubleval.value,
+					inbind->value.doubleval.precision,
+					inbind->value.doubleval.scale);
+				blkvalues.append((const unsigned char *)str,
+						charstring::length(str));
+				break;
+			case SQLRSERVERBINDVARTYPE_DATE:
+				charstring::printf(date,sizeof(date),
+					"%04d-%02d-%02d %02d:%02d:%02d.%03d",
+					(int)inbind->value.dateval.year,
+					inbind->value.dateval.month,
+					inbind->value.dateval.day,
+					inbind->value.dateval.hour,
+					inbind->value.dateval.minute,
+					inbind->value.dateval.second,
+					inbind->value.dateval.microsecond/1000);
+				blkvalues.append((const unsigned char *)date,
+						charstring::length(date));
+				break;
+			default:
+				return false;
+		}
+		delete[] str;
+
+		blkindicator[index]=0;
+		blklength[index]=blkvalues.getSize()-before;
+	}
+
+	blkrowcount++;
+	return true;
+}
+
+uint32_t freetdscursor::getArrayBindRowCount() {
+	return blkrowcount;
+}
+
+bool freetdscursor::executeArrayQuery(const char *query, uint32_t length) {
+
+	// reset the row and error counters
+	CS_INT		outrows=0;
+	uint32_t	rows=blkrowcount;
+	blkrowcount=0;
+	blkerrorcount=0;
+	affectedrows=0;
+
+	if (!rows) {
+		return true;
+	}
+
+	// clear out any errors
+	freetdsconn->errorcode=0;
+	freetdsconn->liveconnection=true;
+
+	// allocate a bulk copy descriptor, if necessary
+	if (!blkdesc && blk_alloc(freetdsconn->dbconn,
+				BLK_VERSION_100,&blkdesc)!=CS_SUCCEED) {
+		return false;
+	}
+
+	// start the bulk copy
+	if (blk_init(blkdesc,CS_BLK_IN,
+			(CS_CHAR *)blktable.getString(),
+			(CS_INT)blktable.getStringLength())!=CS_SUCCEED) {
+		return false;
+	}
+
+	// send the rows...
+	uint16_t		maxbindcount=
+				conn->cont->getConfig()->getMaxBindCount();
+	const unsigned char	*value=blkvalues.getBuffer();
+	for (uint32_t r=0; r<rows; r++) {
+
+		// bind the columns to the values for this row
+		for (uint16_t i=0; i<blkcolcount; i++) {
+
+			uint32_t	index=r*maxbindcount+i;
+
+			CS_DATAFMT	fmt;
+			bytestring::zero(&fmt,sizeof(fmt));
+			fmt.datatype=blkcoltype[i];
+			fmt.format=CS_FMT_UNUSED;
+			fmt.maxlength=blklength[index];
+			fmt.count=1;
+			fmt.locale=NULL;
+
+			if (blk_bind(blkdesc,i+1,&fmt,(CS_VOID *)value,
+					&blklength[index],
+					&blkindicator[index])!=CS_SUCCEED) {
+				blk_done(blkdesc,CS_BLK_CANCEL,&outrows);
+				return false;
+			}
+			value+=blklength[index];
+		}
+
+		// Send the row.  If it fails (eg. because a value couldn't
+		// be converted) then keep track of the error and move on.
+		if (blk_rowxfer(blkdesc)!=CS_SUCCEED) {
+			if (!freetdsconn->liveconnection) {
+				blk_done(blkdesc,CS_BLK_CANCEL,&outrows);
+				return false;
+			}
+			blkerror	*be=&(blkerrors[blkerrorcount++]);
+			be->row=r;
+			be->errorcode=freetdsconn->errorcode;
+			be->error.clear();
+			be->error.append(freetdsconn->errorstring.getString());
+			freetdsconn->errorcode=0;
+		}
+	}
+
+	// finish the bulk copy, if this fails then the entire batch failed
+	if (blk_done(blkdesc,CS_BLK_ALL,&outrows)!=CS_SUCCEED) {
+		return false;
+	}
+	affectedrows=outrows;
+	return true;
+}
+
+uint32_t freetdscursor::getArrayErrorCount() {
+	return blkerrorcount;
+}
+
+bool freetdscursor::getArrayError(uint32_t index,
+					uint32_t *row,
+					int64_t *errorcode,
+					const char **error,
+					uint32_t *errorlength) {
+	if (index>=blkerrorcount) {
+		return false;
+	}
+	blkerror	*be=&(blkerrors[index]);
+	*row=be->row;
+	*errorcode=be->errorcode;
+	*error=be->error.getString();
+	*errorlength=be->error.getStringLength();
+	return true;
+}
+#endif
+
 uint64_t freetdscursor::affectedRows() {
 	return affectedrows;
 }
@@ -2,7 +2,9 @@
 // See the file COPYING for more information
 
 #include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlrstatementcache.h>
 #include <rudiments/environment.h>
+#include <rudiments/bytestring.h>
 
 #include <datatypes.h>
 #include <defines.h>
@@ -62,6 +64,9 @@ class SQLRSERVER_DLLSPEC informixcursor : public sqlrservercursor {
 		bool		close();
 		bool		prepareQuery(const char *query,
 						uint32_t length);
+		bool		reusePreparedStatement(const char *query,
+							uint32_t length);
+		void		invalidatePreparedStatement();
 		bool		inputBind(const char *variable, 
 						uint16_t variablesize,
 						const char *value, 
@@ -165,6 +170,7 @@ class SQLRSERVER_DLLSPEC informixcursor : public sqlrservercursor {
 		uint16_t	getColumnIsAutoIncrement(uint32_t i);
 		const char	*getColumnTable(uint32_t i);
 		uint16_t	getColumnTableLength(uint32_t i);
+		void		sizeFieldBuffer(SQLSMALLINT col);
 		bool		noRowsToReturn();
 		bool		skipRow(bool *error);
 		bool		fetchRow(bool *error);
@@ -189,6 +195,7 @@ class SQLRSERVER_DLLSPEC informixcursor : public sqlrservercursor {
 
 		int32_t		columncount;
 		char		**field;
+		uint32_t	*fieldlength;
 		SQLLEN		**loblength;
 		SQLLEN		**indicator;
 		informixcolumn	*column;
@@ -212,6 +219,10 @@ class SQLRSERVER_DLLSPEC informixcursor : public sqlrservercursor {
 
 		bool		bindformaterror;
 
+		char		*stmtquery;
+		uint32_t	stmtquerylength;
+		uint32_t	stmtgeneration;
+
 		stringbuffer	errormsg;
 
 		informixconnection	*informixconn;
@@ -260,6 +271,11 @@ class SQLRSERVER_DLLSPEC informixconnection : public sqlrserverconnection {
 		const char	*noopQuery();
 		const char	*bindFormat();
 
+		bool		changesDatabase(const char *query);
+		void		cacheStatement(SQLHSTMT stmt,
+							char *query,
+							uint32_t length);
+
 		SQLHENV		env;
 		SQLRETURN	erg;
 		SQLHDBC		dbc;
@@ -276,13 +292,20 @@ class SQLRSERVER_DLLSPEC informixconnection : public sqlrserverconnection {
 
 		const char	*identity;
 
+		sqlrstatementcache< SQLHSTMT >	stmtcache;
+
 		char		dbversion[512];
 
 		stringbuffer	errormsg;
 };
 
+static void freeStatement(SQLHSTMT stmt) {
+	SQLFreeHandle(SQL_HANDLE_STMT,stmt);
+}
+
 informixconnection::informixconnection(sqlrservercontroller *cont) :
-					sqlrserverconnection(cont) {
+					sqlrserverconnection(cont),
+					stmtcache(freeStatement) {
 
 	maxoutbindlobsize=MAX_OUT_BIND_LOB_SIZE;
 	identity=NULL;
@@ -342,6 +365,9 @@ void informixconnection::handleConnectString() {
 		maxoutbindlobsize=MAX_OUT_BIND_LOB_SIZE;
 	}
 	identity=cont->getConnectStringValue("identity");
+
+	stmtcache.setSize(charstring::toUnsignedInteger(
+			cont->getConnectStringValue("stmtcachesize")));
 }
 
 bool informixconnection::logIn(const char **error, const char **warning) {
@@ -455,6 +481,7 @@ void informixconnection::deleteCursor(sqlrservercursor *curs) {
 }
 
 void informixconnection::logOut() {
+	stmtcache.clear();
 	SQLDisconnect(dbc);
 	SQLFreeHandle(SQL_HANDLE_DBC,dbc);
 	SQLFreeHandle(SQL_HANDLE_ENV,env);
@@ -765,6 +792,40 @@ const char *informixconnection::selectDatabaseQuery() {
 	return "database %s";
 }
 
+bool informixconnection::changesDatabase(const char *query) {
+
+	// prepared statements belong to the database that was current
+	// when they were prepared, so look for "database ..." and
+	// "close database"
+	const char	*ptr=cont->skipWhitespaceAndComments(query);
+	if (!charstring::compareIgnoringCase(ptr,"close",5)) {
+		ptr=cont->skipWhitespaceAndComments(ptr+5);
+	}
+	return !charstring::compareIgnoringCase(ptr,"database",8);
+}
+
+void informixconnection::cacheStatement(SQLHSTMT stmt,
+					char *query, uint32_t length) {
+
+	// close any open result set and release the
+	// column and parameter bindings of the old cursor
+	SQLRETURN	closeerg=SQLFreeStmt(stmt,SQL_CLOSE);
+	SQLRETURN	unbinderg=SQLFreeStmt(stmt,SQL_UNBIND);
+	SQLRETURN	reseterg=SQLFreeStmt(stmt,SQL_RESET_PARAMS);
+
+	// if any of that failed, then the statement
+	// can't be reused, so just free it
+	if ((closeerg!=SQL_SUCCESS && closeerg!=SQL_SUCCESS_WITH_INFO) ||
+		(unbinderg!=SQL_SUCCESS && unbinderg!=SQL_SUCCESS_WITH_INFO) ||
+		(reseterg!=SQL_SUCCESS && reseterg!=SQL_SUCCESS_WITH_INFO)) {
+		SQLFreeHandle(SQL_HANDLE_STMT,stmt);
+		delete[] query;
+		return;
+	}
+
+	stmtcache.put(stmt,query,length);
+}
+
 const char *informixconnection::getCurrentDatabaseQuery() {
 	return "select dbinfo('dbname') from sysmaster:sysdual";
 }
@@ -803,6 +864,9 @@ informixcursor::informixcursor(sqlrserverconnection *conn, uint16_t id) :
 	}
 	sqlnulldata=SQL_NULL_DATA;
 	bindformaterror=false;
+	stmtquery=NULL;
+	stmtquerylength=0;
+	stmtgeneration=0;
 	allocateResultSetBuffers(conn->cont->getMaxColumnCount());
 	truevalue=SQL_TRUE;
 }
@@ -814,6 +878,7 @@ informixcursor::~informixcursor() {
 	delete[] outlobbindlen;
 	delete[] outisnullptr;
 	delete[] outisnull;
+	delete[] stmtquery;
 	deallocateResultSetBuffers();
 }
 
@@ -822,20 +887,24 @@ void informixcursor::allocateResultSetBuffers(int32_t columncount) {
 	if (!columncount) {
 		this->columncount=0;
 		field=NULL;
+		fieldlength=NULL;
 		loblength=NULL;
 		indicator=NULL;
 		column=NULL;
 	} else {
 		this->columncount=columncount;
 		field=new char *[columncount];
+		fieldlength=new uint32_t[columncount];
 		loblength=new SQLLEN *[columncount];
 		indicator=new SQLLEN *[columncount];
 		column=new informixcolumn[columncount];
 		uint32_t	fetchatonce=conn->cont->getFetchAtOnce();
-		int32_t		maxfieldlength=conn->cont->getMaxFieldLength();
 		for (int32_t i=0; i<columncount; i++) {
 			column[i].name=new char[4096];
-			field[i]=new char[fetchatonce*maxfieldlength];
+			// field buffers are allocated by sizeFieldBuffer(),
+			// once the size of the column is known
+			field[i]=NULL;
+			fieldlength[i]=0;
 			loblength[i]=new SQLLEN[fetchatonce];
 			indicator[i]=new SQLLEN[fetchatonce];
 		}
@@ -852,6 +921,7 @@ void informixcursor::deallocateResultSetBuffers() {
 		}
 		delete[] column;
 		delete[] field;
+		delete[] fieldlength;
 		delete[] loblength;
 		delete[] indicator;
 		columncount=0;
@@ -891,6 +961,7 @@ bool informixcursor::close() {
 		SQLFreeHandle(SQL_HANDLE_STMT,stmt);
 		stmt=0;
 	}
+	invalidatePreparedStatement();
 	return true;
 }
 
@@ -898,6 +969,16 @@ bool informixcursor::prepareQuery(const char *query, uint32_t length) {
 
 	bindformaterror=false;
 
+	// handle noops
+	noop=!charstring::compare(query,"noop");
+
+	// reuse a statement that already has this query prepared,
+	// if one is available
+	if (!noop && reusePreparedStatement(query,length)) {
+		ncols=0;
+		return true;
+	}
+
 	// FIXME: we shouldn't have to do this, but the tests crash in
 	// multiple locations if we don't...
 	if (!close() || !open()) {
@@ -907,15 +988,74 @@ bool informixcursor::prepareQuery(const char *query, uint32_t length) {
 	// initialize column count
 	ncols=0;
 
-	// handle noops
-	noop=!charstring::compare(query,"noop");
 	if (noop) {
 		return true;
 	}
 
 	// prepare the query
 	erg=SQLPrepare(stmt,(SQLCHAR *)query,length);
-	return (erg==SQL_SUCCESS || erg==SQL_SUCCESS_WITH_INFO);
+	if (erg!=SQL_SUCCESS && erg!=SQL_SUCCESS_WITH_INFO) {
+		return false;
+	}
+	if (informixconn->stmtcache.getSize()) {
+		stmtquery=charstring::duplicate(query,length);
+		stmtquerylength=length;
+		stmtgeneration=informixconn->stmtcache.getGeneration();
+	}
+	return true;
+}
+
+bool informixcursor::reusePreparedStatement(const char *query,
+							uint32_t length) {
+
+	if (!informixconn->stmtcache.getSize()) {
+		return false;
+	}
+
+	// changing the current database invalidates any cached statements
+	if (informixconn->changesDatabase(query)) {
+		informixconn->stmtcache.clear();
+	}
+	if (stmtquery &&
+		stmtgeneration!=informixconn->stmtcache.getGeneration()) {
+		invalidatePreparedStatement();
+	}
+
+	// if this cursor's statement already has this query prepared,
+	// then just use it again
+	if (stmtquery && stmtquerylength==length &&
+			!bytestring::compare(stmtquery,query,length)) {
+		return true;
+	}
+
+	// otherwise, swap this cursor's statement for a cached statement
+	// that has this query prepared, if there is one, and put this
+	// cursor's statement in the cache for use later
+	SQLHSTMT	cachedstmt=0;
+	informixconn->stmtcache.take(query,length,&cachedstmt);
+	if (stmtquery) {
+		informixconn->cacheStatement(stmt,stmtquery,stmtquerylength);
+		stmtquery=NULL;
+		stmtquerylength=0;
+		stmt=0;
+	} else if (cachedstmt) {
+		close();
+	}
+	if (!cachedstmt) {
+		return false;
+	}
+	stmt=cachedstmt;
+
+	stmtquery=charstring::duplicate(query,length);
+	stmtquerylength=length;
+	stmtgeneration=informixconn->stmtcache.getGeneration();
+	return true;
+}
+
+void informixcursor::invalidatePreparedStatement() {
+	delete[] stmtquery;
+	stmtquery=NULL;
+	stmtquerylength=0;
 }
 
 bool informixcursor::inputBind(const char *variable,
@@ -1366,6 +1506,9 @@ bool informixcursor::executeQuery(const char *query, uint32_t length) {
 	if (erg!=SQL_SUCCESS &&
 		erg!=SQL_SUCCESS_WITH_INFO &&
 		erg!=SQL_NO_DATA) {
+		// don't reuse the statement, in case it failed
+		// because objects that it refers to have changed
+		invalidatePreparedStatement();
 		return false;
 	}
 
@@ -1475,16 +1618,17 @@ bool informixcursor::executeQuery(const char *query, uint32_t length) {
 				charstring::length(column[i].table);
 		}
 
+		sizeFieldBuffer(i);
 		if (column[i].type==SQL_LONGVARBINARY ||
 			column[i].type==SQL_INFX_UDT_BLOB) {
 			erg=SQLBindCol(stmt,i+1,SQL_C_BINARY,
 					field[i],
-					conn->cont->getMaxFieldLength(),
+					fieldlength[i],
 					indicator[i]);
 		} else {
 			erg=SQLBindCol(stmt,i+1,SQL_C_CHAR,
 					field[i],
-					conn->cont->getMaxFieldLength(),
+					fieldlength[i],
 					indicator[i]);
 		}
 		if (erg!=SQL_SUCCESS && erg!=SQL_SUCCESS_WITH_INFO) {
@@ -1718,6 +1862,33 @@ uint16_t informixcursor::getColumnTableLength(uint32_t i) {
 	return column[i].tablelength;
 }
 
+void informixcursor::sizeFieldBuffer(SQLSMALLINT col) {
+
+	// Size the buffer from the display size of the column, rather than
+	// using maxfieldlength for every column.  Allow up to 4 bytes per
+	// character, in case the data is converted to a multi-byte character
+	// set, and fall back to maxfieldlength if the size isn't known
+	// (eg. for lobs).
+	uint32_t	maxfieldlength=conn->cont->getMaxFieldLength();
+	uint32_t	size=maxfieldlength;
+	SQLLEN		displaysize=0;
+	SQLRETURN	result=SQLColAttribute(stmt,col+1,
+					SQL_COLUMN_DISPLAY_SIZE,
+					NULL,0,NULL,&displaysize);
+	if ((result==SQL_SUCCESS || result==SQL_SUCCESS_WITH_INFO) &&
+			displaysize>0 &&
+			(uint64_t)displaysize<(maxfieldlength-1)/4) {
+		size=displaysize*4+1;
+	}
+
+	// buffers only grow, so they can be reused by subsequent queries
+	if (size>fieldlength[col]) {
+		delete[] field[col];
+		field[col]=new char[conn->cont->getFetchAtOnce()*size];
+		fieldlength[col]=size;
+	}
+}
+
 bool informixcursor::noRowsToReturn() {
 	// if there are no columns, then there can't be any rows either
 	return (ncols)?false:true;
@@ -1797,7 +1968,7 @@ void informixcursor::getField(uint32_t col,
 	}
 
 	// handle normal datatypes
-	*fld=&field[col][rowgroupindex*conn->cont->getMaxFieldLength()];
+	*fld=&field[col][rowgroupindex*fieldlength[col]];
 	*fldlength=indicator[col][rowgroupindex];
 }
 
@@ -151,6 +151,9 @@ SQLRETURN (*SQLGetData)(SQLHSTMT hstmt,
 
 SQLRETURN (*SQLCloseCursor)(SQLHSTMT hStmt);
 
+SQLRETURN (*SQLFreeStmt)(SQLHSTMT hstmt,
+				SQLUSMALLINT fOption);
+
 
 // constants...
 #define	SQL_HANDLE_ENV	1
@@ -183,12 +186,17 @@ SQLRETURN (*SQLCloseCursor)(SQLHSTMT hStmt);
 #define	SQL_ATTR_ROW_ARRAY_SIZE	27
 #define	SQL_ATTR_ROW_NUMBER	14
 
+#define	SQL_CLOSE		0
+#define	SQL_UNBIND		2
+#define	SQL_RESET_PARAMS	3
+
 #define	SQL_PARAM_INPUT		1
 #define	SQL_PARAM_OUTPUT	4
 
 #define	SQL_COLUMN_TYPE			2
 #define	SQL_COLUMN_PRECISION		4
 #define	SQL_COLUMN_SCALE		5
+#define	SQL_COLUMN_DISPLAY_SIZE		6
 #define	SQL_COLUMN_UNSIGNED		8
 #define	SQL_COLUMN_AUTO_INCREMENT	11
 #define	SQL_COLUMN_TABLE_NAME		15
@@ -495,6 +503,13 @@ static bool loadLibraries(stringbuffer *errormessage) {
 		goto error;
 	}
 
+	SQLFreeStmt=(SQLRETURN (*)(SQLHSTMT hstmt,
+					SQLUSMALLINT fOption))
+				lib.getSymbol("SQLFreeStmt");
+	if (!SQLFreeStmt) {
+		goto error;
+	}
+
 	// success
 	return true;
 
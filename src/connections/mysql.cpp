@@ -2,7 +2,9 @@
 // See the file COPYING for more information
 
 #include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlrstatementcache.h>
 #include <rudiments/charstring.h>
+#include <rudiments/character.h>
 #include <rudiments/bytestring.h>
 #include <rudiments/regularexpression.h>
 
@@ -52,6 +54,12 @@ class SQLRSERVER_DLLSPEC mysqlcursor : public sqlrservercursor {
 #endif
 		bool		prepareQuery(const char *query,
 						uint32_t length);
+#ifdef HAVE_MYSQL_STMT_PREPARE
+		bool		reusePreparedStatement(const char *query,
+							uint32_t length);
+		bool		resetPreparedStatement();
+		void		invalidatePreparedStatement();
+#endif
 		bool		supportsNativeBinds(const char *query,
 							uint32_t length);
 #ifdef HAVE_MYSQL_STMT_PREPARE
@@ -95,6 +103,9 @@ class SQLRSERVER_DLLSPEC mysqlcursor : public sqlrservercursor {
 #endif
 		bool		executeQuery(const char *query,
 						uint32_t length);
+#if defined(HAVE_MYSQL_REAL_CONNECT_FOR_SURE) && MYSQL_VERSION_ID>=32200
+		bool		cancelQuery();
+#endif
 #ifdef HAVE_MYSQL_COMMIT
 		bool		queryIsNotSelect();
 #endif
@@ -169,6 +180,9 @@ class SQLRSERVER_DLLSPEC mysqlcursor : public sqlrservercursor {
 		bool		stmtreset;
 		bool		stmtfreeresult;
 		bool		stmtpreparefailed;
+		char		*stmtquery;
+		uint32_t	stmtquerylength;
+		uint32_t	stmtgeneration;
 
 		MYSQL_BIND	*fieldbind;
 		char		*field;
@@ -218,6 +232,7 @@ class SQLRSERVER_DLLSPEC mysqlconnection : public sqlrserverconnection {
 		const char	*getDatabaseListQuery(bool wild);
 		const char	*getColumnListQuery(
 						const char *table, bool wild);
+		bool		selectDatabase(const char *database);
 		const char	*selectDatabaseQuery();
 		const char	*getCurrentDatabaseQuery();
 		const char	*setIsolationLevelQuery();
@@ -238,6 +253,10 @@ class SQLRSERVER_DLLSPEC mysqlconnection : public sqlrserverconnection {
 		int16_t		nullBindValue();
 #endif
 		void		endSession();
+#if defined(HAVE_MYSQL_REAL_CONNECT_FOR_SURE) && MYSQL_VERSION_ID>=32200
+		void		setSslOptions(MYSQL *mptr);
+		bool		killQuery();
+#endif
 
 #if MYSQL_VERSION_ID<32200
 		MYSQL	mysql;
@@ -274,6 +293,9 @@ class SQLRSERVER_DLLSPEC mysqlconnection : public sqlrserverconnection {
 
 		const char	*identity;
 		bool		usestmtapi;
+#ifdef HAVE_MYSQL_STMT_PREPARE
+		sqlrstatementcache< MYSQL_STMT * >	stmtcache;
+#endif
 
 		char	*dbversion;
 		char	*dbhostname;
@@ -300,8 +322,18 @@ extern "C" {
 const my_bool	mysqlconnection::mytrue=TRUE;
 const my_bool	mysqlconnection::myfalse=FALSE;
 
+#ifdef HAVE_MYSQL_STMT_PREPARE
+static void closeStatement(MYSQL_STMT *stmt) {
+	mysql_stmt_close(stmt);
+}
+#endif
+
 mysqlconnection::mysqlconnection(sqlrservercontroller *cont) :
-					sqlrserverconnection(cont) {
+					sqlrserverconnection(cont)
+#ifdef HAVE_MYSQL_STMT_PREPARE
+					,stmtcache(closeStatement)
+#endif
+					{
 	connected=false;
 	dbversion=NULL;
 	dbhostname=NULL;
@@ -387,6 +419,10 @@ void mysqlconnection::handleConnectString() {
 
 	usestmtapi=charstring::compare(
 			cont->getConnectStringValue("api"),"classic");
+#ifdef HAVE_MYSQL_STMT_PREPARE
+	stmtcache.setSize(charstring::toUnsignedInteger(
+			cont->getConnectStringValue("stmtcachesize")));
+#endif
 
 	// mysql doesn't support multi-row fetches
 	cont->setFetchAtOnce(1);
@@ -442,41 +478,7 @@ bool mysqlconnection::logIn(const char **error, const char **warning) {
 			*error="mysql_init failed";
 			return false;
 		}
-		#ifdef HAVE_MYSQL_OPT_SSL_MODE
-			mysql_options(mysqlptr,
-					MYSQL_OPT_SSL_MODE,
-					&sslmode);
-		#else
-			#ifdef HAVE_MYSQL_OPT_SSL_ENFORCE
-				mysql_options(mysqlptr,
-						MYSQL_OPT_SSL_ENFORCE,
-						sslenforce);
-			#endif
-			#ifdef HAVE_MYSQL_OPT_SSL_VERIFY_SERVER_CERT
-				mysql_options(mysqlptr,
-					MYSQL_OPT_SSL_VERIFY_SERVER_CERT,
-					sslverifyservercert);
-			#endif
-		#endif
-		#ifdef HAVE_MYSQL_OPT_TLS_VERSION
-			mysql_options(mysqlptr,
-					MYSQL_OPT_TLS_VERSION,
-					tlsversion);
-		#endif
-		#ifdef HAVE_MYSQL_SSL_SET
-			mysql_ssl_set(mysqlptr,sslkey,sslcert,
-					sslca,sslcapath,sslcipher);
-		#endif
-		#ifdef HAVE_MYSQL_OPT_SSLCRL
-			mysql_options(mysqlptr,
-					MYSQL_OPT_SSLCRL,
-					sslcrl);
-		#endif
-		#ifdef HAVE_MYSQL_OPT_SSLCRLPATH
-			mysql_options(mysqlptr,
-					MYSQL_OPT_SSLCRLPATH,
-					sslcrlpath);
-		#endif
+		setSslOptions(mysqlptr);
 	
 		bool	sslcafallback=false;
 		MYSQL	*result=mysql_real_connect(mysqlptr,
@@ -623,6 +625,89 @@ bool mysqlconnection::logIn(const char **error, const char **warning) {
 	return true;
 }
 
+#if defined(HAVE_MYSQL_REAL_CONNECT_FOR_SURE) && MYSQL_VERSION_ID>=32200
+void mysqlconnection::setSslOptions(MYSQL *mptr) {
+	#ifdef HAVE_MYSQL_OPT_SSL_MODE
+		mysql_options(mptr,
+				MYSQL_OPT_SSL_MODE,
+				&sslmode);
+	#else
+		#ifdef HAVE_MYSQL_OPT_SSL_ENFORCE
+			mysql_options(mptr,
+					MYSQL_OPT_SSL_ENFORCE,
+					sslenforce);
+		#endif
+		#ifdef HAVE_MYSQL_OPT_SSL_VERIFY_SERVER_CERT
+			mysql_options(mptr,
+				MYSQL_OPT_SSL_VERIFY_SERVER_CERT,
+				sslverifyservercert);
+		#endif
+	#endif
+	#ifdef HAVE_MYSQL_OPT_TLS_VERSION
+		mysql_options(mptr,
+				MYSQL_OPT_TLS_VERSION,
+				tlsversion);
+	#endif
+	#ifdef HAVE_MYSQL_SSL_SET
+		mysql_ssl_set(mptr,sslkey,sslcert,
+				sslca,sslcapath,sslcipher);
+	#endif
+	#ifdef HAVE_MYSQL_OPT_SSLCRL
+		mysql_options(mptr,
+				MYSQL_OPT_SSLCRL,
+				sslcrl);
+	#endif
+	#ifdef HAVE_MYSQL_OPT_SSLCRLPATH
+		mysql_options(mptr,
+				MYSQL_OPT_SSLCRLPATH,
+				sslcrlpath);
+	#endif
+}
+
+bool mysqlconnection::killQuery() {
+
+	// MySQL doesn't have a way to cancel a query that's running on a
+	// connection from outside of that connection, so log in again and
+	// kill the query from a second connection
+	MYSQL	*killptr=mysql_init(NULL);
+	if (!killptr) {
+		return false;
+	}
+	setSslOptions(killptr);
+
+	// don't let an unreachable or unresponsive server hang the cancel
+	// thread, the client that asked for the cancel waits on it
+	unsigned int	killtimeout=5;
+	mysql_options(killptr,MYSQL_OPT_CONNECT_TIMEOUT,
+				(const char *)&killtimeout);
+	#if MYSQL_VERSION_ID>=40101
+	mysql_options(killptr,MYSQL_OPT_READ_TIMEOUT,
+				(const char *)&killtimeout);
+	mysql_options(killptr,MYSQL_OPT_WRITE_TIMEOUT,
+				(const char *)&killtimeout);
+	#endif
+
+	bool	result=false;
+	if (mysql_real_connect(killptr,
+			(!charstring::isNullOrEmpty(host))?host:"",
+			cont->getUser(),cont->getPassword(),
+			(!charstring::isNullOrEmpty(db))?db:"",
+			(!charstring::isNullOrEmpty(port))?
+					charstring::toInteger(port):0,
+			(!charstring::isNullOrEmpty(socket))?socket:NULL,
+			0)) {
+		char	*query=NULL;
+		charstring::printf(&query,"KILL QUERY %lu",
+				(unsigned long)mysql_thread_id(mysqlptr));
+		result=!mysql_real_query(killptr,query,
+					charstring::length(query));
+		delete[] query;
+	}
+	mysql_close(killptr);
+	return result;
+}
+#endif
+
 sqlrservercursor *mysqlconnection::newCursor(uint16_t id) {
 	return (sqlrservercursor *)new mysqlcursor((sqlrserverconnection *)this,id);
 }
@@ -632,6 +717,9 @@ void mysqlconnection::deleteCursor(sqlrservercursor *curs) {
 }
 
 void mysqlconnection::logOut() {
+#ifdef HAVE_MYSQL_STMT_PREPARE
+	stmtcache.clear();
+#endif
 	connected=false;
 	mysql_close(mysqlptr);
 }
@@ -886,6 +974,15 @@ int16_t mysqlconnection::nullBindValue() {
 }
 #endif
 
+bool mysqlconnection::selectDatabase(const char *database) {
+#ifdef HAVE_MYSQL_STMT_PREPARE
+	// table names in prepared statements are resolved against the
+	// database that was current when the statement was prepared
+	stmtcache.clear();
+#endif
+	return sqlrserverconnection::selectDatabase(database);
+}
+
 void mysqlconnection::endSession() {
 	firstquery=true;
 }
@@ -912,6 +1009,9 @@ mysqlcursor::mysqlcursor(sqlrserverconnection *conn, uint16_t id) :
 
 	usestmtprepare=true;
 	stmtpreparefailed=false;
+	stmtquery=NULL;
+	stmtquerylength=0;
+	stmtgeneration=0;
 	bindformaterror=false;
 	unsupportedbystmt.setPattern(
 			"^[ 	\r\n]*"
@@ -954,6 +1054,7 @@ mysqlcursor::~mysqlcursor() {
 	}
 	delete[] bind;
 	delete[] bindvaluesize;
+	delete[] stmtquery;
 #endif
 	deallocateResultSetBuffers();
 }
@@ -1016,6 +1117,8 @@ bool mysqlcursor::open() {
 
 bool mysqlcursor::close() {
 	mysql_stmt_close(stmt);
+	delete[] stmtquery;
+	stmtquery=NULL;
 	return true;
 }
 #endif
@@ -1054,6 +1157,18 @@ bool mysqlcursor::prepareQuery(const char *query, uint32_t length) {
 	// pings or "use xxx" or other internal queries.  It might be good
 	// to sort all of that out at some point.)
 	if (!supportsNativeBinds(query,length)) {
+
+		// "use xxx" invalidates any cached statements
+		// (but queries like "useraccounts" don't)
+		if (mysqlconn->stmtcache.getSize()) {
+			const char	*ptr=
+				conn->cont->skipWhitespaceAndComments(query);
+			if (!charstring::compareIgnoringCase(ptr,"use",3) &&
+				!character::isAlphanumeric(ptr[3]) &&
+				ptr[3]!='_' && ptr[3]!='$') {
+				mysqlconn->stmtcache.clear();
+			}
+		}
 		return true;
 	}
 
@@ -1066,10 +1181,18 @@ bool mysqlcursor::prepareQuery(const char *query, uint32_t length) {
 	// free any lingering result sets
 	freeResult();
 
-	// prepare the statement
-	if (mysql_stmt_prepare(stmt,query,length)) {
-		stmtpreparefailed=true;
-		return false;
+	// prepare the statement, unless a statement that already
+	// has this query prepared is available
+	if (!reusePreparedStatement(query,length)) {
+		if (mysql_stmt_prepare(stmt,query,length)) {
+			stmtpreparefailed=true;
+			return false;
+		}
+		if (mysqlconn->stmtcache.getSize()) {
+			stmtquery=charstring::duplicate(query,length);
+			stmtquerylength=length;
+			stmtgeneration=mysqlconn->stmtcache.getGeneration();
+		}
 	}
 
 	stmtfreeresult=true;
@@ -1125,6 +1248,100 @@ bool mysqlcursor::prepareQuery(const char *query, uint32_t length) {
 	return true;
 }
 
+#ifdef HAVE_MYSQL_STMT_PREPARE
+bool mysqlcursor::reusePreparedStatement(const char *query, uint32_t length) {
+
+	if (!mysqlconn->stmtcache.getSize()) {
+		return false;
+	}
+
+	// statements prepared before the current database was changed might
+	// refer to tables in the old database, so they can't be reused, even
+	// by the cursor that prepared them
+	if (stmtquery &&
+		stmtgeneration!=mysqlconn->stmtcache.getGeneration()) {
+		delete[] stmtquery;
+		stmtquery=NULL;
+		stmtquerylength=0;
+	}
+
+	// if this cursor's statement already has this query prepared,
+	// then just use it again
+	if (stmtquery && stmtquerylength==length &&
+			!bytestring::compare(stmtquery,query,length)) {
+		return resetPreparedStatement();
+	}
+
+	// otherwise, swap this cursor's statement for a cached statement
+	// that has this query prepared, if there is one, and put this
+	// cursor's statement in the cache for use later
+	MYSQL_STMT	*cachedstmt=NULL;
+	mysqlconn->stmtcache.take(query,length,&cachedstmt);
+	if (stmtquery) {
+		mysqlconn->stmtcache.put(stmt,stmtquery,stmtquerylength);
+		stmtquery=NULL;
+		stmtquerylength=0;
+		stmt=(cachedstmt)?cachedstmt:
+				mysql_stmt_init(mysqlconn->mysqlptr);
+	} else if (cachedstmt) {
+		mysql_stmt_close(stmt);
+		stmt=cachedstmt;
+	}
+
+	if (!cachedstmt) {
+		return false;
+	}
+	stmtquery=charstring::duplicate(query,length);
+	stmtquerylength=length;
+	stmtgeneration=mysqlconn->stmtcache.getGeneration();
+	return resetPreparedStatement();
+}
+
+bool mysqlcursor::resetPreparedStatement() {
+
+	// Reset the statement before running it again.  This discards any
+	// rows and errors left over from the last time that it was run, along
+	// with any long data that was sent for it, and closes its cursor.
+	if (!mysql_stmt_reset(stmt)) {
+		return true;
+	}
+
+	// if that failed, then replace the statement
+	// with a new one, and prepare the query again
+	mysql_stmt_close(stmt);
+	stmt=mysql_stmt_init(mysqlconn->mysqlptr);
+	delete[] stmtquery;
+	stmtquery=NULL;
+	stmtquerylength=0;
+	return false;
+}
+
+void mysqlcursor::invalidatePreparedStatement() {
+
+	if (!stmtquery) {
+		return;
+	}
+
+	switch (mysql_stmt_errno(stmt)) {
+		case 1054: // ER_BAD_FIELD_ERROR
+		case 1146: // ER_NO_SUCH_TABLE
+		case 1243: // ER_UNKNOWN_STMT_HANDLER
+		case 1615: // ER_NEED_REPREPARE
+			break;
+		default:
+			return;
+	}
+
+	// The schema changed out from under the statement.  Forget the query
+	// so the statement won't be reused or cached, and close and reopen
+	// it when the result set is closed.
+	delete[] stmtquery;
+	stmtquery=NULL;
+	stmtquerylength=0;
+	stmtpreparefailed=true;
+}
+#endif
+
 bool mysqlcursor::supportsNativeBinds(const char *query, uint32_t length) {
 #ifdef HAVE_MYSQL_STMT_PREPARE
 	usestmtprepare=mysqlconn->usestmtapi &&
@@ -1387,6 +1604,7 @@ bool mysqlcursor::executeQuery(const char *query, uint32_t length) {
 
 		// execute the query
 		if ((queryresult=mysql_stmt_execute(stmt))) {
+			invalidatePreparedStatement();
 			return false;
 		}
 
@@ -1473,6 +1691,12 @@ bool mysqlcursor::executeQuery(const char *query, uint32_t length) {
 	return true;
 }
 
+#if defined(HAVE_MYSQL_REAL_CONNECT_FOR_SURE) && MYSQL_VERSION_ID>=32200
+bool mysqlcursor::cancelQuery() {
+	return mysqlconn->killQuery();
+}
+#endif
+
 #ifdef HAVE_MYSQL_COMMIT
 bool mysqlcursor::queryIsNotSelect() {
 	// Kludge.  The controller uses this to decide whether to run a
@@ -1972,6 +2196,9 @@ void mysqlcursor::closeResultSet() {
 			mysql_stmt_close(stmt);
 			stmt=mysql_stmt_init(mysqlconn->mysqlptr);
 			stmtpreparefailed=false;
+			delete[] stmtquery;
+			stmtquery=NULL;
+			stmtquerylength=0;
 		}
 	} else {
 		freeResult();
@@ -186,6 +186,7 @@ class SQLRSERVER_DLLSPEC odbccursor : public sqlrservercursor {
 		bool		bindValueIsNull(uint16_t isnull);
 		bool		executeQuery(const char *query,
 						uint32_t length);
+		bool		cancelQuery();
 		bool		handleColumns(bool getcolumninfo,
 						bool bindcolumns);
 		void		errorMessage(char *errorbuffer,
@@ -209,6 +210,10 @@ class SQLRSERVER_DLLSPEC odbccursor : public sqlrservercursor {
 		uint16_t	getColumnTableLength(uint32_t i);
 		bool		noRowsToReturn();
 		bool		fetchRow(bool *error);
+		bool		fetchRowGroup(bool *error);
+		bool		convertFields();
+		void		nextRow();
+		bool		skipRow(bool *error);
 		void		getField(uint32_t col,
 					const char **field,
 					uint64_t *fieldlength,
@@ -277,6 +282,11 @@ class SQLRSERVER_DLLSPEC odbccursor : public sqlrservercursor {
 		uint32_t	row;
 		uint32_t	maxrow;
 		uint32_t	totalrows;
+		uint32_t	fetchatonce;
+		uint32_t	rowarraysize;
+		#if (ODBCVER >= 0x0300)
+		SQLULEN		rowsfetched;
+		#endif
 
 		stringbuffer	errormsg;
 
@@ -935,8 +945,12 @@ void odbcconnection::handleConnectString() {
 		ncharencoding="UCS-2//TRANSLIT";
 	}
 
-	// unixodbc doesn't support array fetches
-	cont->setFetchAtOnce(1);
+	// array fetches aren't supported by every driver, so only use them
+	// if fetchatonce was explicitly specified
+	if (charstring::isNullOrEmpty(
+			cont->getConnectStringValue("fetchatonce"))) {
+		cont->setFetchAtOnce(1);
+	}
 	#ifdef HAVE_WINDOWS
 	const char	*ansicodepage_s=cont->getConnectStringValue("ansicodepage");
 	if (ansicodepage_s) {
@@ -2367,6 +2381,12 @@ odbccursor::odbccursor(sqlrserverconnection *conn, uint16_t id) :
 	}
 	sqlnulldata=SQL_NULL_DATA;
 	bindformaterror=false;
+	fetchatonce=conn->cont->getFetchAtOnce();
+	#if (ODBCVER < 0x0300)
+	// SQLFetchScroll and SQLSetStmtAttr aren't available in ODBC 2
+	fetchatonce=1;
+	#endif
+	rowarraysize=1;
 	allocateResultSetBuffers(conn->cont->getMaxColumnCount());
 	initializeColCounts();
 	initializeRowCounts();
@@ -2400,15 +2420,15 @@ void odbccursor::allocateResultSetBuffers(int32_t columncount) {
 		field=new char *[columncount];
 		#ifdef SQLBINDCOL_SQLLEN
 		loblength=new SQLLEN[columncount];
-		indicator=new SQLLEN[columncount];
+		indicator=new SQLLEN[columncount*fetchatonce];
 		#else
 		loblength=new SQLINTEGER[columncount];
-		indicator=new SQLINTEGER[columncount];
+		indicator=new SQLINTEGER[columncount*fetchatonce];
 		#endif
 		uint32_t	maxfieldlength=conn->cont->getMaxFieldLength();
 		column=new odbccolumn[columncount];
 		for (int32_t i=0; i<columncount; i++) {
-			field[i]=new char[maxfieldlength];
+			field[i]=new char[fetchatonce*maxfieldlength];
 		}
 	}
 }
@@ -3570,6 +3590,12 @@ bool odbccursor::executeQuery(const char *query, uint32_t length) {
 	return true;
 }
 
+bool odbccursor::cancelQuery() {
+	// (this runs in another thread, so don't use erg)
+	SQLRETURN	result=SQLCancel(stmt);
+	return (result==SQL_SUCCESS || result==SQL_SUCCESS_WITH_INFO);
+}
+
 void odbccursor::initializeColCounts() {
 	ncols=0;
 	columninfoisvalidafterprepare=true;
@@ -3908,6 +3934,35 @@ bool odbccursor::handleColumns(bool getcolumninfo, bool bindcolumns) {
 
 		uint32_t	maxfieldlength=conn->cont->getMaxFieldLength();
 
+		// Fetch fetchatonce rows at a time, unless the result set
+		// contains lobs.  Lobs are fetched using SQLGetData, which
+		// can't reliably be used with block cursors.
+		rowarraysize=1;
+		#if (ODBCVER >= 0x0300)
+		if (fetchatonce>1) {
+			rowarraysize=fetchatonce;
+			for (SQLSMALLINT i=0; i<ncols; i++) {
+				if (isLob(column[i].type)) {
+					rowarraysize=1;
+					break;
+				}
+			}
+		}
+		erg=SQLSetStmtAttr(stmt,SQL_ATTR_ROW_ARRAY_SIZE,
+					(SQLPOINTER)(SQLULEN)rowarraysize,0);
+		if (erg!=SQL_SUCCESS && erg!=SQL_SUCCESS_WITH_INFO) {
+			// fall back to fetching a row at a time
+			rowarraysize=1;
+			erg=SQL_SUCCESS;
+		}
+		if (rowarraysize>1) {
+			SQLSetStmtAttr(stmt,SQL_ATTR_ROW_BIND_TYPE,
+					(SQLPOINTER)SQL_BIND_BY_COLUMN,0);
+			SQLSetStmtAttr(stmt,SQL_ATTR_ROWS_FETCHED_PTR,
+					&rowsfetched,0);
+		}
+		#endif
+
 		// run through the columns
 		for (SQLSMALLINT i=0; i<ncols; i++) {
 
@@ -3918,24 +3973,24 @@ bool odbccursor::handleColumns(bool getcolumninfo, bool bindcolumns) {
 					column[i].type==SQL_WCHAR) {
 					erg=SQLBindCol(stmt,i+1,SQL_C_WCHAR,
 							field[i],maxfieldlength,
-							&(indicator[i]));
+							&(indicator[i*fetchatonce]));
 				} else if (column[i].type==SQL_TYPE_TIMESTAMP ||
 					(odbcconn->sqltypedatetosqlcbinary &&
 					column[i].type==SQL_TYPE_DATE)) {
 					erg=SQLBindCol(stmt,i+1,SQL_C_BINARY,
 							field[i],maxfieldlength,
-							&(indicator[i]));
+							&(indicator[i*fetchatonce]));
 				} else if (!isLob(column[i].type)) {
 					erg=SQLBindCol(stmt,i+1,SQL_C_CHAR,
 							field[i],maxfieldlength,
-							&(indicator[i]));
+							&(indicator[i*fetchatonce]));
 				}
 			} else {
 			#endif
 				if (!isLob(column[i].type)) {
 					erg=SQLBindCol(stmt,i+1,SQL_C_CHAR,
 							field[i],maxfieldlength,
-							&(indicator[i]));
+							&(indicator[i*fetchatonce]));
 				}
 			#ifdef HAVE_SQLCONNECTW
 			}
@@ -4143,7 +4198,23 @@ bool odbccursor::noRowsToReturn() {
 bool odbccursor::fetchRow(bool *error) {
 
 	*error=false;
+
+	// fetch another group of rows if we've run through the current one
+	if (row==maxrow && !fetchRowGroup(error)) {
+		return false;
+	}
+
+	return convertFields();
+}
+
+bool odbccursor::fetchRowGroup(bool *error) {
+
+	#if (ODBCVER >= 0x0300)
+	erg=(rowarraysize>1)?SQLFetchScroll(stmt,SQL_FETCH_NEXT,0):
+							SQLFetch(stmt);
+	#else
 	erg=SQLFetch(stmt);
+	#endif
 	if (erg==SQL_ERROR) {
 		*error=true;
 		return false;
@@ -4151,19 +4222,37 @@ bool odbccursor::fetchRow(bool *error) {
 	if (erg!=SQL_SUCCESS && erg!=SQL_SUCCESS_WITH_INFO) {
 		return false;
 	}
-	
+
+	row=0;
+	#if (ODBCVER >= 0x0300)
+	maxrow=(rowarraysize>1)?rowsfetched:1;
+	#else
+	maxrow=1;
+	#endif
+	totalrows+=maxrow;
+	return (maxrow>0);
+}
+
+bool odbccursor::convertFields() {
+
 	#if defined(HAVE_SQLCONNECTW) || defined(HAVE_WINDOWS)
 //	if (odbcconn->unicode) {
 		// convert wvarchar/wchar fields to user coding
 		uint32_t	maxfieldlength=conn->cont->getMaxFieldLength();
 		for (int i=0; i<ncols; i++) {
+			char	*fld=field[i]+row*maxfieldlength;
+			#ifdef SQLBINDCOL_SQLLEN
+			SQLLEN		*ind=&(indicator[i*fetchatonce+row]);
+			#else
+			SQLINTEGER	*ind=&(indicator[i*fetchatonce+row]);
+			#endif
 			#ifdef HAVE_SQLCONNECTW
 			if (column[i].type==SQL_WVARCHAR ||
 					column[i].type==SQL_WCHAR) {
-				if (indicator[i]!=SQL_NULL_DATA && field[i]) {
+				if (*ind!=SQL_NULL_DATA && fld) {
 					char	*err=NULL;
 					char	*u=convertCharset(
-						field[i],
+						fld,
 						odbcconn->ncharencoding,
 						"UTF-8",&err);
 					if (err) {
@@ -4177,10 +4266,10 @@ bool odbccursor::fetchRow(bool *error) {
 						s=maxfieldlength-
 							nullSize("UTF-8");
 					}
-					bytestring::zero(field[i]+s,
+					bytestring::zero(fld+s,
 							nullSize("UTF-8"));
-					bytestring::copy(field[i],u,s);
-					indicator[i]=s;
+					bytestring::copy(fld,u,s);
+					*ind=s;
 					delete[] u;
 				}
 			}
@@ -4188,17 +4277,17 @@ bool odbccursor::fetchRow(bool *error) {
 			#ifdef HAVE_WINDOWS
 			if (column[i].type==SQL_VARCHAR ||
 					column[i].type==SQL_CHAR) {
-				if (indicator[i]!=SQL_NULL_DATA && field[i]) {
+				if (*ind!=SQL_NULL_DATA && fld) {
 					char	*err=NULL;
 					char	*u=convertCharset(
-						field[i],odbcconn->ansicodepage,
+						fld,odbcconn->ansicodepage,
 						"UTF-8",&err);
 					size_t	len=charstring::length(u);
 					if (len>=maxfieldlength) {
 						len=maxfieldlength-1;
 					}
-					charstring::copy(field[i],u,len);
-					indicator[i]=len;
+					charstring::copy(fld,u,len);
+					*ind=len;
 					delete[] u;
 				}
 			}
@@ -4210,12 +4299,24 @@ bool odbccursor::fetchRow(bool *error) {
 	return true;
 }
 
+void odbccursor::nextRow() {
+	row++;
+}
+
+bool odbccursor::skipRow(bool *error) {
+	if (fetchRow(error)) {
+		row++;
+		return true;
+	}
+	return false;
+}
+
 void odbccursor::getField(uint32_t col,
 				const char **fld, uint64_t *fldlength,
 				bool *blob, bool *null) {
 
 	// handle NULLs
-	if (indicator[col]==SQL_NULL_DATA) {
+	if (indicator[col*fetchatonce+row]==SQL_NULL_DATA) {
 		*null=true;
 		return;
 	}
@@ -4227,8 +4328,8 @@ void odbccursor::getField(uint32_t col,
 	}
 
 	// handle normal datatypes
-	*fld=field[col];
-	*fldlength=indicator[col];
+	*fld=field[col]+row*conn->cont->getMaxFieldLength();
+	*fldlength=indicator[col*fetchatonce+row];
 }
 
 bool odbccursor::getLobFieldLength(uint32_t col, uint64_t *length) {
@@ -4,6 +4,7 @@
 #include <sqlrelay/sqlrserver.h>
 #include <rudiments/charstring.h>
 #include <rudiments/bytestring.h>
+#include <rudiments/bytebuffer.h>
 #include <rudiments/character.h>
 #include <rudiments/environment.h>
 #include <rudiments/file.h>
@@ -32,6 +33,7 @@
 #endif
 
 #define STMT_CACHE_SIZE		0
+#define ARRAY_BIND_SIZE		100
 
 extern "C" {
 	#ifdef __CYGWIN__
@@ -85,6 +87,24 @@ struct datebind {
 	OCIDate		*ocidate;
 };
 
+#ifdef HAVE_ORACLE_8i
+struct arraybind {
+	const char	*variable;
+	uint16_t	variablesize;
+	ub2		type;
+	bytebuffer	values;
+	ub2		*alen;
+	sb2		*ind;
+	ub1		*buffer;
+};
+
+struct arraybinderror {
+	ub4		row;
+	sb4		errorcode;
+	stringbuffer	error;
+};
+#endif
+
 class SQLRSERVER_DLLSPEC oracleconnection : public sqlrserverconnection {
 	friend class oraclecursor;
 	public:
@@ -147,6 +167,7 @@ class SQLRSERVER_DLLSPEC oracleconnection : public sqlrserverconnection {
 		OCIEnv		*env;
 		OCIServer	*srv;
 		OCIError	*err;
+		OCIError	*breakerr;
 		OCISvcCtx	*svc;
 		OCISession	*session;
 		OCITrans	*trans;
@@ -174,6 +195,7 @@ class SQLRSERVER_DLLSPEC oracleconnection : public sqlrserverconnection {
 		#ifdef HAVE_ORACLE_8i
 		bool		droptemptables;
 		bool		temptabletruncatebeforedrop;
+		uint32_t	arraybindsize;
 		#endif
 		bool		rejectduplicatebinds;
 		bool		disablekeylookup;
@@ -294,6 +316,7 @@ class SQLRSERVER_DLLSPEC oraclecursor : public sqlrservercursor {
 		#endif
 		bool		executeQuery(const char *query,
 						uint32_t length);
+		bool		cancelQuery();
 		bool		fetchFromBindCursor();
 		bool		executeQueryOrFetchFromBindCursor(
 						const char *query,
@@ -301,6 +324,17 @@ class SQLRSERVER_DLLSPEC oraclecursor : public sqlrservercursor {
 						bool execute);
 		bool		validBinds();
 		#ifdef HAVE_ORACLE_8i
+		uint32_t	getArrayBindSize();
+		bool		arrayBindRow();
+		uint32_t	getArrayBindRowCount();
+		bool		executeArrayQuery(const char *query,
+							uint32_t length);
+		uint32_t	getArrayErrorCount();
+		bool		getArrayError(uint32_t index,
+						uint32_t *row,
+						int64_t *errorcode,
+						const char **error,
+						uint32_t *errorlength);
 		void		checkForTempTable(const char *query,
 							uint32_t length);
 		const char	*truncateTableQuery();
@@ -400,6 +434,13 @@ class SQLRSERVER_DLLSPEC oraclecursor : public sqlrservercursor {
 		OCILobLocator	**outbind_lob;
 		uint16_t	orainbindlobcount;
 		uint16_t	oraoutbindlobcount;
+
+		arraybind	*arraybinds;
+		OCIBind		**arraybindpp;
+		uint16_t	arraybindcount;
+		uint32_t	arraybindrowcount;
+		arraybinderror	*arraybinderrors;
+		ub4		arraybinderrorcount;
 		#endif
 
 		bool		bindformaterror;
@@ -430,6 +471,7 @@ oracleconnection::oracleconnection(sqlrservercontroller *cont) :
 	env=NULL;
 	srv=NULL;
 	err=NULL;
+	breakerr=NULL;
 	svc=NULL;
 	session=NULL;
 	trans=NULL;
@@ -453,6 +495,7 @@ oracleconnection::oracleconnection(sqlrservercontroller *cont) :
 	#ifdef HAVE_ORACLE_8i
 	droptemptables=false;
 	temptabletruncatebeforedrop=false;
+	arraybindsize=ARRAY_BIND_SIZE;
 	#endif
 	rejectduplicatebinds=false;
 	disablekeylookup=false;
@@ -501,6 +544,11 @@ void oracleconnection::handleConnectString() {
 
 	cont->addGlobalTempTables(
 			cont->getConnectStringValue("globaltemptables"));
+
+	const char	*abs=cont->getConnectStringValue("arraybindsize");
+	if (!charstring::isNullOrEmpty(abs)) {
+		arraybindsize=charstring::toUnsignedInteger(abs);
+	}
 	#endif
 
 	rejectduplicatebinds=charstring::isYes(
@@ -631,8 +679,12 @@ bool oracleconnection::logIn(const char **error, const char **warning) {
 	#endif
 
 	// init OCI
+	// (the cancel thread calls OCIBreak() while the query is running,
+	// which requires a threaded environment)
+	ub4	envmode=(cont->getConfig()->getQueryCancellation())?
+						OCI_THREADED:OCI_DEFAULT;
 	#ifdef HAVE_ORACLE_8i
-	if (OCIEnvCreate((OCIEnv **)&env,OCI_DEFAULT|OCI_OBJECT,(dvoid *)0,
+	if (OCIEnvCreate((OCIEnv **)&env,envmode|OCI_OBJECT,(dvoid *)0,
 				(dvoid *(*)(dvoid *, size_t))0,
 				(dvoid *(*)(dvoid *, dvoid *, size_t))0,
 				(void (*)(dvoid *, dvoid *))0,
@@ -641,7 +693,7 @@ bool oracleconnection::logIn(const char **error, const char **warning) {
 		return false;
 	}
 	#else
-	if (OCIInitialize(OCI_DEFAULT,NULL,NULL,NULL,NULL)!=OCI_SUCCESS) {
+	if (OCIInitialize(envmode,NULL,NULL,NULL,NULL)!=OCI_SUCCESS) {
 		*error=logInError("OCIInitialize() failed");
 		return false;
 	}
@@ -946,6 +998,14 @@ bool oracleconnection::logIn(const char **error, const char **warning) {
 		}
 	}
 	#endif
+
+	// allocate a separate error handle for cancelling queries from
+	// another thread (it's not fatal if this fails, queries just
+	// can't be cancelled)
+	if (OCIHandleAlloc((dvoid *)env,(dvoid **)&breakerr,
+				OCI_HTYPE_ERROR,0,NULL)!=OCI_SUCCESS) {
+		breakerr=NULL;
+	}
 	return true;
 }
 
@@ -992,6 +1052,10 @@ void oracleconnection::logOut() {
 	// free the service, server and error handles
 	OCIHandleFree(svc,OCI_HTYPE_SVCCTX);
 	OCIHandleFree(srv,OCI_HTYPE_SERVER);
+	if (breakerr) {
+		OCIHandleFree(breakerr,OCI_HTYPE_ERROR);
+		breakerr=NULL;
+	}
 	OCIHandleFree(err,OCI_HTYPE_ERROR);
 	OCIHandleFree(env,OCI_HTYPE_ENV);
 }
@@ -2445,6 +2509,13 @@ oraclecursor::oraclecursor(sqlrserverconnection *conn, uint16_t id) :
 	}
 	orainbindlobcount=0;
 	oraoutbindlobcount=0;
+
+	arraybinds=NULL;
+	arraybindpp=NULL;
+	arraybindcount=0;
+	arraybindrowcount=0;
+	arraybinderrors=NULL;
+	arraybinderrorcount=0;
 	#endif
 	bindformaterror=false;
 
@@ -2500,6 +2571,17 @@ oraclecursor::~oraclecursor() {
 	#ifdef HAVE_ORACLE_8i
 	delete[] inbind_lob;
 	delete[] outbind_lob;
+
+	if (arraybinds) {
+		for (uint16_t i=0; i<maxbindcount; i++) {
+			delete[] arraybinds[i].alen;
+			delete[] arraybinds[i].ind;
+			delete[] arraybinds[i].buffer;
+		}
+	}
+	delete[] arraybinds;
+	delete[] arraybindpp;
+	delete[] arraybinderrors;
 	#endif
 
 	deallocateResultSetBuffers();
@@ -3507,6 +3589,14 @@ bool oraclecursor::executeQuery(const char *query, uint32_t length) {
 	return executeQueryOrFetchFromBindCursor(query,length,true);
 }
 
+bool oraclecursor::cancelQuery() {
+	// OCIBreak is safe to call from another thread while
+	// the query is running, but needs its own error handle
+	return (oracleconn->breakerr &&
+		OCIBreak((dvoid *)oracleconn->svc,
+				oracleconn->breakerr)==OCI_SUCCESS);
+}
+
 bool oraclecursor::fetchFromBindCursor() {
 	return executeQueryOrFetchFromBindCursor(NULL,0,false);
 }
@@ -3770,6 +3860,302 @@ bool oraclecursor::executeQueryOrFetchFromBindCursor(const char *query,
 	return true;
 }
 
+#ifdef HAVE_ORACLE_8i
+uint32_t oraclecursor::getArrayBindSize() {
+	return oracleconn->arraybindsize;
+}
+
+bool oraclecursor::arrayBindRow() {
+
+	uint16_t		inbindcount=getInputBindCount();
+	sqlrserverbindvar	*inbinds=getInputBinds();
+	uint32_t		arraybindsize=oracleconn->arraybindsize;
+
+	// bail if the array is full or if there are too many binds
+	if (arraybindrowcount==arraybindsize || inbindcount>maxbindcount) {
+		return false;
+	}
+
+	// allocate buffers on first use
+	if (!arraybinds) {
+		arraybinds=new arraybind[maxbindcount];
+		for (uint16_t i=0; i<maxbindcount; i++) {
+			arraybinds[i].alen=new ub2[arraybindsize];
+			arraybinds[i].ind=new sb2[arraybindsize];
+			arraybinds[i].buffer=NULL;
+		}
+		arraybindpp=new OCIBind *[maxbindcount];
+		arraybinderrors=new arraybinderror[arraybindsize];
+	}
+
+	// validate the binds, and on the first row, get the oracle type of
+	// each bind (subsequent rows must have the same types)
+	if (!arraybindrowcount) {
+		arraybindcount=inbindcount;
+	} else if (inbindcount!=arraybindcount) {
+		return false;
+	}
+	for (uint16_t i=0; i<inbindcount; i++) {
+
+		ub2	type=0;
+		switch (inbinds[i].type) {
+			case SQLRSERVERBINDVARTYPE_STRING:
+			case SQLRSERVERBINDVARTYPE_CLOB:
+				if (inbinds[i].valuesize>65535) {
+					return false;
+				}
+				type=SQLT_CHR;
+				break;
+			case SQLRSERVERBINDVARTYPE_BLOB:
+				if (inbinds[i].valuesize>65535) {
+					return false;
+				}
+				type=SQLT_BIN;
+				break;
+			case SQLRSERVERBINDVARTYPE_INTEGER:
+				type=SQLT_INT;
+				break;
+			case SQLRSERVERBINDVARTYPE_DOUBLE:
+				type=SQLT_FLT;
+				break;
+			case SQLRSERVERBINDVARTYPE_DATE:
+				type=SQLT_ODT;
+				break;
+			default:
+				return false;
+		}
+
+		if (!arraybindrowcount) {
+			arraybinds[i].variable=inbinds[i].variable;
+			arraybinds[i].variablesize=inbinds[i].variablesize;
+			arraybinds[i].type=type;
+			arraybinds[i].values.clear();
+		} else if (type!=arraybinds[i].type) {
+			return false;
+		}
+	}
+
+	// append the values to the arrays
+	for (uint16_t i=0; i<inbindcount; i++) {
+
+		arraybind		*ab=&(arraybinds[i]);
+		sqlrserverbindvar	*inbind=&(inbinds[i]);
+
+		ab->ind[arraybindrowcount]=
+			(conn->bindValueIsNull(inbind->isnull))?-1:0;
+
+		switch (ab->type) {
+			case SQLT_CHR:
+			case SQLT_BIN:
+				ab->values.append(
+					(const unsigned char *)
+						inbind->value.stringval,
+					inbind->valuesize);
+				ab->alen[arraybindrowcount]=inbind->valuesize;
+				break;
+			case SQLT_INT:
+				ab->values.append(
+					(const unsigned char *)
+						&inbind->value.integerval,
+					sizeof(int64_t));
+				ab->alen[arraybindrowcount]=sizeof(int64_t);
+				break;
+			case SQLT_FLT:
+				ab->values.append(
+					(const unsigned char *)
+						&inbind->value.doubleval.value,
+					sizeof(double));
+				ab->alen[arraybindrowcount]=sizeof(double);
+				break;
+			case SQLT_ODT:
+				{
+				OCIDate	ocidate;
+				OCIDateSetDate(&ocidate,
+						inbind->value.dateval.year,
+						inbind->value.dateval.month,
+						inbind->value.dateval.day);
+				OCIDateSetTime(&ocidate,
+						inbind->value.dateval.hour,
+						inbind->value.dateval.minute,
+						inbind->value.dateval.second);
+				ab->values.append(
+					(const unsigned char *)&ocidate,
+					sizeof(OCIDate));
+				ab->alen[arraybindrowcount]=sizeof(OCIDate);
+				}
+				break;
+		}
+	}
+
+	arraybindrowcount++;
+	return true;
+}
+
+uint32_t oraclecursor::getArrayBindRowCount() {
+	return arraybindrowcount;
+}
+
+bool oraclecursor::executeArrayQuery(const char *query, uint32_t length) {
+
+	// reset the row and error counters
+	ub4	iters=arraybindrowcount;
+	arraybindrowcount=0;
+	arraybinderrorcount=0;
+	row=0;
+	maxrow=0;
+	totalrows=0;
+
+	if (!iters) {
+		return true;
+	}
+
+	checkRePrepare();
+
+	// get the type of the query, arrays can't be bound to selects
+	if (OCIAttrGet(stmt,OCI_HTYPE_STMT,
+			(dvoid *)&stmttype,(ub4 *)NULL,
+			OCI_ATTR_STMT_TYPE,oracleconn->err)!=OCI_SUCCESS ||
+			stmttype==OCI_STMT_SELECT) {
+		return false;
+	}
+
+	// bind the arrays...
+	for (uint16_t i=0; i<arraybindcount; i++) {
+
+		arraybind	*ab=&(arraybinds[i]);
+
+		// OCI requires that each element of the array be the same
+		// size, so copy the values into a buffer, with each value
+		// padded out to the size of the largest one
+		ub2	maxlen=1;
+		for (ub4 j=0; j<iters; j++) {
+			if (ab->alen[j]>maxlen) {
+				maxlen=ab->alen[j];
+			}
+		}
+		delete[] ab->buffer;
+		ab->buffer=new ub1[maxlen*iters];
+		const unsigned char	*value=ab->values.getBuffer();
+		for (ub4 j=0; j<iters; j++) {
+			bytestring::copy(ab->buffer+j*maxlen,value,ab->alen[j]);
+			value+=ab->alen[j];
+		}
+
+		if (charstring::isInteger(ab->variable+1,
+						ab->variablesize-1)) {
+			ub4	pos=charstring::toInteger(ab->variable+1);
+			if (!pos) {
+				bindformaterror=true;
+				return false;
+			}
+			if (OCIBindByPos(stmt,&arraybindpp[i],
+					oracleconn->err,pos,
+					(dvoid *)ab->buffer,(sb4)maxlen,
+					ab->type,
+					(dvoid *)ab->ind,(ub2 *)ab->alen,
+					(ub2 *)0,0,(ub4 *)0,
+					OCI_DEFAULT)!=OCI_SUCCESS) {
+				return false;
+			}
+		} else {
+			if (OCIBindByName(stmt,&arraybindpp[i],
+					oracleconn->err,
+					(text *)ab->variable,
+					(sb4)ab->variablesize,
+					(dvoid *)ab->buffer,(sb4)maxlen,
+					ab->type,
+					(dvoid *)ab->ind,(ub2 *)ab->alen,
+					(ub2 *)0,0,(ub4 *)0,
+					OCI_DEFAULT)!=OCI_SUCCESS) {
+				return false;
+			}
+		}
+	}
+
+	// execute the query once for each row, and rather than aborting on
+	// the first failed row, collect per-row errors
+	sword	result=OCIStmtExecute(oracleconn->svc,stmt,
+					oracleconn->err,iters,
+					(ub4)0,NULL,NULL,
+					oracleconn->stmtmode|OCI_BATCH_ERRORS);
+
+	// reset the prepared flag
+	prepared=false;
+
+	if (result==OCI_SUCCESS) {
+		return true;
+	}
+
+	// get the number of rows that failed
+	ub4	errorcount=0;
+	if (OCIAttrGet(stmt,OCI_HTYPE_STMT,
+			(dvoid *)&errorcount,(ub4 *)NULL,
+			OCI_ATTR_NUM_DML_ERRORS,
+			oracleconn->err)!=OCI_SUCCESS || !errorcount) {
+		// if the query failed but no rows failed,
+		// then the entire query failed
+		return (result==OCI_SUCCESS_WITH_INFO);
+	}
+	if (errorcount>iters) {
+		errorcount=iters;
+	}
+
+	// get the errors
+	OCIError	*rowerr=NULL;
+	if (OCIHandleAlloc((dvoid *)oracleconn->env,(dvoid **)&rowerr,
+				OCI_HTYPE_ERROR,0,NULL)!=OCI_SUCCESS) {
+		return false;
+	}
+	for (ub4 i=0; i<errorcount; i++) {
+
+		if (OCIParamGet(oracleconn->err,OCI_HTYPE_ERROR,
+					oracleconn->err,(dvoid **)&rowerr,
+					i)!=OCI_SUCCESS) {
+			break;
+		}
+
+		arraybinderror	*abe=&(arraybinderrors[arraybinderrorcount]);
+		abe->row=0;
+		OCIAttrGet(rowerr,OCI_HTYPE_ERROR,
+				(dvoid *)&abe->row,(ub4 *)NULL,
+				OCI_ATTR_DML_ROW_OFFSET,oracleconn->err);
+
+		text	message[1024];
+		message[0]='\0';
+		abe->errorcode=0;
+		OCIErrorGet((dvoid *)rowerr,1,(text *)0,&abe->errorcode,
+				message,sizeof(message),OCI_HTYPE_ERROR);
+		abe->error.clear();
+		abe->error.append((const char *)message);
+
+		arraybinderrorcount++;
+	}
+	OCIHandleFree(rowerr,OCI_HTYPE_ERROR);
+
+	return true;
+}
+
+uint32_t oraclecursor::getArrayErrorCount() {
+	return arraybinderrorcount;
+}
+
+bool oraclecursor::getArrayError(uint32_t index,
+					uint32_t *row,
+					int64_t *errorcode,
+					const char **error,
+					uint32_t *errorlength) {
+	if (index>=arraybinderrorcount) {
+		return false;
+	}
+	arraybinderror	*abe=&(arraybinderrors[index]);
+	*row=abe->row;
+	*errorcode=abe->errorcode;
+	*error=abe->error.getString();
+	*errorlength=abe->error.getStringLength();
+	return true;
+}
+#endif
+
 bool oraclecursor::validBinds() {
 
 	// NOTE: If we're using the statement cache, then it is vital to
@@ -83,6 +83,8 @@ sword (*OCIServerAttach)(OCIServer *,
 sword (*OCIServerDetach)(OCIServer *,
 				OCIError *,
 				ub4);
+sword (*OCIBreak)(void *,
+				OCIError *);
 sword (*OCISessionBegin)(OCISvcCtx *,
 				OCIError *,
 				OCISession *,
@@ -294,6 +296,7 @@ sword (*OCITransRollback)(OCISvcCtx *,
 
 // constants...
 #define OCI_DEFAULT		0x00000000
+#define OCI_THREADED		0x00000001
 #define OCI_SUCCESS		0
 #define OCI_SUCCESS_WITH_INFO	1
 #define OCI_ERROR		-1
@@ -319,6 +322,8 @@ sword (*OCITransRollback)(OCISvcCtx *,
 #define OCI_ATTR_ROW_COUNT	9
 #define OCI_ATTR_PREFETCH_ROWS	11
 #define OCI_ATTR_PARAM_COUNT	18
+#define OCI_ATTR_NUM_DML_ERRORS	73
+#define OCI_ATTR_DML_ROW_OFFSET	74
 #define OCI_ATTR_USERNAME	22
 #define OCI_ATTR_PASSWORD	23
 #define OCI_ATTR_NOCACHE	87
@@ -338,6 +343,7 @@ sword (*OCITransRollback)(OCISvcCtx *,
 #define OCI_NTV_SYNTAX	1
 
 #define OCI_COMMIT_ON_SUCCESS	0x00000020
+#define OCI_BATCH_ERRORS	0x00000080
 
 #define OCI_STRLS_CACHE_DELETE	0x0010
 
@@ -369,8 +375,11 @@ sword (*OCITransRollback)(OCISvcCtx *,
 
 #define OCI_FETCH_NEXT	0x00000002
 
+#define SQLT_CHR	1
+#define SQLT_INT	3
 #define SQLT_FLT	4
 #define SQLT_STR	5
+#define SQLT_BIN	23
 #define SQLT_CLOB	112
 #define SQLT_BLOB	113
 #define SQLT_RSET	116
@@ -510,6 +519,13 @@ static bool loadLibraries(stringbuffer *errormessage) {
 		goto error;
 	}
 
+	OCIBreak=(sword (*)(void *,
+					OCIError *))
+				lib.getSymbol("OCIBreak");
+	if (!OCIBreak) {
+		goto error;
+	}
+
 	OCISessionBegin=(sword (*)(OCISvcCtx *,
 					OCIError *,
 					OCISession *,
@@ -57,6 +57,9 @@ class SQLRSERVER_DLLSPEC postgresqlconnection : public sqlrserverconnection {
 		dictionary< int32_t, char *>	tables;
 
 		PGconn	*pgconn;
+#ifdef HAVE_POSTGRESQL_PQGETCANCEL
+		PGcancel	*pgcancel;
+#endif
 
 		const char	*host;
 		const char	*port;
@@ -68,6 +71,9 @@ class SQLRSERVER_DLLSPEC postgresqlconnection : public sqlrserverconnection {
 		const char	*charset;
 		char		*dbversion;
 		char		*hostname;
+#ifdef HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE
+		uint32_t	chunksize;
+#endif
 
 #ifdef HAVE_POSTGRESQL_PQCONNECTDB
 		stringbuffer	conninfo;
@@ -136,6 +142,9 @@ class SQLRSERVER_DLLSPEC postgresqlcursor : public sqlrservercursor {
 #endif
 		bool		executeQuery(const char *query,
 						uint32_t length);
+#ifdef HAVE_POSTGRESQL_PQGETCANCEL
+		bool		cancelQuery();
+#endif
 #if (defined(HAVE_POSTGRESQL_PQEXECPREPARED) && \
 		defined(HAVE_POSTGRESQL_PQPREPARE)) || \
 		(defined(HAVE_POSTGRESQL_PQSENDQUERYPREPARED) && \
@@ -227,12 +236,18 @@ postgresqlconnection::postgresqlconnection(sqlrservercontroller *cont) :
 	datatypes.setTrackInsertionOrder(false);
 	tables.setTrackInsertionOrder(false);
 	pgconn=NULL;
+#ifdef HAVE_POSTGRESQL_PQGETCANCEL
+	pgcancel=NULL;
+#endif
 #ifdef HAVE_POSTGRESQL_PQOIDVALUE
 	currentoid=InvalidOid;
 #endif
 	lastinsertidquery=NULL;
 	identity=NULL;
 	hostname=NULL;
+#ifdef HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE
+	chunksize=1;
+#endif
 }
 
 postgresqlconnection::~postgresqlconnection() {
@@ -278,6 +293,13 @@ void postgresqlconnection::handleConnectString() {
 	}
 	identity=cont->getConnectStringValue("identity");
 
+#ifdef HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE
+	// libpq can't hand us multiple rows to fetch at once, in the sense
+	// that the sqlrservercontroller means it, but it can get rows from
+	// the server in chunks, so use fetchatonce as the chunk size
+	chunksize=cont->getFetchAtOnce();
+#endif
+
 	// postgresql doesn't support multi-row fetches
 	cont->setFetchAtOnce(1);
 	cont->setMaxFieldLength(0);
@@ -354,6 +376,11 @@ bool postgresqlconnection::logIn(const char **error,
 	}
 #endif
 
+#ifdef HAVE_POSTGRESQL_PQGETCANCEL
+	// get the information needed to cancel queries
+	pgcancel=PQgetCancel(pgconn);
+#endif
+
 	// build the datatype dictionary
 	if (typemangling==2) {
 		PGresult	*result=PQexec(pgconn,
@@ -425,6 +452,13 @@ void postgresqlconnection::logOut() {
 	devnull.close();
 #endif
 
+#ifdef HAVE_POSTGRESQL_PQGETCANCEL
+	if (pgcancel) {
+		PQfreeCancel(pgcancel);
+		pgcancel=NULL;
+	}
+#endif
+
 	if (pgconn) {
 		PQfinish(pgconn);
 		pgconn=NULL;
@@ -1045,7 +1079,17 @@ bool postgresqlcursor::executeQuery(const char *query, uint32_t length) {
 		return false;
 	}
 
-	// set single-row mode
+	// Set chunked-rows mode if we can, and the chunk size is more than 1
+	// row, or single-row mode otherwise.  Either way, the result set
+	// is streamed, rather than buffered entirely in memory.
+#ifdef HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE
+	if (postgresqlconn->chunksize>1) {
+		if (!PQsetChunkedRowsMode(postgresqlconn->pgconn,
+					postgresqlconn->chunksize)) {
+			return false;
+		}
+	} else
+#endif
 	if (!PQsetSingleRowMode(postgresqlconn->pgconn)) {
 		return false;
 	}
@@ -1140,6 +1184,16 @@ bool postgresqlcursor::executeQuery(const char *query, uint32_t length) {
 	return true;
 }
 
+#ifdef HAVE_POSTGRESQL_PQGETCANCEL
+bool postgresqlcursor::cancelQuery() {
+	if (!postgresqlconn->pgcancel) {
+		return false;
+	}
+	char	errbuf[256];
+	return PQcancel(postgresqlconn->pgcancel,errbuf,sizeof(errbuf));
+}
+#endif
+
 #if (defined(HAVE_POSTGRESQL_PQEXECPREPARED) && \
 		defined(HAVE_POSTGRESQL_PQPREPARE)) || \
 		(defined(HAVE_POSTGRESQL_PQSENDQUERYPREPARED) && \
@@ -1515,8 +1569,18 @@ bool postgresqlcursor::fetchRow(bool *error) {
 #if defined(HAVE_POSTGRESQL_PQSENDQUERYPREPARED) && \
 		defined(HAVE_POSTGRESQL_PQSETSINGLEROWMODE)
 	if (!justexecuted) {
+#ifdef HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE
+		// move on to the next row of the current chunk, if there is one
+		if (pgresult &&
+			PQresultStatus(pgresult)==PGRES_TUPLES_CHUNK &&
+			currentrow<PQntuples(pgresult)-1) {
+			currentrow++;
+			return true;
+		}
+#endif
 		PQclear(pgresult);
 		pgresult=PQgetResult(postgresqlconn->pgconn);
+		currentrow=0;
 	} else {
 		justexecuted=false;
 	}
@@ -1527,6 +1591,12 @@ bool postgresqlcursor::fetchRow(bool *error) {
 	if (PQresultStatus(pgresult)==PGRES_SINGLE_TUPLE && pgresult) {
 		return true;
 	}
+#ifdef HAVE_POSTGRESQL_PQSETCHUNKEDROWSMODE
+	if (PQresultStatus(pgresult)==PGRES_TUPLES_CHUNK && pgresult &&
+						PQntuples(pgresult)) {
+		return true;
+	}
+#endif
 	return false;
 #else
 	if (currentrow<nrows-1) {
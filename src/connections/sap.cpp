@@ -7,6 +7,7 @@
 #include <rudiments/charstring.h>
 #include <rudiments/character.h>
 #include <rudiments/bytestring.h>
+#include <rudiments/bytebuffer.h>
 #include <rudiments/stdio.h>
 #include <rudiments/process.h>
 
@@ -19,6 +20,7 @@
 #else
 	extern "C" {
 		#include <ctpublic.h>
+		#include <bkpublic.h>
 	}
 #endif
 
@@ -69,6 +71,7 @@ class SQLRSERVER_DLLSPEC sapconnection : public sqlrserverconnection {
 		const char	*language;
 		const char	*hostname;
 		const char	*packetsize;
+		uint32_t	bcpbatchsize;
 
 		const char	*identity;
 
@@ -104,6 +107,12 @@ struct datebind {
 	bool		*isnegative;
 };
 
+struct blkerror {
+	uint32_t	row;
+	int64_t		errorcode;
+	stringbuffer	error;
+};
+
 class SQLRSERVER_DLLSPEC sapcursor : public sqlrservercursor {
 	friend class sapconnection;
 	private:
@@ -177,6 +186,18 @@ class SQLRSERVER_DLLSPEC sapcursor : public sqlrservercursor {
 						int16_t *isnull);
 		bool		executeQuery(const char *query,
 						uint32_t length);
+		uint32_t	getArrayBindSize();
+		bool		arrayBindRow();
+		uint32_t	getArrayBindRowCount();
+		bool		executeArrayQuery(const char *query,
+							uint32_t length);
+		uint32_t	getArrayErrorCount();
+		bool		getArrayError(uint32_t index,
+						uint32_t *row,
+						int64_t *errorcode,
+						const char **error,
+						uint32_t *errorlength);
+		bool		getBulkCopyTable();
 		uint64_t	affectedRows();
 		uint32_t	colCount();
 		const char	*getColumnName(uint32_t col);
@@ -242,6 +263,17 @@ class SQLRSERVER_DLLSPEC sapcursor : public sqlrservercursor {
 		bool		prepared;
 		bool		clean;
 
+		CS_BLKDESC	*blkdesc;
+		stringbuffer	blktable;
+		uint16_t	blkcolcount;
+		CS_INT		*blkcoltype;
+		uint32_t	blkrowcount;
+		bytebuffer	blkvalues;
+		CS_INT		*blklength;
+		CS_SMALLINT	*blkindicator;
+		blkerror	*blkerrors;
+		uint32_t	blkerrorcount;
+
 		sapconnection	*sapconn;
 };
 
@@ -255,6 +287,7 @@ sapconnection::sapconnection(sqlrservercontroller *cont) :
 					sqlrserverconnection(cont) {
 	dbused=false;
 	dbversion=NULL;
+	bcpbatchsize=0;
 
 	identity=NULL;
 }
@@ -275,6 +308,8 @@ void sapconnection::handleConnectString() {
 	language=cont->getConnectStringValue("language");
 	hostname=cont->getConnectStringValue("hostname");
 	packetsize=cont->getConnectStringValue("packetsize");
+	bcpbatchsize=charstring::toUnsignedInteger(
+			cont->getConnectStringValue("bcpbatchsize"));
 
 	if (cont->getMaxColumnCount()==1) {
 		// if max column count is set to 1 then force it
@@ -406,6 +441,16 @@ bool sapconnection::logIn(const char **error, const char **warning) {
 		return false;
 	}
 
+	// enable bulk copies
+	CS_BOOL	bulklogin=CS_TRUE;
+	if (bcpbatchsize>1 &&
+		ct_con_props(dbconn,CS_SET,CS_BULK_LOGIN,
+			(CS_VOID *)&bulklogin,CS_UNUSED,
+			(CS_INT *)NULL)!=CS_SUCCEED) {
+		*error=logInError("Failed to enable bulk copies",5);
+		return false;
+	}
+
 	// set packetsize
 	uint16_t	ps=charstring::toInteger(packetsize);
 	if (!charstring::isNullOrEmpty(packetsize) &&
@@ -687,6 +732,15 @@ sapcursor::sapcursor(sqlrserverconnection *conn, uint16_t id) :
 	languagecmd=NULL;
 	cursorcmd=NULL;
 
+	blkdesc=NULL;
+	blkcolcount=0;
+	blkcoltype=NULL;
+	blkrowcount=0;
+	blklength=NULL;
+	blkindicator=NULL;
+	blkerrors=NULL;
+	blkerrorcount=0;
+
 	cursornamelength=charstring::integerLength(id);
 	cursorname=charstring::parseNumber(id);
 
@@ -731,6 +785,10 @@ sapcursor::~sapcursor() {
 	delete[] outbindints;
 	delete[] outbinddoubles;
 	delete[] outbinddates;
+	delete[] blkcoltype;
+	delete[] blklength;
+	delete[] blkindicator;
+	delete[] blkerrors;
 
 	deallocateResultSetBuffers();
 }
@@ -856,6 +914,10 @@ bool sapcursor::close() {
 		retval=(retval && (ct_cmd_drop(cursorcmd)==CS_SUCCEED));
 		cursorcmd=NULL;
 	}
+	if (blkdesc) {
+		retval=(retval && (blk_drop(blkdesc)==CS_SUCCEED));
+		blkdesc=NULL;
+	}
 	cmd=NULL;
 	return retval;
 }
@@ -1477,6 +1539,283 @@ bool sapcursor::executeQuery(const char *query, uint32_t length) {
 	return (!sapconn->errorcode);
 }
 
+uint32_t sapcursor::getArrayBindSize() {
+	return sapconn->bcpbatchsize;
+}
+
+bool sapcursor::getBulkCopyTable() {
+
+	// get the table from "insert into table values (...)"
+	const char	*ptr=conn->cont->skipWhitespaceAndComments(query);
+	if (charstring::compareIgnoringCase(ptr,"insert",6) ||
+				!character::isWhitespace(ptr[6])) {
+		return false;
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+6);
+	if (charstring::compareIgnoringCase(ptr,"into",4) ||
+				!character::isWhitespace(ptr[4])) {
+		return false;
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+4);
+	const char	*start=ptr;
+	while (*ptr && !character::isWhitespace(*ptr) && *ptr!='(') {
+		ptr++;
+	}
+	if (ptr==start) {
+		return false;
+	}
+	blktable.clear();
+	blktable.append(start,ptr-start);
+
+	// Bulk copies supply every column of the table, in order, from the
+	// bind variables, so only inserts whose values list is made up of
+	// every bind variable, in the order that they were bound, can be
+	// bulk copied.  Inserts with an explicit column list, or with
+	// literals, expressions or reordered bind variables in the values
+	// list, can't be.
+	ptr=conn->cont->skipWhitespaceAndComments(ptr);
+	if (charstring::compareIgnoringCase(ptr,"values",6)) {
+		return false;
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+6);
+	if (*ptr!='(') {
+		return false;
+	}
+	uint16_t		inbindcount=getInputBindCount();
+	sqlrserverbindvar	*inbinds=getInputBinds();
+	if (!inbindcount) {
+		return false;
+	}
+	for (uint16_t i=0; i<inbindcount; i++) {
+
+		// skip the ( or , before the value
+		ptr=conn->cont->skipWhitespaceAndComments(ptr+1);
+
+		// the value must be this bind variable...
+		if (charstring::compare(ptr,inbinds[i].variable,
+						inbinds[i].variablesize)) {
+			return false;
+		}
+		ptr=conn->cont->skipWhitespaceAndComments(
+					ptr+inbinds[i].variablesize);
+
+		// ...and nothing else
+		if (*ptr!=((i<inbindcount-1)?',':')')) {
+			return false;
+		}
+	}
+	ptr=conn->cont->skipWhitespaceAndComments(ptr+1);
+	return (!*ptr);
+}
+
+bool sapcursor::arrayBindRow() {
+
+	uint16_t		inbindcount=getInputBindCount();
+	sqlrserverbindvar	*inbinds=getInputBinds();
+	uint32_t		batchsize=sapconn->bcpbatchsize;
+	uint16_t		maxbindcount=
+				conn->cont->getConfig()->getMaxBindCount();
+
+	// bail if the batch is full or if there are too many binds
+	if (blkrowcount==batchsize || inbindcount>maxbindcount) {
+		return false;
+	}
+
+	// allocate buffers on first use
+	if (!blkcoltype) {
+		blkcoltype=new CS_INT[maxbindcount];
+		blklength=new CS_INT[maxbindcount*batchsize];
+		blkindicator=new CS_SMALLINT[maxbindcount*batchsize];
+		blkerrors=new blkerror[batchsize];
+	}
+
+	// on the first row, get the table and the type of each column,
+	// subsequent rows must have the same number of columns
+	if (!blkrowcount) {
+		if (!getBulkCopyTable()) {
+			return false;
+		}
+		blkcolcount=inbindcount;
+		blkvalues.clear();
+		for (uint16_t i=0; i<inbindcount; i++) {
+			blkcoltype[i]=
+				(inbinds[i].type==SQLRSERVERBINDVARTYPE_BLOB)?
+						CS_BINARY_TYPE:CS_CHAR_TYPE;
+		}
+	} else if (inbindcount!=blkcolcount) {
+		return false;
+	}
+
+	// append the values to the batch, as strings, and let
+	// the bulk copy library convert them to the column types
+	for (uint16_t i=0; i<inbindcount; i++) {
+
+		sqlrserverbindvar	*inbind=&(inbinds[i]);
+		uint32_t		index=blkrowcount*maxbindcount+i;
+		size_t			before=blkvalues.getSize();
+
+		if (conn->bindValueIsNull(inbind->isnull)) {
+			blkindicator[index]=-1;
+			blklength[index]=0;
+			continue;
+		}
+
+		char	*str=NULL;
+		char	date[64];
+		switch (inbind->type) {
+			case SQLRSERVERBINDVARTYPE_STRING:
+			case SQLRSERVERBINDVARTYPE_CLOB:
+			case SQLRSERVERBINDVARTYPE_BLOB:
+				blkvalues.append((const unsigned char *)
+						inbind->value.stringval,
+						inbind->valuesize);
+				break;
+			case SQLRSERVERBINDVARTYPE_INTEGER:
+				str=charstring::parseNumber(
+						inbind->value.integerval);
+				blkvalues.append((const unsigned char *)str,
+						charstring::length(str));
+				break;
+			case SQLRSERVERBINDVARTYPE_DOUBLE:
+				str=charstring::parseNumber(
+					inbind->value.doubleval.value,
+					inbind->value.doubleval.precision,
+					inbind->value.doubleval.scale);
+				blkvalues.append((const unsigned char *)str,
+						charstring::length(str));
+				break;
+			case SQLRSERVERBINDVARTYPE_DATE:
+				charstring::printf(date,sizeof(date),
+					"%04d-%02d-%02d %02d:%02d:%02d.%03d",
+					(int)inbind->value.dateval.year,
+					inbind->value.dateval.month,
+					inbind->value.dateval.day,
+					inbind->value.dateval.hour,
+					inbind->value.dateval.minute,
+					inbind->value.dateval.second,
+					inbind->value.dateval.microsecond/1000);
+				blkvalues.append((const unsigned char *)date,
+						charstring::length(date));
+				break;
+			default:
+				return false;
+		}
+		delete[] str;
+
+		blkindicator[index]=0;
+		blklength[index]=blkvalues.getSize()-before;
+	}
+
+	blkrowcount++;
+	return true;
+}
+
+uint32_t sapcursor::getArrayBindRowCount() {
+	return blkrowcount;
+}
+
+bool sapcursor::executeArrayQuery(const char *query, uint32_t length) {
+
+	// reset the row and error counters
+	CS_INT		outrows=0;
+	uint32_t	rows=blkrowcount;
+	blkrowcount=0;
+	blkerrorcount=0;
+	affectedrows=0;
+
+	if (!rows) {
+		return true;
+	}
+
+	// clear out any errors
+	sapconn->errorcode=0;
+	sapconn->liveconnection=true;
+
+	// allocate a bulk copy descriptor, if necessary
+	if (!blkdesc && blk_alloc(sapconn->dbconn,
+				BLK_VERSION_100,&blkdesc)!=CS_SUCCEED) {
+		return false;
+	}
+
+	// start the bulk copy
+	if (blk_init(blkdesc,CS_BLK_IN,
+			(CS_CHAR *)blktable.getString(),
+			(CS_INT)blktable.getStringLength())!=CS_SUCCEED) {
+		return false;
+	}
+
+	// send the rows...
+	uint16_t		maxbindcount=
+				conn->cont->getConfig()->getMaxBindCount();
+	const unsigned char	*value=blkvalues.getBuffer();
+	for (uint32_t r=0; r<rows; r++) {
+
+		// bind the columns to the values for this row
+		for (uint16_t i=0; i<blkcolcount; i++) {
+
+			uint32_t	index=r*maxbindcount+i;
+
+			CS_DATAFMT	fmt;
+			bytestring::zero(&fmt,sizeof(fmt));
+			fmt.datatype=blkcoltype[i];
+			fmt.format=CS_FMT_UNUSED;
+			fmt.maxlength=blklength[index];
+			fmt.count=1;
+			fmt.locale=NULL;
+
+			if (blk_bind(blkdesc,i+1,&fmt,(CS_VOID *)value,
+					&blklength[index],
+					&blkindicator[index])!=CS_SUCCEED) {
+				blk_done(blkdesc,CS_BLK_CANCEL,&outrows);
+				return false;
+			}
+			value+=blklength[index];
+		}
+
+		// Send the row.  If it fails (eg. because a value couldn't
+		// be converted) then keep track of the error and move on.
+		if (blk_rowxfer(blkdesc)!=CS_SUCCEED) {
+			if (!sapconn->liveconnection) {
+				blk_done(blkdesc,CS_BLK_CANCEL,&outrows);
+				return false;
+			}
+			blkerror	*be=&(blkerrors[blkerrorcount++]);
+			be->row=r;
+			be->errorcode=sapconn->errorcode;
+			be->error.clear();
+			be->error.append(sapconn->errorstring.getString());
+			sapconn->errorcode=0;
+		}
+	}
+
+	// finish the bulk copy, if this fails then the entire batch failed
+	if (blk_done(blkdesc,CS_BLK_ALL,&outrows)!=CS_SUCCEED) {
+		return false;
+	}
+	affectedrows=outrows;
+	return true;
+}
+
+uint32_t sapcursor::getArrayErrorCount() {
+	return blkerrorcount;
+}
+
+bool sapcursor::getArrayError(uint32_t index,
+					uint32_t *row,
+					int64_t *errorcode,
+					const char **error,
+					uint32_t *errorlength) {
+	if (index>=blkerrorcount) {
+		return false;
+	}
+	blkerror	*be=&(blkerrors[index]);
+	*row=be->row;
+	*errorcode=be->errorcode;
+	*error=be->error.getString();
+	*errorlength=be->error.getStringLength();
+	return true;
+}
+
 uint64_t sapcursor::affectedRows() {
 	return affectedrows;
 }
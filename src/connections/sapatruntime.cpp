@@ -21,6 +21,7 @@ struct CS_CONTEXT;
 struct CS_CONNECTION;
 struct CS_COMMAND;
 struct CS_LOCALE;
+struct CS_BLKDESC;
 
 struct CS_DATAFMT {
 	CS_CHAR		name[256];
@@ -123,6 +124,12 @@ struct CS_SERVERMSG {
 #define cs_loc_drop cs_loc_drop_ptr
 #define cs_ctx_drop cs_ctx_drop_ptr
 #define cs_dt_crack cs_dt_crack_ptr
+#define blk_alloc blk_alloc_ptr
+#define blk_init blk_init_ptr
+#define blk_bind blk_bind_ptr
+#define blk_rowxfer blk_rowxfer_ptr
+#define blk_done blk_done_ptr
+#define blk_drop blk_drop_ptr
 
 
 // function pointers...
@@ -272,6 +279,36 @@ CS_RETCODE (*cs_dt_crack)(
 		CS_VOID *,
 		CS_DATEREC *);
 
+CS_RETCODE (*blk_alloc)(
+		CS_CONNECTION *,
+		CS_INT,
+		CS_BLKDESC **);
+
+CS_RETCODE (*blk_init)(
+		CS_BLKDESC *,
+		CS_INT,
+		CS_CHAR *,
+		CS_INT);
+
+CS_RETCODE (*blk_bind)(
+		CS_BLKDESC *,
+		CS_INT,
+		CS_DATAFMT *,
+		CS_VOID *,
+		CS_INT *,
+		CS_SMALLINT *);
+
+CS_RETCODE (*blk_rowxfer)(
+		CS_BLKDESC *);
+
+CS_RETCODE (*blk_done)(
+		CS_BLKDESC *,
+		CS_INT,
+		CS_INT *);
+
+CS_RETCODE (*blk_drop)(
+		CS_BLKDESC *);
+
 
 // constants...
 #define CS_VERSION_100		(CS_INT)113
@@ -295,6 +332,13 @@ CS_RETCODE (*cs_dt_crack)(
 #define CS_PACKETSIZE		(CS_INT)9107
 #define CS_LOC_PROP		(CS_INT)9125
 #define CS_SEC_ENCRYPTION	(CS_INT)9135
+#define CS_BULK_LOGIN		(CS_INT)9124
+
+#define BLK_VERSION_100		CS_VERSION_100
+#define CS_BLK_IN		(CS_INT)1
+#define CS_BLK_BATCH		(CS_INT)1
+#define CS_BLK_ALL		(CS_INT)2
+#define CS_BLK_CANCEL		(CS_INT)3
 
 #define CS_TRUE			(CS_BOOL)1
 #define CS_FALSE		(CS_BOOL)0
@@ -705,6 +749,60 @@ static bool loadLibraries(stringbuffer *errormessage) {
 		goto error;
 	}
 
+	blk_alloc=(CS_RETCODE (*)(
+				CS_CONNECTION *,
+				CS_INT,
+				CS_BLKDESC **))
+			lib.getSymbol("blk_alloc");
+	if (!blk_alloc) {
+		goto error;
+	}
+
+	blk_init=(CS_RETCODE (*)(
+				CS_BLKDESC *,
+				CS_INT,
+				CS_CHAR *,
+				CS_INT))
+			lib.getSymbol("blk_init");
+	if (!blk_init) {
+		goto error;
+	}
+
+	blk_bind=(CS_RETCODE (*)(
+				CS_BLKDESC *,
+				CS_INT,
+				CS_DATAFMT *,
+				CS_VOID *,
+				CS_INT *,
+				CS_SMALLINT *))
+			lib.getSymbol("blk_bind");
+	if (!blk_bind) {
+		goto error;
+	}
+
+	blk_rowxfer=(CS_RETCODE (*)(
+				CS_BLKDESC *))
+			lib.getSymbol("blk_rowxfer");
+	if (!blk_rowxfer) {
+		goto error;
+	}
+
+	blk_done=(CS_RETCODE (*)(
+				CS_BLKDESC *,
+				CS_INT,
+				CS_INT *))
+			lib.getSymbol("blk_done");
+	if (!blk_done) {
+		goto error;
+	}
+
+	blk_drop=(CS_RETCODE (*)(
+				CS_BLKDESC *))
+			lib.getSymbol("blk_drop");
+	if (!blk_drop) {
+		goto error;
+	}
+
 	// success
 	return true;
 
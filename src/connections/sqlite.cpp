@@ -2,7 +2,8 @@
 // See the file COPYING for more information
 
 #include <sqlrelay/sqlrserver.h>
-#include <rudiments/regularexpression.h>
+#include <sqlrelay/private/sqlrstatementcache.h>
+#include <rudiments/character.h>
 #include <rudiments/sys.h>
 
 #include <datatypes.h>
@@ -24,6 +25,7 @@ extern "C" {
 	#define	sqlite3_errmsg			sqlite_errmsg
 	#define	sqlite3_free_table		sqlite_free_table
 	#define	sqlite3_last_insert_rowid	sqlite_last_insert_rowid
+	#define	sqlite3_interrupt		sqlite_interrupt
 	#define sqlite3_free(mem)		sqlite_free((char *)mem)
 #endif
 
@@ -40,6 +42,9 @@ class SQLRSERVER_DLLSPEC sqliteconnection : public sqlrserverconnection {
 	private:
 		void		handleConnectString();
 		bool		logIn(const char **error, const char **warning);
+		#ifdef SQLITE3
+		bool		runPragmas();
+		#endif
 		sqlrservercursor	*newCursor(uint16_t id);
 		void		deleteCursor(sqlrservercursor *curs);
 		void		logOut();
@@ -75,9 +80,23 @@ class SQLRSERVER_DLLSPEC sqliteconnection : public sqlrserverconnection {
 
 		void		clearErrors();
 
+		#ifdef HAVE_SQLITE3_STMT
+		void		cacheStatement(sqlite3_stmt *stmt,
+							char *query,
+							uint32_t length);
+		#endif
+
 		char		*db;
 
 		const char	*identity;
+		const char	*mmapsize;
+		const char	*journalmode;
+		const char	*cachesize;
+		bool		readonly;
+
+		#ifdef HAVE_SQLITE3_STMT
+		sqlrstatementcache< sqlite3_stmt * >	stmtcache;
+		#endif
 
 		#ifdef SQLITE3
 		sqlite3	*sqliteptr;
@@ -100,9 +119,14 @@ class SQLRSERVER_DLLSPEC sqlitecursor : public sqlrservercursor {
 		bool		supportsNativeBinds(const char *query,
 							uint32_t length);
 
+		bool		isSelectLastInsertRowId(const char *query);
+
 		#ifdef HAVE_SQLITE3_STMT
 		bool		prepareQuery(const char *query,
 						uint32_t length);
+		bool		reusePreparedStatement(const char *query,
+							uint32_t length);
+		void		releasePreparedStatement();
 		int32_t		getBindVariableIndex(
 						const char *variable,
 						uint16_t variablesize);
@@ -127,6 +151,7 @@ class SQLRSERVER_DLLSPEC sqlitecursor : public sqlrservercursor {
 		#endif
 		bool		executeQuery(const char *query,
 						uint32_t length);
+		bool		cancelQuery();
 		int		runQuery(const char *query);
 		void		selectLastInsertRowId();
 		bool		knowsRowCount();
@@ -157,6 +182,9 @@ class SQLRSERVER_DLLSPEC sqlitecursor : public sqlrservercursor {
 		char		**columntables;
 		int		*columntypes;
 		sqlite3_stmt	*stmt;
+		char		*stmtquery;
+		uint32_t	stmtquerylength;
+		uint32_t	stmtgeneration;
 		bool		justexecuted;
 		char		*lastinsertrowidstr;
 		#else
@@ -164,20 +192,32 @@ class SQLRSERVER_DLLSPEC sqlitecursor : public sqlrservercursor {
 		int		rowindex;
 		#endif
 
-		regularexpression	selectlastinsertrowid;
-
 		sqliteconnection	*sqliteconn;
 };
 
 
+#ifdef HAVE_SQLITE3_STMT
+static void finalizeStatement(sqlite3_stmt *stmt) {
+	sqlite3_finalize(stmt);
+}
+#endif
+
 sqliteconnection::sqliteconnection(sqlrservercontroller *cont) :
-					sqlrserverconnection(cont) {
+					sqlrserverconnection(cont)
+					#ifdef HAVE_SQLITE3_STMT
+					,stmtcache(finalizeStatement)
+					#endif
+					{
 	identity=NULL;
 	sqliteptr=NULL;
 	errmesg=NULL;
 	errcode=0;
 	hostname=NULL;
 	db=NULL;
+	mmapsize=NULL;
+	journalmode=NULL;
+	cachesize=NULL;
+	readonly=false;
 }
 
 sqliteconnection::~sqliteconnection() {
@@ -189,6 +229,14 @@ sqliteconnection::~sqliteconnection() {
 void sqliteconnection::handleConnectString() {
 	db=charstring::duplicate(cont->getConnectStringValue("db"));
 	identity=cont->getConnectStringValue("identity");
+	mmapsize=cont->getConnectStringValue("mmapsize");
+	journalmode=cont->getConnectStringValue("journalmode");
+	cachesize=cont->getConnectStringValue("cachesize");
+	readonly=charstring::isYes(cont->getConnectStringValue("readonly"));
+	#ifdef HAVE_SQLITE3_STMT
+	stmtcache.setSize(charstring::toUnsignedInteger(
+			cont->getConnectStringValue("stmtcachesize")));
+	#endif
 
 	cont->setFetchAtOnce(1);
 	cont->setMaxColumnCount(0);
@@ -198,11 +246,25 @@ void sqliteconnection::handleConnectString() {
 bool sqliteconnection::logIn(const char **error, const char **warning) {
 #ifdef SQLITE_TRANSACTIONAL
 	#ifdef SQLITE3
-		if (sqlite3_open(db,&sqliteptr)==SQLITE_OK) {
+		clearErrors();
+		#ifdef HAVE_SQLITE3_OPEN_V2
+		// (SQLITE_OPEN_SHAREDCACHE isn't used, it only shares the
+		// page cache between handles in the same process, and this
+		// process only ever has one handle open)
+		int	flags=(readonly)?SQLITE_OPEN_READONLY:
+					(SQLITE_OPEN_READWRITE|
+						SQLITE_OPEN_CREATE);
+		if (sqlite3_open_v2(db,&sqliteptr,flags,NULL)==SQLITE_OK &&
+		#else
+		if (sqlite3_open(db,&sqliteptr)==SQLITE_OK &&
+		#endif
+							runPragmas()) {
 			return true;
 		}
-		errmesg=duplicate(sqlite3_errmsg(sqliteptr));
-		errcode=sqlite3_errcode(sqliteptr);
+		if (!errmesg) {
+			errmesg=duplicate(sqlite3_errmsg(sqliteptr));
+			errcode=sqlite3_errcode(sqliteptr);
+		}
 	#else
 		if ((sqliteptr=sqlite3_open(db,666,&errmesg))) {
 			return true;
@@ -217,6 +279,37 @@ bool sqliteconnection::logIn(const char **error, const char **warning) {
 #endif
 }
 
+#ifdef SQLITE3
+bool sqliteconnection::runPragmas() {
+
+	stringbuffer	pragmas;
+	if (!charstring::isNullOrEmpty(mmapsize)) {
+		pragmas.append("pragma mmap_size=");
+		pragmas.append(charstring::toInteger(mmapsize))->append(';');
+	}
+	if (!charstring::isNullOrEmpty(journalmode)) {
+		pragmas.append("pragma journal_mode=");
+		pragmas.append(journalmode)->append(';');
+	}
+	if (!charstring::isNullOrEmpty(cachesize)) {
+		pragmas.append("pragma cache_size=");
+		pragmas.append(charstring::toInteger(cachesize))->append(';');
+	}
+	if (!pragmas.getSize()) {
+		return true;
+	}
+
+	char	*err=NULL;
+	if (sqlite3_exec(sqliteptr,pragmas.getString(),
+				NULL,NULL,&err)==SQLITE_OK) {
+		return true;
+	}
+	errmesg=err;
+	errcode=sqlite3_errcode(sqliteptr);
+	return false;
+}
+#endif
+
 sqlrservercursor *sqliteconnection::newCursor(uint16_t id) {
 	return (sqlrservercursor *)new sqlitecursor(
 					(sqlrserverconnection *)this,id);
@@ -227,6 +320,11 @@ void sqliteconnection::deleteCursor(sqlrservercursor *curs) {
 }
 
 void sqliteconnection::logOut() {
+	#ifdef HAVE_SQLITE3_STMT
+	// statements prepared before the database is
+	// closed and reopened can't be reused
+	stmtcache.clear();
+	#endif
 	#ifdef SQLITE_TRANSACTIONAL
 	if (sqliteptr) {
 		sqlite3_close(sqliteptr);
@@ -429,6 +527,20 @@ void sqliteconnection::clearErrors() {
 	}
 }
 
+#ifdef HAVE_SQLITE3_STMT
+void sqliteconnection::cacheStatement(sqlite3_stmt *stmt,
+					char *query, uint32_t length) {
+
+	// The statement's bind values may point to memory that is about to be
+	// reused, so clear them.  Resetting the statement also releases any
+	// locks it might still hold.
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+
+	stmtcache.put(stmt,query,length);
+}
+#endif
+
 sqlitecursor::sqlitecursor(sqlrserverconnection *conn, uint16_t id) :
 						sqlrservercursor(conn,id) {
 
@@ -440,6 +552,9 @@ sqlitecursor::sqlitecursor(sqlrserverconnection *conn, uint16_t id) :
 	columntables=NULL;
 	columntypes=NULL;
 	stmt=NULL;
+	stmtquery=NULL;
+	stmtquerylength=0;
+	stmtgeneration=0;
 	justexecuted=false;
 	lastinsertrowidstr=NULL;
 	#else
@@ -448,11 +563,6 @@ sqlitecursor::sqlitecursor(sqlrserverconnection *conn, uint16_t id) :
 	#endif
 
 	sqliteconn=(sqliteconnection *)conn;
-
-	selectlastinsertrowid.setPattern("^[ 	\r\n]*(select|SELECT)[ 	\r\n]+"
-				"(last|LAST)[ 	\r\n]+(insert|INSERT)[ 	\r\n]+"
-				"(rowid|ROWID)");
-	selectlastinsertrowid.study();
 }
 
 sqlitecursor::~sqlitecursor() {
@@ -483,6 +593,7 @@ sqlitecursor::~sqlitecursor() {
 	closeResultSet();
 	#ifdef HAVE_SQLITE3_STMT
 	sqlite3_finalize(stmt);
+	delete[] stmtquery;
 	delete[] lastinsertrowidstr;
 	#endif
 }
@@ -495,6 +606,29 @@ bool sqlitecursor::supportsNativeBinds(const char *query, uint32_t length) {
 	#endif
 }
 
+bool sqlitecursor::isSelectLastInsertRowId(const char *query) {
+
+	// This is called for every query, so rather than running a regular
+	// expression, look for the words "select last insert rowid" directly
+	// and bail at the first character that doesn't match.
+	static const char	*words[]={"select","last","insert","rowid",NULL};
+	const char	*ptr=query;
+	for (const char * const *word=words; *word; word++) {
+		if (word!=words && !character::isWhitespace(*ptr)) {
+			return false;
+		}
+		while (character::isWhitespace(*ptr)) {
+			ptr++;
+		}
+		size_t	wordlength=charstring::length(*word);
+		if (charstring::compareIgnoringCase(ptr,*word,wordlength)) {
+			return false;
+		}
+		ptr+=wordlength;
+	}
+	return true;
+}
+
 #ifdef HAVE_SQLITE3_STMT
 bool sqlitecursor::prepareQuery(const char *query, uint32_t length) {
 
@@ -508,25 +642,45 @@ bool sqlitecursor::prepareQuery(const char *query, uint32_t length) {
 	sqliteconn->clearErrors();
 
 	// don't prepare "select last insert rowid" queries
-	if (selectlastinsertrowid.match(query)) {
+	if (isSelectLastInsertRowId(query)) {
+		return true;
+	}
+
+	// reuse a statement that already has this query prepared, if possible
+	if (reusePreparedStatement(query,length)) {
 		return true;
 	}
 
 	// completely reset the statement
-	sqlite3_finalize(stmt);
+	releasePreparedStatement();
 
 	// prepare the query
 	// try again if it fails with SQLITE_SCHEMA
 	int	res=SQLITE_SCHEMA;
 	while (res==SQLITE_SCHEMA) {
-		#ifdef HAVE_SQLITE3_PREPARE_V2
-			res=sqlite3_prepare_v2
+		#if defined(HAVE_SQLITE3_PREPARE_V3)
+			// let sqlite know that cached statements
+			// will be around for a while
+			res=sqlite3_prepare_v3(sqliteconn->sqliteptr,
+					query,length,
+					(sqliteconn->stmtcache.getSize())?
+						SQLITE_PREPARE_PERSISTENT:0,
+					&stmt,NULL);
+		#elif defined(HAVE_SQLITE3_PREPARE_V2)
+			res=sqlite3_prepare_v2(sqliteconn->sqliteptr,
+						query,length,&stmt,NULL);
 		#else
-			res=sqlite3_prepare
+			res=sqlite3_prepare(sqliteconn->sqliteptr,
+						query,length,&stmt,NULL);
 		#endif
-			(sqliteconn->sqliteptr,query,length,&stmt,NULL);
 	}
 	if (res==SQLITE_OK) {
+		if (sqliteconn->stmtcache.getSize()) {
+			stmtquery=charstring::duplicate(query,length);
+			stmtquerylength=length;
+			stmtgeneration=
+				sqliteconn->stmtcache.getGeneration();
+		}
 		return true;
 	}
 	sqliteconn->errcode=res;
@@ -535,6 +689,61 @@ bool sqlitecursor::prepareQuery(const char *query, uint32_t length) {
 	return false;
 }
 
+bool sqlitecursor::reusePreparedStatement(const char *query, uint32_t length) {
+
+	if (!sqliteconn->stmtcache.getSize()) {
+		return false;
+	}
+
+	// statements prepared before the database was
+	// closed and reopened can't be reused
+	if (stmtquery &&
+		stmtgeneration!=sqliteconn->stmtcache.getGeneration()) {
+		sqlite3_finalize(stmt);
+		stmt=NULL;
+		delete[] stmtquery;
+		stmtquery=NULL;
+		stmtquerylength=0;
+	}
+
+	// if this cursor's statement already has this query prepared,
+	// then just reset it and use it again
+	if (stmtquery && stmtquerylength==length &&
+			!bytestring::compare(stmtquery,query,length)) {
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+		return true;
+	}
+
+	// otherwise, look for a cached statement with this query prepared
+	sqlite3_stmt	*cachedstmt=NULL;
+	if (!sqliteconn->stmtcache.take(query,length,&cachedstmt)) {
+		return false;
+	}
+	releasePreparedStatement();
+	stmt=cachedstmt;
+	stmtquery=charstring::duplicate(query,length);
+	stmtquerylength=length;
+	stmtgeneration=sqliteconn->stmtcache.getGeneration();
+	return true;
+}
+
+void sqlitecursor::releasePreparedStatement() {
+
+	// put this cursor's statement in the cache for later
+	// use, if it's valid, or just finalize it otherwise
+	if (stmtquery &&
+		stmtgeneration==sqliteconn->stmtcache.getGeneration()) {
+		sqliteconn->cacheStatement(stmt,stmtquery,stmtquerylength);
+	} else {
+		sqlite3_finalize(stmt);
+		delete[] stmtquery;
+	}
+	stmt=NULL;
+	stmtquery=NULL;
+	stmtquerylength=0;
+}
+
 int32_t sqlitecursor::getBindVariableIndex(const char *variable,
 						uint16_t variablesize) {
 	if (charstring::isInteger(variable+1,variablesize-1)) {
@@ -610,6 +819,11 @@ bool sqlitecursor::executeQuery(const char *query, uint32_t length) {
 			// This appears to be generally true, but with 
 			// version 3.6.20 it does.
 			#if defined(HAVE_SQLITE3_STMT)
+				// don't reuse the statement or put it back
+				// in the cache, prepare the query again
+				delete[] stmtquery;
+				stmtquery=NULL;
+				stmtquerylength=0;
 				if (!prepareQuery(query,length)) {
 					break;
 				}
@@ -698,6 +912,14 @@ bool sqlitecursor::executeQuery(const char *query, uint32_t length) {
 	return (success==SQLITE_OK);
 }
 
+bool sqlitecursor::cancelQuery() {
+	// sqlite3_interrupt is safe to call from another thread
+	if (sqliteconn->sqliteptr) {
+		sqlite3_interrupt(sqliteconn->sqliteptr);
+	}
+	return true;
+}
+
 int sqlitecursor::runQuery(const char *query) {
 
 	// clear any errors
@@ -738,7 +960,7 @@ int sqlitecursor::runQuery(const char *query) {
 	lastinsertrowid=false;
 
 	// handle special case of selecting the last row id
-	if (selectlastinsertrowid.match(query)) {
+	if (isSelectLastInsertRowId(query)) {
 		lastinsertrowid=true;
 		#ifdef HAVE_SQLITE3_STMT
 		justexecuted=true;
@@ -0,0 +1,310 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information
+
+#include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlrtrace.h>
+#include <sqlrelay/private/sqlrfingerprint.h>
+#include <rudiments/process.h>
+#include <rudiments/charstring.h>
+#include <rudiments/bytestring.h>
+#include <rudiments/file.h>
+#include <rudiments/permissions.h>
+#include <rudiments/memorymap.h>
+#include <rudiments/stringbuffer.h>
+
+// states of the cursors
+#define TRACER_NOTTRACED	0
+#define TRACER_QUERY		1
+#define TRACER_FETCH		2
+
+class SQLRSERVER_DLLSPEC sqlrlogger_tracer : public sqlrlogger {
+	public:
+			sqlrlogger_tracer(sqlrloggers *ls,
+						domnode *parameters);
+			~sqlrlogger_tracer();
+
+		bool	init(sqlrlistener *sqlrl,
+					sqlrserverconnection *sqlrcon);
+		bool	run(sqlrlistener *sqlrl,
+					sqlrserverconnection *sqlrcon,
+					sqlrservercursor *sqlrcur,
+					sqlrlogger_loglevel_t level,
+					sqlrevent_t event,
+					const char *info);
+		void	endCommand(sqlrservercursor *sqlrcur);
+
+		bool	wantsDebugMessages();
+	private:
+		void	close();
+		void	setState(uint16_t id, unsigned char state);
+		unsigned char	getState(uint16_t id);
+		void	writeRecord(sqlrservercursor *sqlrcur,
+						sqlrtracerecordtype_t type);
+
+		char		*tracefilename;
+		file		tracefile;
+		memorymap	tracemap;
+		sqlrtraceheader	*header;
+		sqlrtracerecord	*records;
+
+		uint64_t	sample;
+		uint64_t	recordcount;
+		uint64_t	count;
+		pid_t		pid;
+
+		unsigned char	*states;
+		uint32_t	statecount;
+
+		stringbuffer	fp;
+
+		bool		enabled;
+};
+
+sqlrlogger_tracer::sqlrlogger_tracer(sqlrloggers *ls,
+						domnode *parameters) :
+						sqlrlogger(ls,parameters) {
+	tracefilename=NULL;
+	header=NULL;
+	records=NULL;
+	sample=charstring::toInteger(parameters->getAttributeValue("sample"));
+	if (!sample) {
+		sample=100;
+	}
+	recordcount=charstring::toInteger(
+				parameters->getAttributeValue("records"));
+	if (!recordcount) {
+		recordcount=16384;
+	}
+	count=0;
+	pid=0;
+	states=NULL;
+	statecount=0;
+	enabled=!charstring::isNo(parameters->getAttributeValue("enabled"));
+}
+
+sqlrlogger_tracer::~sqlrlogger_tracer() {
+	close();
+	delete[] states;
+	delete[] tracefilename;
+}
+
+bool sqlrlogger_tracer::init(sqlrlistener *sqlrl,
+					sqlrserverconnection *sqlrcon) {
+
+	if (!enabled) {
+		return true;
+	}
+
+	// don't trace anything for the listener
+	if (!sqlrcon) {
+		return true;
+	}
+
+	close();
+
+	// get the pid
+	pid=process::getProcessId();
+
+	// start the sample at a different point in each process, so the
+	// connections don't all trace their queries at the same time
+	count=pid%sample;
+
+	// build up the trace file name
+	delete[] tracefilename;
+	charstring::printf(&tracefilename,
+				"%s/sqlr-connection-%s-trace.%ld",
+				sqlrcon->cont->getLogDir(),
+				sqlrcon->cont->getId(),(long)pid);
+
+	// remove any old trace file
+	file::remove(tracefilename);
+
+	// create the new trace file, big enough for the whole ring
+	size_t	size=sizeof(sqlrtraceheader)+
+			recordcount*sizeof(sqlrtracerecord);
+	if (!tracefile.create(tracefilename,
+				permissions::evalPermString("rw-------"))) {
+		return false;
+	}
+	tracefile.close();
+	if (!tracefile.open(tracefilename,O_RDWR) ||
+				!tracefile.truncate(size)) {
+		tracefile.close();
+		return false;
+	}
+
+	// map it into memory
+	if (!tracemap.attach(tracefile.getFileDescriptor(),0,size,
+					PROT_READ|PROT_WRITE,MAP_SHARED)) {
+		tracefile.close();
+		return false;
+	}
+	header=(sqlrtraceheader *)tracemap.getData();
+	records=(sqlrtracerecord *)(((unsigned char *)header)+
+						sizeof(sqlrtraceheader));
+
+	// fill in the header
+	bytestring::zero(header,sizeof(sqlrtraceheader));
+	charstring::copy(header->magic,SQLRTRACE_MAGIC);
+	header->version=SQLRTRACE_VERSION;
+	header->byteorder=SQLRTRACE_BYTEORDER;
+	header->headersize=sizeof(sqlrtraceheader);
+	header->recordsize=sizeof(sqlrtracerecord);
+	header->records=recordcount;
+	header->sample=sample;
+	header->pid=pid;
+	header->next=0;
+	charstring::safeCopy(header->id,sizeof(header->id)-1,
+					sqlrcon->cont->getId());
+	return true;
+}
+
+void sqlrlogger_tracer::close() {
+	if (header) {
+		tracemap.detach();
+		tracefile.close();
+	}
+	header=NULL;
+	records=NULL;
+}
+
+bool sqlrlogger_tracer::run(sqlrlistener *sqlrl,
+					sqlrserverconnection *sqlrcon,
+					sqlrservercursor *sqlrcur,
+					sqlrlogger_loglevel_t level,
+					sqlrevent_t event,
+					const char *info) {
+
+	// don't do anything unless we got INFO/QUERY
+	if (!header || !sqlrcur ||
+		level!=SQLRLOGGER_LOGLEVEL_INFO || event!=SQLREVENT_QUERY) {
+		return true;
+	}
+
+	// only trace 1 in "sample" queries
+	count++;
+	if (count<sample) {
+		setState(sqlrcur->getId(),TRACER_NOTTRACED);
+		return true;
+	}
+	count=0;
+
+	// Protocols that time each command, like the native protocol, end
+	// each command with a call to endCommand(), and the record is written
+	// then.  Other protocols don't, so write the record now.
+	if (!sqlrcur->getCommandStartSec() &&
+				!sqlrcur->getCommandStartUSec()) {
+		writeRecord(sqlrcur,SQLRTRACERECORDTYPE_QUERY);
+		return true;
+	}
+	setState(sqlrcur->getId(),TRACER_QUERY);
+	return true;
+}
+
+void sqlrlogger_tracer::endCommand(sqlrservercursor *sqlrcur) {
+
+	if (!header) {
+		return;
+	}
+
+	// The command that ran the query is recorded, and then each of the
+	// commands that fetch the rest of its result set.  These all end up
+	// here, and any other command that the cursor runs ends up here too,
+	// so the state has to be checked first.
+	switch (getState(sqlrcur->getId())) {
+		case TRACER_QUERY:
+			writeRecord(sqlrcur,SQLRTRACERECORDTYPE_QUERY);
+			setState(sqlrcur->getId(),TRACER_FETCH);
+			break;
+		case TRACER_FETCH:
+			writeRecord(sqlrcur,SQLRTRACERECORDTYPE_FETCH);
+			break;
+		default:
+			break;
+	}
+}
+
+bool sqlrlogger_tracer::wantsDebugMessages() {
+	return false;
+}
+
+void sqlrlogger_tracer::setState(uint16_t id, unsigned char state) {
+
+	// grow the array of states, if necessary
+	if (id>=statecount) {
+		if (state==TRACER_NOTTRACED) {
+			return;
+		}
+		uint32_t	newstatecount=id+8;
+		unsigned char	*newstates=new unsigned char[newstatecount];
+		bytestring::zero(newstates,newstatecount);
+		if (states) {
+			bytestring::copy(newstates,states,statecount);
+		}
+		delete[] states;
+		states=newstates;
+		statecount=newstatecount;
+	}
+	states[id]=state;
+}
+
+unsigned char sqlrlogger_tracer::getState(uint16_t id) {
+	return (id<statecount)?states[id]:TRACER_NOTTRACED;
+}
+
+void sqlrlogger_tracer::writeRecord(sqlrservercursor *sqlrcur,
+					sqlrtracerecordtype_t type) {
+
+	// get the next record in the ring, and mark it as unused
+	// until we're done with it
+	sqlrtracerecord	*r=&(records[header->next%header->records]);
+	r->sequence=0;
+
+	// times
+	r->commandstart=sqlrcur->getCommandStartSec()*1000000+
+				sqlrcur->getCommandStartUSec();
+	r->commandend=sqlrcur->getCommandEndSec()*1000000+
+				sqlrcur->getCommandEndUSec();
+	if (type==SQLRTRACERECORDTYPE_QUERY) {
+		r->querystart=sqlrcur->getQueryStartSec()*1000000+
+					sqlrcur->getQueryStartUSec();
+		r->queryend=sqlrcur->getQueryEndSec()*1000000+
+					sqlrcur->getQueryEndUSec();
+	} else {
+		r->querystart=0;
+		r->queryend=0;
+	}
+
+	// rows and bytes fetched so far
+	r->rows=sqlrcur->getTotalRowsFetched();
+	r->bytes=sqlrcur->getTotalBytesFetched();
+
+	// where it came from
+	r->pid=pid;
+	r->cursorid=sqlrcur->getId();
+	r->type=type;
+	r->error=(sqlrcur->getQueryStatus()==SQLRQUERYSTATUS_ERROR);
+
+	// what it was
+	fingerprintQuery(&fp,sqlrcur->getQueryBuffer(),
+					sqlrcur->getQueryLength());
+	r->fingerprinthash=fingerprintHash(fp.getString(),fp.getSize());
+	size_t	length=fp.getSize();
+	if (length>=SQLRTRACE_FINGERPRINTLEN) {
+		length=SQLRTRACE_FINGERPRINTLEN-1;
+	}
+	charstring::copy(r->fingerprint,fp.getString(),length);
+	r->fingerprint[length]='\0';
+
+	// the record is complete now
+	header->next++;
+	r->sequence=header->next;
+}
+
+extern "C" {
+	SQLRSERVER_DLLSPEC sqlrlogger *new_sqlrlogger_tracer(
+						sqlrloggers *ls,
+						domnode *parameters) {
+		return new sqlrlogger_tracer(ls,parameters);
+	}
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information
+
+#include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlratomic.h>
+#include <sqlrelay/private/sqlrfingerprint.h>
+#include <rudiments/charstring.h>
+#include <rudiments/stringbuffer.h>
+#include <rudiments/dictionary.h>
+//#define DEBUG_MESSAGES 1
+#include <rudiments/debugprint.h>
+
+class SQLRSERVER_DLLSPEC sqlrmoduledata_fingerprints : public sqlrmoduledata {
+	public:
+		sqlrmoduledata_fingerprints(domnode *parameters);
+
+		void	closeResultSet(sqlrservercursor *sqlrcur);
+
+	private:
+		sqlrfingerprintstatistics	*getStatistics(sqlrshm *shm,
+							uint64_t h,
+							const char *str,
+							size_t length);
+
+		stringbuffer	fp;
+
+		dictionary<uint16_t, uint64_t>	lastquerystart;
+};
+
+sqlrmoduledata_fingerprints::sqlrmoduledata_fingerprints(
+						domnode *parameters) :
+						sqlrmoduledata(parameters) {
+}
+
+void sqlrmoduledata_fingerprints::closeResultSet(sqlrservercursor *sqlrcur) {
+	debugFunction();
+
+	// The previous result set is closed right before the next query is
+	// prepared, at the end of the session, and in a few other places.  At
+	// that point, the cursor still holds the query, its run time, its
+	// status, and the number of rows and bytes that were fetched from it.
+
+	// skip custom queries and cursors that haven't run anything
+	uint32_t	querylength=sqlrcur->getQueryLength();
+	if (!querylength || sqlrcur->getCustomQueryCursor() ||
+				(sqlrcur->getQueryStatus()!=
+					SQLRQUERYSTATUS_SUCCESS &&
+				sqlrcur->getQueryStatus()!=
+					SQLRQUERYSTATUS_ERROR)) {
+		return;
+	}
+
+	// the result set of the same query may be closed more than once,
+	// so skip queries that have already been counted
+	uint64_t	startsec=sqlrcur->getQueryStartSec();
+	uint64_t	startusec=sqlrcur->getQueryStartUSec();
+	uint64_t	start=startsec*1000000+startusec;
+	uint64_t	last=0;
+	if (!start || (lastquerystart.getValue(sqlrcur->getId(),&last) &&
+								last==start)) {
+		return;
+	}
+	lastquerystart.setValue(sqlrcur->getId(),start);
+
+	// get the run time
+	uint64_t	end=sqlrcur->getQueryEndSec()*1000000+
+					sqlrcur->getQueryEndUSec();
+	uint64_t	usec=(end>start)?end-start:0;
+
+	// get the number of rows returned or affected
+	uint64_t	rows=sqlrcur->getTotalRowsFetched();
+	if (!rows && sqlrcur->knowsAffectedRows()) {
+		rows=sqlrcur->affectedRows();
+	}
+
+	// get the number of bytes of field data sent to the client
+	uint64_t	bytes=sqlrcur->getTotalBytesFetched();
+
+	// fingerprint the query
+	fingerprintQuery(&fp,sqlrcur->getQueryBuffer(),querylength);
+	if (!fp.getSize()) {
+		return;
+	}
+
+	// find the fingerprint's statistics
+	sqlrshm	*shm=sqlrcur->conn->cont->getShm();
+	sqlrfingerprintstatistics	*fs=getStatistics(shm,
+				fingerprintHash(fp.getString(),fp.getSize()),
+				fp.getString(),fp.getSize());
+	if (!fs) {
+		atomicAdd64(&(shm->fingerprintsdropped),1);
+		return;
+	}
+
+	// update them
+	atomicAdd64(&(fs->calls),1);
+	if (sqlrcur->getQueryStatus()==SQLRQUERYSTATUS_ERROR) {
+		atomicAdd64(&(fs->errors),1);
+	}
+	atomicAdd64(&(fs->rows),rows);
+	atomicAdd64(&(fs->bytes),bytes);
+	atomicAdd64(&(fs->totalusec),usec);
+	atomicMin64(&(fs->minusec),(usec)?usec:1);
+	atomicMax64(&(fs->maxusec),usec);
+	atomicAddDouble(&(fs->sumsquares),((double)usec)*((double)usec));
+}
+
+sqlrfingerprintstatistics *sqlrmoduledata_fingerprints::getStatistics(
+							sqlrshm *shm,
+							uint64_t h,
+							const char *str,
+							size_t length) {
+
+	// The table is shared by every connection in the instance, and
+	// none of them hold a semaphore while using it.  Slots are claimed by
+	// swapping the hash into an unused slot, using linear probing, and
+	// are never released.
+	uint32_t	start=h%STATFINGERPRINTS;
+	for (uint32_t i=0; i<STATFINGERPRINTS; i++) {
+		sqlrfingerprintstatistics	*fs=
+			&(shm->fingerprints[(start+i)%STATFINGERPRINTS]);
+		if (fs->hash==h) {
+			return fs;
+		}
+		if (!fs->hash && atomicCompareAndSwap64(&(fs->hash),0,h)) {
+			if (length>=STATSQLTEXTLEN) {
+				length=STATSQLTEXTLEN-1;
+			}
+			charstring::copy(fs->fingerprint,str,length);
+			fs->fingerprint[length]='\0';
+			return fs;
+		}
+		if (fs->hash==h) {
+			return fs;
+		}
+	}
+	return NULL;
+}
+
+extern "C" {
+	SQLRSERVER_DLLSPEC
+	sqlrmoduledata	*new_sqlrmoduledata_fingerprints(
+						domnode *parameters) {
+		return new sqlrmoduledata_fingerprints(parameters);
+	}
+}
@@ -638,6 +638,8 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_mysql : public sqlrprotocol {
 					const char *sqlstate);
 		bool	sendEofPacket(uint16_t warnings,
 					uint16_t statusflags);
+		bool	sendOldEofPacket(uint16_t warnings,
+					uint16_t statusflags);
 		bool	selectDatabase();
 
 		void	debugCapabilityFlags(uint32_t capabilityflags);
@@ -721,11 +723,14 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_mysql : public sqlrprotocol {
 		bool	sendResultSet(sqlrservercursor *cursor,
 						uint32_t colcount,
 						bool binary);
+		bool	sendCursorResultSet(sqlrservercursor *cursor,
+						uint32_t colcount);
 		void	cacheColumnDefinitions(sqlrservercursor *cursor,
 							uint32_t colcount);
 		bool	sendColumnDefinitions(sqlrservercursor *cursor,
 							uint32_t colcount,
-							bool binary);
+							bool binary,
+							uint16_t statusflags);
 		bool	sendColumnDefinition(sqlrservercursor *cursor,
 							uint32_t column);
 		bool	sendColumnDefinition(sqlrservercursor *cursor,
@@ -839,6 +844,7 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_mysql : public sqlrprotocol {
 		bool	sendQueryError(sqlrservercursor *cursor);
 		bool	sendNotImplementedError();
 		bool	sendCursorNotOpenError();
+		bool	sendNoOpenCursorError(uint32_t stmtid);
 		bool	sendMalformedPacketError();
 
 		filedescriptor	*clientsock;
@@ -884,6 +890,7 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_mysql : public sqlrprotocol {
 		uint16_t	*pcounts;
 		uint16_t	**ptypes;
 		bool		*columntypescached;
+		bool		*cursoropen;
 		unsigned char	**columntypes;
 		unsigned char	**nullbitmap;
 };
@@ -970,12 +977,14 @@ sqlrprotocol_mysql::sqlrprotocol_mysql(sqlrservercontroller *cont,
 	pcounts=new uint16_t[maxcursorcount];
 	ptypes=new uint16_t *[maxcursorcount];
 	columntypescached=new bool[maxcursorcount];
+	cursoropen=new bool[maxcursorcount];
 	columntypes=new unsigned char *[maxcursorcount];
 	nullbitmap=new unsigned char *[maxcursorcount];
 	for (uint16_t i=0; i<maxcursorcount; i++) {
 		pcounts[i]=0;
 		ptypes[i]=new uint16_t[maxbindcount];
 		columntypescached[i]=false;
+		cursoropen[i]=false;
 		if (cont->getMaxColumnCount()) {
 			columntypes[i]=new unsigned char[
 					cont->getMaxColumnCount()];
@@ -1005,6 +1014,7 @@ sqlrprotocol_mysql::~sqlrprotocol_mysql() {
 	}
 	delete[] pcounts;
 	delete[] ptypes;
+	delete[] cursoropen;
 	delete[] columntypes;
 	delete[] nullbitmap;
 }
@@ -2310,6 +2320,12 @@ bool sqlrprotocol_mysql::sendEofPacket(uint16_t warnings,
 	}
 
 	// the second is an "old school" eof packet...
+	return sendOldEofPacket(warnings,statusflags);
+}
+
+bool sqlrprotocol_mysql::sendOldEofPacket(uint16_t warnings,
+						uint16_t statusflags) {
+
 	resetSendPacketBuffer();
 
 	// update statusflags
@@ -3117,10 +3133,27 @@ bool sqlrprotocol_mysql::sendResultSet(sqlrservercursor *cursor,
 						uint32_t colcount,
 						bool binary) {
 	cacheColumnDefinitions(cursor,colcount);
-	return (sendColumnDefinitions(cursor,colcount,binary) &&
+	return (sendColumnDefinitions(cursor,colcount,binary,0) &&
 				sendResultSetRows(cursor,colcount,0,binary));
 }
 
+bool sqlrprotocol_mysql::sendCursorResultSet(sqlrservercursor *cursor,
+							uint32_t colcount) {
+
+	// When the client requests a read-only cursor, only the column
+	// definitions are sent here, followed by an EOF packet with
+	// SERVER_STATUS_CURSOR_EXISTS set.  Rows are then pulled from the
+	// database, N at a time, by subsequent COM_STMT_FETCH requests, so
+	// at most fetchatonce rows are ever buffered by the connection.
+	cacheColumnDefinitions(cursor,colcount);
+	if (!sendColumnDefinitions(cursor,colcount,true,
+					SERVER_STATUS_CURSOR_EXISTS)) {
+		return false;
+	}
+	cursoropen[cont->getId(cursor)]=true;
+	return true;
+}
+
 void sqlrprotocol_mysql::cacheColumnDefinitions(sqlrservercursor *cursor,
 							uint32_t colcount) {
 
@@ -3152,7 +3185,8 @@ void sqlrprotocol_mysql::cacheColumnDefinitions(sqlrservercursor *cursor,
 
 bool sqlrprotocol_mysql::sendColumnDefinitions(sqlrservercursor *cursor,
 							uint32_t colcount,
-							bool binary) {
+							bool binary,
+							uint16_t statusflags) {
 
 	// column count
 	if (getDebug()) {
@@ -3174,9 +3208,16 @@ bool sqlrprotocol_mysql::sendColumnDefinitions(sqlrservercursor *cursor,
 	}
 
 	// EOF (if not deprecated)
+	//
+	// Even if the EOF is deprecated, the client expects an old-school
+	// EOF packet to tell it that a cursor was opened.
 	if (!(servercapabilityflags&CLIENT_DEPRECATE_EOF &&
 		clientcapabilityflags&CLIENT_DEPRECATE_EOF)) {
-		if (!sendEofPacket(0,0)) {
+		if (!sendEofPacket(0,statusflags)) {
+			return false;
+		}
+	} else if (statusflags&SERVER_STATUS_CURSOR_EXISTS) {
+		if (!sendOldEofPacket(0,statusflags)) {
 			return false;
 		}
 	} else {
@@ -3480,6 +3521,8 @@ bool sqlrprotocol_mysql::sendResultSetRows(sqlrservercursor *cursor,
 
 	bool	retval=false;
 
+	uint16_t	curid=cont->getId(cursor);
+
 	// for each row...
 	uint32_t	rowsfetched=0;
 	for (;;) {
@@ -3488,6 +3531,9 @@ bool sqlrprotocol_mysql::sendResultSetRows(sqlrservercursor *cursor,
 		bool	error;
 		if (!cont->fetchRow(cursor,&error)) {
 
+			// the cursor (if there was one) is exhausted now
+			cursoropen[curid]=false;
+
 			if (error) {
 				retval=sendQueryError(cursor);
 			} else {
@@ -3504,6 +3550,7 @@ bool sqlrprotocol_mysql::sendResultSetRows(sqlrservercursor *cursor,
 		if (!((binary)?buildBinaryRow(cursor,colcount):
 				buildTextRow(cursor,colcount))) {
 			debugEnd();
+			cursoropen[curid]=false;
 			retval=sendQueryError(cursor);
 			break;
 		}
@@ -3522,7 +3569,12 @@ bool sqlrprotocol_mysql::sendResultSetRows(sqlrservercursor *cursor,
 		if (rowcount) {
 			rowsfetched++;
 			if (rowsfetched==rowcount) {
-				retval=(binary)?sendEofPacket(0,0):true;
+				// if a cursor is open then tell the client
+				// that there may be more rows to fetch
+				retval=(binary)?
+					sendEofPacket(0,(cursoropen[curid])?
+						SERVER_STATUS_CURSOR_EXISTS:0):
+					true;
 				break;
 			}
 		}
@@ -4131,13 +4183,15 @@ bool sqlrprotocol_mysql::buildListQuery(sqlrservercursor *cursor,
 	}
 
 	// fill the query buffer and update the length
-	char	*querybuffer=cont->getQueryBuffer(cursor);
+	uint32_t	querybuffersize=cont->getQueryLength(cursor)+1;
+	char		*querybuffer=cont->allocateQueryBuffer(cursor,
+						querybuffersize-1);
 	if (tablebuf.getStringLength()) {
-		charstring::printf(querybuffer,maxquerysize+1,
+		charstring::printf(querybuffer,querybuffersize,
 						query,tablebuf.getString(),
 						wildbuf.getString());
 	} else {
-		charstring::printf(querybuffer,maxquerysize+1,
+		charstring::printf(querybuffer,querybuffersize,
 						query,wildbuf.getString());
 	}
 	cont->setQueryLength(cursor,charstring::length(querybuffer));
@@ -4420,8 +4474,9 @@ bool sqlrprotocol_mysql::comStmtPrepare(sqlrservercursor *cursor) {
 
 	// prepares the specified query
 
-	// reset column type cache flag
+	// reset column type cache and open cursor flags
 	columntypescached[cont->getId(cursor)]=false;
+	cursoropen[cont->getId(cursor)]=false;
 
 	// get the query and query size
 	const char	*query=(const char *)reqpacket+1;
@@ -4439,7 +4494,7 @@ bool sqlrprotocol_mysql::comStmtPrepare(sqlrservercursor *cursor) {
 	}
 
 	// copy it into the cursor's query buffer
-	char	*querybuffer=cont->getQueryBuffer(cursor);
+	char	*querybuffer=cont->allocateQueryBuffer(cursor,querylen);
 	bytestring::copy(querybuffer,query,querylen);
 	querybuffer[querylen]='\0';
 	cont->setQueryLength(cursor,querylen);
@@ -4599,6 +4654,9 @@ bool sqlrprotocol_mysql::comStmtExecute() {
 	unsigned char	flags=*rp;
 	rp++;
 
+	// any cursor opened by a previous execute is implicitly closed
+	cursoropen[cont->getId(cursor)]=false;
+
 	// get iteration count
 	uint32_t	iterationcount;
 	readLE(rp,&iterationcount,&rp);
@@ -4658,6 +4716,16 @@ bool sqlrprotocol_mysql::comStmtExecute() {
 		return sendQueryError(cursor);
 	}
 
+	// if the client requested a read-only cursor, and the query
+	// produced a result set, then just send the column definitions
+	// and let the client fetch the rows via COM_STMT_FETCH
+	if (flags&CURSOR_TYPE_READ_ONLY) {
+		uint32_t	colcount=cont->colCount(cursor);
+		if (colcount) {
+			return sendCursorResultSet(cursor,colcount);
+		}
+	}
+
 	// return the query result
 	return sendQueryResult(cursor,true);
 }
@@ -4679,10 +4747,11 @@ void sqlrprotocol_mysql::bindParameters(sqlrservercursor *cursor,
 		stdoutput.write("	bind {\n");
 	}
 
+	cont->setInputBindCount(cursor,pcount);
+
 	memorypool		*bindpool=cont->getBindPool(cursor);
 	sqlrserverbindvar	*inbinds=cont->getInputBinds(cursor);
 
-	cont->setInputBindCount(cursor,pcount);
 	bindpool->clear();
 
 	for (uint16_t i=0; i<pcount; i++) {
@@ -5093,6 +5162,7 @@ bool sqlrprotocol_mysql::comStmtClose() {
 
 	clearParams(cursor);
 	pcounts[cont->getId(cursor)]=0;
+	cursoropen[cont->getId(cursor)]=false;
 
 	// release the cursor
 	cont->setState(cursor,SQLRCURSORSTATE_AVAILABLE);
@@ -5125,6 +5195,7 @@ bool sqlrprotocol_mysql::comStmtReset() {
 
 	clearParams(cursor);
 	pcounts[cont->getId(cursor)]=0;
+	cursoropen[cont->getId(cursor)]=false;
 
 	cont->closeResultSet(cursor);
 	return sendOkPacket();
@@ -5181,7 +5252,17 @@ bool sqlrprotocol_mysql::comStmtFetch() {
 	if (!cursor) {
 		return sendCursorNotOpenError();
 	}
-	return sendResultSetRows(cursor,cont->colCount(cursor),numrows,true);
+
+	// rows can only be fetched from a cursor that
+	// was opened by COM_STMT_EXECUTE
+	if (!cursoropen[cont->getId(cursor)]) {
+		return sendNoOpenCursorError(stmtid);
+	}
+
+	// send exactly the requested number of rows (or fewer,
+	// if the result set is exhausted first)
+	return sendResultSetRows(cursor,cont->colCount(cursor),
+					(numrows)?numrows:1,true);
 }
 
 bool sqlrprotocol_mysql::sendError() {
@@ -5221,6 +5302,14 @@ bool sqlrprotocol_mysql::sendCursorNotOpenError() {
 	return sendErrPacket(1325,"Cursor is not open","24000");
 }
 
+bool sqlrprotocol_mysql::sendNoOpenCursorError(uint32_t stmtid) {
+	stringbuffer	err;
+	err.append("The statement (");
+	err.append(stmtid);
+	err.append(") has no open cursor.");
+	return sendErrPacket(1421,err.getString(),"HY000");
+}
+
 bool sqlrprotocol_mysql::sendMalformedPacketError() {
 	return sendErrPacket(2027,"Malformed packet","");
 }
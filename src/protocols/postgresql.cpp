@@ -89,6 +89,8 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_postgresql : public sqlrprotocol {
 
 		bool	initialHandshake();
 		bool	recvStartupMessage();
+		void	recvCancelRequest(const unsigned char *rp,
+						const unsigned char *rpend);
 		bool	handleTlsRequest();
 		void	parseOptions(const char *opts);
 		bool	sendStartupMessageResponse();
@@ -584,6 +586,12 @@ bool sqlrprotocol_postgresql::recvStartupMessage() {
 		// protocol version
 		readBE(rp,&protocolversion,&rp);
 
+		// handle cancel requests
+		if (protocolversion==80877102) {
+			recvCancelRequest(rp,rpend);
+			return false;
+		}
+
 		// if the client requested SSL, then deny it
 		if (protocolversion==80877103) {
 
@@ -938,6 +946,47 @@ bool sqlrprotocol_postgresql::sendAuthenticationOk() {
 	return sendPacket(MESSAGE_AUTHENTICATION);
 }
 
+void sqlrprotocol_postgresql::recvCancelRequest(const unsigned char *rp,
+						const unsigned char *rpend) {
+
+	// request packet data structure:
+	//
+	// data {
+	// 	int32_t		protocol version (80877102)
+	//	uint32_t	process id
+	//	uint32_t	secret key
+	// }
+
+	// (the protocol version has already been read)
+	if (rpend-rp<(ssize_t)(2*sizeof(uint32_t))) {
+		return;
+	}
+	uint32_t	pid;
+	uint32_t	key;
+	readBE(rp,&pid,&rp);
+	readBE(rp,&key,&rp);
+
+	// debug
+	if (getDebug()) {
+		debugStart("CancelRequest");
+		stdoutput.printf("	process id: %d\n",pid);
+		stdoutput.printf("	secret key: %d\n",key);
+		debugEnd();
+	}
+
+	// The process id and secret key are the ones that were sent to the
+	// client in the BackendKeyData message, so the process id is the pid
+	// of the connection that's running the query, and the secret key is
+	// that connection's cancel key.
+	//
+	// The server doesn't send a response to a cancel request, and the
+	// client just closes the connection.
+	//
+	// Cancel requests don't say which query they're for, so this cancels
+	// whatever query the connection is running.
+	cont->cancelQuery(pid,key,0);
+}
+
 bool sqlrprotocol_postgresql::sendBackendKeyData() {
 
 	// response packet data structure:
@@ -949,7 +998,7 @@ bool sqlrprotocol_postgresql::sendBackendKeyData() {
 
 	// set values to send
 	uint32_t	pid=process::getProcessId();
-	rand.generateNumber(&secretkey);
+	secretkey=cont->getCancelKey();
 
 	// debug
 	if (getDebug()) {
@@ -1989,7 +2038,7 @@ bool sqlrprotocol_postgresql::parse() {
 	}
 
 	// copy the query into the cursor's query buffer
-	char	*querybuffer=cont->getQueryBuffer(cursor);
+	char	*querybuffer=cont->allocateQueryBuffer(cursor,querylength);
 	bytestring::copy(querybuffer,query,querylength);
 	querybuffer[querylength]='\0';
 	cont->setQueryLength(cursor,querylength);
@@ -2070,9 +2119,6 @@ bool sqlrprotocol_postgresql::bind() {
 	// (see execute() method for more info on this)
 	executeflag.setValue(cursor,true);
 
-	// get the input binds
-	sqlrserverbindvar	*inbinds=cont->getInputBinds(cursor);
-
 	// debug
 	if (getDebug()) {
 		stdoutput.printf("	portal name: %s\n",portal.getString());
@@ -2117,6 +2163,11 @@ bool sqlrprotocol_postgresql::bind() {
 		stdoutput.printf("	param value count: %d\n",
 							paramvaluecount);
 	}
+
+	// set the bind count and get the input binds
+	cont->setInputBindCount(cursor,paramvaluecount);
+	sqlrserverbindvar	*inbinds=cont->getInputBinds(cursor);
+
 	for (uint16_t i=0; i<paramvaluecount; i++) {
 
 		sqlrserverbindvar	*bv=&(inbinds[i]);
@@ -2176,9 +2227,6 @@ bool sqlrprotocol_postgresql::bind() {
 
 	delete[] paramformatcodes;
 
-	// set the bind count
-	cont->setInputBindCount(cursor,paramvaluecount);
-
 	// result format codes...
 	// FIXME: do something with these...
 	uint16_t	resultformatcodecount;
@@ -18,6 +18,10 @@
 #include <defaults.h>
 #include <defines.h>
 
+#define MAX_BYTES_PER_CHAR	4
+#define MIN_LOB_SEGMENT_SIZE	32768
+#define MAX_LOB_SEGMENT_SIZE	4194304
+
 enum sqlrclientquerytype_t {
 	SQLRCLIENTQUERYTYPE_QUERY=0,
 	SQLRCLIENTQUERYTYPE_DATABASE_LIST,
@@ -53,6 +57,8 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_sqlrclient : public sqlrprotocol {
 		bool	getPasswordFromClient();
 		void	suspendSessionCommand();
 		void	pingCommand();
+		bool	getCancelKeyCommand();
+		bool	cancelQueryCommand();
 		void	identifyCommand();
 		void	autoCommitCommand();
 		void	beginCommand();
@@ -115,7 +121,8 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_sqlrclient : public sqlrprotocol {
 		void	returnOutputBindClob(sqlrservercursor *cursor,
 							uint16_t index);
 		void	sendLobOutputBind(sqlrservercursor *cursor,
-							uint16_t index);
+							uint16_t index,
+							bool binary);
 		void	returnInputOutputBindValues(sqlrservercursor *cursor);
 		void	sendColumnDefinition(const char *name,
 						uint16_t namelen,
@@ -158,6 +165,11 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_sqlrclient : public sqlrprotocol {
 		void	sendField(const char *data, uint32_t size);
 		void	sendNullField();
 		void	sendLobField(sqlrservercursor *cursor, uint32_t col);
+		uint64_t	prepareLobSegment(uint64_t loblength,
+							uint64_t offset,
+							bool binary);
+		void		growLobSegment(uint64_t charstoread,
+							uint64_t charsread);
 		void	startSendingLong(uint64_t longlength);
 		void	sendLongSegment(const char *data, uint32_t size);
 		void	endSendingLong();
@@ -232,7 +244,9 @@ class SQLRSERVER_DLLSPEC sqlrprotocol_sqlrclient : public sqlrprotocol {
 		uint64_t	fetch;
 		bool		lazyfetch;
 
-		char		lobbuffer[32768];
+		char		*lobbuffer;
+		uint64_t	lobbuffersize;
+		uint64_t	lobsegmentsize;
 
 		uint16_t	protocolversion;
 		uint16_t	endresultset;
@@ -259,6 +273,10 @@ sqlrprotocol_sqlrclient::sqlrprotocol_sqlrclient(
 	clientinfo=new char[maxclientinfolength+1];
 	clientsock=NULL;
 
+	lobbuffersize=MIN_LOB_SEGMENT_SIZE;
+	lobbuffer=new char[lobbuffersize];
+	lobsegmentsize=MIN_LOB_SEGMENT_SIZE;
+
 	if (useKrb()) {
 		ctx=getGssContext();
 	} else if (useTls()) {
@@ -274,6 +292,7 @@ sqlrprotocol_sqlrclient::sqlrprotocol_sqlrclient(
 sqlrprotocol_sqlrclient::~sqlrprotocol_sqlrclient() {
 	debugFunction();
 	delete[] clientinfo;
+	delete[] lobbuffer;
 }
 
 clientsessionexitstatus_t sqlrprotocol_sqlrclient::clientSession(
@@ -360,6 +379,18 @@ clientsessionexitstatus_t sqlrprotocol_sqlrclient::clientSession(
 			cont->incrementPingCount();
 			pingCommand();
 			continue;
+		} else if (command==GET_CANCEL_KEY) {
+			if (getCancelKeyCommand()) {
+				continue;
+			}
+			endsession=false;
+			break;
+		} else if (command==CANCEL_QUERY) {
+			if (cancelQueryCommand()) {
+				continue;
+			}
+			endsession=false;
+			break;
 		} else if (command==IDENTIFY) {
 			cont->incrementIdentifyCount();
 			identifyCommand();
@@ -435,7 +466,7 @@ clientsessionexitstatus_t sqlrprotocol_sqlrclient::clientSession(
 
 		// set the command start-time
 		cont->setCommandStart(cursor,
-				dt.getSeconds(),dt.getMicroseconds());
+				dt.getEpoch(),dt.getMicroseconds());
 
 		// these commands are all handled at the cursor level
 		if (command==NEW_QUERY) {
@@ -507,7 +538,7 @@ clientsessionexitstatus_t sqlrprotocol_sqlrclient::clientSession(
 		// set the command end-time
 		dt.getSystemDateAndTime();
 		cont->setCommandEnd(cursor,
-				dt.getSeconds(),dt.getMicroseconds());
+				dt.getEpoch(),dt.getMicroseconds());
 
 		// free memory used by binds...
 		// FIXME: can we move this inside of processQueryOrBindCursor?
@@ -876,6 +907,85 @@ void sqlrprotocol_sqlrclient::pingCommand() {
 	}
 }
 
+bool sqlrprotocol_sqlrclient::getCancelKeyCommand() {
+	debugFunction();
+
+	cont->raiseDebugMessageEvent("get cancel key");
+
+	// The client follows this command with an invalid cursor id.  Older
+	// servers that don't support this command treat it like a command
+	// that uses a cursor, and return a no-cursors error rather than
+	// waiting for more data or ending the session.
+	uint16_t	id;
+	ssize_t		result=clientsock->read(&id,idleclienttimeout,0);
+	if (result!=sizeof(uint16_t)) {
+		cont->raiseClientProtocolErrorEvent(NULL,
+				"get cancel key failed: "
+				"failed to get cursor id",result);
+		return false;
+	}
+
+	// send the pid, the cancel key, and the id of the next query,
+	// which is the one that the client is about to send
+	// (this is sent right away, while the query runs, so the client
+	// has it if it gives up waiting for the query)
+	clientsock->write((uint16_t)NO_ERROR_OCCURRED);
+	clientsock->write((uint32_t)process::getProcessId());
+	clientsock->write(cont->getCancelKey());
+	clientsock->write(cont->getNextQueryId());
+	clientsock->flushWriteBuffer(-1,-1);
+	return true;
+}
+
+bool sqlrprotocol_sqlrclient::cancelQueryCommand() {
+	debugFunction();
+
+	cont->raiseDebugMessageEvent("cancel query");
+
+	// get the pid and cancel key of the connection
+	// that's running the query to cancel, and the query's id
+	uint32_t	pid;
+	uint32_t	key;
+	uint32_t	queryid;
+	ssize_t		result=clientsock->read(&pid,idleclienttimeout,0);
+	if (result!=sizeof(uint32_t)) {
+		cont->raiseClientProtocolErrorEvent(NULL,
+				"cancel query failed: "
+				"failed to get pid",result);
+		return false;
+	}
+	result=clientsock->read(&key,idleclienttimeout,0);
+	if (result!=sizeof(uint32_t)) {
+		cont->raiseClientProtocolErrorEvent(NULL,
+				"cancel query failed: "
+				"failed to get cancel key",result);
+		return false;
+	}
+	result=clientsock->read(&queryid,idleclienttimeout,0);
+	if (result!=sizeof(uint32_t)) {
+		cont->raiseClientProtocolErrorEvent(NULL,
+				"cancel query failed: "
+				"failed to get query id",result);
+		return false;
+	}
+
+	// cancel the query
+	if (cont->cancelQuery(pid,key,queryid)) {
+		clientsock->write((uint16_t)NO_ERROR_OCCURRED);
+		clientsock->flushWriteBuffer(-1,-1);
+		return true;
+	}
+
+	// indicate that an error has occurred
+	clientsock->write((uint16_t)ERROR_OCCURRED);
+	clientsock->write((uint64_t)SQLR_ERROR_CANCELFAILED);
+	clientsock->write((uint16_t)charstring::length(
+				SQLR_ERROR_CANCELFAILED_STRING));
+	clientsock->write(SQLR_ERROR_CANCELFAILED_STRING);
+	clientsock->flushWriteBuffer(-1,-1);
+	return true;
+}
+
 void sqlrprotocol_sqlrclient::identifyCommand() {
 	debugFunction();
 
@@ -1533,6 +1643,7 @@ bool sqlrprotocol_sqlrclient::getQuery(sqlrservercursor *cursor) {
 	}
 
 	// read the query into the buffer
+	querybuffer=cont->allocateQueryBuffer(cursor,querylength);
 	result=clientsock->read(querybuffer,querylength,idleclienttimeout,0);
 	if ((uint32_t)result!=querylength) {
 
@@ -2899,21 +3010,20 @@ void sqlrprotocol_sqlrclient::returnOutputBindValues(sqlrservercursor *cursor) {
 void sqlrprotocol_sqlrclient::returnOutputBindBlob(sqlrservercursor *cursor,
 							uint16_t index) {
 	debugFunction();
-	sendLobOutputBind(cursor,index);
+	sendLobOutputBind(cursor,index,true);
 	cont->closeLobOutputBind(cursor,index);
 }
 
 void sqlrprotocol_sqlrclient::returnOutputBindClob(sqlrservercursor *cursor,
 							uint16_t index) {
 	debugFunction();
-	sendLobOutputBind(cursor,index);
+	sendLobOutputBind(cursor,index,false);
 	cont->closeLobOutputBind(cursor,index);
 }
 
-#define MAX_BYTES_PER_CHAR	4
-
 void sqlrprotocol_sqlrclient::sendLobOutputBind(sqlrservercursor *cursor,
-							uint16_t index) {
+							uint16_t index,
+							bool binary) {
 	debugFunction();
 
 	// Get lob length.  If this fails, send a NULL field.
@@ -2932,16 +3042,20 @@ void sqlrprotocol_sqlrclient::sendLobOutputBind(sqlrservercursor *cursor,
 	}
 
 	// initialize sizes and status
-	uint64_t	charstoread=sizeof(lobbuffer)/MAX_BYTES_PER_CHAR;
+	uint64_t	charstoread=0;
 	uint64_t	charsread=0;
 	uint64_t	offset=0;
 	bool		start=true;
+	lobsegmentsize=MIN_LOB_SEGMENT_SIZE;
 
 	for (;;) {
 
+		// size the next segment
+		charstoread=prepareLobSegment(loblength,offset,binary);
+
 		// read a segment from the lob
 		if (!cont->getLobOutputBindSegment(cursor,index,
-					lobbuffer,sizeof(lobbuffer),
+					lobbuffer,lobbuffersize,
 					offset,charstoread,&charsread) ||
 					!charsread) {
 
@@ -2968,6 +3082,9 @@ void sqlrprotocol_sqlrclient::sendLobOutputBind(sqlrservercursor *cursor,
 
 			// FIXME: or should this be charsread?
 			offset=offset+charstoread;
+
+			// grow the next segment if this one was filled
+			growLobSegment(charstoread,charsread);
 		}
 	}
 }
@@ -3443,12 +3560,16 @@ void sqlrprotocol_sqlrclient::sendNullField() {
 	clientsock->write((uint16_t)NULL_DATA);
 }
 
-#define MAX_BYTES_PER_CHAR	4
-
 void sqlrprotocol_sqlrclient::sendLobField(sqlrservercursor *cursor,
 							uint32_t col) {
 	debugFunction();
 
+	// binary lobs are read byte-for-byte, others may contain
+	// multi-byte characters
+	bool	binary=(cont->getColumnIsBinary(cursor,col) ||
+			cont->isBinaryType(
+				(int16_t)cont->getColumnType(cursor,col)));
+
 	// Get lob length.  If this fails, send a NULL field.
 	uint64_t	loblength;
 	if (!cont->getLobFieldLength(cursor,col,&loblength)) {
@@ -3467,16 +3588,20 @@ void sqlrprotocol_sqlrclient::sendLobField(sqlrservercursor *cursor,
 	}
 
 	// initialize sizes and status
-	uint64_t	charstoread=sizeof(lobbuffer)/MAX_BYTES_PER_CHAR;
+	uint64_t	charstoread=0;
 	uint64_t	charsread=0;
 	uint64_t	offset=0;
 	bool		start=true;
+	lobsegmentsize=MIN_LOB_SEGMENT_SIZE;
 
 	for (;;) {
 
+		// size the next segment
+		charstoread=prepareLobSegment(loblength,offset,binary);
+
 		// read a segment from the lob
 		if (!cont->getLobFieldSegment(cursor,col,
-					lobbuffer,sizeof(lobbuffer),
+					lobbuffer,lobbuffersize,
 					offset,charstoread,&charsread) ||
 					!charsread) {
 
@@ -3504,6 +3629,54 @@ void sqlrprotocol_sqlrclient::sendLobField(sqlrservercursor *cursor,
 
 			// FIXME: or should this be charsread?
 			offset=offset+charstoread;
+
+			// grow the next segment if this one was filled
+			growLobSegment(charstoread,charsread);
+		}
+	}
+}
+
+uint64_t sqlrprotocol_sqlrclient::prepareLobSegment(uint64_t loblength,
+							uint64_t offset,
+							bool binary) {
+	debugFunction();
+
+	// Size the segment to whatever is left of the lob, but no larger than
+	// the current segment size.  Binary lobs are 1 byte per char, others
+	// might need up to MAX_BYTES_PER_CHAR bytes per char.  If the lob
+	// turns out to be longer than reported, keep reading in minimum-sized
+	// segments until the db says there's no more.
+	uint64_t	bytesperchar=(binary)?1:MAX_BYTES_PER_CHAR;
+	uint64_t	remaining=(offset<loblength)?loblength-offset:0;
+	uint64_t	bytes=lobsegmentsize;
+	if (remaining && remaining<=lobsegmentsize/bytesperchar) {
+		bytes=remaining*bytesperchar;
+	}
+	if (bytes<MIN_LOB_SEGMENT_SIZE) {
+		bytes=MIN_LOB_SEGMENT_SIZE;
+	}
+
+	// grow the buffer if necessary
+	if (bytes>lobbuffersize) {
+		delete[] lobbuffer;
+		lobbuffersize=bytes;
+		lobbuffer=new char[lobbuffersize];
+	}
+
+	return bytes/bytesperchar;
+}
+
+void sqlrprotocol_sqlrclient::growLobSegment(uint64_t charstoread,
+							uint64_t charsread) {
+	debugFunction();
+
+	// if the segment came back full, then there's probably a lot more
+	// where that came from, so double the segment size (up to a limit)
+	// to cut down on round trips to the db
+	if (charsread>=charstoread && lobsegmentsize<MAX_LOB_SEGMENT_SIZE) {
+		lobsegmentsize=lobsegmentsize*2;
+		if (lobsegmentsize>MAX_LOB_SEGMENT_SIZE) {
+			lobsegmentsize=MAX_LOB_SEGMENT_SIZE;
 		}
 	}
 }
@@ -4127,13 +4300,15 @@ bool sqlrprotocol_sqlrclient::buildListQuery(sqlrservercursor *cursor,
 	}
 
 	// fill the query buffer and update the length
-	char	*querybuffer=cont->getQueryBuffer(cursor);
+	uint32_t	querybuffersize=cont->getQueryLength(cursor)+1;
+	char		*querybuffer=cont->allocateQueryBuffer(cursor,
+						querybuffersize-1);
 	if (objectbuf.getStringLength()) {
-		charstring::printf(querybuffer,maxquerysize+1,
+		charstring::printf(querybuffer,querybuffersize,
 						query,objectbuf.getString(),
 						wildbuf.getString());
 	} else {
-		charstring::printf(querybuffer,maxquerysize+1,
+		charstring::printf(querybuffer,querybuffersize,
 						query,wildbuf.getString());
 	}
 	cont->setQueryLength(cursor,charstring::length(querybuffer));
@@ -48,6 +48,7 @@ class sqlrquery_sqlrcmdcstatcursor : public sqlrquerycursor {
 		char		*fieldbuffer[9];
 
 		sqlrconnstatistics	*cs;
+		sqlrconntext		*ct;
 
 };
 
@@ -82,6 +83,7 @@ sqlrquery_sqlrcmdcstatcursor::sqlrquery_sqlrcmdcstatcursor(
 		fieldbuffer[i]=NULL;
 	}
 	cs=NULL;
+	ct=NULL;
 }
 
 sqlrquery_sqlrcmdcstatcursor::~sqlrquery_sqlrcmdcstatcursor() {
@@ -150,8 +152,10 @@ bool sqlrquery_sqlrcmdcstatcursor::noRowsToReturn() {
 
 bool sqlrquery_sqlrcmdcstatcursor::fetchRow(bool *error) {
 	*error=false;
-	while (currentrow<MAXCONNECTIONS) {
-		cs=&(conn->cont->getShm()->connstats[currentrow]);
+	sqlrshm	*shm=conn->cont->getShm();
+	while (currentrow<shm->maxconnections) {
+		cs=sqlrshmConnStats(shm,currentrow);
+		ct=sqlrshmConnText(shm,currentrow);
 		currentrow++;
 		if (cs->processid) {
 			return true;
@@ -231,10 +235,10 @@ void sqlrquery_sqlrcmdcstatcursor::getField(uint32_t col,
 			datetime	dt;
 			dt.getSystemDateAndTime();
 			double	statetime=
-				((double)(dt.getSeconds()-
-					cs->statestartsec))+
-				((double)(dt.getMicroseconds()-
-					cs->statestartusec))/1000000.0;
+				((double)dt.getEpoch()-
+					(double)cs->statestartsec)+
+				((double)dt.getMicroseconds()-
+					(double)cs->statestartusec)/1000000.0;
 			fieldbuffer[col]=charstring::parseNumber(statetime,
 					colinfo[5].precision,colinfo[5].scale);
 			}
@@ -242,19 +246,19 @@ void sqlrquery_sqlrcmdcstatcursor::getField(uint32_t col,
 		case 6:
 			// client_addr -
 			// address of currently connected client
-			*field=cs->clientaddr;
+			*field=ct->clientaddr;
 			*fieldlength=charstring::length(*field);
 			return;
 		case 7:
 			// client info -
 			// client info string
-			*field=cs->clientinfo;
+			*field=ct->clientinfo;
 			*fieldlength=charstring::length(*field);
 			return;
 		case 8:
 			// sql_text -
 			// query currently being executed
-			*field=cs->sqltext;
+			*field=ct->sqltext;
 			*fieldlength=charstring::length(*field);
 			return;
 		default:
@@ -0,0 +1,289 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information
+
+#include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlratomic.h>
+#include <rudiments/charstring.h>
+//#define DEBUG_MESSAGES 1
+#include <rudiments/debugprint.h>
+#include <datatypes.h>
+
+class SQLRSERVER_DLLSPEC sqlrquery_sqlrcmdfingerprints : public sqlrquery {
+	public:
+			sqlrquery_sqlrcmdfingerprints(sqlrservercontroller *cont,
+							sqlrqueries *qs,
+							domnode *parameters);
+		bool	match(const char *querystring, uint32_t querylength);
+		sqlrquerycursor	*newCursor(sqlrserverconnection *conn,
+							uint16_t id);
+};
+
+class sqlrquery_sqlrcmdfingerprintscursor : public sqlrquerycursor {
+	public:
+			sqlrquery_sqlrcmdfingerprintscursor(
+						sqlrserverconnection *sqlrcon,
+						sqlrquery *q,
+						domnode *parameters,
+						uint16_t id);
+			~sqlrquery_sqlrcmdfingerprintscursor();
+
+		bool		executeQuery(const char *query,
+						uint32_t length);
+		uint32_t	colCount();
+		const char	*getColumnName(uint32_t col);
+		uint16_t	getColumnType(uint32_t col);
+		uint32_t	getColumnLength(uint32_t col);
+		uint32_t	getColumnPrecision(uint32_t col);
+		uint32_t	getColumnScale(uint32_t col);
+		bool		noRowsToReturn();
+		bool		fetchRow(bool *error);
+		void		getField(uint32_t col,
+					const char **field,
+					uint64_t *fieldlength,
+					bool *blob, bool *null);
+	private:
+		uint64_t	standardDeviation();
+
+		uint32_t	currentrow;
+		uint32_t	rowcount;
+		uint32_t	rows[STATFINGERPRINTS];
+		char		*fieldbuffer[10];
+
+		sqlrfingerprintstatistics	*fs;
+};
+
+sqlrquery_sqlrcmdfingerprints::sqlrquery_sqlrcmdfingerprints(
+						sqlrservercontroller *cont,
+						sqlrqueries *qs,
+						domnode *parameters) :
+						sqlrquery(cont,qs,parameters) {
+	debugFunction();
+}
+
+bool sqlrquery_sqlrcmdfingerprints::match(const char *querystring,
+						uint32_t querylength) {
+	debugFunction();
+	return !charstring::compareIgnoringCase(querystring,
+						"sqlrcmd fingerprints");
+}
+
+sqlrquerycursor *sqlrquery_sqlrcmdfingerprints::newCursor(
+					sqlrserverconnection *sqlrcon,
+					uint16_t id) {
+	return new sqlrquery_sqlrcmdfingerprintscursor(sqlrcon,this,
+						getParameters(),id);
+}
+
+sqlrquery_sqlrcmdfingerprintscursor::sqlrquery_sqlrcmdfingerprintscursor(
+					sqlrserverconnection *sqlrcon,
+					sqlrquery *q,
+					domnode *parameters,
+					uint16_t id) :
+				sqlrquerycursor(sqlrcon,q,parameters,id) {
+	currentrow=0;
+	rowcount=0;
+	for (uint16_t i=0; i<10; i++) {
+		fieldbuffer[i]=NULL;
+	}
+	fs=NULL;
+}
+
+sqlrquery_sqlrcmdfingerprintscursor::~sqlrquery_sqlrcmdfingerprintscursor() {
+	for (uint16_t i=0; i<10; i++) {
+		delete[] fieldbuffer[i];
+	}
+}
+
+bool sqlrquery_sqlrcmdfingerprintscursor::executeQuery(const char *query,
+							uint32_t length) {
+
+	// collect the fingerprints that anything has been recorded for...
+	sqlrshm	*shm=conn->cont->getShm();
+	currentrow=0;
+	rowcount=0;
+	for (uint32_t i=0; i<STATFINGERPRINTS; i++) {
+		if (shm->fingerprints[i].hash && shm->fingerprints[i].calls) {
+			rows[rowcount++]=i;
+		}
+	}
+
+	// ...and sort them, most total time first
+	for (uint32_t i=1; i<rowcount; i++) {
+		uint32_t	row=rows[i];
+		uint64_t	totalusec=shm->fingerprints[row].totalusec;
+		uint32_t	j=i;
+		while (j && shm->fingerprints[rows[j-1]].totalusec<totalusec) {
+			rows[j]=rows[j-1];
+			j--;
+		}
+		rows[j]=row;
+	}
+	return true;
+}
+
+uint32_t sqlrquery_sqlrcmdfingerprintscursor::colCount() {
+	return 10;
+}
+
+struct colinfo_t {
+	const char	*name;
+	uint16_t	type;
+	uint32_t	length;
+	uint32_t	precision;
+	uint32_t	scale;
+};
+
+static struct colinfo_t colinfo[]={
+	{"FINGERPRINT",VARCHAR2_DATATYPE,STATSQLTEXTLEN,0,0},
+	{"CALLS",NUMBER_DATATYPE,20,20,0},
+	{"ERRORS",NUMBER_DATATYPE,20,20,0},
+	{"ROWS",NUMBER_DATATYPE,20,20,0},
+	{"BYTES",NUMBER_DATATYPE,20,20,0},
+	{"TOTAL_USEC",NUMBER_DATATYPE,20,20,0},
+	{"AVG_USEC",NUMBER_DATATYPE,20,20,0},
+	{"MIN_USEC",NUMBER_DATATYPE,20,20,0},
+	{"MAX_USEC",NUMBER_DATATYPE,20,20,0},
+	{"STDDEV_USEC",NUMBER_DATATYPE,20,20,0}
+};
+
+const char *sqlrquery_sqlrcmdfingerprintscursor::getColumnName(uint32_t col) {
+	return (col<10)?colinfo[col].name:NULL;
+}
+
+uint16_t sqlrquery_sqlrcmdfingerprintscursor::getColumnType(uint32_t col) {
+	return (col<10)?colinfo[col].type:0;
+}
+
+uint32_t sqlrquery_sqlrcmdfingerprintscursor::getColumnLength(uint32_t col) {
+	return (col<10)?colinfo[col].length:0;
+}
+
+uint32_t sqlrquery_sqlrcmdfingerprintscursor::getColumnPrecision(uint32_t col) {
+	return (col<10)?colinfo[col].precision:0;
+}
+
+uint32_t sqlrquery_sqlrcmdfingerprintscursor::getColumnScale(uint32_t col) {
+	return (col<10)?colinfo[col].scale:0;
+}
+
+bool sqlrquery_sqlrcmdfingerprintscursor::noRowsToReturn() {
+	return false;
+}
+
+bool sqlrquery_sqlrcmdfingerprintscursor::fetchRow(bool *error) {
+	*error=false;
+	if (currentrow<rowcount) {
+		fs=&(conn->cont->getShm()->fingerprints[rows[currentrow]]);
+		currentrow++;
+		return true;
+	}
+	return false;
+}
+
+void sqlrquery_sqlrcmdfingerprintscursor::getField(uint32_t col,
+						const char **field,
+						uint64_t *fieldlength,
+						bool *blob,
+						bool *null) {
+	*field=NULL;
+	*fieldlength=0;
+	*blob=false;
+	*null=false;
+
+	delete[] fieldbuffer[col];
+	fieldbuffer[col]=NULL;
+
+	switch (col) {
+		case 0:
+			// fingerprint -
+			// the normalized query, with literals and
+			// bind variables replaced by ?'s
+			*field=fs->fingerprint;
+			*fieldlength=charstring::length(*field);
+			return;
+		case 1:
+			// calls -
+			// number of times queries with the fingerprint were run
+			fieldbuffer[col]=charstring::parseNumber(fs->calls);
+			break;
+		case 2:
+			// errors -
+			// number of those that failed
+			fieldbuffer[col]=charstring::parseNumber(fs->errors);
+			break;
+		case 3:
+			// rows -
+			// total rows fetched or affected
+			fieldbuffer[col]=charstring::parseNumber(fs->rows);
+			break;
+		case 4:
+			// bytes -
+			// total bytes of field data sent to the client
+			fieldbuffer[col]=charstring::parseNumber(fs->bytes);
+			break;
+		case 5:
+			// total_usec -
+			// total execution time
+			fieldbuffer[col]=charstring::parseNumber(fs->totalusec);
+			break;
+		case 6:
+			// avg_usec -
+			// average execution time
+			fieldbuffer[col]=charstring::parseNumber(
+						fs->totalusec/fs->calls);
+			break;
+		case 7:
+			// min_usec -
+			// lowest execution time
+			fieldbuffer[col]=charstring::parseNumber(fs->minusec);
+			break;
+		case 8:
+			// max_usec -
+			// highest execution time
+			fieldbuffer[col]=charstring::parseNumber(fs->maxusec);
+			break;
+		case 9:
+			// stddev_usec -
+			// standard deviation of the execution time
+			fieldbuffer[col]=charstring::parseNumber(
+						standardDeviation());
+			break;
+		default:
+			*null=true;
+			return;
+	}
+
+	*field=fieldbuffer[col];
+	*fieldlength=charstring::length(fieldbuffer[col]);
+}
+
+uint64_t sqlrquery_sqlrcmdfingerprintscursor::standardDeviation() {
+
+	// variance = mean of the squares - square of the mean
+	double	calls=(double)fs->calls;
+	double	mean=((double)fs->totalusec)/calls;
+	double	variance=atomicGetDouble(&(fs->sumsquares))/calls-mean*mean;
+	if (variance<=0.0) {
+		return 0;
+	}
+
+	// square root, by Newton's method
+	double	root=(variance>1.0)?variance/2.0:1.0;
+	for (uint16_t i=0; i<64; i++) {
+		double	next=(root+variance/root)/2.0;
+		if (next==root) {
+			break;
+		}
+		root=next;
+	}
+	return (uint64_t)(root+0.5);
+}
+
+extern "C" {
+	SQLRSERVER_DLLSPEC sqlrquery *new_sqlrquery_sqlrcmdfingerprints(
+						sqlrservercontroller *cont,
+						sqlrqueries *qs,
+						domnode *parameters) {
+		return new sqlrquery_sqlrcmdfingerprints(cont,qs,parameters);
+	}
+}
@@ -199,6 +199,10 @@ bool sqlrquery_sqlrcmdgstatcursor::executeQuery(const char *query,
 	setGSResult("busy_listener",gs->forked_listeners,rowcount++);
 	setGSResult("peak_listener",gs->peak_listeners,rowcount++);
 	setGSResult("connection",gs->totalconnections,rowcount++);
+	setGSResult("max_connection",gs->maxconnections,rowcount++);
+	charstring::printf(tmpbuf,GSTAT_VALUE_LEN,"%llu",
+					(unsigned long long)gs->size);
+	setGSResult("shm_size",tmpbuf,rowcount++);
 	setGSResult("session",connectedclients,rowcount++);
 	setGSResult("peak_session",gs->peak_connectedclients,rowcount++);
 	setGSResult("peak_session_1min",
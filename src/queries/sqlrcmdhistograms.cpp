@@ -0,0 +1,251 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information
+
+#include <sqlrelay/sqlrserver.h>
+#include <sqlrelay/private/sqlrlatencyhistogram.h>
+#include <rudiments/charstring.h>
+//#define DEBUG_MESSAGES 1
+#include <rudiments/debugprint.h>
+#include <datatypes.h>
+
+class SQLRSERVER_DLLSPEC sqlrquery_sqlrcmdhistograms : public sqlrquery {
+	public:
+			sqlrquery_sqlrcmdhistograms(sqlrservercontroller *cont,
+							sqlrqueries *qs,
+							domnode *parameters);
+		bool	match(const char *querystring, uint32_t querylength);
+		sqlrquerycursor	*newCursor(sqlrserverconnection *conn,
+							uint16_t id);
+};
+
+class sqlrquery_sqlrcmdhistogramscursor : public sqlrquerycursor {
+	public:
+			sqlrquery_sqlrcmdhistogramscursor(
+						sqlrserverconnection *sqlrcon,
+						sqlrquery *q,
+						domnode *parameters,
+						uint16_t id);
+			~sqlrquery_sqlrcmdhistogramscursor();
+
+		bool		executeQuery(const char *query,
+						uint32_t length);
+		uint32_t	colCount();
+		const char	*getColumnName(uint32_t col);
+		uint16_t	getColumnType(uint32_t col);
+		uint32_t	getColumnLength(uint32_t col);
+		uint32_t	getColumnPrecision(uint32_t col);
+		uint32_t	getColumnScale(uint32_t col);
+		bool		noRowsToReturn();
+		bool		fetchRow(bool *error);
+		void		getField(uint32_t col,
+					const char **field,
+					uint64_t *fieldlength,
+					bool *blob, bool *null);
+	private:
+		uint32_t	currentrow;
+		uint32_t	querytype;
+		uint32_t	stage;
+		uint64_t	count;
+		char		*fieldbuffer[9];
+
+		sqlrlatencyhistogram	*h;
+};
+
+sqlrquery_sqlrcmdhistograms::sqlrquery_sqlrcmdhistograms(
+						sqlrservercontroller *cont,
+						sqlrqueries *qs,
+						domnode *parameters) :
+						sqlrquery(cont,qs,parameters) {
+	debugFunction();
+}
+
+bool sqlrquery_sqlrcmdhistograms::match(const char *querystring,
+						uint32_t querylength) {
+	debugFunction();
+	return !charstring::compareIgnoringCase(querystring,
+						"sqlrcmd histograms");
+}
+
+sqlrquerycursor *sqlrquery_sqlrcmdhistograms::newCursor(
+					sqlrserverconnection *sqlrcon,
+					uint16_t id) {
+	return new sqlrquery_sqlrcmdhistogramscursor(sqlrcon,this,
+						getParameters(),id);
+}
+
+sqlrquery_sqlrcmdhistogramscursor::sqlrquery_sqlrcmdhistogramscursor(
+					sqlrserverconnection *sqlrcon,
+					sqlrquery *q,
+					domnode *parameters,
+					uint16_t id) :
+				sqlrquerycursor(sqlrcon,q,parameters,id) {
+	currentrow=0;
+	querytype=0;
+	stage=0;
+	count=0;
+	for (uint16_t i=0; i<9; i++) {
+		fieldbuffer[i]=NULL;
+	}
+	h=NULL;
+}
+
+sqlrquery_sqlrcmdhistogramscursor::~sqlrquery_sqlrcmdhistogramscursor() {
+	for (uint16_t i=0; i<9; i++) {
+		delete[] fieldbuffer[i];
+	}
+}
+
+bool sqlrquery_sqlrcmdhistogramscursor::executeQuery(const char *query,
+							uint32_t length) {
+	currentrow=0;
+	return true;
+}
+
+uint32_t sqlrquery_sqlrcmdhistogramscursor::colCount() {
+	return 9;
+}
+
+struct colinfo_t {
+	const char	*name;
+	uint16_t	type;
+	uint32_t	length;
+	uint32_t	precision;
+	uint32_t	scale;
+};
+
+static struct colinfo_t colinfo[]={
+	{"QUERY_TYPE",VARCHAR2_DATATYPE,10,0,0},
+	{"STAGE",VARCHAR2_DATATYPE,10,0,0},
+	{"COUNT",NUMBER_DATATYPE,20,20,0},
+	{"AVG_USEC",NUMBER_DATATYPE,20,20,0},
+	{"P50_USEC",NUMBER_DATATYPE,20,20,0},
+	{"P90_USEC",NUMBER_DATATYPE,20,20,0},
+	{"P99_USEC",NUMBER_DATATYPE,20,20,0},
+	{"P999_USEC",NUMBER_DATATYPE,20,20,0},
+	{"MAX_USEC",NUMBER_DATATYPE,20,20,0}
+};
+
+const char *sqlrquery_sqlrcmdhistogramscursor::getColumnName(uint32_t col) {
+	return (col<9)?colinfo[col].name:NULL;
+}
+
+uint16_t sqlrquery_sqlrcmdhistogramscursor::getColumnType(uint32_t col) {
+	return (col<9)?colinfo[col].type:0;
+}
+
+uint32_t sqlrquery_sqlrcmdhistogramscursor::getColumnLength(uint32_t col) {
+	return (col<9)?colinfo[col].length:0;
+}
+
+uint32_t sqlrquery_sqlrcmdhistogramscursor::getColumnPrecision(uint32_t col) {
+	return (col<9)?colinfo[col].precision:0;
+}
+
+uint32_t sqlrquery_sqlrcmdhistogramscursor::getColumnScale(uint32_t col) {
+	return (col<9)?colinfo[col].scale:0;
+}
+
+bool sqlrquery_sqlrcmdhistogramscursor::noRowsToReturn() {
+	return false;
+}
+
+bool sqlrquery_sqlrcmdhistogramscursor::fetchRow(bool *error) {
+	*error=false;
+
+	// return a row for each histogram that anything has been recorded in
+	while (currentrow<STATLATENCYQUERYTYPES*LATENCYSTAGE_COUNT) {
+		querytype=currentrow/LATENCYSTAGE_COUNT;
+		stage=currentrow%LATENCYSTAGE_COUNT;
+		h=&(conn->cont->getShm()->latency[querytype][stage]);
+		currentrow++;
+		count=latencyHistogramCount(h);
+		if (count) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void sqlrquery_sqlrcmdhistogramscursor::getField(uint32_t col,
+						const char **field,
+						uint64_t *fieldlength,
+						bool *blob,
+						bool *null) {
+	*field=NULL;
+	*fieldlength=0;
+	*blob=false;
+	*null=false;
+
+	delete[] fieldbuffer[col];
+	fieldbuffer[col]=NULL;
+
+	switch (col) {
+		case 0:
+			// query type -
+			// "all" or the type of query
+			*field=latencyHistogramQueryTypeName(querytype);
+			*fieldlength=charstring::length(*field);
+			return;
+		case 1:
+			// stage -
+			// the stage of query processing
+			*field=latencyHistogramStageName(stage);
+			*fieldlength=charstring::length(*field);
+			return;
+		case 2:
+			// count -
+			// number of latencies recorded
+			fieldbuffer[col]=charstring::parseNumber(count);
+			break;
+		case 3:
+			// avg_usec -
+			// average latency
+			fieldbuffer[col]=charstring::parseNumber(
+							h->totalusec/count);
+			break;
+		case 4:
+			// p50_usec -
+			// median latency
+			fieldbuffer[col]=charstring::parseNumber(
+					latencyHistogramPercentile(h,50.0));
+			break;
+		case 5:
+			// p90_usec -
+			// 90th percentile latency
+			fieldbuffer[col]=charstring::parseNumber(
+					latencyHistogramPercentile(h,90.0));
+			break;
+		case 6:
+			// p99_usec -
+			// 99th percentile latency
+			fieldbuffer[col]=charstring::parseNumber(
+					latencyHistogramPercentile(h,99.0));
+			break;
+		case 7:
+			// p999_usec -
+			// 99.9th percentile latency
+			fieldbuffer[col]=charstring::parseNumber(
+					latencyHistogramPercentile(h,99.9));
+			break;
+		case 8:
+			// max_usec -
+			// highest latency
+			fieldbuffer[col]=charstring::parseNumber(h->maxusec);
+			break;
+		default:
+			*null=true;
+			return;
+	}
+
+	*field=fieldbuffer[col];
+	*fieldlength=charstring::length(fieldbuffer[col]);
+}
+
+extern "C" {
+	SQLRSERVER_DLLSPEC sqlrquery *new_sqlrquery_sqlrcmdhistograms(
+						sqlrservercontroller *cont,
+						sqlrqueries *qs,
+						domnode *parameters) {
+		return new sqlrquery_sqlrcmdhistograms(cont,qs,parameters);
+	}
+}
@@ -11,6 +11,7 @@
 #include <rudiments/signalclasses.h>
 #include <rudiments/stdio.h>
 #include <config.h>
+#include <defaults.h>
 #include <version.h>
 
 sqlrservercontroller	*cont=NULL;
@@ -119,6 +120,18 @@ static void helpmessage(const char *progname) {
 		"	-scaler		Indicates to the %s that it was spawned\n"
 		"			by the %s-scaler.\n"
 		"\n"
+		"	-connections count\n"
+		"			Initializes once, then forks off count-1\n"
+		"			additional %s daemons, each of which\n"
+		"			logs in to the database in parallel.\n"
+		"\n"
+		"	-parallel-logins count\n"
+		"			When used with -connections, limits the number\n"
+		"			of them that log in to the database at once.\n"
+		"\n"
+		"	-ready-fd fd	Writes a byte to the specified file descriptor\n"
+		"			once logged in and ready for clients.\n"
+		"\n"
 		"	-ttl sec	Time-to-live, in seconds.  If the %s is\n"
 		"			idle for this number of seconds, then it will exit.\n"
 		"\n"
@@ -130,7 +143,8 @@ static void helpmessage(const char *progname) {
 		DISABLECRASHHANDLER
 		BACKTRACE,
 		progname,SQL_RELAY,progname,progname,SQL_RELAY,
-		progname,SQLR,SQLR,progname,progname,progname,SQLR,progname);
+		progname,SQLR,SQLR,progname,progname,progname,SQLR,
+		progname,progname);
 }
 
 int main(int argc, const char **argv) {
@@ -145,7 +159,10 @@ int main(int argc, const char **argv) {
 			" %s-connection [-config config] "
 			"-id id -connectionid connectionid\n"
 			"                 [-localstatedir dir] "
-			"[-scaler] [-ttl sec] [-silent] [-nodetach]\n",
+			"[-scaler] [-connections count] "
+			"[-parallel-logins count]\n"
+			"                 [-ready-fd fd] [-ttl sec] "
+			"[-silent] [-nodetach]\n",
 			SQLR);
 		process::exit(0);
 	}
@@ -211,8 +228,68 @@ int main(int argc, const char **argv) {
 	signalmanager::ignoreSignals(&set);
 
 
+	// Load the config and modules once, then, if more than one connection
+	// was requested, fork off the rest, rather than having sqlr-start
+	// spawn a separate process to repeat all of that for each of them.
+	// Each connection logs in on its own, so the logins run in parallel.
+	// If a limit was placed on the number of connections that may log in
+	// in parallel, then each forked connection writes to a pipe when it's
+	// done trying to log in, and more aren't forked until one has.
+	bool		result=cont->initTemplate(argc,argv);
+	bool		throttle=false;
+	filedescriptor	loggedinreadfd;
+	filedescriptor	loggedinwritefd;
+	if (result && process::supportsFork()) {
+		const char	*connections=cmdl.getValue("-connections");
+		int64_t		count=(!charstring::isNullOrEmpty(connections))?
+					charstring::toInteger(connections):1;
+		const char	*parallellogins=
+					cmdl.getValue("-parallel-logins");
+		int64_t		parallel=
+				(!charstring::isNullOrEmpty(parallellogins))?
+					charstring::toInteger(parallellogins):0;
+		throttle=(parallel>0 && count>parallel &&
+				file::createPipe(&loggedinreadfd,
+							&loggedinwritefd));
+		for (int64_t i=1; i<count; i++) {
+			if (throttle && i>=parallel) {
+				char	loggedin;
+				loggedinreadfd.read(&loggedin,
+					DEFAULT_CONNECTION_START_TIMEOUT,0);
+			}
+			pid_t	pid=process::fork();
+			if (!pid) {
+				break;
+			}
+			if (pid==-1) {
+				stderror.printf("%s-connection: "
+						"fork() failed\n",SQLR);
+				break;
+			}
+		}
+	}
+
 	// connect to the db
-	bool	result=cont->init(argc,argv);
+	if (result) {
+		result=cont->initFromTemplate(NULL);
+	}
+
+	// let the process that forked this one know that it's done logging in
+	if (throttle) {
+		loggedinwritefd.write((char)result);
+		loggedinwritefd.close();
+		loggedinreadfd.close();
+	}
+
+	// let sqlr-start know that this connection is ready
+	const char	*readyfd=cmdl.getValue("-ready-fd");
+	if (result && !charstring::isNullOrEmpty(readyfd)) {
+		filedescriptor	fd;
+		fd.setFileDescriptor(charstring::toInteger(readyfd));
+		fd.write((char)1);
+		fd.close();
+	}
+
 	if (result) {
 		// wait for client connections
 		result=cont->listen();
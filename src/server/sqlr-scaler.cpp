@@ -12,10 +12,12 @@
 #include <rudiments/userentry.h>
 #include <rudiments/groupentry.h>
 #include <rudiments/process.h>
+#include <rudiments/signalclasses.h>
 #include <rudiments/datetime.h>
 #include <rudiments/error.h>
 #include <rudiments/randomnumber.h>
 #include <rudiments/charstring.h>
+#include <rudiments/bytestring.h>
 #include <rudiments/sys.h>
 #include <rudiments/stdio.h>
 
@@ -26,6 +28,399 @@
 // for pid_t
 #include <sys/types.h>
 
+// forecast policy parameters...
+// how far ahead to forecast (roughly, how long it takes to start connections)
+#define FORECAST_HORIZON 30
+// how often to look for periodic peaks in the qps history
+#define FORECAST_PERIOD_CHECK_INTERVAL 60
+// shortest and longest periods to look for
+#define FORECAST_MIN_PERIOD 30
+#define FORECAST_MAX_PERIOD (STATQPSKEEP/2)
+// how well the history has to correlate with itself to be called periodic
+#define FORECAST_MIN_CORRELATION 0.5
+// weights of the newest sample in the various moving averages
+#define FORECAST_LEVEL_WEIGHT 0.3
+#define FORECAST_THROUGHPUT_WEIGHT 0.1
+#define FORECAST_QUEUEWAIT_WEIGHT 0.3
+// extra capacity to plan for, beyond the forecast
+#define FORECAST_HEADROOM 1.2
+// average queue wait beyond which to start more connections
+#define FORECAST_MAX_QUEUEWAIT_USEC 100000
+// how long demand has to stay low before each step down
+#define FORECAST_SCALEDOWN_DELAY 60
+
+// A scaling policy decides how many connections should be started, each time
+// the scaler evaluates the connection count, and how many idle connections
+// should be kept from timing out.
+class scalingpolicy {
+	public:
+			scalingpolicy(sqlrconfig *cfg, sqlrshm *shm);
+		virtual	~scalingpolicy();
+
+		virtual	const char	*getName()=0;
+
+		// returns the number of connections to start now
+		virtual	uint32_t	evaluate(uint32_t connectedclients,
+						uint32_t currentconnections)=0;
+
+		uint32_t	getForecastQps();
+		uint32_t	getPeriod();
+		uint64_t	getAvgQueueWaitUsec();
+		uint32_t	getTarget();
+		uint32_t	getFloor();
+		const char	*getDecision();
+
+	protected:
+		sqlrconfig	*cfg;
+		sqlrshm		*shm;
+
+		uint32_t	forecastqps;
+		uint32_t	period;
+		uint64_t	avgqueuewaitusec;
+		uint32_t	target;
+		uint32_t	floor;
+		stringbuffer	decision;
+};
+
+scalingpolicy::scalingpolicy(sqlrconfig *cfg, sqlrshm *shm) {
+	this->cfg=cfg;
+	this->shm=shm;
+	forecastqps=0;
+	period=0;
+	avgqueuewaitusec=0;
+	target=0;
+	floor=0;
+}
+
+scalingpolicy::~scalingpolicy() {
+}
+
+uint32_t scalingpolicy::getForecastQps() {
+	return forecastqps;
+}
+
+uint32_t scalingpolicy::getPeriod() {
+	return period;
+}
+
+uint64_t scalingpolicy::getAvgQueueWaitUsec() {
+	return avgqueuewaitusec;
+}
+
+uint32_t scalingpolicy::getTarget() {
+	return target;
+}
+
+uint32_t scalingpolicy::getFloor() {
+	return floor;
+}
+
+const char *scalingpolicy::getDecision() {
+	return decision.getString();
+}
+
+
+// The threshold policy is the original behavior: start growby connections
+// whenever the queue of waiting clients exceeds maxqueuelength and let idle
+// connections time out on their own.
+class thresholdpolicy : public scalingpolicy {
+	public:
+			thresholdpolicy(sqlrconfig *cfg, sqlrshm *shm);
+
+		const char	*getName();
+		uint32_t	evaluate(uint32_t connectedclients,
+						uint32_t currentconnections);
+};
+
+thresholdpolicy::thresholdpolicy(sqlrconfig *cfg, sqlrshm *shm) :
+						scalingpolicy(cfg,shm) {
+}
+
+const char *thresholdpolicy::getName() {
+	return "threshold";
+}
+
+uint32_t thresholdpolicy::evaluate(uint32_t connectedclients,
+					uint32_t currentconnections) {
+
+	target=currentconnections;
+	decision.clear();
+
+	// do we need to open more connections?
+	if (connectedclients<currentconnections ||
+		(connectedclients-currentconnections)<=
+					cfg->getMaxQueueLength()) {
+		decision.append("queue within maxqueuelength");
+		return 0;
+	}
+
+	// can more be opened, or will we exceed the max?
+	if ((currentconnections+cfg->getGrowBy())>cfg->getMaxConnections()) {
+		decision.append("queue exceeds maxqueuelength, "
+				"but at maxconnections");
+		return 0;
+	}
+
+	target=currentconnections+cfg->getGrowBy();
+	decision.append("queue exceeds maxqueuelength, starting ");
+	decision.append(cfg->getGrowBy());
+	return cfg->getGrowBy();
+}
+
+
+// The forecast policy forecasts demand from the queries-per-second history
+// (including periodic peaks that recur within the history) and the time
+// clients spend waiting for a connection, starts connections ahead of that
+// demand, and steps the number of connections that it keeps from timing out
+// down gradually once demand falls.
+class forecastpolicy : public scalingpolicy {
+	public:
+			forecastpolicy(sqlrconfig *cfg, sqlrshm *shm);
+
+		const char	*getName();
+		uint32_t	evaluate(uint32_t connectedclients,
+						uint32_t currentconnections);
+
+	private:
+		void		updateModel(time_t now,
+						uint32_t connectedclients);
+		uint32_t	getQps(time_t second);
+		void		findPeriod(time_t now);
+		double		getSeasonalPeak(time_t now);
+
+		time_t		lastsecond;
+		time_t		lastperiodcheck;
+		time_t		floorchanged;
+
+		double		level;
+		double		throughput;
+		double		queuewait;
+
+		uint64_t	lastqueuewaits;
+		uint64_t	lastqueuewaitusec;
+};
+
+forecastpolicy::forecastpolicy(sqlrconfig *cfg, sqlrshm *shm) :
+						scalingpolicy(cfg,shm) {
+	lastsecond=0;
+	lastperiodcheck=0;
+	floorchanged=0;
+	level=0.0;
+	throughput=0.0;
+	queuewait=0.0;
+	lastqueuewaits=shm->queuewaits;
+	lastqueuewaitusec=shm->queuewaitusec;
+}
+
+const char *forecastpolicy::getName() {
+	return "forecast";
+}
+
+uint32_t forecastpolicy::evaluate(uint32_t connectedclients,
+					uint32_t currentconnections) {
+
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	time_t	now=dt.getEpoch();
+
+	// the qps history has a one-second resolution,
+	// so only update the model once per second
+	if (now!=lastsecond) {
+		updateModel(now,connectedclients);
+		lastsecond=now;
+	}
+
+	decision.clear();
+
+	// plan for the forecast demand, plus some headroom,
+	// at the observed throughput of each connection
+	uint32_t	needed=cfg->getConnections();
+	if (throughput>0.0) {
+		double		d=forecastqps*FORECAST_HEADROOM/throughput;
+		uint32_t	n=(uint32_t)d;
+		if ((double)n<d) {
+			n++;
+		}
+		if (n>needed) {
+			needed=n;
+			decision.append("forecast ");
+			decision.append(forecastqps);
+			decision.append(" qps");
+			if (period) {
+				decision.append(" (period ");
+				decision.append(period);
+				decision.append("s)");
+			}
+		}
+	}
+
+	// if clients are queueing up, or waiting too long, then grow
+	// regardless of the forecast
+	uint32_t	growby=cfg->getGrowBy();
+	bool	queued=(connectedclients>currentconnections &&
+			(connectedclients-currentconnections)>
+					cfg->getMaxQueueLength());
+	bool	waiting=(avgqueuewaitusec>FORECAST_MAX_QUEUEWAIT_USEC);
+	if ((queued || waiting) && needed<currentconnections+growby) {
+		needed=currentconnections+growby;
+		if (decision.getStringLength()) {
+			decision.append(", ");
+		}
+		decision.append((queued)?"queue exceeds maxqueuelength":
+						"clients waiting too long");
+	}
+
+	if (needed>cfg->getMaxConnections()) {
+		needed=cfg->getMaxConnections();
+	}
+	target=needed;
+
+	// raise the floor immediately, but lower it one step at a time,
+	// and only after demand has stayed lower for a while
+	if (target>=floor) {
+		floor=target;
+		floorchanged=now;
+	} else if (now-floorchanged>=FORECAST_SCALEDOWN_DELAY) {
+		floor=(floor-target>growby)?floor-growby:target;
+		floorchanged=now;
+	}
+
+	uint32_t	open=(target>currentconnections)?
+					target-currentconnections:0;
+	if (!decision.getStringLength()) {
+		decision.append("demand within capacity");
+	}
+	if (open) {
+		decision.append(", starting ");
+		decision.append(open);
+	}
+	return open;
+}
+
+void forecastpolicy::updateModel(time_t now, uint32_t connectedclients) {
+
+	// track the queries-per-second over the last complete second...
+	double	qps=getQps(now-1);
+	level=level+FORECAST_LEVEL_WEIGHT*(qps-level);
+
+	// ...and how many queries-per-second each busy connection handles
+	if (connectedclients && qps>0.0) {
+		double	perconnection=qps/connectedclients;
+		throughput=(throughput>0.0)?
+			throughput+FORECAST_THROUGHPUT_WEIGHT*
+					(perconnection-throughput):
+			perconnection;
+	}
+
+	// track the average time that clients wait for a connection
+	uint64_t	queuewaits=shm->queuewaits;
+	uint64_t	queuewaitusec=shm->queuewaitusec;
+	double		wait=0.0;
+	if (queuewaits>lastqueuewaits) {
+		wait=(double)(queuewaitusec-lastqueuewaitusec)/
+				(double)(queuewaits-lastqueuewaits);
+	}
+	queuewait=queuewait+FORECAST_QUEUEWAIT_WEIGHT*(wait-queuewait);
+	avgqueuewaitusec=(uint64_t)queuewait;
+	lastqueuewaits=queuewaits;
+	lastqueuewaitusec=queuewaitusec;
+
+	// look for periodic peaks every so often
+	if (now-lastperiodcheck>=FORECAST_PERIOD_CHECK_INTERVAL) {
+		findPeriod(now);
+		lastperiodcheck=now;
+	}
+
+	// forecast the larger of the current level and
+	// whatever happened just ahead of now, one period ago
+	double	forecast=level;
+	if (period) {
+		double	peak=getSeasonalPeak(now);
+		if (peak>forecast) {
+			forecast=peak;
+		}
+	}
+	forecastqps=(uint32_t)forecast;
+}
+
+uint32_t forecastpolicy::getQps(time_t second) {
+	int	index=second%STATQPSKEEP;
+	if (shm->timestamp[index]!=second) {
+		return 0;
+	}
+	return shm->qps_select[index]+
+		shm->qps_insert[index]+
+		shm->qps_update[index]+
+		shm->qps_delete[index]+
+		shm->qps_create[index]+
+		shm->qps_drop[index]+
+		shm->qps_alter[index]+
+		shm->qps_custom[index]+
+		shm->qps_etc[index];
+}
+
+void forecastpolicy::findPeriod(time_t now) {
+
+	period=0;
+
+	// get the history, oldest first
+	double	history[STATQPSKEEP];
+	double	mean=0.0;
+	for (uint32_t i=0; i<STATQPSKEEP; i++) {
+		history[i]=getQps(now-STATQPSKEEP+i);
+		mean+=history[i];
+	}
+	mean/=STATQPSKEEP;
+	double	variance=0.0;
+	for (uint32_t i=0; i<STATQPSKEEP; i++) {
+		history[i]-=mean;
+		variance+=history[i]*history[i];
+	}
+	variance/=STATQPSKEEP;
+	if (variance==0.0) {
+		return;
+	}
+
+	// find the lag at which the history best correlates with itself
+	double	best=FORECAST_MIN_CORRELATION;
+	for (uint32_t lag=FORECAST_MIN_PERIOD;
+				lag<=FORECAST_MAX_PERIOD; lag++) {
+		double	sum=0.0;
+		for (uint32_t i=0; i+lag<STATQPSKEEP; i++) {
+			sum+=history[i]*history[i+lag];
+		}
+		double	correlation=sum/((STATQPSKEEP-lag)*variance);
+		if (correlation>best) {
+			best=correlation;
+			period=lag;
+		}
+	}
+}
+
+double forecastpolicy::getSeasonalPeak(time_t now) {
+	uint32_t	peak=0;
+	for (uint32_t i=0; i<=FORECAST_HORIZON && i<period; i++) {
+		uint32_t	qps=getQps(now-period+i);
+		if (qps>peak) {
+			peak=qps;
+		}
+	}
+	return peak;
+}
+
+static scalingpolicy *newScalingPolicy(sqlrconfig *cfg, sqlrshm *shm) {
+	const char	*name=cfg->getScalingPolicy();
+	if (!charstring::compare(name,"forecast")) {
+		return new forecastpolicy(cfg,shm);
+	}
+	if (charstring::compare(name,"threshold")) {
+		stderror.printf("Warning: unknown scalingpolicy \"%s\", "
+				"using \"threshold\".\n",name);
+	}
+	return new thresholdpolicy(cfg,shm);
+}
+
+
 class SQLRSERVER_DLLSPEC scaler {
 
 	public:
@@ -39,8 +434,18 @@ class SQLRSERVER_DLLSPEC scaler {
 	private:
 		void	cleanUp();
 
+		uint16_t	buildConnectionArgs(const char **args,
+						const char *cmdname,
+						const char *connid);
+		void		initTemplate();
+		pid_t		forkConnection();
+		static	void	forkedConnectionShutDown(int32_t signum);
+
 		pid_t	openOneConnection();
+		uint32_t	openConnections(uint32_t count,
+						uint32_t currentconnections);
 		bool	connectionStarted();
+		bool	connectionLoggedIn(pid_t connpid);
 		void	killConnection(pid_t connpid);
 		bool	openMoreConnections();
 		bool	reapChildren(pid_t connpid);
@@ -52,6 +457,9 @@ class SQLRSERVER_DLLSPEC scaler {
 		void		incrementConnectionCount();
 		void		decrementConnectionCount();
 
+		void		initScalerStats();
+		void		updateScalerStats(uint32_t opened);
+
 		char		*pidfile;
 
 		const char	*id;
@@ -62,9 +470,6 @@ class SQLRSERVER_DLLSPEC scaler {
 		sqlrconfigs	*sqlrcfgs;
 		sqlrconfig	*cfg;
 
-		uint32_t	maxconnections;
-		uint32_t	maxqueuelength;
-		uint32_t	growby;
 		int32_t		ttl;
 
 		semaphoreset	*semset;
@@ -78,6 +483,8 @@ class SQLRSERVER_DLLSPEC scaler {
 
 		uint32_t	currentseed;
 
+		scalingpolicy	*policy;
+
 		bool		init;
 
 		sqlrpaths	*sqlrpth;
@@ -88,11 +495,22 @@ class SQLRSERVER_DLLSPEC scaler {
 		const char	*backtrace;
 		bool		disablecrashhandler;
 
+		char		ttlstr[20];
+
+		const char		*templateargs[18];
+		sqlrservercontroller	*templatecont;
+
 		static	bool	shutdown;
+
+		static	sqlrservercontroller	*forkedcont;
+		static	volatile sig_atomic_t	forkedshutdowninprogress;
 };
 
 bool	scaler::shutdown=false;
 
+sqlrservercontroller	*scaler::forkedcont=NULL;
+volatile sig_atomic_t	scaler::forkedshutdowninprogress=0;
+
 scaler::scaler() {
 
 	init=false;
@@ -113,6 +531,10 @@ scaler::scaler() {
 	config=NULL;
 	dbase=NULL;
 
+	templatecont=NULL;
+
+	policy=NULL;
+
 	iswindows=!charstring::compareIgnoringCase(
 				sys::getOperatingSystemName(),"Windows");
 }
@@ -317,9 +739,7 @@ bool scaler::initScaler(int argc, const char **argv) {
 		}
 
 		// get the dynamic connection scaling parameters
-		maxconnections=cfg->getMaxConnections();
-		maxqueuelength=cfg->getMaxQueueLength();
-		growby=cfg->getGrowBy();
+		// (the rest are used by the scaling policy)
 		ttl=cfg->getTtl();
 
 		// get the database type
@@ -357,6 +777,31 @@ bool scaler::initScaler(int argc, const char **argv) {
 		return false;
 	}
 
+	// the segment is sized for the instance's maxconnections,
+	// so re-attach to the whole thing, as described by its layout
+	if (!sqlrshmLayoutIsValid(shm)) {
+		stderror.printf("shared memory segment was created by "
+				"an incompatible version of %s\n",SQL_RELAY);
+		delete shmem;
+		shmem=NULL;
+		return false;
+	}
+	if (shm->size>sizeof(sqlrshm)) {
+		uint64_t	size=shm->size;
+		delete shmem;
+		shmem=new sharedmemory;
+		if (!shmem->attach(key,size)) {
+			char	*err=error::getErrorString();
+			stderror.printf("Couldn't attach to shared memory "
+					"segment: %s\n",err);
+			delete[] err;
+			delete shmem;
+			shmem=NULL;
+			return false;
+		}
+		shm=(sqlrshm *)shmem->getPointer();
+	}
+
 	// connect to the semaphore set
 	semset=new semaphoreset;
 	if (!semset->attach(key,13)) {
@@ -371,6 +816,13 @@ bool scaler::initScaler(int argc, const char **argv) {
 		return false;
 	}
 
+	// create the scaling policy
+	if (!cfg) {
+		return false;
+	}
+	policy=newScalingPolicy(cfg,shm);
+	initScalerStats();
+
 	// set up random number generator
 	datetime	dt;
 	dt.getSystemDateAndTime();
@@ -384,15 +836,50 @@ bool scaler::initScaler(int argc, const char **argv) {
 	// create the pid file
 	process::createPidFile(pidfile,permissions::ownerReadWrite());
 
+	// build ttl string
+	charstring::printf(ttlstr,sizeof(ttlstr),"%d",ttl);
+	ttlstr[19]='\0';
+
+	initTemplate();
+
 	return true;
 }
 
+void scaler::initTemplate() {
+
+	// Loading the configuration and database/query-processing modules is
+	// the same for every connection, so if we can fork, do it once here
+	// and fork new connections off of this pre-initialized controller,
+	// rather than spawning an sqlr-connection that repeats it all.
+	// The connections remain children of the scaler, so they're reaped
+	// and counted exactly as if they'd been spawned.
+	if (!process::supportsFork()) {
+		return;
+	}
+
+	uint16_t	argc=buildConnectionArgs(templateargs,
+						SQLR "-connection",NULL);
+	templatecont=new sqlrservercontroller;
+	if (!templatecont->initTemplate(argc,templateargs)) {
+		stderror.printf("%s-scaler: failed to initialize "
+				"connection template, "
+				"falling back to spawning connections\n",
+				SQLR);
+		delete templatecont;
+		templatecont=NULL;
+	}
+}
+
 void scaler::shutDown(int32_t signum) {
 	shutdown=true;
 }
 
 void scaler::cleanUp() {
 
+	delete templatecont;
+
+	delete policy;
+
 	delete semset;
 	delete shmem;
 	delete sqlrcfgs;
@@ -475,36 +962,21 @@ bool scaler::reapChildren(pid_t connpid) {
 	return reaped;
 }
 
-pid_t scaler::openOneConnection() {
-
-	// build command name
-	stringbuffer	cmdname;
-	cmdname.append(SQLR)->append("-connection");
-
-	// build command to spawn
-	stringbuffer	cmd;
-	cmd.append(sqlrpth->getBinDir())->append(cmdname.getString());
-	if (iswindows) {
-		cmd.append(".exe");
-	}
-
-	// build ttl string
-	char	ttlstr[20];
-	charstring::printf(ttlstr,sizeof(ttlstr),"%d",ttl);
-	ttlstr[19]='\0';
-
-	// build args
+uint16_t scaler::buildConnectionArgs(const char **args,
+						const char *cmdname,
+						const char *connid) {
 	uint16_t	p=0;
-	const char	*args[18];
-	args[p++]=cmdname.getString();
+	args[p++]=cmdname;
 	args[p++]="-silent";
 	args[p++]="-nodetach";
 	args[p++]="-ttl";
 	args[p++]=ttlstr;
 	args[p++]="-id";
 	args[p++]=id;
-	args[p++]="-connectionid";
-	args[p++]=connectionid;
+	if (connid) {
+		args[p++]="-connectionid";
+		args[p++]=connid;
+	}
 	if (!charstring::isNullOrEmpty(config)) {
 		args[p++]="-config";
 		args[p++]=config;
@@ -519,7 +991,30 @@ pid_t scaler::openOneConnection() {
 	if (disablecrashhandler) {
 		args[p++]="-disable-crash-handler";
 	}
-	args[p++]=NULL; // the last
+	args[p]=NULL; // the last
+	return p;
+}
+
+pid_t scaler::openOneConnection() {
+
+	if (templatecont) {
+		return forkConnection();
+	}
+
+	// build command name
+	stringbuffer	cmdname;
+	cmdname.append(SQLR)->append("-connection");
+
+	// build command to spawn
+	stringbuffer	cmd;
+	cmd.append(sqlrpth->getBinDir())->append(cmdname.getString());
+	if (iswindows) {
+		cmd.append(".exe");
+	}
+
+	// build args
+	const char	*args[18];
+	buildConnectionArgs(args,cmdname.getString(),connectionid);
 
 	pid_t	pid=process::spawn(cmd.getString(),args,(iswindows)?true:false);
 	if (pid==-1) {
@@ -529,6 +1024,59 @@ pid_t scaler::openOneConnection() {
 	return (pid>0)?pid:0;
 }
 
+pid_t scaler::forkConnection() {
+
+	pid_t	pid=process::fork();
+	if (pid==-1) {
+		// error
+		stderror.printf("fork() failed: %s\n",error::getErrorString());
+	}
+	if (pid) {
+		return (pid>0)?pid:0;
+	}
+
+	// child...
+
+	// from here on, this process is an sqlr-connection,
+	// so handle kill and crash signals the way one would
+	forkedcont=templatecont;
+	process::handleShutDown(forkedConnectionShutDown);
+	if (!disablecrashhandler) {
+		process::handleCrash(forkedConnectionShutDown);
+	}
+
+	// finish initializing and wait for client connections
+	bool	result=forkedcont->initFromTemplate(connectionid);
+	if (result) {
+		result=forkedcont->listen();
+	}
+	forkedshutdowninprogress=1;
+	delete forkedcont;
+
+	// don't return to the scaler's loop
+	process::exit((result)?0:1);
+	return 0;
+}
+
+void scaler::forkedConnectionShutDown(int32_t signum) {
+
+	// bail if we get called recursively or during the final exit
+	if (forkedshutdowninprogress) {
+		process::exit(0);
+	}
+	forkedshutdowninprogress=1;
+
+	if (signum!=SIGTERM && signum!=SIGINT) {
+		stderror.printf("%s-connection (pid=%d) "
+				"Abnormal termination: "
+				"signal %d received\n",
+				SQLR,(uint32_t)process::getProcessId(),signum);
+	}
+
+	delete forkedcont;
+	process::exit((signum==SIGTERM)?0:1);
+}
+
 bool scaler::openMoreConnections() {
 
 	// Wait 1/10th of a second.  If the os supports timed semaphore
@@ -561,97 +1109,108 @@ bool scaler::openMoreConnections() {
 	uint32_t	connectedclients=getConnectedClientCount();
 	uint32_t	currentconnections=getConnectionCount();
 
-	// do we need to open more connections?
-	if (connectedclients<currentconnections ||
-		(connectedclients-currentconnections)<=maxqueuelength) {
+	// ask the scaling policy how many connections to open
+	uint32_t	needed=policy->evaluate(connectedclients,
+						currentconnections);
+	updateScalerStats(0);
+	if (!needed) {
 		return true;
 	}
 
-	// can more be opened, or will we exceed the max?
-	if ((currentconnections+growby)>maxconnections) {
-		return true;
+	// open them
+	// Initialize attempts to start connections...
+	// We'll try to start them some number of times.  If they fail that
+	// many times then usually something bad happened, like the password
+	// expired or the DB died, or something, and it's a bad idea to keep
+	// trying to start more, so we'll stop.  The listener should stop
+	// waiting in a few seconds and send errors to the clients.
+	for (uint16_t attempts=0;
+			needed && attempts<DEFAULT_CONNECTION_START_ATTEMPTS;
+			attempts++) {
+
+		// exit if a shutdown request has been made
+		if (shutdown) {
+			return false;
+		}
+
+		uint32_t	opened=openConnections(needed,
+							currentconnections);
+		updateScalerStats(opened);
+		needed-=opened;
 	}
 
-	// open "growby" connections
-	for (uint32_t i=0; i<growby; i++) {
+	return true;
+}
 
-		// initialize attempts to start a connection...
-		// We'll try to start it some number of times.  If it fails,
-		// that many times then usually something bad happened, like
-		// the password expired or the DB died, or something, and it's
-		// a bad idea to keep trying to start more, so we'll stop that
-		// too.
-		uint16_t	attempts=0;
+uint32_t scaler::openConnections(uint32_t count,
+					uint32_t currentconnections) {
 
-		// loop until a connection is successfully started
-		pid_t	connpid=0;
-		while (!connpid) {
+	// Start all of the connections first, and then wait for them, so
+	// that they log in to the database in parallel, rather than one
+	// after another.
 
-			// exit if a shutdown request has been made
-			if (shutdown) {
-				return false;
-			}
+	// The semaphore should be at 0, though the race condition described
+	// below could potentially leave it set to 1, so we'll make sure to set
+	// it back to 0 here.
+	semset->setValue(8,0);
 
-			getRandomConnectionId();
-
-			// if the database associated with the
-			// connection id that was randomly chosen is
-			// currently unavailable, loop back and get
-			// another one
-			// if no connections are currently open then
-			// we won't know if the database is up or down
-			// because no connections have tried to log
-			// in to it yet, so in that case, don't even
-			// test to see if the database is up or down
-			if (currentconnections && !availableDatabase()) {
-				snooze::macrosnooze(1);
-				continue;
-			}
+	pid_t		*connpids=new pid_t[count];
+	uint32_t	started=0;
+	while (started<count) {
 
-			// The semaphore should be at 0, though the
-			// race condition described below could
-			// potentially leave it set to 1, so we'll make
-			// sure to set it back to 0 here.
-			semset->setValue(8,0);
-
-			connpid=openOneConnection();
-
-			if (connpid) {
-				incrementConnectionCount();
-				if (!connectionStarted()) {
-					// There is a race condition
-					// here.  connectionStarted()
-					// waits for some number seconds.
-					// Presumably the connection
-					// will start up and signal
-					// during that time, or will be
-					// killed before it signals,
-					// but if it takes just barely
-					// longer than that for the
-					// connection to start, the wait
-					// could time out, then the
-					// connection could signal,
-					// then it could be killed,
-					// leaving the semaphore set to
-					// 1 rather than 0.
-					killConnection(connpid);
-					connpid=0;
-					attempts++;
-				}
-			}
+		// exit if a shutdown request has been made
+		if (shutdown) {
+			break;
+		}
 
-			// Stop trying to start this connection and bail on
-			// trying to starting others too.  The listener should
-			// stop waiting in a few seconds and send errors to the
-			// clients.
-			if (attempts==DEFAULT_CONNECTION_START_ATTEMPTS) {
-				i=growby;
-				break;
+		getRandomConnectionId();
+
+		// if the database associated with the connection id that was
+		// randomly chosen is currently unavailable, loop back and get
+		// another one
+		// if no connections are currently open then we won't know if
+		// the database is up or down because no connections have tried
+		// to log in to it yet, so in that case, don't even test to see
+		// if the database is up or down
+		if (currentconnections && !availableDatabase()) {
+			snooze::macrosnooze(1);
+			continue;
+		}
+
+		pid_t	connpid=openOneConnection();
+		if (!connpid) {
+			break;
+		}
+		incrementConnectionCount();
+		connpids[started++]=connpid;
+	}
+
+	// wait for each of them to signal that it has started
+	uint32_t	ready=0;
+	while (ready<started && connectionStarted()) {
+		ready++;
+	}
+
+	// if any of them didn't, then find and kill the ones that didn't
+	// There is a race condition here.  connectionStarted() waits for some
+	// number seconds.  Presumably the connections will start up and signal
+	// during that time, or will be killed before they signal, but if one
+	// takes just barely longer than that to start, the wait could time
+	// out, then the connection could signal, then it could be killed,
+	// leaving the semaphore set to 1 rather than 0.
+	if (ready<started) {
+		ready=0;
+		for (uint32_t i=0; i<started; i++) {
+			if (connectionLoggedIn(connpids[i])) {
+				ready++;
+			} else {
+				killConnection(connpids[i]);
 			}
 		}
 	}
 
-	return true;
+	delete[] connpids;
+	return ready;
 }
 
 bool scaler::connectionStarted() {
@@ -667,6 +1226,18 @@ bool scaler::connectionStarted() {
 			semset->wait(8);
 }
 
+bool scaler::connectionLoggedIn(pid_t connpid) {
+
+	// connections register themselves in the
+	// connstats array once they've logged in
+	for (uint32_t i=0; i<shm->maxconnections; i++) {
+		if (sqlrshmConnStats(shm,i)->processid==(uint32_t)connpid) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void scaler::killConnection(pid_t connpid) {
 
 	// The connection may have crashed or gotten hung up trying to start,
@@ -772,6 +1343,56 @@ void scaler::decrementConnectionCount() {
 		shm->totalconnections--;
 	}
 
+	// if the connection exited because the scaling policy let it,
+	// then it's no longer retiring
+	if (shm->scalerstats.retiring) {
+		shm->scalerstats.retiring--;
+	}
+
+	// signal that the connection counter may be accessed by someone else
+	semset->signalWithUndo(4);
+}
+
+void scaler::initScalerStats() {
+
+	// wait for access to the connection counter
+	semset->waitWithUndo(4);
+
+	sqlrscalerstatistics	*stats=&(shm->scalerstats);
+	bytestring::zero(stats,sizeof(sqlrscalerstatistics));
+	charstring::copy(stats->policy,policy->getName(),
+					STATSCALINGPOLICYLEN-1);
+
+	// signal that the connection counter may be accessed by someone else
+	semset->signalWithUndo(4);
+}
+
+void scaler::updateScalerStats(uint32_t opened) {
+
+	// wait for access to the connection counter
+	// (the connections read the floor while holding it)
+	semset->waitWithUndo(4);
+
+	sqlrscalerstatistics	*stats=&(shm->scalerstats);
+	stats->forecastqps=policy->getForecastQps();
+	stats->period=policy->getPeriod();
+	stats->avgqueuewaitusec=policy->getAvgQueueWaitUsec();
+	stats->target=policy->getTarget();
+	stats->floor=policy->getFloor();
+	stats->opened+=opened;
+
+	// only update the decision (and its time) when it changes
+	const char	*decision=policy->getDecision();
+	if (charstring::compare(stats->decision,decision,
+					STATSCALINGDECISIONLEN-1)) {
+		charstring::copy(stats->decision,decision,
+					STATSCALINGDECISIONLEN-1);
+		stats->decision[STATSCALINGDECISIONLEN-1]='\0';
+		datetime	dt;
+		dt.getSystemDateAndTime();
+		stats->decisiontime=dt.getEpoch();
+	}
+
 	// signal that the connection counter may be accessed by someone else
 	semset->signalWithUndo(4);
 }
@@ -5,9 +5,9 @@
 #include <sqlrelay/private/sqlrshm.h>
 #include <rudiments/process.h>
 #ifndef _WIN32
-	#include <rudiments/inetsocketclient.h>
-	#include <rudiments/unixsocketclient.h>
-	#include <rudiments/snooze.h>
+	#include <rudiments/file.h>
+	#include <rudiments/listener.h>
+	#include <rudiments/datetime.h>
 #endif
 #include <rudiments/stdio.h>
 #include <config.h>
@@ -28,6 +28,9 @@
 // for ceil()
 #include <math.h>
 
+// how long -wait waits for instances to become ready
+#define INSTANCE_START_TIMEOUT 30
+
 bool	iswindows;
 
 static bool startListener(sqlrpaths *sqlrpth,
@@ -93,6 +96,9 @@ static bool startListener(sqlrpaths *sqlrpth,
 static bool startConnection(sqlrpaths *sqlrpth,
 				const char *id,
 				const char *connectionid,
+				int32_t count,
+				const char *parallellogins,
+				const char *readyfd,
 				const char *config,
 				const char *localstatedir,
 				bool strace,
@@ -114,9 +120,14 @@ static bool startConnection(sqlrpaths *sqlrpth,
 		}
 	}
 
+	// build count string
+	char	countstr[20];
+	charstring::printf(countstr,sizeof(countstr),"%d",count);
+	countstr[19]='\0';
+
 	// build args
 	uint16_t	i=0;
-	const char	*args[17];
+	const char	*args[23];
 	if (strace) {
 		args[i++]="strace";
 		args[i++]="-ff";
@@ -129,6 +140,18 @@ static bool startConnection(sqlrpaths *sqlrpth,
 		args[i++]="-connectionid";
 		args[i++]=connectionid;
 	}
+	if (count>1) {
+		args[i++]="-connections";
+		args[i++]=countstr;
+		if (!charstring::isNullOrEmpty(parallellogins)) {
+			args[i++]="-parallel-logins";
+			args[i++]=parallellogins;
+		}
+	}
+	if (!charstring::isNullOrEmpty(readyfd)) {
+		args[i++]="-ready-fd";
+		args[i++]=readyfd;
+	}
 	if (!charstring::isNullOrEmpty(config)) {
 		args[i++]="-config";
 		args[i++]=config;
@@ -167,11 +190,16 @@ static bool startConnection(sqlrpaths *sqlrpth,
 static bool startConnections(sqlrpaths *sqlrpth,
 				sqlrconfig *cfg,
 				const char *id,
+				const char *parallellogins,
+				const char *readyfd,
 				const char *config,
 				const char *localstatedir,
 				bool strace,
 				const char *backtrace,
-				bool disablecrashhandler) {
+				bool disablecrashhandler,
+				uint32_t *started) {
+
+	*started=0;
 
 	// get the connection count and total metric
 	linkedlist< connectstringcontainer *>	*connectionlist=
@@ -185,8 +213,13 @@ static bool startConnections(sqlrpaths *sqlrpth,
 	// if no connections were defined in the configuration,
 	// start 1 default one
 	if (!cfg->getConnectionCount()) {
-		return !startConnection(sqlrpth,id,config,localstatedir,NULL,
-					strace,backtrace,disablecrashhandler);
+		if (!startConnection(sqlrpth,id,NULL,1,NULL,readyfd,
+					config,localstatedir,strace,
+					backtrace,disablecrashhandler)) {
+			return false;
+		}
+		*started=1;
+		return true;
 	}
 
 	// get number of connections
@@ -226,14 +259,26 @@ static bool startConnections(sqlrpaths *sqlrpth,
 		stdoutput.printf("%s :\n",csc->getConnectionId());
 
 		// fire them up
-		for (int32_t i=0; i<startup; i++) {
+		// (Unless we're running them under strace or on a platform
+		// that doesn't support fork(), start one connection and let it
+		// fork off the rest after it has loaded its configuration and
+		// modules.  Otherwise, spawn each of them individually.)
+		int32_t	spawn=startup;
+		int32_t	count=1;
+		if (!strace && process::supportsFork() && startup) {
+			spawn=1;
+			count=startup;
+		}
+		for (int32_t i=0; i<spawn; i++) {
 			if (!startConnection(sqlrpth,id,
-					csc->getConnectionId(),
+					csc->getConnectionId(),count,
+					parallellogins,readyfd,
 					config,localstatedir,strace,
 					backtrace,disablecrashhandler)) {
 				// it's ok if at least 1 connection started up
 				return (totalstarted>0 || i>0);
 			}
+			*started=*started+count;
 		}
 
 		// have we started enough connections?
@@ -313,48 +358,101 @@ static bool startScaler(sqlrpaths *sqlrpth,
 }
 
 #ifndef _WIN32
-static bool waitForInstance(sqlrpaths *sqlrpth,
-				sqlrconfig *cfg,
-				const char *thisid) {
+struct instancestartup {
+	char		*id;
+	filedescriptor	readyfd;
+	uint32_t	expected;
+	uint32_t	ready;
+	bool		reported;
+};
 
-	stdoutput.printf("\nWaiting for instance...\n");
+static void reportInstance(instancestartup *is, bool ready,
+					filedescriptor *notifyfd) {
 
-	bool	retval=false;
-	for (uint16_t i=0; i<30; i++) {
+	is->reported=true;
 
-		// try to connect
-		if (cfg->getListenOnUnix()) {
-			unixsocketclient	s;
-			if (s.connect(cfg->getDefaultSocket(),1,0,0,1)==
-							RESULT_SUCCESS) {
-				retval=true;
-				break;
-			}
+	stdoutput.printf("Instance %s %s.\n",is->id,
+				(ready)?"is ready":"failed to start");
 
-		} else if (cfg->getListenOnInet()) {
-			inetsocketclient	s;
-			if (s.connect("localhost",
-					cfg->getDefaultPort(),1,0,0,1)==
-							RESULT_SUCCESS) {
-				retval=true;
+	// tell whoever passed us -ready-fd too
+	if (notifyfd) {
+		notifyfd->write(is->id);
+		notifyfd->write((ready)?" ready\n":" failed\n");
+	}
+}
+
+static bool waitForInstances(linkedlist< instancestartup * > *startups,
+						filedescriptor *notifyfd) {
+
+	stdoutput.printf("\nWaiting for instances...\n");
+
+	// Each connection writes a byte to its instance's pipe once it's
+	// logged in and ready.  An instance is ready once all of the
+	// connections that were started for it are.  If they all exit first,
+	// then the pipe will close, and the instance failed to start.
+	bool		retval=true;
+	uint32_t	pending=0;
+	listener	lsnr;
+	for (linkedlistnode< instancestartup * > *node=startups->getFirst();
+						node; node=node->getNext()) {
+		instancestartup	*is=node->getValue();
+		if (is->ready<is->expected) {
+			lsnr.addReadFileDescriptor(&is->readyfd);
+			pending++;
+		} else {
+			reportInstance(is,true,notifyfd);
+		}
+	}
+
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	time_t	deadline=dt.getEpoch()+INSTANCE_START_TIMEOUT;
+	while (pending) {
+
+		dt.getSystemDateAndTime();
+		if (dt.getEpoch()>=deadline ||
+			lsnr.listen(deadline-dt.getEpoch(),0)<1) {
+			break;
+		}
+		filedescriptor	*fd=
+			lsnr.getReadReadyList()->getFirst()->getValue();
+
+		// find the instance that the pipe belongs to
+		instancestartup	*is=NULL;
+		for (linkedlistnode< instancestartup * >
+				*node=startups->getFirst();
+				node; node=node->getNext()) {
+			if (&node->getValue()->readyfd==fd) {
+				is=node->getValue();
 				break;
 			}
 		}
 
-		// FIXME: Ideally, rather than waiting 30 seconds, we'd check
-		// to see if the sqlr-connections are still running and bail if
-		// they aren't.
-
-		// wait a second and try again
-		snooze::macrosnooze(1);
+		char	ready;
+		bool	closed=(fd->read(&ready)!=sizeof(char));
+		if (!closed) {
+			is->ready++;
+		}
+		if (closed || is->ready==is->expected) {
+			lsnr.removeFileDescriptor(fd);
+			pending--;
+			reportInstance(is,!closed,notifyfd);
+			if (closed) {
+				retval=false;
+			}
+		}
 	}
 
-	if (retval) {
-		stdoutput.printf("Instance is ready.\n");
-	} else {
-		stdoutput.printf("Instance failed to start.\n");
+	// any instances that are still pending didn't start in time
+	for (linkedlistnode< instancestartup * > *node=startups->getFirst();
+						node; node=node->getNext()) {
+		instancestartup	*is=node->getValue();
+		if (!is->reported) {
+			reportInstance(is,false,notifyfd);
+			retval=false;
+		}
 	}
-	return true;
+	return retval;
 }
 #endif
 
@@ -372,7 +470,13 @@ static void helpmessage(const char *progname) {
 		SERVEROPTIONS
 		"	-abs-max-connections	Displays the absolute maximum number of\n"
 		"				database connections that may be opened by\n"
-		"				instance of SQL Relay and exits.n\n"
+		"				an instance of SQL Relay, and the amount of\n"
+		"				shared memory that an instance requires,\n"
+		"				and exits.\n"
+		"\n"
+		"	-parallel-logins count	Limits the number of connections to each\n"
+		"				database that log in at once.  Defaults to\n"
+		"				no limit.\n"
 		"\n"
 		DISABLECRASHHANDLER
 		BACKTRACECHILDREN
@@ -383,10 +487,17 @@ static void helpmessage(const char *progname) {
 		"\n"
 #endif
 #ifndef _WIN32
-		"	-wait			Wait up to 30 seconds for each instance to\n"
+		"	-wait			Wait up to 30 seconds for the instances to\n"
 		"				become ready before exiting and exit with\n"
 		"				status 1 if an instance failed to become ready\n"
-		"				in the allotted time.\n"
+		"				in the allotted time.  An instance is ready\n"
+		"				once all of its initial connections have\n"
+		"				logged in to the database.\n"
+		"\n"
+		"	-ready-fd fd		Like -wait, but also write \"id ready\" or\n"
+		"				\"id failed\" lines to the specified file\n"
+		"				descriptor as each instance becomes ready or\n"
+		"				fails to, for use by deployment tools.\n"
 		"\n"
 #endif
 		"Examples:\n"
@@ -419,8 +530,13 @@ static void absmaxconnections(int argc, const char **argv) {
 		return;
 	}
 
-	stdoutput.printf("abs max connections: %d\n",MAXCONNECTIONS);
-	stdoutput.printf("shmmax requirement:  %d\n",sizeof(sqlrshm));
+	// the shared memory segment is sized from
+	// the maxconnections of the instance
+	stdoutput.printf("abs max connections: unlimited\n");
+	stdoutput.printf("shmmax requirement:  %lld + %lld per connection\n",
+			(long long)sqlrshmAlign(sizeof(sqlrshm)),
+			(long long)(sqlrshmAlign(sizeof(sqlrconnstatistics))+
+						sizeof(sqlrconntext)));
 
 	process::exit(0);
 }
@@ -444,8 +560,20 @@ int main(int argc, const char **argv) {
 	const char	*backtrace=cmdl.getValue("-backtrace");
 	bool		disablecrashhandler=
 				cmdl.found("-disable-crash-handler");
+	const char	*parallellogins=cmdl.getValue("-parallel-logins");
 	#ifndef _WIN32
 	bool		wait=cmdl.found("-wait");
+	const char	*readyfdstr=cmdl.getValue("-ready-fd");
+	bool		notify=!charstring::isNullOrEmpty(readyfdstr);
+	filedescriptor	notifyfd;
+	if (notify) {
+		wait=true;
+		notifyfd.setFileDescriptor(charstring::toInteger(readyfdstr));
+		// don't let the listeners and connections inherit it,
+		// or whoever is waiting on it won't see it close
+		notifyfd.closeOnExec();
+	}
+	linkedlist< instancestartup * >	startups;
 	#endif
 
 	// on Windows, open a new console window and redirect everything to it
@@ -490,7 +618,8 @@ int main(int argc, const char **argv) {
 		sqlrcfgs.getEnabledIds(configurl,&ids);
 	}
 
-	// start each enabled instance
+	// Start each enabled instance.  None of this waits for anything, so
+	// the instances, and their connections, all start up concurrently.
 	int32_t	exitstatus=0;
 	for (linkedlistnode< char * > *node=ids.getFirst();
 					node; node=node->getNext()) {
@@ -498,29 +627,79 @@ int main(int argc, const char **argv) {
 		// get the id
 		char	*thisid=node->getValue();
 
-		// load the configuration and
-		// start listener, connections and scaler
+		// load the configuration and start the listener
 		sqlrconfig	*cfg=sqlrcfgs.load(configurl,thisid);
 		if (!cfg ||
 			!startListener(&sqlrpth,thisid,
 					config,localstatedir,
-					backtrace,disablecrashhandler) ||
-			!startConnections(&sqlrpth,cfg,thisid,
+					backtrace,disablecrashhandler)) {
+			exitstatus=1;
+			continue;
+		}
+
+		// If we're going to wait for the instance, then create a pipe
+		// for its connections to report that they're ready on.  Only
+		// they should have the write end of it though, so close it
+		// here before starting anything else.
+		const char	*readyfd=NULL;
+		#ifndef _WIN32
+		char		readyfdstr[20];
+		instancestartup	*is=NULL;
+		filedescriptor	readywritefd;
+		if (wait) {
+			is=new instancestartup;
+			is->id=thisid;
+			is->expected=0;
+			is->ready=0;
+			is->reported=false;
+			if (file::createPipe(&is->readyfd,&readywritefd)) {
+				is->readyfd.closeOnExec();
+				charstring::printf(readyfdstr,
+						sizeof(readyfdstr),"%d",
+						readywritefd.getFileDescriptor());
+				readyfd=readyfdstr;
+			}
+			startups.append(is);
+		}
+		#endif
+
+		// start connections and scaler
+		uint32_t	started=0;
+		if (!startConnections(&sqlrpth,cfg,thisid,
+					parallellogins,readyfd,
 					config,localstatedir,
 					strace,backtrace,
-					disablecrashhandler) ||
-			!startScaler(&sqlrpth,cfg,thisid,
+					disablecrashhandler,&started)) {
+			exitstatus=1;
+		}
+		#ifndef _WIN32
+		if (is) {
+			is->expected=(readyfd)?started:0;
+			readywritefd.close();
+		}
+		#endif
+		if (!startScaler(&sqlrpth,cfg,thisid,
 					config,localstatedir,
-					backtrace,disablecrashhandler)
-			#ifndef _WIN32
-			|| (wait && !waitForInstance(&sqlrpth,cfg,thisid))
-			#endif
-			) {
+					backtrace,disablecrashhandler)) {
 			exitstatus=1;
 		}
+	}
 
-		// clean up
-		delete[] thisid;
+	// wait for the instances to become ready
+	#ifndef _WIN32
+	if (wait && !waitForInstances(&startups,(notify)?&notifyfd:NULL)) {
+		exitstatus=1;
+	}
+	for (linkedlistnode< instancestartup * > *node=startups.getFirst();
+						node; node=node->getNext()) {
+		delete node->getValue();
+	}
+	#endif
+
+	// clean up
+	for (linkedlistnode< char * > *node=ids.getFirst();
+					node; node=node->getNext()) {
+		delete[] node->getValue();
 	}
 
 	// successful exit
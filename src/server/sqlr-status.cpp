@@ -6,9 +6,17 @@
 #include <rudiments/sharedmemory.h>
 #include <rudiments/process.h>
 #include <rudiments/charstring.h>
+#include <rudiments/bytestring.h>
 #include <rudiments/error.h>
 #include <rudiments/stdio.h>
+#include <rudiments/stringbuffer.h>
+#include <rudiments/inetsocketserver.h>
+#include <rudiments/unixsocketserver.h>
+#include <rudiments/listener.h>
+#include <rudiments/datetime.h>
+#include <rudiments/signalclasses.h>
 #include <sqlrelay/private/sqlrshm.h>
+#include <sqlrelay/private/sqlrlatencyhistogram.h>
 #include <sqlrelay/sqlrutil.h>
 #include <datatypes.h>
 #include <defines.h>
@@ -64,7 +72,7 @@ static const char *sqlrconnectionstateStr(sqlrconnectionstate_t s) {
 	return "undefined";
 }
 
-static void printQuery(sqlrconnstatistics *conn) {
+static void printQuery(sqlrconntext *conn) {
 	// We could use stdoutput.safePrint().  But to take up as little space
 	// as possible we want to compress whitespace and just ignore non-ascii
 	// characters, which is not the right thing, but in practice is ok in
@@ -103,6 +111,562 @@ static void printQuery(sqlrconnstatistics *conn) {
 	}
 }
 
+static void printHistograms(sqlrshm *statistics) {
+
+	stdoutput.printf("\nLatency histograms (usec):\n");
+	stdoutput.printf("  %-10s %-10s %10s %10s %10s %10s %10s %10s %10s\n",
+				"query type","stage","count","avg",
+				"p50","p90","p99","p99.9","max");
+
+	bool	found=false;
+	for (uint32_t i=0; i<STATLATENCYQUERYTYPES; i++) {
+		for (uint32_t j=0; j<LATENCYSTAGE_COUNT; j++) {
+
+			// skip empty histograms
+			sqlrlatencyhistogram	*h=&(statistics->latency[i][j]);
+			uint64_t		count=latencyHistogramCount(h);
+			if (!count) {
+				continue;
+			}
+			found=true;
+
+			stdoutput.printf("  %-10s %-10s "
+					"%10llu %10llu %10llu %10llu "
+					"%10llu %10llu %10llu\n",
+					latencyHistogramQueryTypeName(i),
+					latencyHistogramStageName(j),
+					(unsigned long long)count,
+					(unsigned long long)
+						(h->totalusec/count),
+					(unsigned long long)
+					latencyHistogramPercentile(h,50.0),
+					(unsigned long long)
+					latencyHistogramPercentile(h,90.0),
+					(unsigned long long)
+					latencyHistogramPercentile(h,99.0),
+					(unsigned long long)
+					latencyHistogramPercentile(h,99.9),
+					(unsigned long long)h->maxusec);
+		}
+	}
+	if (!found) {
+		stdoutput.printf("  (none recorded)\n");
+	}
+}
+
+static void printMetricFamily(stringbuffer *out, const char *name,
+					const char *type, const char *help) {
+	out->append("# HELP ")->append(name)->append(' ')->append(help);
+	out->append("\n# TYPE ")->append(name)->append(' ')->append(type);
+	out->append('\n');
+}
+
+static void printMetric(stringbuffer *out, const char *name,
+					const char *labels, uint64_t value) {
+	out->append(name);
+	if (!charstring::isNullOrEmpty(labels)) {
+		out->append('{')->append(labels)->append('}');
+	}
+	out->append(' ')->append(value)->append('\n');
+}
+
+static void printCounter(stringbuffer *out, const char *name,
+					const char *help, uint64_t value) {
+	printMetricFamily(out,name,"counter",help);
+	stringbuffer	total;
+	total.append(name)->append("_total");
+	printMetric(out,total.getString(),NULL,value);
+}
+
+static void printGauge(stringbuffer *out, const char *name,
+					const char *help, uint64_t value) {
+	printMetricFamily(out,name,"gauge",help);
+	printMetric(out,name,NULL,value);
+}
+
+static void printMetrics(stringbuffer *out, sqlrshm *shm,
+						semaphoreset *semset) {
+
+	// Metrics are read directly from shared memory without taking any
+	// semaphores, so a scrape never stalls the instance.  Individual
+	// values are always consistent, but values that are updated together
+	// may occasionally be caught in the middle of an update.
+
+	out->clear();
+
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	uint64_t	now=dt.getEpoch();
+
+	// instance-wide counts
+	printGauge(out,"sqlrelay_enabled",
+			"Whether the instance is enabled.",
+			!shm->disabled);
+	printGauge(out,"sqlrelay_start_time_seconds",
+			"When the instance was started, in seconds since "
+			"the epoch.",
+			shm->starttime);
+	printGauge(out,"sqlrelay_open_database_connections",
+			"Database connections that are currently open.",
+			shm->open_db_connections);
+	printCounter(out,"sqlrelay_opened_database_connections",
+			"Database connections opened since the instance "
+			"was started.",
+			shm->opened_db_connections);
+	printGauge(out,"sqlrelay_open_database_cursors",
+			"Database cursors that are currently open.",
+			shm->open_db_cursors);
+	printCounter(out,"sqlrelay_opened_database_cursors",
+			"Database cursors opened since the instance "
+			"was started.",
+			shm->opened_db_cursors);
+	printGauge(out,"sqlrelay_open_client_connections",
+			"Clients that are currently connected.",
+			shm->open_cli_connections);
+	printCounter(out,"sqlrelay_opened_client_connections",
+			"Clients that have connected since the instance "
+			"was started.",
+			shm->opened_cli_connections);
+	printCounter(out,"sqlrelay_new_cursor_used",
+			"Times a cursor couldn't be reused.",
+			shm->times_new_cursor_used);
+	printCounter(out,"sqlrelay_cursor_reused",
+			"Times a cursor was reused.",
+			shm->times_cursor_reused);
+	printCounter(out,"sqlrelay_queries",
+			"Queries run through the instance.",
+			shm->total_queries);
+	printCounter(out,"sqlrelay_errors",
+			"Queries that generated errors.",
+			shm->total_errors);
+	printGauge(out,"sqlrelay_forked_listeners",
+			"Child listener processes that are running.",
+			shm->forked_listeners);
+	printGauge(out,"sqlrelay_max_listeners",
+			"Maximum number of listeners allowed.",
+			shm->max_listeners);
+	printCounter(out,"sqlrelay_max_listeners_errors",
+			"Times the maximum number of listeners was hit.",
+			shm->max_listeners_errors);
+	printGauge(out,"sqlrelay_peak_listeners",
+			"Highest number of listeners since the instance "
+			"was started.",
+			shm->peak_listeners);
+	printGauge(out,"sqlrelay_busy_listeners",
+			"Listeners that are currently busy.",
+			semset->getValue(10));
+	printGauge(out,"sqlrelay_connections",
+			"Connections, as seen by the scaler.",
+			shm->totalconnections);
+	printGauge(out,"sqlrelay_connected_clients",
+			"Connected clients, as seen by the scaler.",
+			shm->connectedclients);
+	printGauge(out,"sqlrelay_peak_connected_clients",
+			"Highest number of connected clients since the "
+			"instance was started.",
+			shm->peak_connectedclients);
+	printCounter(out,"sqlrelay_queue_waits",
+			"Times a client waited for a connection.",
+			shm->queuewaits);
+	printCounter(out,"sqlrelay_queue_wait_microseconds",
+			"Time clients spent waiting for a connection.",
+			shm->queuewaitusec);
+
+	// admission classes
+	static const char	*admissionmetrics[][3]={
+		{"sqlrelay_admission_queued","gauge",
+		"Clients currently queued in each admission class."},
+		{"sqlrelay_admission_peak_queued","gauge",
+		"Most clients queued in each admission class at once."},
+		{"sqlrelay_admission_admitted","counter",
+		"Clients admitted from each admission class."},
+		{"sqlrelay_admission_rejected","counter",
+		"Clients rejected without being queued, because the "
+		"class was full or they wouldn't have been admitted in time."},
+		{"sqlrelay_admission_timed_out","counter",
+		"Clients that gave up after waiting for the class's "
+		"maximum queue wait."},
+		{"sqlrelay_admission_queue_wait_microseconds","counter",
+		"Time admitted clients spent queued in each admission class."},
+		{"sqlrelay_admission_max_queue_wait_microseconds","gauge",
+		"Longest time an admitted client spent queued in each "
+		"admission class."}
+	};
+	for (uint16_t m=0; m<7 && shm->admissionclasses; m++) {
+		printMetricFamily(out,admissionmetrics[m][0],
+					admissionmetrics[m][1],
+					admissionmetrics[m][2]);
+		stringbuffer	name;
+		name.append(admissionmetrics[m][0]);
+		if (!charstring::compare(admissionmetrics[m][1],"counter")) {
+			name.append("_total");
+		}
+		for (uint32_t i=0; i<shm->admissionclasses &&
+					i<STATADMISSIONCLASSES; i++) {
+			sqlradmissionclass	*ac=&(shm->admission[i]);
+			uint64_t	values[]={
+				ac->queued,ac->peakqueued,
+				ac->admitted,ac->rejected,ac->timedout,
+				ac->queuewaitusec,ac->maxqueuewaitusecseen
+			};
+			stringbuffer	labels;
+			labels.append("class=\"")->append(ac->name);
+			labels.append('"');
+			printMetric(out,name.getString(),
+					labels.getString(),values[m]);
+		}
+	}
+
+	// queries per type over the last 1, 5 and 15 minutes,
+	// from the per-second ring
+	static const char	*querytypes[]={
+		"select","insert","update","delete",
+		"create","drop","alter","custom","etc"
+	};
+	static const uint32_t	windows[]={60,300,900};
+	printMetricFamily(out,"sqlrelay_recent_queries","gauge",
+			"Queries run over the last window_seconds seconds.");
+	for (uint16_t w=0; w<3; w++) {
+		uint64_t	counts[9]={0,0,0,0,0,0,0,0,0};
+		for (uint32_t j=0; j<STATQPSKEEP; j++) {
+			if (now-shm->timestamp[j]>=windows[w]) {
+				continue;
+			}
+			counts[0]+=shm->qps_select[j];
+			counts[1]+=shm->qps_insert[j];
+			counts[2]+=shm->qps_update[j];
+			counts[3]+=shm->qps_delete[j];
+			counts[4]+=shm->qps_create[j];
+			counts[5]+=shm->qps_drop[j];
+			counts[6]+=shm->qps_alter[j];
+			counts[7]+=shm->qps_custom[j];
+			counts[8]+=shm->qps_etc[j];
+		}
+		for (uint16_t t=0; t<9; t++) {
+			stringbuffer	labels;
+			labels.append("type=\"")->append(querytypes[t]);
+			labels.append("\",window_seconds=\"");
+			labels.append(windows[w])->append('"');
+			printMetric(out,"sqlrelay_recent_queries",
+					labels.getString(),counts[t]);
+		}
+	}
+
+	// latency histograms, as summaries
+	printMetricFamily(out,"sqlrelay_latency_microseconds","summary",
+			"Latency of each stage of query processing.");
+	for (uint32_t i=0; i<STATLATENCYQUERYTYPES; i++) {
+		for (uint32_t j=0; j<LATENCYSTAGE_COUNT; j++) {
+
+			sqlrlatencyhistogram	*h=&(shm->latency[i][j]);
+			uint64_t		count=latencyHistogramCount(h);
+			if (!count) {
+				continue;
+			}
+
+			stringbuffer	labels;
+			labels.append("query_type=\"");
+			labels.append(latencyHistogramQueryTypeName(i));
+			labels.append("\",stage=\"");
+			labels.append(latencyHistogramStageName(j));
+			labels.append('"');
+
+			static const char	*quantiles[]={
+				"0.5","0.9","0.99","0.999"
+			};
+			static const double	percentiles[]={
+				50.0,90.0,99.0,99.9
+			};
+			for (uint16_t q=0; q<4; q++) {
+				stringbuffer	qlabels;
+				qlabels.append(labels.getString());
+				qlabels.append(",quantile=\"");
+				qlabels.append(quantiles[q])->append('"');
+				printMetric(out,"sqlrelay_latency_microseconds",
+					qlabels.getString(),
+					latencyHistogramPercentile(
+							h,percentiles[q]));
+			}
+			printMetric(out,"sqlrelay_latency_microseconds_count",
+						labels.getString(),count);
+			printMetric(out,"sqlrelay_latency_microseconds_sum",
+						labels.getString(),
+						h->totalusec);
+		}
+	}
+
+	// connections, by state
+	uint32_t	statecounts[WAIT_SEMAPHORE+1];
+	for (uint32_t i=0; i<=WAIT_SEMAPHORE; i++) {
+		statecounts[i]=0;
+	}
+	for (uint32_t j=0; j<shm->maxconnections; j++) {
+		uint32_t	state=sqlrshmConnStats(shm,j)->state;
+		if (state!=NOT_AVAILABLE && state<=WAIT_SEMAPHORE) {
+			statecounts[state]++;
+		}
+	}
+	printMetricFamily(out,"sqlrelay_connection_states","gauge",
+			"Connections in each state.");
+	for (uint32_t i=INIT; i<=WAIT_SEMAPHORE; i++) {
+		stringbuffer	labels;
+		labels.append("state=\"");
+		labels.append(sqlrconnectionstateStr(
+					(sqlrconnectionstate_t)i));
+		labels.append('"');
+		printMetric(out,"sqlrelay_connection_states",
+					labels.getString(),statecounts[i]);
+	}
+
+	// per-connection details
+	printMetricFamily(out,"sqlrelay_connection_state","gauge",
+			"The current state of each connection.");
+	stringbuffer	statesec;
+	stringbuffer	sessions;
+	stringbuffer	queries;
+	stringbuffer	relogins;
+	stringbuffer	buffermemory;
+	for (uint32_t j=0; j<shm->maxconnections; j++) {
+
+		sqlrconnstatistics	*cs=sqlrshmConnStats(shm,j);
+		if (cs->state==NOT_AVAILABLE) {
+			continue;
+		}
+
+		stringbuffer	labels;
+		labels.append("connection=\"")->append(j);
+		labels.append("\",pid=\"")->append(cs->processid);
+		labels.append('"');
+
+		stringbuffer	statelabels;
+		statelabels.append(labels.getString());
+		statelabels.append(",state=\"");
+		statelabels.append(sqlrconnectionstateStr(cs->state));
+		statelabels.append('"');
+		printMetric(out,"sqlrelay_connection_state",
+					statelabels.getString(),1);
+
+		printMetric(&statesec,"sqlrelay_connection_state_seconds",
+					labels.getString(),
+					(now>cs->statestartsec)?
+						now-cs->statestartsec:0);
+		printMetric(&sessions,"sqlrelay_connection_sessions_total",
+					labels.getString(),cs->nconnect);
+		printMetric(&queries,"sqlrelay_connection_queries_total",
+					labels.getString(),
+					cs->nnewquery+cs->nreexecutequery);
+		printMetric(&relogins,"sqlrelay_connection_relogins_total",
+					labels.getString(),cs->nrelogin);
+		printMetric(&buffermemory,
+				"sqlrelay_connection_cursor_buffer_bytes",
+					labels.getString(),
+					cs->cursorbuffermemory);
+	}
+	printMetricFamily(out,"sqlrelay_connection_state_seconds","gauge",
+			"Time each connection has been in its current state.");
+	out->append(statesec.getString());
+	printMetricFamily(out,"sqlrelay_connection_sessions","counter",
+			"Client sessions handled by each connection.");
+	out->append(sessions.getString());
+	printMetricFamily(out,"sqlrelay_connection_queries","counter",
+			"Queries run by each connection.");
+	out->append(queries.getString());
+	printMetricFamily(out,"sqlrelay_connection_relogins","counter",
+			"Times each connection re-logged in to the database.");
+	out->append(relogins.getString());
+	printMetricFamily(out,"sqlrelay_connection_cursor_buffer_bytes",
+			"gauge",
+			"Memory used by each connection's cursor buffers.");
+	out->append(buffermemory.getString());
+
+	out->append("# EOF\n");
+}
+
+// A client gets METRICSDEADLINE microseconds, all told, to send its request
+// and read the response, so that a slow or idle client can't hold up the
+// clients behind it for long.
+#define METRICSDEADLINE	2000000
+
+static uint64_t getMetricsTime() {
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	return ((uint64_t)dt.getEpoch())*1000000+dt.getMicroseconds();
+}
+
+static bool getTimeLeft(uint64_t deadline, int32_t *sec, int32_t *usec) {
+	uint64_t	now=getMetricsTime();
+	if (now>=deadline) {
+		return false;
+	}
+	*sec=(deadline-now)/1000000;
+	*usec=(deadline-now)%1000000;
+	return true;
+}
+
+static void respond(filedescriptor *clientsock, uint64_t deadline,
+					const char *status,
+					const char *contenttype,
+					const char *body, size_t bodylength,
+					bool sendbody) {
+	stringbuffer	header;
+	header.append("HTTP/1.0 ")->append(status)->append("\r\n");
+	header.append("Content-Type: ")->append(contenttype)->append("\r\n");
+	header.append("Content-Length: ")->append((uint64_t)bodylength);
+	header.append("\r\n");
+	header.append("Connection: close\r\n\r\n");
+	int32_t	sec;
+	int32_t	usec;
+	if (!getTimeLeft(deadline,&sec,&usec) ||
+		clientsock->write(header.getString(),header.getSize(),
+					sec,usec)!=(ssize_t)header.getSize()) {
+		return;
+	}
+	if (sendbody) {
+		while (bodylength && getTimeLeft(deadline,&sec,&usec)) {
+			ssize_t	result=clientsock->write(body,bodylength,
+								sec,usec);
+			if (result<=0) {
+				break;
+			}
+			body+=result;
+			bodylength-=result;
+		}
+	}
+}
+
+static void handleMetricsRequest(filedescriptor *clientsock,
+					sqlrshm *shm, semaphoreset *semset,
+					stringbuffer *metrics) {
+
+	// read the request headers, but don't let
+	// a slow or idle client tie us up for long
+	uint64_t	deadline=getMetricsTime()+METRICSDEADLINE;
+	char		request[4096];
+	size_t		length=0;
+	int32_t		sec;
+	int32_t		usec;
+	while (length<sizeof(request)-1 &&
+			getTimeLeft(deadline,&sec,&usec)) {
+		ssize_t	result=clientsock->read(request+length,
+						sizeof(request)-1-length,
+						sec,usec);
+		if (result<=0) {
+			break;
+		}
+		length+=result;
+		request[length]='\0';
+		if (charstring::contains(request,"\r\n\r\n") ||
+				charstring::contains(request,"\n\n")) {
+			break;
+		}
+	}
+	request[length]='\0';
+
+	// get the method and path
+	const char	*method=request;
+	char		*space=charstring::findFirst(request,' ');
+	if (!space) {
+		const char	*body="Bad Request\n";
+		respond(clientsock,deadline,"400 Bad Request","text/plain",
+				body,charstring::length(body),true);
+		return;
+	}
+	*space='\0';
+	char	*path=space+1;
+	char	*end=charstring::findFirstOfSet(path," ?\r\n");
+	if (end) {
+		*end='\0';
+	}
+
+	bool	head=!charstring::compare(method,"HEAD");
+	if (charstring::compare(method,"GET") && !head) {
+		const char	*body="Method Not Allowed\n";
+		respond(clientsock,deadline,
+				"405 Method Not Allowed","text/plain",
+				body,charstring::length(body),true);
+		return;
+	}
+	if (charstring::compare(path,"/metrics") &&
+				charstring::compare(path,"/")) {
+		const char	*body="Not Found\n";
+		respond(clientsock,deadline,"404 Not Found","text/plain",
+				body,charstring::length(body),!head);
+		return;
+	}
+
+	printMetrics(metrics,shm,semset);
+	respond(clientsock,deadline,"200 OK",
+		"application/openmetrics-text; version=1.0.0; charset=utf-8",
+		metrics->getString(),metrics->getSize(),!head);
+}
+
+static void serveMetrics(sqlrshm *shm, semaphoreset *semset,
+						const char *address,
+						uint16_t port,
+						const char *socket) {
+
+	// don't die if a scraper hangs up on us
+	#ifdef SIGPIPE
+	signalset	set;
+	set.addSignal(SIGPIPE);
+	signalmanager::ignoreSignals(&set);
+	#endif
+
+	listener		lsnr;
+	inetsocketserver	inetserver;
+	unixsocketserver	unixserver;
+	bool			listening=false;
+
+	if (port) {
+		if (charstring::isNullOrEmpty(address)) {
+			address="0.0.0.0";
+		}
+		if (inetserver.listen(address,port,128)) {
+			lsnr.addReadFileDescriptor(&inetserver);
+			listening=true;
+		} else {
+			char	*err=error::getErrorString();
+			stderror.printf("Couldn't listen on %s/%d: %s\n",
+							address,port,err);
+			delete[] err;
+		}
+	}
+	if (!charstring::isNullOrEmpty(socket)) {
+		if (unixserver.listen(socket,0077,128)) {
+			lsnr.addReadFileDescriptor(&unixserver);
+			listening=true;
+		} else {
+			char	*err=error::getErrorString();
+			stderror.printf("Couldn't listen on %s: %s\n",
+							socket,err);
+			delete[] err;
+		}
+	}
+	if (!listening) {
+		process::exit(1);
+	}
+
+	// serve requests one at a time, they're small and quick, and
+	// handleMetricsRequest() gives up on clients that aren't
+	stringbuffer	metrics;
+	for (;;) {
+		if (lsnr.listen(-1,-1)<1) {
+			continue;
+		}
+		filedescriptor	*fd=
+			lsnr.getReadReadyList()->getFirst()->getValue();
+		filedescriptor	*clientsock=(fd==&inetserver)?
+						inetserver.accept():
+						unixserver.accept();
+		if (!clientsock) {
+			continue;
+		}
+		handleMetricsRequest(clientsock,shm,semset,&metrics);
+		clientsock->close();
+		delete clientsock;
+	}
+}
+
 static void helpmessage(const char *progname) {
 	stdoutput.printf(
 		"%s is the %s status utility.\n"
@@ -113,6 +677,31 @@ static void helpmessage(const char *progname) {
 		"\n"
 		"Options:\n"
 		SERVEROPTIONS
+		"	-short			Print a few key counts as key=value pairs\n"
+		"				on a single line.\n"
+		"\n"
+		"	-connection-detail	Print statistics for each connection.\n"
+		"\n"
+		"	-query			With -connection-detail, also print each\n"
+		"				connection's current query.\n"
+		"\n"
+		"	-histograms		Print the count, average, 50th, 90th, 99th\n"
+		"				and 99.9th percentiles and maximum latency,\n"
+		"				in microseconds, for each stage of query\n"
+		"				processing: handoff, filter, translate,\n"
+		"				prepare, execute, firstrow, send and think.\n"
+		"\n"
+		"	-serve port		Rather than printing the status and exiting,\n"
+		"				run until killed, serving the status as\n"
+		"				Prometheus/OpenMetrics text over HTTP on\n"
+		"				the specified port, at /metrics.\n"
+		"\n"
+		"	-serve-address addr	With -serve, listen on the specified\n"
+		"				address.  Defaults to 0.0.0.0.\n"
+		"\n"
+		"	-serve-socket socket	Serve the status as with -serve, on the\n"
+		"				specified unix socket.  May be used with\n"
+		"				or instead of -serve.\n"
 		"\n"
 		"Examples:\n"
 		"\n"
@@ -125,8 +714,12 @@ static void helpmessage(const char *progname) {
 		"./myconfig.conf\n"
 		"\n"
 		"	%s -config ./myconfig.conf -id myinst\n"
+		"\n"
+		"Serve the status of the specified instance to Prometheus on port 9187.\n"
+		"\n"
+		"	%s -id myinst -serve 9187\n"
 		"\n",
-		progname,SQL_RELAY,progname,progname,progname,progname);
+		progname,SQL_RELAY,progname,progname,progname,progname,progname);
 }
 
 int main(int argc, const char **argv) {
@@ -142,12 +735,20 @@ int main(int argc, const char **argv) {
 		stdoutput.printf("usage:\n"
 			" %s-status [-config config] -id id "
 			"[-localstatedir dir] [-short] "
-			"[-connection-detail [-query]]\n",SQLR);
+			"[-connection-detail [-query]] [-histograms] "
+			"[-serve port [-serve-address addr]] "
+			"[-serve-socket socket]\n",SQLR);
 		process::exit(1);
 	}
 	bool		shortoutput=cmdl.found("-short");
 	bool		connoutput=cmdl.found("-connection-detail");
 	bool		queryoutput=cmdl.found("-query");
+	bool		histogramoutput=cmdl.found("-histograms");
+	const char	*serve=cmdl.getValue("-serve");
+	uint16_t	serveport=(!charstring::isNullOrEmpty(serve))?
+					charstring::toInteger(serve):0;
+	const char	*serveaddress=cmdl.getValue("-serve-address");
+	const char	*servesocket=cmdl.getValue("-serve-socket");
 	
 	// get the id filename and key
 	sqlrpaths	sqlrp(&cmdl);
@@ -170,6 +771,27 @@ int main(int argc, const char **argv) {
 		process::exit(0);
 	}
 
+	// the segment is sized for the instance's maxconnections,
+	// so re-attach to the whole thing, as described by its header
+	if (!sqlrshmLayoutIsValid(shm)) {
+		stderror.printf("Shared memory segment was created by "
+				"an incompatible version of %s\n",SQL_RELAY);
+		process::exit(0);
+	}
+	uint64_t	shmsize=shm->size;
+	sharedmemory	wholememory;
+	if (shmsize>sizeof(sqlrshm)) {
+		if (!wholememory.attach(key,shmsize)) {
+			char	*err=error::getErrorString();
+			stderror.printf("Couldn't attach to "
+					"shared memory segment: ");
+			stderror.printf("%s\n",err);
+			delete[] err;
+			process::exit(0);
+		}
+		shm=(sqlrshm *)wholememory.getPointer();
+	}
+
 	// attach to the semaphore set for the specified instance
 	semaphoreset	semset;
 	if (!semset.attach(key,13)) {
@@ -180,12 +802,18 @@ int main(int argc, const char **argv) {
 		process::exit(0);
 	}
 
+	// serve the stats, rather than printing them
+	if (serveport || !charstring::isNullOrEmpty(servesocket)) {
+		serveMetrics(shm,&semset,serveaddress,serveport,servesocket);
+	}
+
 	// take a snapshot of the stats
 	semset.waitWithUndo(9);
 	// create this on the heap, rather than stack because it can be pretty
 	// big and easily exceed the default stack ulimit on some platforms
-	sqlrshm		*statistics=new sqlrshm;
-	*statistics=*shm;
+	unsigned char	*snapshot=new unsigned char[shmsize];
+	bytestring::copy(snapshot,shm,shmsize);
+	sqlrshm		*statistics=(sqlrshm *)snapshot;
 	semset.signalWithUndo(9);
 	#define SEM_COUNT	13
 	int32_t	sem[SEM_COUNT];
@@ -218,7 +846,7 @@ int main(int argc, const char **argv) {
 				statistics->times_cursor_reused,
 				statistics->total_queries,
 				statistics->total_errors);
-		delete statistics;
+		delete[] snapshot;
 		process::exit(0);
 	}
 
@@ -263,6 +891,61 @@ int main(int argc, const char **argv) {
 		statistics->connectedclients
 		);
 
+	// print out the scaling policy's most recent decisions
+	sqlrscalerstatistics	*scaler=&statistics->scalerstats;
+	if (scaler->policy[0]) {
+		stdoutput.printf(
+			"Scaling policy:                 %s\n"
+			"  Forecast QPS:                 %d\n"
+			"  Detected Period (sec):        %d\n"
+			"  Avg Queue Wait (usec):        %llu\n"
+			"  Target Connections:           %d\n"
+			"  Connections Kept (floor):     %d\n"
+			"  Connections Retiring:         %d\n"
+			"  Connections Opened:           %d\n"
+			"  Last Decision:                %s\n"
+			"  Last Decision Time:           %ld\n"
+			"\n",
+			scaler->policy,
+			scaler->forecastqps,
+			scaler->period,
+			scaler->avgqueuewaitusec,
+			scaler->target,
+			scaler->floor,
+			scaler->retiring,
+			scaler->opened,
+			scaler->decision,
+			(long)scaler->decisiontime);
+	}
+
+	// print out the admission classes
+	if (statistics->admissionclasses) {
+		stdoutput.printf("Admission classes:\n");
+		stdoutput.printf("  %-16s %6s %6s %6s %10s %10s %10s "
+					"%10s %10s\n",
+					"class","weight","queued","peak",
+					"admitted","rejected","timedout",
+					"avg wait","max wait");
+		for (uint32_t i=0; i<statistics->admissionclasses &&
+					i<STATADMISSIONCLASSES; i++) {
+			sqlradmissionclass	*ac=&(statistics->admission[i]);
+			stdoutput.printf("  %-16s %6d %6d %6d %10llu %10llu "
+					"%10llu %10llu %10llu\n",
+					ac->name,ac->weight,
+					ac->queued,ac->peakqueued,
+					(unsigned long long)ac->admitted,
+					(unsigned long long)ac->rejected,
+					(unsigned long long)ac->timedout,
+					(unsigned long long)
+					((ac->admitted)?
+						ac->queuewaitusec/
+						ac->admitted:0),
+					(unsigned long long)
+						ac->maxqueuewaitusecseen);
+		}
+		stdoutput.printf("  (wait times are in usec)\n\n");
+	}
+
 	stdoutput.printf("Mutexes:\n");
 	stdoutput.printf("  Connection Announce               : ");
 	printAcquisitionStatus(sem[0]);
@@ -308,14 +991,15 @@ int main(int argc, const char **argv) {
 		);
 
 	if (connoutput) {
-		long conndim=sizeof(statistics->connstats)/
-				sizeof(struct sqlrconnstatistics);
-		sqlrconnstatistics *conn=&statistics->connstats[0];
+		long conndim=statistics->maxconnections;
 		stdoutput.printf("\n");
 		stdoutput.printf("Info for max=%ld connections id=%s\n\n",
 					conndim,&statistics->connectionid[0]);
 		for(long j=0; j<conndim; j++) {
-			if (conn[j].state!=NOT_AVAILABLE) {
+			sqlrconnstatistics *conn=
+					sqlrshmConnStats(statistics,j);
+			sqlrconntext *text=sqlrshmConnText(statistics,j);
+			if (conn->state!=NOT_AVAILABLE) {
 				// print out multiple lines, a cross between
 				// ease of human readability and potentially
 				// automated parsing.
@@ -327,29 +1011,34 @@ int main(int argc, const char **argv) {
 						"nsuspend=%d "
 						"nend=%d "
 						"nrelogin=%d "
-						"loggedinsec=%d "
-						"statestartsec=%d "
-						"clientsessionsec=%d\n",
-						j,conn[j].processid,
+						"loggedinsec=%llu "
+						"statestartsec=%llu "
+						"clientsessionsec=%llu "
+						"cursorbuffermemory=%llu\n",
+						j,conn->processid,
 						sqlrconnectionstateStr(
-								conn[j].state),
-						conn[j].state,
-						conn[j].nconnect,
-						conn[j].nauth,
-						conn[j].nsuspend_session,
-						conn[j].nend_session,
-						conn[j].nrelogin,
-						conn[j].loggedinsec,
-						conn[j].statestartsec,
-						conn[j].clientsessionsec);
+								conn->state),
+						conn->state,
+						conn->nconnect,
+						conn->nauth,
+						conn->nsuspend_session,
+						conn->nend_session,
+						conn->nrelogin,
+						(unsigned long long)
+							conn->loggedinsec,
+						(unsigned long long)
+							conn->statestartsec,
+						(unsigned long long)
+							conn->clientsessionsec,
+						conn->cursorbuffermemory);
 				// elsewhere in the code the strings
 				// are treated as zero terminated.
 				stdoutput.printf(" clientinfo=%s "
 						"clientaddr=%s "
 						"user=%s\n",
-						&conn[j].clientinfo[0],
-						&conn[j].clientaddr[0],
-						&conn[j].user[0]);
+						&text->clientinfo[0],
+						&text->clientaddr[0],
+						&text->user[0]);
 				stdoutput.printf(" nautocommit=%d "
 						"nbegin=%d "
 						"ncommit=%d "
@@ -358,24 +1047,24 @@ int main(int argc, const char **argv) {
 						"nbindformat=%d "
 						"nserverversion=%d "
 						"nselectdatabase=%d\n",
-						conn[j].nautocommit,
-						conn[j].nbegin,
-						conn[j].ncommit,
-						conn[j].nrollback,
-						conn[j].ndbversion,
-						conn[j].nbindformat,
-						conn[j].nserverversion,
-						conn[j].nselectdatabase);
+						conn->nautocommit,
+						conn->nbegin,
+						conn->ncommit,
+						conn->nrollback,
+						conn->ndbversion,
+						conn->nbindformat,
+						conn->nserverversion,
+						conn->nselectdatabase);
 				stdoutput.printf(" ngetcurrentdatabase=%d "
 						"ngetlastinsertid=%d "
 						"ngettablelist=%d "
 						"ngetcolumnlist=%d "
 						"ngetquerytree=%d\n",
-						conn[j].ngetcurrentdatabase,
-						conn[j].ngetlastinsertid,
-						conn[j].ngettablelist,
-						conn[j].ngetcolumnlist,
-						conn[j].ngetquerytree);
+						conn->ngetcurrentdatabase,
+						conn->ngetlastinsertid,
+						conn->ngettablelist,
+						conn->ngetcolumnlist,
+						conn->ngetquerytree);
 				stdoutput.printf(" ndbhostname=%d "
 						"ndbipaddress=%d "
 						"nfetchfrombindcursor=%d "
@@ -384,14 +1073,14 @@ int main(int argc, const char **argv) {
 						"nsuspendresultset=%d "
 						"nresumeresultset=%d "
 						"ngetdblist=%d\n",
-						conn[j].ndbhostname,
-						conn[j].ndbipaddress,
-						conn[j].nfetchfrombindcursor,
-						conn[j].nfetchresultset,
-						conn[j].nabortresultset,
-						conn[j].nsuspendresultset,
-						conn[j].nresumeresultset,
-						conn[j].ngetdblist);
+						conn->ndbhostname,
+						conn->ndbipaddress,
+						conn->nfetchfrombindcursor,
+						conn->nfetchresultset,
+						conn->nabortresultset,
+						conn->nsuspendresultset,
+						conn->nresumeresultset,
+						conn->ngetdblist);
 				stdoutput.printf(" nping=%d "
 						"nidentify=%d "
 						"nnewquery=%d "
@@ -400,22 +1089,26 @@ int main(int argc, const char **argv) {
 						"ncustomsql=%d "
 						"nnextresultset=%d "
 						"nnextresultsetavailable=%d\n",
-						conn[j].nping,
-						conn[j].nidentify,
-						conn[j].nnewquery,
-						conn[j].nreexecutequery,
-						conn[j].nsql,
-						conn[j].ncustomsql,
-						conn[j].nnextresultset,
-						conn[j].nnextresultsetavailable
+						conn->nping,
+						conn->nidentify,
+						conn->nnewquery,
+						conn->nreexecutequery,
+						conn->nsql,
+						conn->ncustomsql,
+						conn->nnextresultset,
+						conn->nnextresultsetavailable
 						);
 				if (queryoutput) {
-					printQuery(&(conn[j]));
+					printQuery(text);
 				}
 			}
 		}
 	}
 
-	delete statistics;
+	if (histogramoutput) {
+		printHistograms(statistics);
+	}
+
+	delete[] snapshot;
 	process::exit(0);
 }
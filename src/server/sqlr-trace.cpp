@@ -0,0 +1,311 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information
+
+#include <sqlrelay/sqlrutil.h>
+#include <sqlrelay/private/sqlrtrace.h>
+#include <rudiments/file.h>
+#include <rudiments/directory.h>
+#include <rudiments/charstring.h>
+#include <rudiments/bytestring.h>
+#include <rudiments/stringbuffer.h>
+#include <rudiments/linkedlist.h>
+#include <rudiments/process.h>
+#include <rudiments/stdio.h>
+#include <config.h>
+#include <defaults.h>
+#include <version.h>
+
+static void helpmessage(const char *progname) {
+	stdoutput.printf(
+		"%s converts the trace files written by the %s tracer logger to Chrome trace/Perfetto JSON.\n"
+		"\n"
+		"The tracer logger records a sample of query lifecycles in a trace file for each %s-connection process.  %s reads one or more of these files and writes a single JSON document to standard output, which can be loaded into chrome://tracing or https://ui.perfetto.dev.  Each connection process appears as a process, and each of its cursors as a thread.\n"
+		"\n"
+		"Usage: %s [OPTIONS] [tracefile ...]\n"
+		"\n"
+		"Options:\n"
+		SERVEROPTIONS
+		"	-id instanceid		Convert all of the trace files for the\n"
+		"				specified instance, found in the log\n"
+		"				directory, in addition to any trace files\n"
+		"				given on the command line.\n"
+		"\n"
+		"Examples:\n"
+		"\n"
+		"Convert all of the trace files for instance \"myinst\".\n"
+		"\n"
+		"	%s -id myinst > trace.json\n"
+		"\n"
+		"Convert a single trace file.\n"
+		"\n"
+		"	%s /var/log/sqlrelay/sqlr-connection-myinst-trace.12345 > trace.json\n"
+		"\n",
+		progname,SQL_RELAY,SQLR,progname,progname,progname,progname);
+}
+
+static bool	firstevent=true;
+
+static void writeEvent(stringbuffer *ev) {
+	if (!firstevent) {
+		stdoutput.write(",\n");
+	}
+	stdoutput.write(ev->getString(),ev->getStringLength());
+	firstevent=false;
+}
+
+static void appendJSONString(stringbuffer *ev, const char *str) {
+	ev->append('"');
+	for (const char *c=str; *c; c++) {
+		if (*c=='"' || *c=='\\') {
+			ev->append('\\')->append(*c);
+		} else if ((unsigned char)*c<0x20) {
+			char	hex[7];
+			charstring::printf(hex,sizeof(hex),"\\u%04x",
+							(unsigned char)*c);
+			ev->append(hex);
+		} else {
+			ev->append(*c);
+		}
+	}
+	ev->append('"');
+}
+
+static void writeCompleteEvent(const char *name, const char *cat,
+				uint64_t ts, uint64_t end,
+				uint32_t pid, uint16_t tid,
+				const sqlrtracerecord *r) {
+
+	// skip events that weren't timed
+	if (!ts || end<ts) {
+		return;
+	}
+
+	stringbuffer	ev;
+	ev.append("{\"name\":");
+	appendJSONString(&ev,name);
+	ev.append(",\"cat\":\"")->append(cat)->append('"');
+	ev.append(",\"ph\":\"X\"");
+	ev.append(",\"ts\":")->append(ts);
+	ev.append(",\"dur\":")->append(end-ts);
+	ev.append(",\"pid\":")->append(pid);
+	ev.append(",\"tid\":")->append(tid);
+	if (r) {
+		char	hash[17];
+		charstring::printf(hash,sizeof(hash),"%016llx",
+					(unsigned long long)r->fingerprinthash);
+		ev.append(",\"args\":{\"fingerprint\":");
+		appendJSONString(&ev,r->fingerprint);
+		ev.append(",\"fingerprint_hash\":\"");
+		ev.append(hash)->append('"');
+		ev.append(",\"rows\":")->append(r->rows);
+		ev.append(",\"bytes\":")->append(r->bytes);
+		ev.append(",\"error\":")->append((r->error)?"true":"false");
+		ev.append('}');
+	}
+	ev.append('}');
+	writeEvent(&ev);
+}
+
+static void writeMetadataEvent(const char *name,
+				uint32_t pid, uint16_t tid,
+				const char *value) {
+	stringbuffer	ev;
+	ev.append("{\"name\":\"")->append(name)->append('"');
+	ev.append(",\"ph\":\"M\"");
+	ev.append(",\"pid\":")->append(pid);
+	ev.append(",\"tid\":")->append(tid);
+	ev.append(",\"args\":{\"name\":");
+	appendJSONString(&ev,value);
+	ev.append("}}");
+	writeEvent(&ev);
+}
+
+static void writeRecord(const sqlrtracerecord *r) {
+
+	const char	*name=(r->fingerprint[0])?r->fingerprint:"query";
+
+	if (r->type==SQLRTRACERECORDTYPE_FETCH) {
+
+		// fetching more of the result set
+		writeCompleteEvent("fetch","fetch",
+					r->commandstart,r->commandend,
+					r->pid,r->cursorid,r);
+
+	} else if (r->commandstart) {
+
+		// the whole command, and the stages of it:
+		// reading and preparing the query, running it,
+		// and sending the result set back
+		writeCompleteEvent(name,"query",
+					r->commandstart,r->commandend,
+					r->pid,r->cursorid,r);
+		writeCompleteEvent("prepare","stage",
+					r->commandstart,r->querystart,
+					r->pid,r->cursorid,NULL);
+		writeCompleteEvent("execute","stage",
+					r->querystart,r->queryend,
+					r->pid,r->cursorid,NULL);
+		writeCompleteEvent("send","stage",
+					r->queryend,r->commandend,
+					r->pid,r->cursorid,NULL);
+
+	} else {
+
+		// protocols that don't time commands only time the query
+		writeCompleteEvent(name,"query",
+					r->querystart,r->queryend,
+					r->pid,r->cursorid,r);
+	}
+}
+
+static bool convert(const char *filename) {
+
+	// read the file
+	file	f;
+	if (!f.open(filename,O_RDONLY)) {
+		stderror.printf("failed to open %s\n",filename);
+		return false;
+	}
+	off64_t		size=f.getSize();
+	unsigned char	*buffer=new unsigned char[size];
+	if (f.read(buffer,size)!=size) {
+		stderror.printf("failed to read %s\n",filename);
+		delete[] buffer;
+		return false;
+	}
+	f.close();
+
+	// validate the header
+	const sqlrtraceheader	*header=(const sqlrtraceheader *)buffer;
+	if ((size_t)size<sizeof(sqlrtraceheader) ||
+		charstring::compare(header->magic,SQLRTRACE_MAGIC) ||
+		header->version!=SQLRTRACE_VERSION ||
+		header->byteorder!=SQLRTRACE_BYTEORDER ||
+		header->headersize!=sizeof(sqlrtraceheader) ||
+		header->recordsize!=sizeof(sqlrtracerecord) ||
+		(uint64_t)size<sizeof(sqlrtraceheader)+
+				header->records*sizeof(sqlrtracerecord)) {
+		stderror.printf("%s is not a trace file, or was written "
+				"by an incompatible version of %s, or "
+				"on a host with a different byte order\n",
+				filename,SQL_RELAY);
+		delete[] buffer;
+		return false;
+	}
+	const sqlrtracerecord	*records=(const sqlrtracerecord *)
+					(buffer+sizeof(sqlrtraceheader));
+
+	// name the process
+	stringbuffer	processname;
+	processname.append("sqlr-connection ");
+	processname.append(header->id)->append(' ')->append(header->pid);
+	writeMetadataEvent("process_name",header->pid,0,
+					processname.getString());
+
+	// The ring is written in order, so starting at the next record to be
+	// written and going around the ring once visits the records from
+	// oldest to newest.  Records with a sequence of 0 were never written,
+	// or were being written when the process died.
+	bool	*namedcursors=new bool[65536];
+	bytestring::zero(namedcursors,65536*sizeof(bool));
+	for (uint64_t i=0; i<header->records; i++) {
+
+		const sqlrtracerecord	*r=
+			&(records[(header->next+i)%header->records]);
+		if (!r->sequence) {
+			continue;
+		}
+
+		// name the cursor
+		if (!namedcursors[r->cursorid]) {
+			stringbuffer	cursorname;
+			cursorname.append("cursor ")->append(r->cursorid);
+			writeMetadataEvent("thread_name",r->pid,r->cursorid,
+						cursorname.getString());
+			namedcursors[r->cursorid]=true;
+		}
+
+		writeRecord(r);
+	}
+	delete[] namedcursors;
+
+	delete[] buffer;
+	return true;
+}
+
+int main(int argc, const char **argv) {
+
+	version(argc,argv);
+	help(argc,argv);
+
+	// parse the command line
+	sqlrcmdline	cmdl(argc,argv);
+	sqlrpaths	sqlrpth(&cmdl);
+	const char	*id=cmdl.getValue("-id");
+
+	// the files to convert are the arguments that aren't options...
+	stringbuffer	fqp;
+	linkedlist< char * >	filenames;
+	for (int i=1; i<argc; i++) {
+		if (argv[i][0]=='-') {
+			// skip the values of the options that have them
+			if (i+1<argc &&
+				(!charstring::compare(argv[i],"-config") ||
+				!charstring::compare(argv[i],"-id") ||
+				!charstring::compare(argv[i],"-localstatedir"))) {
+				i++;
+			}
+			continue;
+		}
+		filenames.append(charstring::duplicate(argv[i]));
+	}
+
+	// ...and the trace files for the specified instance
+	if (!charstring::isNullOrEmpty(id)) {
+		directory	dir;
+		if (!dir.open(sqlrpth.getLogDir())) {
+			stderror.printf("failed to open log directory %s\n",
+							sqlrpth.getLogDir());
+			process::exit(1);
+		}
+		stringbuffer	match;
+		match.append("sqlr-connection-");
+		match.append(id)->append("-trace.");
+		for (;;) {
+			const char	*name=dir.read();
+			if (!name) {
+				break;
+			}
+			if (charstring::compare(name,match.getString(),
+						match.getStringLength())) {
+				continue;
+			}
+			fqp.clear();
+			fqp.append(sqlrpth.getLogDir())->append(name);
+			filenames.append(charstring::duplicate(
+						fqp.getString()));
+		}
+	}
+
+	// sanity check and usage message
+	if (!filenames.getLength()) {
+		stderror.printf("usage:\n"
+			" %s-trace [-config config] [-id id] "
+			"[-localstatedir dir] [tracefile ...]\n",SQLR);
+		process::exit(1);
+	}
+
+	// convert the files
+	int32_t	exitstatus=0;
+	stdoutput.write("{\"traceEvents\":[\n");
+	for (linkedlistnode< char * > *node=filenames.getFirst();
+					node; node=node->getNext()) {
+		if (!convert(node->getValue())) {
+			exitstatus=1;
+		}
+		delete[] node->getValue();
+	}
+	stdoutput.write("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	process::exit(exitstatus);
+}
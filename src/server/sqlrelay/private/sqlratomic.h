@@ -0,0 +1,92 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#ifndef SQLRATOMIC_H
+#define SQLRATOMIC_H
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+// Atomic operations on 64-bit values in shared memory.  Statistics that all of
+// an instance's listeners and connections update at once use these rather than
+// a semaphore.  On compilers that provide no atomic builtins, they fall back
+// to plain, unsynchronized updates.
+
+static inline bool atomicCompareAndSwap64(uint64_t *value,
+						uint64_t oldvalue,
+						uint64_t newvalue) {
+#if defined(_MSC_VER)
+	return (_InterlockedCompareExchange64((volatile __int64 *)value,
+						(__int64)newvalue,
+						(__int64)oldvalue)==
+						(__int64)oldvalue);
+#elif defined(__GNUC__)
+	return __sync_bool_compare_and_swap(value,oldvalue,newvalue);
+#else
+	if (*value!=oldvalue) {
+		return false;
+	}
+	*value=newvalue;
+	return true;
+#endif
+}
+
+static inline void atomicAdd64(uint64_t *value, uint64_t delta) {
+#if defined(__GNUC__)
+	__sync_fetch_and_add(value,delta);
+#else
+	uint64_t	old;
+	do {
+		old=*((volatile uint64_t *)value);
+	} while (!atomicCompareAndSwap64(value,old,old+delta));
+#endif
+}
+
+static inline void atomicMax64(uint64_t *value, uint64_t candidate) {
+	for (;;) {
+		uint64_t	old=*((volatile uint64_t *)value);
+		if (candidate<=old ||
+			atomicCompareAndSwap64(value,old,candidate)) {
+			return;
+		}
+	}
+}
+
+// 0 is taken to mean that no minimum has been recorded yet
+static inline void atomicMin64(uint64_t *value, uint64_t candidate) {
+	for (;;) {
+		uint64_t	old=*((volatile uint64_t *)value);
+		if ((old && candidate>=old) ||
+			atomicCompareAndSwap64(value,old,candidate)) {
+			return;
+		}
+	}
+}
+
+// the double is stored in the bits of a uint64_t
+static inline void atomicAddDouble(uint64_t *value, double delta) {
+	for (;;) {
+		uint64_t	old=*((volatile uint64_t *)value);
+		union {
+			uint64_t	u;
+			double		d;
+		} sum;
+		sum.u=old;
+		sum.d+=delta;
+		if (atomicCompareAndSwap64(value,old,sum.u)) {
+			return;
+		}
+	}
+}
+
+static inline double atomicGetDouble(const uint64_t *value) {
+	union {
+		uint64_t	u;
+		double		d;
+	} v;
+	v.u=*((const volatile uint64_t *)value);
+	return v.d;
+}
+
+#endif
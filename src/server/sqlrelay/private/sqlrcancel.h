@@ -0,0 +1,61 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#ifndef SQLRCANCEL_H
+#define SQLRCANCEL_H
+
+#include <sqlrelay/private/sqlrshm.h>
+#include <rudiments/unixsocketclient.h>
+#include <rudiments/charstring.h>
+
+// A connection that's running a query can't read a request to cancel it from
+// its client, so each connection runs a thread that listens for them on a
+// unix socket named after its pid, in the sockets directory.  The listener
+// (or another connection) forwards the cancel key, and the id of the query to
+// cancel, to that socket.  A query id of 0 cancels whatever query is running.
+//
+// The connection replies with a uint16_t, 1 if the query was cancelled and 0
+// if it wasn't (because the key was wrong, or the query had already finished).
+
+static inline char *sqlrCancelSocketName(const char *socketsdir,
+							uint32_t pid) {
+	char	*name=NULL;
+	charstring::printf(&name,"%s%ld-cancel.sock",socketsdir,(long)pid);
+	return name;
+}
+
+static inline bool sqlrForwardCancel(sqlrshm *shm, const char *socketsdir,
+							uint32_t pid,
+							uint32_t key,
+							uint32_t queryid) {
+
+	// make sure that the pid belongs to a connection
+	// of this instance, and that it's running a query
+	bool	running=false;
+	for (uint32_t i=0; i<shm->maxconnections; i++) {
+		sqlrconnstatistics	*cs=sqlrshmConnStats(shm,i);
+		if (cs->processid==pid) {
+			running=(cs->state==PROCESS_SQL);
+			break;
+		}
+	}
+	if (!running) {
+		return false;
+	}
+
+	// forward the request
+	char			*name=sqlrCancelSocketName(socketsdir,pid);
+	unixsocketclient	cancelsock;
+	uint16_t		cancelled=0;
+	if (cancelsock.connect(name,5,0,0,1)==RESULT_SUCCESS &&
+		cancelsock.write(key)==sizeof(uint32_t) &&
+		cancelsock.write(queryid)==sizeof(uint32_t) &&
+		cancelsock.read(&cancelled,5,0)!=sizeof(uint16_t)) {
+		cancelled=0;
+	}
+	cancelsock.close();
+	delete[] name;
+	return (cancelled==1);
+}
+
+#endif
@@ -0,0 +1,206 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#ifndef SQLRFINGERPRINT_H
+#define SQLRFINGERPRINT_H
+
+#include <rudiments/stringbuffer.h>
+#include <rudiments/character.h>
+
+// A query's fingerprint follows the same rules as the normalize translation,
+// except that literals and bind variables are replaced with ?'s, and lists of
+// them in IN clauses are collapsed to a single ?, so queries that only differ
+// by their parameters get the same fingerprint.
+
+static inline bool fingerprintIsIdentifierCharacter(char c) {
+	return (character::isAlphanumeric(c) || c=='_' || c=='#' || c=='$');
+}
+
+static inline void fingerprintSkipWhitespaceAndComments(const char **ptr,
+							const char *end) {
+	const char	*p=*ptr;
+	while (p<end) {
+		if (character::isWhitespace(*p)) {
+			p++;
+		} else if (*p=='-' && p+1<end && *(p+1)=='-') {
+			while (p<end && *p!='\n') {
+				p++;
+			}
+		} else if (*p=='/' && p+1<end && *(p+1)=='*') {
+			p+=2;
+			while (p<end && !(*p=='*' && p+1<end && *(p+1)=='/')) {
+				p++;
+			}
+			p=(p<end)?p+2:end;
+		} else {
+			break;
+		}
+	}
+	*ptr=p;
+}
+
+static inline void fingerprintSkipQuotedString(const char **ptr,
+							const char *end) {
+	const char	*p=*ptr+1;
+	while (p<end) {
+		if (*p=='\\' && p+1<end) {
+			p+=2;
+		} else if (*p=='\'') {
+			// doubled quotes are escaped quotes
+			if (p+1<end && *(p+1)=='\'') {
+				p+=2;
+			} else {
+				p++;
+				break;
+			}
+		} else {
+			p++;
+		}
+	}
+	*ptr=p;
+}
+
+static inline void fingerprintCollapseInList(stringbuffer *fp) {
+
+	// if the fingerprint ends with "in(?,?,...,?)"
+	// then replace the list with "in(?)"
+	if (fp->getSize()<6) {
+		return;
+	}
+	const char	*start=fp->getString();
+	const char	*p=start+fp->getSize()-2;
+	uint32_t	items=0;
+	while (p>=start && *p=='?') {
+		items++;
+		p--;
+		if (p>=start && *p==',') {
+			p--;
+		} else {
+			break;
+		}
+	}
+	if (items<2 || p<start+2 || *p!='(' ||
+			character::toLowerCase(*(p-1))!='n' ||
+			character::toLowerCase(*(p-2))!='i' ||
+			(p-3>=start && fingerprintIsIdentifierCharacter(*(p-3)))) {
+		return;
+	}
+	fp->truncate(p-start+1);
+	fp->append("?)");
+}
+
+static inline void fingerprintQuery(stringbuffer *fp,
+					const char *query, uint32_t length) {
+
+	fp->clear();
+
+	const char	*ptr=query;
+	const char	*end=query+length;
+	for (;;) {
+
+		// compress whitespace and comments into a single space
+		const char	*before=ptr;
+		fingerprintSkipWhitespaceAndComments(&ptr,end);
+		if (ptr==end) {
+			break;
+		}
+		if (ptr!=before && fp->getSize()) {
+			fp->append(' ');
+		}
+
+		char	c=*ptr;
+		if (c=='\'') {
+
+			// string literals
+			fingerprintSkipQuotedString(&ptr,end);
+			fp->append('?');
+
+		} else if (c=='"' || c=='`') {
+
+			// quoted identifiers are copied verbatim
+			const char	*start=ptr;
+			ptr++;
+			while (ptr<end && *ptr!=c) {
+				ptr++;
+			}
+			if (ptr<end) {
+				ptr++;
+			}
+			fp->append(start,ptr-start);
+
+		} else if (character::isDigit(c) ||
+				(c=='.' && ptr+1<end &&
+					character::isDigit(*(ptr+1)))) {
+
+			// numbers (including hex and exponents)
+			// (digits in identifiers are consumed with the
+			// identifier below, so they don't land here)
+			while (ptr<end &&
+				(character::isAlphanumeric(*ptr) ||
+					*ptr=='.' ||
+					((*ptr=='+' || *ptr=='-') &&
+					(*(ptr-1)=='e' || *(ptr-1)=='E')))) {
+				ptr++;
+			}
+			fp->append('?');
+
+		} else if (c=='?' ||
+				((c==':' || c=='$') && ptr+1<end &&
+				fingerprintIsIdentifierCharacter(*(ptr+1)) &&
+				(ptr==query || *(ptr-1)!=':')) ||
+				(c=='@' && ptr+1<end && *(ptr+1)!='@')) {
+
+			// bind variables
+			ptr++;
+			while (ptr<end &&
+				fingerprintIsIdentifierCharacter(*ptr)) {
+				ptr++;
+			}
+			fp->append('?');
+
+		} else if (fingerprintIsIdentifierCharacter(c)) {
+
+			// keywords and identifiers are lower-cased
+			while (ptr<end &&
+				fingerprintIsIdentifierCharacter(*ptr)) {
+				fp->append(character::toLowerCase(*ptr));
+				ptr++;
+			}
+
+		} else {
+
+			// remove whitespace around symbols
+			if (fp->getSize() &&
+				fp->getString()[fp->getSize()-1]==' ') {
+				fp->truncate(fp->getSize()-1);
+			}
+			fp->append(c);
+			ptr++;
+			fingerprintSkipWhitespaceAndComments(&ptr,end);
+
+			if (c==')') {
+				fingerprintCollapseInList(fp);
+			}
+		}
+	}
+
+	// trim trailing whitespace
+	if (fp->getSize() && fp->getString()[fp->getSize()-1]==' ') {
+		fp->truncate(fp->getSize()-1);
+	}
+}
+
+static inline uint64_t fingerprintHash(const char *str, size_t length) {
+
+	// 64-bit FNV-1a
+	uint64_t	h=14695981039346656037ULL;
+	for (size_t i=0; i<length; i++) {
+		h^=(unsigned char)str[i];
+		h*=1099511628211ULL;
+	}
+
+	// 0 marks an unused slot
+	return (h)?h:1;
+}
+
+#endif
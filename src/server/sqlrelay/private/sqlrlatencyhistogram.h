@@ -0,0 +1,133 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#ifndef SQLRLATENCYHISTOGRAM_H
+#define SQLRLATENCYHISTOGRAM_H
+
+#include <sqlrelay/private/sqlrshm.h>
+#include <sqlrelay/private/sqlratomic.h>
+
+// Latency histograms are HDR-style.  Latencies of less than
+// STATLATENCYSUBBUCKETS microseconds each get their own bucket.  Above that,
+// each power of 2 is split into STATLATENCYSUBBUCKETS linear buckets, so a
+// value read back from a histogram is never off by more than 1 part in
+// STATLATENCYSUBBUCKETS.  Latencies of 2^STATLATENCYMAXBITS microseconds
+// (about 71 minutes) or more all land in the last bucket.
+//
+// All of an instance's listeners and connections record into the same
+// histograms at once, so the fields are updated atomically rather than under
+// a semaphore.  Readers don't lock either, and may catch a histogram in the
+// middle of an update, so totals are derived from the buckets themselves.
+
+static inline uint32_t latencyHistogramBucket(uint64_t usec) {
+
+	// small values are exact
+	if (usec<STATLATENCYSUBBUCKETS) {
+		return (uint32_t)usec;
+	}
+
+	// huge values go in the last bucket
+	if (usec>>STATLATENCYMAXBITS) {
+		return STATLATENCYBUCKETS-1;
+	}
+
+	// find the most significant bit
+	uint32_t	msb=STATLATENCYSUBBUCKETBITS;
+	while (usec>>(msb+1)) {
+		msb++;
+	}
+
+	// the power of 2 picks the group of sub-buckets and
+	// the bits below the most significant bit pick the sub-bucket
+	return (msb-STATLATENCYSUBBUCKETBITS+1)*STATLATENCYSUBBUCKETS+
+		(uint32_t)((usec>>(msb-STATLATENCYSUBBUCKETBITS))&
+						(STATLATENCYSUBBUCKETS-1));
+}
+
+static inline uint64_t latencyHistogramBucketValue(uint32_t bucket) {
+
+	// returns the highest value that lands in the bucket
+	if (bucket<STATLATENCYSUBBUCKETS) {
+		return bucket;
+	}
+	uint32_t	shift=bucket/STATLATENCYSUBBUCKETS-1;
+	uint64_t	sub=bucket%STATLATENCYSUBBUCKETS;
+	return ((STATLATENCYSUBBUCKETS+sub+1)<<shift)-1;
+}
+
+static inline void latencyHistogramRecord(sqlrlatencyhistogram *h,
+							uint64_t usec) {
+	atomicAdd64(&(h->buckets[latencyHistogramBucket(usec)]),1);
+	atomicAdd64(&(h->count),1);
+	atomicAdd64(&(h->totalusec),usec);
+	atomicMax64(&(h->maxusec),usec);
+}
+
+static inline uint64_t latencyHistogramCount(const sqlrlatencyhistogram *h) {
+	uint64_t	count=0;
+	for (uint32_t i=0; i<STATLATENCYBUCKETS; i++) {
+		count+=h->buckets[i];
+	}
+	return count;
+}
+
+static inline uint64_t latencyHistogramPercentile(
+					const sqlrlatencyhistogram *h,
+					double percentile) {
+
+	uint64_t	count=latencyHistogramCount(h);
+	if (!count) {
+		return 0;
+	}
+
+	// get the rank of the value we're looking for
+	double		r=percentile*count/100.0;
+	uint64_t	rank=(uint64_t)r;
+	if (rank<r || !rank) {
+		rank++;
+	}
+
+	// find the bucket that it lands in
+	uint64_t	seen=0;
+	for (uint32_t i=0; i<STATLATENCYBUCKETS; i++) {
+		seen+=h->buckets[i];
+		if (seen>=rank) {
+			uint64_t	value=latencyHistogramBucketValue(i);
+			return (h->maxusec && value>h->maxusec)?
+							h->maxusec:value;
+		}
+	}
+	return h->maxusec;
+}
+
+static inline const char *latencyHistogramStageName(uint32_t stage) {
+	static const char	*stagenames[]={
+		"handoff",
+		"filter",
+		"translate",
+		"prepare",
+		"execute",
+		"firstrow",
+		"send",
+		"think"
+	};
+	return (stage<LATENCYSTAGE_COUNT)?stagenames[stage]:"unknown";
+}
+
+static inline const char *latencyHistogramQueryTypeName(uint32_t index) {
+	static const char	*querytypenames[]={
+		"all",
+		"select",
+		"insert",
+		"update",
+		"delete",
+		"create",
+		"drop",
+		"alter",
+		"custom",
+		"etc"
+	};
+	return (index<STATLATENCYQUERYTYPES)?querytypenames[index]:"unknown";
+}
+
+#endif
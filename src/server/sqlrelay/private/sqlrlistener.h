@@ -10,6 +10,7 @@
 		void	setSessionHandlerMethod();
 		void	setHandoffMethod();
 		void	setIpPermissions();
+		void	setAdmissionClasses();
 		bool	createSharedMemoryAndSemaphores(const char *id);
 		void	ipcFileError(const char *idfilename);
 		void	keyError(const char *idfilename);
@@ -36,6 +37,22 @@
 					thread *thr);
 		void    errorClientSession(filedescriptor *clientsock,
 					int64_t errnum, const char *err);
+		domnode	*getClientListener(uint16_t protocolindex);
+		bool	peekClient(filedescriptor *clientsock,
+					unsigned char *buffer, size_t size);
+		bool	cancelQuery(filedescriptor *clientsock,
+					uint16_t protocolindex);
+		uint32_t	classifyClient(filedescriptor *sock,
+						uint16_t protocolindex);
+		uint64_t	getAdmissionTime();
+		bool	admitClient(filedescriptor *sock,
+					uint32_t admissionclass,
+					uint64_t startusec);
+		uint32_t	nextAdmissionClass();
+		void	wakeNextAdmissionClass();
+		void	finishAdmission();
+		void	admissionError(filedescriptor *sock,
+					int64_t errnum, const char *err);
 		bool	semWait(int32_t index, thread *thr,
 					bool withundo, bool *timeout);
 		bool	acquireShmAccess(thread *thr, bool *timeout);
@@ -76,6 +93,8 @@
 		void		incrementMaxListenersErrors();
 		void		incrementConnectedClientCount();
 		void		decrementConnectedClientCount();
+		void		updateQueueWaitStats(uint64_t startsec,
+							uint64_t startusec);
 		uint32_t	incrementForkedListeners();
 		uint32_t	decrementForkedListeners();
 		void		incrementBusyListeners();
@@ -107,6 +107,7 @@
 
 		bool	acquireAnnounceMutex();
 		void	releaseAnnounceMutex();
+		bool	keepIdleConnection();
 
 		void	signalListenerToRead();
 		void	unSignalListenerToRead();
@@ -121,6 +122,12 @@
 		void	initConnStats();
 		void	clearConnStats();
 
+		void	getLatencyStart(uint64_t *sec, uint64_t *usec);
+		void	recordLatency(sqlrlatencystage_t stage,
+					sqlrservercursor *cursor,
+					uint64_t startsec,
+					uint64_t startusec);
+
 		sqlrparser	*newParser();
 
 		void	setClientSessionStartTime();
@@ -131,6 +138,11 @@
 		void	sessionEndQueries();
 		void	sessionQuery(const char *query);
 
+		void		startCancelThread();
+		void		stopCancelThread();
+		static void	cancelThread(void *attr);
+		void		cancelQueries();
+
 		static void     alarmHandler(int32_t signum);
 
 		sqlrservercontrollerprivate	*pvt;
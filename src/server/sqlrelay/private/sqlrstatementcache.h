@@ -0,0 +1,146 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#ifndef SQLRSTATEMENTCACHE_H
+#define SQLRSTATEMENTCACHE_H
+
+#include <rudiments/linkedlist.h>
+#include <rudiments/bytestring.h>
+
+// A least-recently-used cache of idle prepared statements, keyed by query,
+// for connection modules whose db api can keep several statements prepared
+// at once.  A cursor that is about to prepare a different query puts its
+// statement in the cache and takes out a statement that already has the new
+// query prepared, if there is one.  The cache holds at most "size" statements
+// and closes the least recently used ones, with the callback that it was
+// created with, to make room for more.
+//
+// Each time the cache is cleared, its generation is incremented.  Cursors
+// record the generation when they prepare a query and compare it with the
+// current generation before reusing their statement, so statements that
+// cursors are holding on to when the cache is cleared aren't reused or put
+// in the cache either.
+
+template <class stmttype>
+class sqlrstatementcache {
+	public:
+			sqlrstatementcache(void (*closestatement)(stmttype));
+			~sqlrstatementcache();
+
+		void		setSize(uint32_t size);
+		uint32_t	getSize();
+
+		bool		take(const char *query, uint32_t length,
+							stmttype *stmt);
+		void		put(stmttype stmt,
+					char *query, uint32_t length);
+		void		clear();
+
+		uint32_t	getGeneration();
+
+	private:
+		struct entry {
+			char		*query;
+			uint32_t	querylength;
+			stmttype	stmt;
+		};
+
+		void	deleteEntry(linkedlistnode< entry * > *node);
+
+		void		(*closestatement)(stmttype);
+		uint32_t	size;
+		uint32_t	generation;
+
+		// idle prepared statements, most recently used first
+		linkedlist< entry * >	entries;
+};
+
+template <class stmttype>
+inline sqlrstatementcache<stmttype>::sqlrstatementcache(
+				void (*closestatement)(stmttype)) {
+	this->closestatement=closestatement;
+	size=0;
+	generation=0;
+}
+
+template <class stmttype>
+inline sqlrstatementcache<stmttype>::~sqlrstatementcache() {
+	clear();
+}
+
+template <class stmttype>
+inline void sqlrstatementcache<stmttype>::setSize(uint32_t size) {
+	this->size=size;
+}
+
+template <class stmttype>
+inline uint32_t sqlrstatementcache<stmttype>::getSize() {
+	return size;
+}
+
+template <class stmttype>
+inline bool sqlrstatementcache<stmttype>::take(const char *query,
+							uint32_t length,
+							stmttype *stmt) {
+
+	// look for an idle statement that already has this query prepared
+	for (linkedlistnode< entry * > *node=entries.getFirst();
+						node; node=node->getNext()) {
+		entry	*e=node->getValue();
+		if (e->querylength==length &&
+			!bytestring::compare(e->query,query,length)) {
+			*stmt=e->stmt;
+			delete[] e->query;
+			delete e;
+			entries.remove(node);
+			return true;
+		}
+	}
+	return false;
+}
+
+template <class stmttype>
+inline void sqlrstatementcache<stmttype>::put(stmttype stmt,
+						char *query, uint32_t length) {
+
+	// add the statement to the front of the cache,
+	// the cache takes ownership of the query
+	entry	*e=new entry;
+	e->query=query;
+	e->querylength=length;
+	e->stmt=stmt;
+	entries.prepend(e);
+
+	// evict the least recently used statements
+	while (entries.getLength()>size) {
+		deleteEntry(entries.getLast());
+	}
+}
+
+template <class stmttype>
+inline void sqlrstatementcache<stmttype>::clear() {
+	while (entries.getFirst()) {
+		deleteEntry(entries.getFirst());
+	}
+
+	// statements that cursors are holding on
+	// to can't be reused either
+	generation++;
+}
+
+template <class stmttype>
+inline uint32_t sqlrstatementcache<stmttype>::getGeneration() {
+	return generation;
+}
+
+template <class stmttype>
+inline void sqlrstatementcache<stmttype>::deleteEntry(
+				linkedlistnode< entry * > *node) {
+	entry	*e=node->getValue();
+	closestatement(e->stmt);
+	delete[] e->query;
+	delete e;
+	entries.remove(node);
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#ifndef SQLRTRACE_H
+#define SQLRTRACE_H
+
+// The tracer logger writes a sample of query lifecycles to a per-process
+// trace file, which sqlr-trace converts to Chrome trace/Perfetto JSON.
+//
+// The file is mapped into memory and used as a ring.  It begins with a
+// sqlrtraceheader, which is followed by "records" sqlrtracerecords.  Records
+// are written in order, starting over at the beginning of the ring when it
+// fills up.  Each record's sequence number is written last, so a reader can
+// sort the records that it finds, and ignore any that a process was in the
+// middle of writing when it died.  Everything is in the byte order of the host
+// that wrote the file.
+
+#define SQLRTRACE_MAGIC		"SQLRTRC"
+#define SQLRTRACE_VERSION	1
+#define SQLRTRACE_BYTEORDER	0x01020304
+#define SQLRTRACE_FINGERPRINTLEN	56
+
+enum sqlrtracerecordtype_t {
+	SQLRTRACERECORDTYPE_QUERY=1,
+	SQLRTRACERECORDTYPE_FETCH
+};
+
+struct sqlrtraceheader {
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	byteorder;
+	uint32_t	headersize;
+	uint32_t	recordsize;
+	uint64_t	records;
+	uint64_t	sample;
+	uint64_t	pid;
+	uint64_t	next;
+	char		id[64];
+};
+
+// (times are in microseconds since the epoch)
+struct sqlrtracerecord {
+	uint64_t	sequence;
+	uint64_t	commandstart;
+	uint64_t	querystart;
+	uint64_t	queryend;
+	uint64_t	commandend;
+	uint64_t	rows;
+	uint64_t	bytes;
+	uint64_t	fingerprinthash;
+	uint32_t	pid;
+	uint16_t	cursorid;
+	uint8_t		type;
+	uint8_t		error;
+	char		fingerprint[SQLRTRACE_FINGERPRINTLEN];
+};
+
+#endif
@@ -114,6 +114,8 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
 		~sqlrservercontroller();
 
 		bool	init(int argc, const char **argv);
+		bool	initTemplate(int argc, const char **argv);
+		bool	initFromTemplate(const char *connectionid);
 		bool	listen();
 
 
@@ -170,6 +172,12 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
 		// ping
 		bool	ping();
 
+		// query cancellation
+		uint32_t	getCancelKey();
+		uint32_t	getNextQueryId();
+		bool		cancelQuery(uint32_t pid, uint32_t key,
+							uint32_t queryid);
+
 		// database info
 		const char	*identify();
 		const char	*dbVersion();
@@ -356,6 +364,7 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
 		void		deleteCursor(sqlrservercursor *curs);
 
 		// command stats
+		// (times are seconds since the epoch, plus microseconds)
 		void		setCommandStart(sqlrservercursor *cursor,
 						uint64_t sec, uint64_t usec);
 		uint64_t	getCommandStartSec(sqlrservercursor *cursor);
@@ -366,6 +375,7 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
 		uint64_t	getCommandEndUSec(sqlrservercursor *cursor);
 
 		// query stats
+		// (times are seconds since the epoch, plus microseconds)
 		void		setQueryStart(sqlrservercursor *cursor,
 						uint64_t sec, uint64_t usec);
 		uint64_t	getQueryStartSec(sqlrservercursor *cursor);
@@ -377,10 +387,19 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
 
 		// query buffer
 		char		*getQueryBuffer(sqlrservercursor *cursor);
+		char		*allocateQueryBuffer(sqlrservercursor *cursor,
+						uint32_t querylength);
 		uint32_t 	getQueryLength(sqlrservercursor *cursor);
 		void		setQueryLength(sqlrservercursor *cursor,
 						uint32_t querylength);
 
+		// cursor buffers
+		char		*allocateCursorBuffer(uint32_t size,
+						uint32_t *buffersize);
+		void		releaseCursorBuffer(char *buffer,
+						uint32_t buffersize);
+		uint64_t	getCursorBufferMemory();
+
 		// query status
 		sqlrquerystatus_t	getQueryStatus(
 						sqlrservercursor *cursor);
@@ -630,6 +649,7 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
 		bool		fetchRow(sqlrservercursor *cursor, bool *error);
 		void		nextRow(sqlrservercursor *cursor);
 		uint64_t	getTotalRowsFetched(sqlrservercursor *cursor);
+		uint64_t	getTotalBytesFetched(sqlrservercursor *cursor);
 		void		closeResultSet(sqlrservercursor *cursor);
 		void		closeAllResultSets();
 
@@ -736,6 +756,7 @@ class SQLRSERVER_DLLSPEC sqlrservercontroller {
                                                 linkedlist<char *> *cols,
                                                 linkedlist<char *> *binds);
 		bool	bulkLoadExecuteQuery();
+		uint64_t	bulkLoadExecuteArray();
 		void	bulkLoadInitBinds();
 		void	bulkLoadBindRow(const unsigned char *data,
 						uint64_t datalen);
@@ -1148,7 +1169,19 @@ class SQLRSERVER_DLLSPEC sqlrservercursor {
 		virtual	const char	*truncateTableQuery();
 		virtual	bool		executeQuery(const char *query,
 							uint32_t length);
+		virtual bool		cancelQuery();
 		virtual bool	fetchFromBindCursor();
+		virtual uint32_t	getArrayBindSize();
+		virtual bool		arrayBindRow();
+		virtual uint32_t	getArrayBindRowCount();
+		virtual bool		executeArrayQuery(const char *query,
+							uint32_t length);
+		virtual uint32_t	getArrayErrorCount();
+		virtual bool		getArrayError(uint32_t index,
+							uint32_t *row,
+							int64_t *errorcode,
+							const char **error,
+							uint32_t *errorlength);
 		virtual	bool	nextResultSet(bool *nextresultsetavailable);
 		virtual	bool	queryIsNotSelect();
 		virtual	bool	queryIsCommitOrRollback();
@@ -1236,8 +1269,10 @@ class SQLRSERVER_DLLSPEC sqlrservercursor {
 		void	abort();
 
 		char		*getQueryBuffer();
+		char		*allocateQueryBuffer(uint32_t querylength);
 		uint32_t 	getQueryLength();
 		void		setQueryLength(uint32_t querylength);
+		void		releaseBuffers();
 
 		void		setQueryStatus(sqlrquerystatus_t status);
 		sqlrquerystatus_t	getQueryStatus();
@@ -1287,6 +1322,10 @@ class SQLRSERVER_DLLSPEC sqlrservercursor {
 		uint64_t	getTotalRowsFetched();
 		void		incrementTotalRowsFetched();
 
+		void		clearTotalBytesFetched();
+		uint64_t	getTotalBytesFetched();
+		void		addTotalBytesFetched(uint64_t bytes);
+
 		void		setCurrentRowReformatted(bool crr);
 		bool		getCurrentRowReformatted();
 
@@ -1803,9 +1842,12 @@ class SQLRSERVER_DLLSPEC sqlrlogger {
 					sqlrlogger_loglevel_t level,
 					sqlrevent_t event,
 					const char *info);
+		virtual void	endCommand(sqlrservercursor *sqlrcur);
 		virtual void	endTransaction(bool commit);
 		virtual void	endSession();
 
+		virtual bool	wantsDebugMessages();
+
 	protected:
 		sqlrloggers	*getLoggers();
 		domnode	*getParameters();
@@ -1828,9 +1870,12 @@ class SQLRSERVER_DLLSPEC sqlrloggers {
 				sqlrevent_t event,
 				const char *info);
 
+		void	endCommand(sqlrservercursor *sqlrcur);
 		void	endTransaction(bool commit);
 		void	endSession();
 
+		bool	wantDebugMessages();
+
 		const char	*logLevel(sqlrlogger_loglevel_t level);
 		sqlrlogger_loglevel_t	logLevel(const char *level);
 
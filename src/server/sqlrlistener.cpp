@@ -24,6 +24,16 @@
 #include <rudiments/inetsocketserver.h>
 #include <rudiments/listener.h>
 
+// for recv()
+#ifdef _WIN32
+	#include <rudiments/private/winsock.h>
+#else
+	#include <sys/socket.h>
+#endif
+
+#include <sqlrelay/private/sqlrlatencyhistogram.h>
+#include <sqlrelay/private/sqlrcancel.h>
+
 #include <config.h>
 #include <defaults.h>
 #include <defines.h>
@@ -32,6 +42,19 @@
 	#define MAXPATHLEN	256
 #endif
 
+// admission control semaphores
+// (the first 13 are described in createSharedMemoryAndSemaphores())
+#define ADMISSIONMUTEX		13
+#define ADMISSIONWAKEUP		14
+#define SEMAPHORECOUNT		(ADMISSIONWAKEUP+STATADMISSIONCLASSES)
+
+// the stride of a class with a weight of 1
+#define ADMISSIONSTRIDE		1000000
+
+// how long to wait for a client to send something,
+// to see whether it's a request to cancel a query
+#define CANCELPEEKUSEC		250000
+
 class SQLRSERVER_DLLSPEC handoffsocketnode {
 	friend class sqlrlistener;
 	private:
@@ -39,6 +62,15 @@ class SQLRSERVER_DLLSPEC handoffsocketnode {
 		filedescriptor	*sock;
 };
 
+class SQLRSERVER_DLLSPEC admissionclassnode {
+	friend class sqlrlistener;
+	private:
+		regularexpression	*ips;
+		uint16_t		port;
+		const char		*socket;
+		const char		*protocol;
+};
+
 class sqlrlistenerprivate {
 	friend class sqlrlistener;
 	private:
@@ -47,6 +79,12 @@ class sqlrlistenerprivate {
 		uint32_t	_maxconnections;
 		bool		_dynamicscaling;
 
+		bool		_latencyhistograms;
+
+		admissionclassnode	*_admissionclasslist;
+		uint32_t		_admissionclasses;
+		uint32_t		_defaultadmissionclass;
+
 		int64_t		_maxlisteners;
 		uint64_t	_listenertimeout;
 
@@ -122,6 +160,12 @@ sqlrlistener::sqlrlistener() {
 	pvt->_shm=NULL;
 	pvt->_idfilename=NULL;
 
+	pvt->_latencyhistograms=false;
+
+	pvt->_admissionclasslist=NULL;
+	pvt->_admissionclasses=0;
+	pvt->_defaultadmissionclass=0;
+
 	pvt->_pidfile=NULL;
 	pvt->_sqlrpth=NULL;
 
@@ -262,6 +306,12 @@ void sqlrlistener::cleanUp() {
 
 	delete pvt->_denied;
 	delete pvt->_allowed;
+	if (pvt->_admissionclasslist) {
+		for (uint32_t i=0; i<pvt->_admissionclasses; i++) {
+			delete pvt->_admissionclasslist[i].ips;
+		}
+		delete[] pvt->_admissionclasslist;
+	}
 	delete pvt->_sqlrlg;
 	delete pvt->_sqlrn;
 }
@@ -330,6 +380,11 @@ bool sqlrlistener::init(int argc, const char **argv) {
 
 	handleDynamicScaling();
 
+	const char	*latencyhistograms=pvt->_cfg->getLatencyHistograms();
+	pvt->_latencyhistograms=
+			(!charstring::compare(latencyhistograms,"instance") ||
+			!charstring::compare(latencyhistograms,"querytype"));
+
 	domnode	*loggers=pvt->_cfg->getLoggers();
 	if (!loggers->isNullNode()) {
 		pvt->_sqlrlg=new sqlrloggers(pvt->_sqlrpth);
@@ -371,6 +426,8 @@ bool sqlrlistener::init(int argc, const char **argv) {
 		return false;
 	}
 
+	setAdmissionClasses();
+
 	if (!listenOnHandoffSocket(pvt->_cmdl->getId())) {
 		return false;
 	}
@@ -608,6 +665,94 @@ void sqlrlistener::setIpPermissions() {
 	}
 }
 
+void sqlrlistener::setAdmissionClasses() {
+
+	domnode	*admission=pvt->_cfg->getAdmission();
+	if (admission->isNullNode() ||
+		admission->getFirstTagChild("class")->isNullNode()) {
+		return;
+	}
+
+	// Clients that don't match any of the classes that specify which
+	// clients belong to them are put in the first class that doesn't,
+	// or in a class named "default", if there isn't one.
+	pvt->_admissionclasslist=new admissionclassnode[STATADMISSIONCLASSES];
+	bool		founddefault=false;
+	uint32_t	count=0;
+	for (domnode *node=admission->getFirstTagChild("class");
+			!node->isNullNode();
+			node=node->getNextTagSibling("class")) {
+
+		if (count==STATADMISSIONCLASSES) {
+			stderror.printf("Warning: only the first %d "
+					"admission classes will be used\n",
+					STATADMISSIONCLASSES);
+			break;
+		}
+
+		// the class itself goes in shared memory
+		sqlradmissionclass	*ac=&(pvt->_shm->admission[count]);
+		const char	*name=node->getAttributeValue("name");
+		if (!charstring::isNullOrEmpty(name)) {
+			charstring::safeCopy(ac->name,sizeof(ac->name)-1,name);
+		} else {
+			charstring::printf(ac->name,sizeof(ac->name),
+							"class%d",count);
+		}
+		ac->weight=charstring::toUnsignedInteger(
+					node->getAttributeValue("weight"));
+		if (!ac->weight) {
+			ac->weight=1;
+		}
+		ac->maxqueuelength=charstring::toUnsignedInteger(
+				node->getAttributeValue("maxqueuelength"));
+		ac->maxqueuewaitusec=charstring::toUnsignedInteger(
+				node->getAttributeValue("maxqueuewait"))*1000;
+
+		// which clients belong to it stays here
+		admissionclassnode	*acn=&(pvt->_admissionclasslist[count]);
+		const char	*ips=node->getAttributeValue("ips");
+		acn->ips=(!charstring::isNullOrEmpty(ips))?
+					new regularexpression(ips):NULL;
+		acn->port=charstring::toUnsignedInteger(
+					node->getAttributeValue("port"));
+		acn->socket=node->getAttributeValue("socket");
+		acn->protocol=node->getAttributeValue("protocol");
+
+		if (!founddefault && !acn->ips && !acn->port &&
+				charstring::isNullOrEmpty(acn->socket) &&
+				charstring::isNullOrEmpty(acn->protocol)) {
+			pvt->_defaultadmissionclass=count;
+			founddefault=true;
+		}
+		count++;
+	}
+
+	if (!founddefault) {
+		if (count==STATADMISSIONCLASSES) {
+			count--;
+			stderror.printf("Warning: admission class \"%s\" "
+					"replaced with class \"default\"\n",
+					pvt->_shm->admission[count].name);
+			delete pvt->_admissionclasslist[count].ips;
+		}
+		sqlradmissionclass	*ac=&(pvt->_shm->admission[count]);
+		bytestring::zero(ac,sizeof(sqlradmissionclass));
+		charstring::copy(ac->name,"default");
+		ac->weight=1;
+		admissionclassnode	*acn=&(pvt->_admissionclasslist[count]);
+		acn->ips=NULL;
+		acn->port=0;
+		acn->socket=NULL;
+		acn->protocol=NULL;
+		pvt->_defaultadmissionclass=count;
+		count++;
+	}
+
+	pvt->_admissionclasses=count;
+	pvt->_shm->admissionclasses=count;
+}
+
 bool sqlrlistener::createSharedMemoryAndSemaphores(const char *id) {
 
 	// initialize the ipc filename
@@ -639,15 +784,17 @@ bool sqlrlistener::createSharedMemoryAndSemaphores(const char *id) {
 	// FIXME: if it already exists, attempt to remove and re-create it
 	raiseDebugMessageEvent("creating shared memory...");
 
+	// (the segment is sized for the configured maxconnections)
 	pvt->_shmem=new sharedmemory;
-	if (!pvt->_shmem->create(key,sizeof(sqlrshm),
+	if (!pvt->_shmem->create(key,sqlrshmSize(pvt->_maxconnections),
 				permissions::evalPermString("rw-r-----"))) {
 		shmError(id,pvt->_shmem->getId());
 		pvt->_shmem->attach(key,sizeof(sqlrshm));
 		return false;
 	}
 	pvt->_shm=(sqlrshm *)pvt->_shmem->getPointer();
-	bytestring::zero(pvt->_shm,sizeof(sqlrshm));
+	bytestring::zero(pvt->_shm,sqlrshmSize(pvt->_maxconnections));
+	sqlrshmInitLayout(pvt->_shm,pvt->_maxconnections);
 
 	setStartTime();
 
@@ -703,11 +850,21 @@ bool sqlrlistener::createSharedMemoryAndSemaphores(const char *id) {
 	// main listenter process/listener children:
 	// 10 - listener: number of busy listeners
 	//
-	int32_t	vals[13]={1,1,0,0,1,1,0,0,0,1,0,0,0};
+	// admission control (listener children only):
+	// 13 - admission mutex
+	// 14 and up - one per admission class:
+	//       * listeners with clients queued in the class wait
+	//       * listener that is done with its turn signals the class
+	//         that goes next
+	//
+	// (the other processes only attach to the first 13)
+	//
+	int32_t	vals[SEMAPHORECOUNT]={1,1,0,0,1,1,0,0,0,1,0,0,0,1};
 	pvt->_semset=new semaphoreset();
-	if (!pvt->_semset->create(key,permissions::ownerReadWrite(),13,vals)) {
+	if (!pvt->_semset->create(key,permissions::ownerReadWrite(),
+						SEMAPHORECOUNT,vals)) {
 		semError(id,pvt->_semset->getId());
-		pvt->_semset->attach(key,13);
+		pvt->_semset->attach(key,SEMAPHORECOUNT);
 		return false;
 	}
 
@@ -1521,6 +1678,13 @@ void sqlrlistener::clientSession(filedescriptor *clientsock,
 					uint16_t protocolindex,
 					thread *thr) {
 
+	// requests to cancel queries are forwarded
+	// by the listener rather than handed off
+	if (cancelQuery(clientsock,protocolindex)) {
+		delete clientsock;
+		return;
+	}
+
 	if (pvt->_dynamicscaling) {
 		incrementConnectedClientCount();
 	}
@@ -1552,12 +1716,34 @@ bool sqlrlistener::handOffOrProxyClient(filedescriptor *sock,
 	uint16_t		unixportstrlen;
 	bool			retval=false;
 
+	// put the client in an admission class
+	uint32_t	admissionclass=0;
+	uint64_t	admissionstart=0;
+	if (pvt->_admissionclasses) {
+		admissionclass=classifyClient(sock,protocolindex);
+		admissionstart=getAdmissionTime();
+	}
+
 	// loop in case client doesn't get handed off successfully
 	for (;;) {
 
-		if (!getAConnection(&connectionpid,&inetport,
-					unixportstr,&unixportstrlen,
-					sock,thr)) {
+		// wait for the client's turn to get a connection
+		if (pvt->_admissionclasses &&
+			!admitClient(sock,admissionclass,admissionstart)) {
+			retval=false;
+			break;
+		}
+
+		bool	gotconnection=getAConnection(&connectionpid,&inetport,
+						unixportstr,&unixportstrlen,
+						sock,thr);
+
+		// let the next client have a turn
+		if (pvt->_admissionclasses) {
+			finishAdmission();
+		}
+
+		if (!gotconnection) {
 			// fatal error occurred while getting a connection
 			retval=false;
 			break;
@@ -1620,6 +1806,445 @@ bool sqlrlistener::handOffOrProxyClient(filedescriptor *sock,
 	return retval;
 }
 
+domnode *sqlrlistener::getClientListener(uint16_t protocolindex) {
+	domnode	*ln=pvt->_cfg->getListeners()->getFirstTagChild("listener");
+	for (uint16_t i=0; i<protocolindex && !ln->isNullNode(); i++) {
+		ln=ln->getNextTagSibling("listener");
+	}
+	return ln;
+}
+
+bool sqlrlistener::peekClient(filedescriptor *clientsock,
+					unsigned char *buffer, size_t size) {
+
+	// wait briefly for the client to send something, then look at it
+	// without reading it, so it's still there for the connection if the
+	// client gets handed off
+	if (clientsock->waitForNonBlockingRead(0,CANCELPEEKUSEC)<1) {
+		return false;
+	}
+	return (recv(clientsock->getFileDescriptor(),
+			(char *)buffer,size,MSG_PEEK)==(ssize_t)size);
+}
+
+bool sqlrlistener::cancelQuery(filedescriptor *clientsock,
+						uint16_t protocolindex) {
+
+	// The connection that's running a query is busy, and so might every
+	// other connection be, so rather than handing a request to cancel the
+	// query off like any other client, the listener reads the pid, key
+	// and query id, and forwards them to the connection itself.
+	//
+	// Only sqlrclient and postgresql clients send cancel requests, and
+	// they both send something as soon as they connect, so it's safe to
+	// wait a moment to see what they send.
+	const char	*protocol=getClientListener(protocolindex)->
+						getAttributeValue("protocol");
+	if (charstring::isNullOrEmpty(protocol)) {
+		protocol=DEFAULT_PROTOCOL;
+	}
+	bool	sqlrclient=!charstring::compare(protocol,"sqlrclient");
+	bool	postgresql=!charstring::compare(protocol,"postgresql");
+	if (!sqlrclient && !postgresql) {
+		return false;
+	}
+
+	// look for a cancel request, in network byte order
+	//
+	// sqlrclient:
+	//	uint16_t	CANCEL_QUERY
+	//	uint32_t	pid
+	//	uint32_t	key
+	//	uint32_t	query id
+	//
+	// postgresql:
+	//	uint32_t	length (16)
+	//	uint32_t	protocol version (80877102)
+	//	uint32_t	pid
+	//	uint32_t	key
+	unsigned char	peek[8];
+	if (sqlrclient) {
+		if (!peekClient(clientsock,peek,sizeof(uint16_t)) ||
+			((peek[0]<<8)|peek[1])!=CANCEL_QUERY) {
+			return false;
+		}
+	} else {
+		if (!peekClient(clientsock,peek,sizeof(peek)) ||
+			((uint32_t)peek[0]<<24|(uint32_t)peek[1]<<16|
+				(uint32_t)peek[2]<<8|(uint32_t)peek[3])!=16 ||
+			((uint32_t)peek[4]<<24|(uint32_t)peek[5]<<16|
+				(uint32_t)peek[6]<<8|(uint32_t)peek[7])!=
+								80877102) {
+			return false;
+		}
+	}
+
+	raiseDebugMessageEvent("cancel request...");
+
+	// read the request
+	uint16_t	command;
+	uint32_t	header[2];
+	uint32_t	pid;
+	uint32_t	key;
+	uint32_t	queryid=0;
+	ssize_t		result=(sqlrclient)?
+				clientsock->read(&command,5,0):
+				clientsock->read(header,sizeof(header),5,0);
+	if (result>0) {
+		result=clientsock->read(&pid,5,0);
+	}
+	if (result>0) {
+		result=clientsock->read(&key,5,0);
+	}
+	if (result>0 && sqlrclient) {
+		result=clientsock->read(&queryid,5,0);
+	}
+	if (result<=0) {
+		raiseClientProtocolErrorEvent("cancel request failed",result);
+		return true;
+	}
+
+	// forward it to the connection that's running the query
+	bool	cancelled=sqlrForwardCancel(pvt->_shm,
+					pvt->_sqlrpth->getSocketsDir(),
+					pid,key,queryid);
+
+	raiseDebugMessageEvent((cancelled)?"cancel query succeeded":
+						"cancel query failed");
+
+	// postgresql clients don't get a response
+	if (postgresql) {
+		return true;
+	}
+	if (cancelled) {
+		clientsock->write((uint16_t)NO_ERROR_OCCURRED);
+	} else {
+		clientsock->write((uint16_t)ERROR_OCCURRED);
+		clientsock->write((uint64_t)SQLR_ERROR_CANCELFAILED);
+		clientsock->write((uint16_t)charstring::length(
+					SQLR_ERROR_CANCELFAILED_STRING));
+		clientsock->write(SQLR_ERROR_CANCELFAILED_STRING);
+	}
+	return true;
+}
+
+uint32_t sqlrlistener::classifyClient(filedescriptor *sock,
+						uint16_t protocolindex) {
+
+	// get the listener that the client connected to
+	domnode		*ln=getClientListener(protocolindex);
+	const char	*protocol=ln->getAttributeValue("protocol");
+	if (charstring::isNullOrEmpty(protocol)) {
+		protocol=DEFAULT_PROTOCOL;
+	}
+
+	// get the client's address (unix socket clients don't have one)
+	char	*ip=sock->getPeerAddress();
+
+	// put the client in the first class that it matches everything about
+	uint32_t	admissionclass=pvt->_defaultadmissionclass;
+	for (uint32_t i=0; i<pvt->_admissionclasses; i++) {
+		admissionclassnode	*acn=&(pvt->_admissionclasslist[i]);
+		if (i==pvt->_defaultadmissionclass ||
+			(acn->ips && (!ip || !acn->ips->match(ip))) ||
+			(acn->port && acn->port!=
+				charstring::toUnsignedInteger(
+					ln->getAttributeValue("port"))) ||
+			(!charstring::isNullOrEmpty(acn->socket) &&
+				charstring::compare(acn->socket,
+					ln->getAttributeValue("socket"))) ||
+			(!charstring::isNullOrEmpty(acn->protocol) &&
+				charstring::compare(acn->protocol,protocol))) {
+			continue;
+		}
+		admissionclass=i;
+		break;
+	}
+	delete[] ip;
+
+	if (pvt->_sqlrlg || pvt->_sqlrn) {
+		stringbuffer	debugstr;
+		debugstr.append("admission class: ");
+		debugstr.append(pvt->_shm->admission[admissionclass].name);
+		raiseDebugMessageEvent(debugstr.getString());
+	}
+
+	return admissionclass;
+}
+
+uint64_t sqlrlistener::getAdmissionTime() {
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	return ((uint64_t)dt.getEpoch())*1000000+dt.getMicroseconds();
+}
+
+bool sqlrlistener::admitClient(filedescriptor *sock,
+					uint32_t admissionclass,
+					uint64_t startusec) {
+
+	// Only one listener at a time takes a turn at getting a connection.
+	// If it's nobody's turn and nobody is waiting, then the client is
+	// admitted immediately.  Otherwise, the client is queued in its class
+	// and the listener waits for the class to be signalled.  When a
+	// listener finishes its turn, it signals the class with the lowest
+	// pass, and one of the listeners waiting in that class takes the next
+	// turn.  Over time, each class gets a share of the turns that is
+	// proportional to its weight.
+
+	sqlrshm			*shm=pvt->_shm;
+	sqlradmissionclass	*ac=&(shm->admission[admissionclass]);
+	uint64_t		stride=ADMISSIONSTRIDE/ac->weight;
+	pid_t			pid=process::getProcessId();
+	bool			queued=false;
+
+	raiseDebugMessageEvent("waiting for admission");
+
+	for (;;) {
+
+		if (!pvt->_semset->waitWithUndo(ADMISSIONMUTEX)) {
+			// FIXME: bail somehow
+		}
+
+		uint64_t	now=getAdmissionTime();
+
+		// if the listener whose turn it is died, then take it back
+		if (shm->admissionturn &&
+			(pid_t)shm->admissionturn!=pid &&
+			!process::sendSignal(shm->admissionturn,0)) {
+			raiseDebugMessageEvent("reclaiming admission turn "
+						"from dead listener");
+			shm->admissionturn=0;
+		}
+
+		if (!queued) {
+
+			// admit the client immediately if
+			// nobody else is waiting
+			uint32_t	waiting=0;
+			uint32_t	waitingweight=ac->weight;
+			for (uint32_t i=0; i<shm->admissionclasses; i++) {
+				waiting+=shm->admission[i].queued;
+				if (i!=admissionclass &&
+					shm->admission[i].queued) {
+					waitingweight+=
+						shm->admission[i].weight;
+				}
+			}
+			if (!shm->admissionturn && !waiting) {
+				if (ac->pass<shm->admissionpass) {
+					ac->pass=shm->admissionpass;
+				}
+				// the queues are empty, so the rate that
+				// clients were admitted the last time that
+				// they backed up says nothing about the next
+				// time, start measuring it over
+				shm->admissionintervalusec=0;
+				break;
+			}
+
+			// Reject the client right away if its class is full,
+			// or if, at the rate that clients have recently been
+			// admitted, it won't be admitted in time.  The
+			// clients ahead of it in its class get turns in
+			// proportion to its weight, relative to the total
+			// weight of the classes that are waiting.  Until a
+			// queued client has been admitted, there's no rate to
+			// go by, and the client is queued rather than rejected
+			// on a guess.
+			uint64_t	ahead=ac->queued+
+						((shm->admissionturn)?1:0);
+			uint64_t	predictedusec=
+					ahead*shm->admissionintervalusec*
+						waitingweight/ac->weight;
+			if ((ac->maxqueuelength &&
+				ac->queued>=ac->maxqueuelength) ||
+				(ac->maxqueuewaitusec &&
+				shm->admissionintervalusec &&
+				predictedusec>ac->maxqueuewaitusec)) {
+				ac->rejected++;
+				if (!pvt->_semset->signalWithUndo(
+							ADMISSIONMUTEX)) {
+					// FIXME: bail somehow
+				}
+				stringbuffer	info;
+				info.append("admission rejected: class ");
+				info.append(ac->name);
+				raiseClientConnectionRefusedEvent(
+							info.getString());
+				admissionError(sock,
+					SQLR_ERROR_ADMISSIONREJECTED,
+					SQLR_ERROR_ADMISSIONREJECTED_STRING);
+				return false;
+			}
+
+			// queue the client
+			// (a class that had nobody waiting
+			// starts over at the current pass)
+			if (!ac->queued && ac->pass<shm->admissionpass) {
+				ac->pass=shm->admissionpass;
+			}
+			ac->queued++;
+			if (ac->queued>ac->peakqueued) {
+				ac->peakqueued=ac->queued;
+			}
+			queued=true;
+
+		} else {
+
+			// admit the client if it's nobody's turn
+			// and the client's class goes next
+			if (!shm->admissionturn &&
+				nextAdmissionClass()==admissionclass) {
+				ac->queued--;
+
+				// Keep track of how often clients are
+				// admitted while others are waiting.  If the
+				// previous admission was before this client
+				// was queued, then only count the time since
+				// it was queued, so time that nobody was
+				// waiting doesn't inflate the average.
+				uint64_t	since=
+					(shm->admissionlastusec>startusec)?
+					shm->admissionlastusec:startusec;
+				uint64_t	interval=
+					(now>since)?now-since:0;
+				if (!interval) {
+					// (keep a 0 average meaning
+					// "no sample yet")
+					interval=1;
+				}
+				shm->admissionintervalusec=
+					(shm->admissionintervalusec)?
+					(shm->admissionintervalusec*7+
+							interval)/8:
+					interval;
+				break;
+			}
+
+			// give up if the client has waited too long
+			if (ac->maxqueuewaitusec &&
+				now-startusec>=ac->maxqueuewaitusec) {
+				ac->queued--;
+				ac->timedout++;
+				if (!pvt->_semset->signalWithUndo(
+							ADMISSIONMUTEX)) {
+					// FIXME: bail somehow
+				}
+				// (if the client's class was going
+				// next, then another class is now)
+				wakeNextAdmissionClass();
+				raiseDebugMessageEvent("admission timed out");
+				admissionError(sock,
+					SQLR_ERROR_ADMISSIONTIMEOUT,
+					SQLR_ERROR_ADMISSIONTIMEOUT_STRING);
+				return false;
+			}
+		}
+
+		if (!pvt->_semset->signalWithUndo(ADMISSIONMUTEX)) {
+			// FIXME: bail somehow
+		}
+
+		// Wait for the class to be signalled, but not for more than
+		// a second at a time, so the turn can be reclaimed if the
+		// listener that has it dies, and not beyond maxqueuewait.
+		uint64_t	waitusec=1000000;
+		if (ac->maxqueuewaitusec) {
+			uint64_t	elapsed=now-startusec;
+			uint64_t	remaining=
+				(elapsed<ac->maxqueuewaitusec)?
+					ac->maxqueuewaitusec-elapsed:0;
+			if (remaining<waitusec) {
+				waitusec=remaining;
+			}
+		}
+		if (pvt->_semset->supportsTimedSemaphoreOperations()) {
+			pvt->_semset->wait(ADMISSIONWAKEUP+admissionclass,
+						waitusec/1000000,
+						(waitusec%1000000)*1000);
+		} else {
+			// poll if timed semaphore operations aren't supported
+			snooze::microsnooze(0,(waitusec<10000)?waitusec:10000);
+		}
+	}
+
+	// take the turn
+	shm->admissionturn=pid;
+	shm->admissionpass=ac->pass;
+	ac->pass+=stride;
+	uint64_t	now=getAdmissionTime();
+	uint64_t	waitusec=(now>startusec)?now-startusec:0;
+	shm->admissionlastusec=now;
+	ac->admitted++;
+	ac->queuewaitusec+=waitusec;
+	if (waitusec>ac->maxqueuewaitusecseen) {
+		ac->maxqueuewaitusecseen=waitusec;
+	}
+
+	if (!pvt->_semset->signalWithUndo(ADMISSIONMUTEX)) {
+		// FIXME: bail somehow
+	}
+
+	raiseDebugMessageEvent("admitted");
+	return true;
+}
+
+uint32_t sqlrlistener::nextAdmissionClass() {
+
+	// the class with clients waiting, with the lowest pass, goes next
+	// (this must be called while holding the admission mutex)
+	uint32_t	next=STATADMISSIONCLASSES;
+	for (uint32_t i=0; i<pvt->_shm->admissionclasses; i++) {
+		sqlradmissionclass	*ac=&(pvt->_shm->admission[i]);
+		if (ac->queued && (next==STATADMISSIONCLASSES ||
+				ac->pass<pvt->_shm->admission[next].pass)) {
+			next=i;
+		}
+	}
+	return next;
+}
+
+void sqlrlistener::wakeNextAdmissionClass() {
+
+	if (!pvt->_semset->waitWithUndo(ADMISSIONMUTEX)) {
+		// FIXME: bail somehow
+	}
+	uint32_t	next=(!pvt->_shm->admissionturn)?
+				nextAdmissionClass():STATADMISSIONCLASSES;
+	if (!pvt->_semset->signalWithUndo(ADMISSIONMUTEX)) {
+		// FIXME: bail somehow
+	}
+
+	if (next!=STATADMISSIONCLASSES) {
+		pvt->_semset->signal(ADMISSIONWAKEUP+next);
+	}
+}
+
+void sqlrlistener::finishAdmission() {
+
+	raiseDebugMessageEvent("finishing admission turn");
+
+	if (!pvt->_semset->waitWithUndo(ADMISSIONMUTEX)) {
+		// FIXME: bail somehow
+	}
+	pvt->_shm->admissionturn=0;
+	if (!pvt->_semset->signalWithUndo(ADMISSIONMUTEX)) {
+		// FIXME: bail somehow
+	}
+
+	wakeNextAdmissionClass();
+}
+
+void sqlrlistener::admissionError(filedescriptor *sock,
+						int64_t errnum,
+						const char *err) {
+	sock->write((uint16_t)ERROR_OCCURRED_DISCONNECT);
+	sock->write((uint64_t)errnum);
+	sock->write((uint16_t)charstring::length(err));
+	sock->write(err);
+	sock->flushWriteBuffer(-1,-1);
+}
+
 bool sqlrlistener::semWait(int32_t index, thread *thr,
 					bool withundo, bool *timeout) {
 
@@ -1784,6 +2409,16 @@ bool sqlrlistener::getAConnection(uint32_t *connectionpid,
 					filedescriptor *sock,
 					thread *thr) {
 
+	// get the time before waiting, for the scaler and latency histograms
+	uint64_t	startsec=0;
+	uint64_t	startusec=0;
+	if (pvt->_dynamicscaling || pvt->_latencyhistograms) {
+		datetime	dt;
+		dt.getSystemDateAndTime();
+		startsec=dt.getEpoch();
+		startusec=dt.getMicroseconds();
+	}
+
 	for (;;) {
 
 		raiseDebugMessageEvent("getting a connection...");
@@ -1836,6 +2471,11 @@ bool sqlrlistener::getAConnection(uint32_t *connectionpid,
 					raiseDebugMessageEvent(
 						debugstr.getString());
 				}
+				if (pvt->_dynamicscaling ||
+					pvt->_latencyhistograms) {
+					updateQueueWaitStats(startsec,
+								startusec);
+				}
 				return true;
 			}
 
@@ -2313,6 +2953,40 @@ void sqlrlistener::decrementConnectedClientCount() {
 	raiseDebugMessageEvent("finished decrementing connected client count");
 }
 
+void sqlrlistener::updateQueueWaitStats(uint64_t startsec,
+						uint64_t startusec) {
+
+	// get the time spent waiting for a connection
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	uint64_t	start=startsec*1000000+startusec;
+	uint64_t	end=((uint64_t)dt.getEpoch())*1000000+
+					dt.getMicroseconds();
+	uint64_t	waitusec=(end>start)?end-start:0;
+
+	// the histogram is updated atomically, without a semaphore
+	if (pvt->_latencyhistograms) {
+		latencyHistogramRecord(
+			&(pvt->_shm->latency[0][LATENCYSTAGE_HANDOFF]),
+			waitusec);
+	}
+
+	if (!pvt->_dynamicscaling) {
+		return;
+	}
+
+	if (!pvt->_semset->waitWithUndo(5)) {
+		// FIXME: bail somehow
+	}
+
+	pvt->_shm->queuewaits++;
+	pvt->_shm->queuewaitusec+=waitusec;
+
+	if (!pvt->_semset->signalWithUndo(5)) {
+		// FIXME: bail somehow
+	}
+}
+
 uint32_t sqlrlistener::incrementForkedListeners() {
 
 	pvt->_semset->waitWithUndo(9);
@@ -2371,7 +3045,7 @@ int32_t sqlrlistener::getBusyListeners() {
 }
 
 void sqlrlistener::raiseDebugMessageEvent(const char *info) {
-	if (pvt->_sqlrlg) {
+	if (pvt->_sqlrlg && pvt->_sqlrlg->wantDebugMessages()) {
 		pvt->_sqlrlg->run(this,NULL,NULL,
 				SQLRLOGGER_LOGLEVEL_DEBUG,
 				SQLREVENT_DEBUG_MESSAGE,
@@ -41,8 +41,15 @@ domnode *sqlrlogger::getParameters() {
 	return pvt->_parameters;
 }
 
+void sqlrlogger::endCommand(sqlrservercursor *sqlrcur) {
+}
+
 void sqlrlogger::endTransaction(bool commit) {
 }
 
 void sqlrlogger::endSession() {
 }
+
+bool sqlrlogger::wantsDebugMessages() {
+	return true;
+}
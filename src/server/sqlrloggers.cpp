@@ -28,12 +28,15 @@ class sqlrloggersprivate {
 		const char	*_libexecdir;
 
 		singlylinkedlist< sqlrloggerplugin * >	_llist;
+
+		bool		_debugmessages;
 };
 
 sqlrloggers::sqlrloggers(sqlrpaths *sqlrpth) {
 	debugFunction();
 	pvt=new sqlrloggersprivate;
 	pvt->_libexecdir=sqlrpth->getLibExecDir();
+	pvt->_debugmessages=false;
 }
 
 sqlrloggers::~sqlrloggers() {
@@ -70,6 +73,7 @@ void sqlrloggers::unload() {
 		delete sqlrlp;
 	}
 	pvt->_llist.clear();
+	pvt->_debugmessages=false;
 }
 
 void sqlrloggers::loadLogger(domnode *logger) {
@@ -138,6 +142,12 @@ void sqlrloggers::loadLogger(domnode *logger) {
 	}
 #endif
 
+	// debug messages are only worth generating
+	// if at least one logger wants them
+	if (lg && lg->wantsDebugMessages()) {
+		pvt->_debugmessages=true;
+	}
+
 	// add the plugin to the list
 	sqlrloggerplugin	*sqlrlp=new sqlrloggerplugin;
 	sqlrlp->lg=lg;
@@ -170,6 +180,14 @@ void sqlrloggers::run(sqlrlistener *sqlrl,
 	}
 }
 
+void sqlrloggers::endCommand(sqlrservercursor *sqlrcur) {
+	for (singlylinkedlistnode< sqlrloggerplugin * > *node=
+						pvt->_llist.getFirst();
+						node; node=node->getNext()) {
+		node->getValue()->lg->endCommand(sqlrcur);
+	}
+}
+
 void sqlrloggers::endTransaction(bool commit) {
 	for (singlylinkedlistnode< sqlrloggerplugin * > *node=
 						pvt->_llist.getFirst();
@@ -186,6 +204,10 @@ void sqlrloggers::endSession() {
 	}
 }
 
+bool sqlrloggers::wantDebugMessages() {
+	return pvt->_debugmessages;
+}
+
 static const char *loglevels[]={"DEBUG","INFO","WARNING","ERROR"};
 
 const char *sqlrloggers::logLevel(sqlrlogger_loglevel_t level) {
@@ -24,8 +24,13 @@
 #include <rudiments/unixsocketserver.h>
 #include <rudiments/unixsocketclient.h>
 #include <rudiments/inetsocketserver.h>
+#include <rudiments/threadmutex.h>
 #include <rudiments/listener.h>
 #include <rudiments/md5.h>
+#include <rudiments/linkedlist.h>
+
+#include <sqlrelay/private/sqlrlatencyhistogram.h>
+#include <sqlrelay/private/sqlrcancel.h>
 
 #include <defines.h>
 #include <defaults.h>
@@ -60,6 +65,16 @@
 	}
 #endif
 
+// Cursor buffers are handed out in power-of-2 sizes, starting here.  Buffers
+// that cursors give back are kept around for reuse, up to a limit.
+#define MIN_CURSOR_BUFFER_SIZE		256
+#define MAX_IDLE_CURSOR_BUFFERS		16
+
+struct sqlrcursorbuffer {
+	char		*buffer;
+	uint32_t	size;
+};
+
 class sqlrservercontrollerprivate {
 	friend class sqlrservercontroller;
 
@@ -77,6 +92,11 @@ class sqlrservercontrollerprivate {
 	// statistics
 	sqlrshm			*_shm;
 	sqlrconnstatistics	*_connstats;
+	sqlrconntext		*_conntext;
+	bool			_latencyhistograms;
+	bool			_querytypelatencyhistograms;
+	uint64_t		_lastcommandendsec;
+	uint64_t		_lastcommandendusec;
 
 	sqlrcmdline	*_cmdl;
 
@@ -151,6 +171,18 @@ class sqlrservercontrollerprivate {
 	uint64_t		_serversockincount;
 	unixsocketserver	*_serversockun;
 
+	char			*_cancelsockname;
+	unixsocketserver	*_cancelsock;
+	thread			_cancelthread;
+	volatile bool		_cancelstop;
+	threadmutex		_cancelmutex;
+	randomnumber		_cancelrand;
+	uint32_t		_cancelkey;
+	uint32_t		_lastqueryid;
+	uint32_t		_nextqueryid;
+	uint32_t		_executingqueryid;
+	sqlrservercursor	*_executingcursor;
+
 	memorypool	_txpool;
 	memorypool	_sessionpool;
 
@@ -193,6 +225,7 @@ class sqlrservercontrollerprivate {
 	bool		_scalerspawned;
 	const char	*_connectionid;
 	int32_t		_ttl;
+	bool		_ttlreached;
 
 	char		*_pidfile;
 
@@ -224,6 +257,9 @@ class sqlrservercontrollerprivate {
 	char		*_reformattedfield;
 	uint32_t	_reformattedfieldlength;
 
+	linkedlist< sqlrcursorbuffer * >	_idlecursorbuffers;
+	uint64_t				_cursorbuffermemory;
+
 	singlylinkedlist< char * >	_globaltemptables;
 	bool				_allglobaltemptables;
 	singlylinkedlist< char * >	_sessiontemptablesfordrop;
@@ -315,6 +351,13 @@ sqlrservercontroller::sqlrservercontroller() {
 	pvt->_cfg=NULL;
 	pvt->_pth=NULL;
 	pvt->_connstats=NULL;
+	pvt->_conntext=NULL;
+	pvt->_latencyhistograms=false;
+	pvt->_querytypelatencyhistograms=false;
+	pvt->_lastcommandendsec=0;
+	pvt->_lastcommandendusec=0;
+
+	pvt->_cursorbuffermemory=0;
 
 	pvt->_cmdl=NULL;
 	pvt->_semset=NULL;
@@ -337,6 +380,15 @@ sqlrservercontroller::sqlrservercontroller() {
 	pvt->_serversockin=NULL;
 	pvt->_serversockincount=0;
 
+	pvt->_cancelsockname=NULL;
+	pvt->_cancelsock=NULL;
+	pvt->_cancelstop=false;
+	pvt->_cancelkey=0;
+	pvt->_lastqueryid=0;
+	pvt->_nextqueryid=0;
+	pvt->_executingqueryid=0;
+	pvt->_executingcursor=NULL;
+
 	pvt->_inetport=0;
 
 	pvt->_needscommitorrollback=false;
@@ -420,6 +472,7 @@ sqlrservercontroller::sqlrservercontroller() {
 
 	pvt->_pidfile=NULL;
 
+	pvt->_ttlreached=false;
 	pvt->_decrementonclose=false;
 	pvt->_silent=false;
 
@@ -465,6 +518,7 @@ sqlrservercontroller::~sqlrservercontroller() {
 	shutDown();
 
 	if (pvt->_connstats) {
+		bytestring::zero(pvt->_conntext,sizeof(sqlrconntext));
 		bytestring::zero(pvt->_connstats,sizeof(sqlrconnstatistics));
 	}
 
@@ -485,6 +539,11 @@ sqlrservercontroller::~sqlrservercontroller() {
 		file::remove(pvt->_unixsocket.getString());
 	}
 
+	if (pvt->_cancelsockname) {
+		file::remove(pvt->_cancelsockname);
+		delete[] pvt->_cancelsockname;
+	}
+
 	delete pvt->_sqlrpr;
 	delete pvt->_sqlrp;
 	delete pvt->_sqlrd;
@@ -529,6 +588,13 @@ sqlrservercontroller::~sqlrservercontroller() {
 	delete pvt->_bulkclientshmem;
 	delete pvt->_bulkcursor;
 
+	for (linkedlistnode< sqlrcursorbuffer * >
+			*node=pvt->_idlecursorbuffers.getFirst();
+						node; node=node->getNext()) {
+		delete[] node->getValue()->buffer;
+		delete node->getValue();
+	}
+
 	delete pvt->_db;
 	delete pvt->_schema;
 	delete pvt->_object;
@@ -537,6 +603,14 @@ sqlrservercontroller::~sqlrservercontroller() {
 }
 
 bool sqlrservercontroller::init(int argc, const char **argv) {
+	return initTemplate(argc,argv) && initFromTemplate(NULL);
+}
+
+bool sqlrservercontroller::initTemplate(int argc, const char **argv) {
+
+	// Everything done here is independent of the connection id and of the
+	// process id, so it can be done once by a template process (eg. the
+	// sqlr-scaler) and then inherited by connections forked from it.
 
 	// process command line
 	pvt->_cmdl=new sqlrcmdline(argc,argv);
@@ -552,13 +626,6 @@ bool sqlrservercontroller::init(int argc, const char **argv) {
 	// get whether this connection was spawned by the scaler
 	pvt->_scalerspawned=pvt->_cmdl->found("-scaler");
 
-	// get the connection id from the command line
-	pvt->_connectionid=pvt->_cmdl->getValue("-connectionid");
-	if (charstring::isNullOrEmpty(pvt->_connectionid)) {
-		pvt->_connectionid=DEFAULT_CONNECTIONID;
-		stderror.printf("Warning: using default connectionid.\n");
-	}
-
 	// get the time to live from the command line
 	const char	*ttlstr=pvt->_cmdl->getValue("-ttl");
 	pvt->_ttl=(!charstring::isNullOrEmpty(ttlstr))?
@@ -585,6 +652,11 @@ bool sqlrservercontroller::init(int argc, const char **argv) {
 	pvt->_idleclienttimeout=pvt->_cfg->getIdleClientTimeout();
 	pvt->_debugsql=pvt->_cfg->getDebugSql();
 	pvt->_debugbulkload=pvt->_cfg->getDebugBulkLoad();
+	const char	*latencyhistograms=pvt->_cfg->getLatencyHistograms();
+	pvt->_querytypelatencyhistograms=
+			!charstring::compare(latencyhistograms,"querytype");
+	pvt->_latencyhistograms=(pvt->_querytypelatencyhistograms ||
+			!charstring::compare(latencyhistograms,"instance"));
 
 	// get password encryptions
 	domnode	*pwdencs=pvt->_cfg->getPasswordEncryptions();
@@ -612,7 +684,6 @@ bool sqlrservercontroller::init(int argc, const char **argv) {
 	if (!loggers->isNullNode()) {
 		pvt->_sqlrlg=new sqlrloggers(pvt->_pth);
 		pvt->_sqlrlg->load(loggers);
-		pvt->_sqlrlg->init(NULL,pvt->_conn);
 	}
 
 	// get notifications
@@ -629,61 +700,6 @@ bool sqlrservercontroller::init(int argc, const char **argv) {
 		pvt->_sqlrs->load(schedules);
 	}
 
-	// handle the pid file
-	if (!handlePidFile()) {
-		return false;
-	}
-
-	// handle the connect string
-	pvt->_constr=pvt->_cfg->getConnectString(pvt->_connectionid);
-	if (!pvt->_constr) {
-		stderror.printf("Error: invalid connectionid \"%s\".\n",
-							pvt->_connectionid);
-		return false;
-	}
-	pvt->_conn->handleConnectString();
-
-	initDatabaseAvailableFileName();
-
-	// set unix socket filename (for suspended/resumed sessions)
-	pvt->_unixsocket.append(pvt->_pth->getSocketsDir())->
-				append((uint32_t)process::getProcessId())->
-				append(".sock");
-
-	if (!createSharedMemoryAndSemaphores(pvt->_cmdl->getId())) {
-		return false;
-	}
-
-	// if there's no way to interrupt a semaphore wait,
-	// then force the ttl to zero
-	if (pvt->_ttl>0 &&
-			!pvt->_semset->supportsTimedSemaphoreOperations() &&
-			!sys::signalsInterruptSystemCalls()) {
-		pvt->_ttl=0;
-	}
-
-	// log in and detach
-	if (pvt->_conn->mustDetachBeforeLogIn() &&
-			!pvt->_cmdl->found("-nodetach")) {
-		process::detach();
-	}
-	bool	reloginatstart=pvt->_cfg->getReLoginAtStart();
-	if (!reloginatstart) {
-		if (!attemptLogIn(!pvt->_silent)) {
-			return false;
-		}
-	}
-	if (!pvt->_conn->mustDetachBeforeLogIn() &&
-			!pvt->_cmdl->found("-nodetach")) {
-		process::detach();
-	}
-	if (reloginatstart) {
-		while (!attemptLogIn(false)) {
-			snooze::macrosnooze(5);
-		}
-	}
-	initConnStats();
-
 	// get the module datas
 	pvt->_debugsqlrmoduledata=pvt->_cfg->getDebugModuleDatas();
 	domnode	*moduledatas=pvt->_cfg->getModuleDatas();
@@ -781,6 +797,79 @@ bool sqlrservercontroller::init(int argc, const char **argv) {
 		pvt->_sqlrtr->load(triggers);
 	}
 
+	return true;
+}
+
+bool sqlrservercontroller::initFromTemplate(const char *connectionid) {
+
+	// get the connection id, from the command line if it wasn't passed in
+	pvt->_connectionid=(connectionid)?connectionid:
+				pvt->_cmdl->getValue("-connectionid");
+	if (charstring::isNullOrEmpty(pvt->_connectionid)) {
+		pvt->_connectionid=DEFAULT_CONNECTIONID;
+		stderror.printf("Warning: using default connectionid.\n");
+	}
+
+	// init loggers
+	if (pvt->_sqlrlg) {
+		pvt->_sqlrlg->init(NULL,pvt->_conn);
+	}
+
+	// handle the pid file
+	if (!handlePidFile()) {
+		return false;
+	}
+
+	// handle the connect string
+	pvt->_constr=pvt->_cfg->getConnectString(pvt->_connectionid);
+	if (!pvt->_constr) {
+		stderror.printf("Error: invalid connectionid \"%s\".\n",
+							pvt->_connectionid);
+		return false;
+	}
+	pvt->_conn->handleConnectString();
+
+	initDatabaseAvailableFileName();
+
+	// set unix socket filename (for suspended/resumed sessions)
+	pvt->_unixsocket.append(pvt->_pth->getSocketsDir())->
+				append((uint32_t)process::getProcessId())->
+				append(".sock");
+
+	if (!createSharedMemoryAndSemaphores(pvt->_cmdl->getId())) {
+		return false;
+	}
+
+	// if there's no way to interrupt a semaphore wait,
+	// then force the ttl to zero
+	if (pvt->_ttl>0 &&
+			!pvt->_semset->supportsTimedSemaphoreOperations() &&
+			!sys::signalsInterruptSystemCalls()) {
+		pvt->_ttl=0;
+	}
+
+	// log in and detach
+	if (pvt->_conn->mustDetachBeforeLogIn() &&
+			!pvt->_cmdl->found("-nodetach")) {
+		process::detach();
+	}
+	bool	reloginatstart=pvt->_cfg->getReLoginAtStart();
+	if (!reloginatstart) {
+		if (!attemptLogIn(!pvt->_silent)) {
+			return false;
+		}
+	}
+	if (!pvt->_conn->mustDetachBeforeLogIn() &&
+			!pvt->_cmdl->found("-nodetach")) {
+		process::detach();
+	}
+	if (reloginatstart) {
+		while (!attemptLogIn(false)) {
+			snooze::macrosnooze(5);
+		}
+	}
+	initConnStats();
+
 	// get fake input bind variable behavior
 	// (this may have already been set true by the connect string)
 	pvt->_fakeinputbinds=(pvt->_fakeinputbinds ||
@@ -855,6 +944,17 @@ bool sqlrservercontroller::init(int argc, const char **argv) {
 	}
 	#endif
 
+	// seed the cancel key generator
+	// (mixing in the pid, so connections that were forked
+	// at the same time don't generate the same keys)
+	pvt->_cancelrand.setSeed(randomnumber::getSeed()^
+					(uint32_t)process::getProcessId());
+
+	// listen for requests to cancel queries, if necessary
+	if (pvt->_cfg->getQueryCancellation()) {
+		startCancelThread();
+	}
+
 	return true;
 }
 
@@ -1018,7 +1118,7 @@ bool sqlrservercontroller::attemptLogIn(bool printerrors) {
 	// get stats
 	datetime	dt;
 	dt.getSystemDateAndTime();
-	pvt->_loggedinsec=dt.getSeconds();
+	pvt->_loggedinsec=dt.getEpoch();
 	pvt->_loggedinusec=dt.getMicroseconds();
 
 	raiseDebugMessageEvent("done logging in");
@@ -1588,6 +1688,14 @@ void sqlrservercontroller::initSession() {
 	}
 	pvt->_accepttimeout=5;
 
+	// generate a new cancel key for each session, so a client can't
+	// cancel the queries of clients that use the connection after it
+	pvt->_cancelmutex.lock();
+	pvt->_cancelrand.generateNumber(&pvt->_cancelkey);
+	pvt->_lastqueryid=0;
+	pvt->_nextqueryid=0;
+	pvt->_cancelmutex.unlock();
+
 	raiseDebugMessageEvent("done initializing session...");
 }
 
@@ -1615,11 +1723,16 @@ bool sqlrservercontroller::announceAvailability(const char *connectionid) {
 	// This will fall through if the ttl was reached while waiting.
 	// In that case, since we failed to acquire the announce mutex,
 	// we don't need to release it.  We also don't need to reset the
-	// ttl because we're going to exit.
-	if (!acquireAnnounceMutex()) {
-		raiseDebugMessageEvent("ttl reached, "
+	// ttl because we're going to exit, unless the scaler wants this
+	// connection kept around, in which case we'll just wait again.
+	while (!acquireAnnounceMutex()) {
+		if (!keepIdleConnection()) {
+			raiseDebugMessageEvent("ttl reached, "
 					"aborting announcing availabilty");
-		return false;
+			return false;
+		}
+		raiseDebugMessageEvent("ttl reached, but the scaler "
+					"wants idle connections kept");
 	}
 
 	setState(ANNOUNCE_AVAILABILITY);
@@ -2462,6 +2575,175 @@ bool sqlrservercontroller::ping() {
 	return pvt->_conn->ping();
 }
 
+void sqlrservercontroller::startCancelThread() {
+
+	raiseDebugMessageEvent("starting cancel thread...");
+
+	if (!thread::supported()) {
+		raiseDebugMessageEvent("threads not supported, "
+					"queries can't be cancelled");
+		return;
+	}
+
+	// The cancel thread listens on a unix socket named after this
+	// process' pid.  The listener (or whichever connection receives a
+	// request to cancel the query that this one is running) connects to
+	// the socket and passes along the cancel key and query id.
+	pvt->_cancelsockname=sqlrCancelSocketName(
+					pvt->_pth->getSocketsDir(),
+					(uint32_t)process::getProcessId());
+
+	// remove any socket left over by a
+	// previous process with the same pid
+	file::remove(pvt->_cancelsockname);
+
+	// only processes running as the same user may connect to the socket
+	pvt->_cancelsock=new unixsocketserver();
+	if (!pvt->_cancelsock->listen(pvt->_cancelsockname,0077,16)) {
+		pvt->_debugstr.clear();
+		pvt->_debugstr.append("failed to listen on cancel socket: ");
+		pvt->_debugstr.append(pvt->_cancelsockname);
+		raiseInternalErrorEvent(NULL,pvt->_debugstr.getString());
+		delete pvt->_cancelsock;
+		pvt->_cancelsock=NULL;
+		delete[] pvt->_cancelsockname;
+		pvt->_cancelsockname=NULL;
+		return;
+	}
+
+	pvt->_cancelstop=false;
+	if (!pvt->_cancelthread.spawn((void *(*)(void *))cancelThread,
+							(void *)this,false)) {
+		raiseInternalErrorEvent(NULL,"failed to spawn cancel thread");
+		delete pvt->_cancelsock;
+		pvt->_cancelsock=NULL;
+		file::remove(pvt->_cancelsockname);
+		delete[] pvt->_cancelsockname;
+		pvt->_cancelsockname=NULL;
+		return;
+	}
+
+	raiseDebugMessageEvent("done starting cancel thread");
+}
+
+void sqlrservercontroller::stopCancelThread() {
+
+	if (!pvt->_cancelsock) {
+		return;
+	}
+
+	raiseDebugMessageEvent("stopping cancel thread...");
+
+	// The cancel thread is probably waiting for a connection, so tell it
+	// to stop, then wake it up by connecting to its socket.  It mustn't
+	// outlive the cursors, or the socket that it's listening on.
+	pvt->_cancelstop=true;
+	unixsocketclient	cancelsockun;
+	cancelsockun.connect(pvt->_cancelsockname,5,0,0,1);
+	cancelsockun.close();
+	int32_t	status;
+	pvt->_cancelthread.wait(&status);
+
+	pvt->_cancelsock->close();
+	delete pvt->_cancelsock;
+	pvt->_cancelsock=NULL;
+
+	raiseDebugMessageEvent("done stopping cancel thread");
+}
+
+void sqlrservercontroller::cancelThread(void *attr) {
+	((sqlrservercontroller *)attr)->cancelQueries();
+}
+
+void sqlrservercontroller::cancelQueries() {
+
+	// This runs in its own thread, alongside the thread that's running
+	// the query, so it doesn't raise any events, and only touches the
+	// cancel key and the executing cursor.  The native cancel functions
+	// that the cursors call are all safe to call from another thread.
+	for (;;) {
+
+		filedescriptor	*fd=pvt->_cancelsock->accept();
+		if (pvt->_cancelstop) {
+			if (fd) {
+				fd->close();
+				delete fd;
+			}
+			return;
+		}
+		if (!fd) {
+			snooze::macrosnooze(1);
+			continue;
+		}
+
+		// get the key and query id, and cancel the query if
+		// the key matches and the query is still running
+		//
+		// The cursor is cancelled with the mutex held, so the query
+		// can't finish, and the next one start, in the meantime.
+		// Some cancel functions (mysql's in particular) log in to the
+		// database, which can take a while, so a query that finishes
+		// on its own while it's being cancelled may have to wait for
+		// the cancel to finish too.
+		bool		cancelled=false;
+		uint32_t	key;
+		uint32_t	queryid;
+		if (fd->read(&key,5,0)==sizeof(uint32_t) &&
+			fd->read(&queryid,5,0)==sizeof(uint32_t)) {
+			pvt->_cancelmutex.lock();
+			if (key==pvt->_cancelkey && pvt->_executingcursor &&
+				(!queryid || queryid==pvt->_executingqueryid)) {
+				cancelled=pvt->_executingcursor->cancelQuery();
+			}
+			pvt->_cancelmutex.unlock();
+		}
+
+		// return the result
+		fd->write((uint16_t)((cancelled)?1:0));
+		fd->close();
+		delete fd;
+	}
+}
+
+uint32_t sqlrservercontroller::getCancelKey() {
+	return pvt->_cancelkey;
+}
+
+uint32_t sqlrservercontroller::getNextQueryId() {
+
+	// The next query that this session runs gets this id, so a request to
+	// cancel it that shows up after it's finished doesn't cancel whatever
+	// query the session runs after it.
+	pvt->_cancelmutex.lock();
+	pvt->_lastqueryid++;
+	if (!pvt->_lastqueryid) {
+		pvt->_lastqueryid++;
+	}
+	pvt->_nextqueryid=pvt->_lastqueryid;
+	uint32_t	queryid=pvt->_nextqueryid;
+	pvt->_cancelmutex.unlock();
+	return queryid;
+}
+
+bool sqlrservercontroller::cancelQuery(uint32_t pid, uint32_t key,
+							uint32_t queryid) {
+
+	pvt->_debugstr.clear();
+	pvt->_debugstr.append("cancel query: ")->append(pid);
+	raiseDebugMessageEvent(pvt->_debugstr.getString());
+
+	// Cancel requests are usually forwarded by the listener, but if one
+	// was handed off to this connection instead, then forward it to the
+	// connection that's running the query.
+	bool	result=sqlrForwardCancel(pvt->_shm,
+					pvt->_pth->getSocketsDir(),
+					pid,key,queryid);
+
+	raiseDebugMessageEvent((result)?"cancel query succeeded":
+					"cancel query failed");
+	return result;
+}
+
 bool sqlrservercontroller::getListsByApiCalls() {
 	return pvt->_conn->getListsByApiCalls();
 }
@@ -2476,6 +2758,7 @@ bool sqlrservercontroller::fakePrepareAndExecuteForApiCall(
 		return false;
 	}
 	cursor->clearTotalRowsFetched();
+	cursor->clearTotalBytesFetched();
 	return true;
 }
 
@@ -3536,11 +3819,18 @@ bool sqlrservercontroller::translateQuery(sqlrservercursor *cursor) {
 	// clear the query tree
 	cursor->clearQueryTree();
 
+	// for timings...
+	uint64_t	startsec;
+	uint64_t	startusec;
+	getLatencyStart(&startsec,&startusec);
+
 	// apply translation rules
 	stringbuffer	*translatedquery=cursor->getTranslatedQueryBuffer();
 	translatedquery->clear();
-	if (!pvt->_sqlrt->run(pvt->_conn,cursor,pvt->_sqlrp,
-					query,querylen,translatedquery)) {
+	bool	success=pvt->_sqlrt->run(pvt->_conn,cursor,pvt->_sqlrp,
+					query,querylen,translatedquery);
+	recordLatency(LATENCYSTAGE_TRANSLATE,cursor,startsec,startusec);
+	if (!success) {
 		raiseTranslationFailureEvent(cursor,query);
 		if (pvt->_sqlrt->getUseOriginalOnError()) {
 			if (pvt->_debugsqlrtranslations) {
@@ -3583,11 +3873,13 @@ bool sqlrservercontroller::translateQuery(sqlrservercursor *cursor) {
 
 	// write the translated query to the cursor's query buffer
 	// so it'll be there if we decide to re-execute it later
-	bytestring::copy(cursor->getQueryBuffer(),
+	char	*querybuffer=cursor->allocateQueryBuffer(
+					translatedquery->getSize());
+	bytestring::copy(querybuffer,
 			translatedquery->getString(),
 			translatedquery->getSize());
 	cursor->setQueryLength(translatedquery->getSize());
-	cursor->getQueryBuffer()[cursor->getQueryLength()]='\0';
+	querybuffer[cursor->getQueryLength()]='\0';
 	return true;
 }
 
@@ -3777,6 +4069,7 @@ void sqlrservercontroller::translateBindVariables(sqlrservercursor *cursor) {
 	if (newqlen>pvt->_maxquerysize) {
 		newqlen=pvt->_maxquerysize;
 	}
+	querybuffer=cursor->allocateQueryBuffer(newqlen);
 	bytestring::copy(querybuffer,newq,newqlen);
 	querybuffer[newqlen]='\0';
 	cursor->setQueryLength(newqlen);
@@ -4047,17 +4340,16 @@ void sqlrservercontroller::translateBindVariablesFromMappings(
 
 void sqlrservercontroller::translateBeginTransaction(sqlrservercursor *cursor) {
 
-	// get query buffer
-	char	*querybuffer=cursor->getQueryBuffer();
-
 	// debug
 	raiseDebugMessageEvent("translating begin tx query...");
 	raiseDebugMessageEvent("original:");
-	raiseDebugMessageEvent(querybuffer);
+	raiseDebugMessageEvent(cursor->getQueryBuffer());
 
 	// translate query
+	// (making sure the query buffer is big enough first)
 	const char	*beginquery=pvt->_conn->beginTransactionQuery();
 	uint32_t	querylength=charstring::length(beginquery);
+	char		*querybuffer=cursor->allocateQueryBuffer(querylength);
 	charstring::copy(querybuffer,beginquery,querylength);
 	querybuffer[querylength]='\0';
 	cursor->setQueryLength(querylength);
@@ -4079,6 +4371,11 @@ bool sqlrservercontroller::filterQuery(sqlrservercursor *cursor, bool before) {
 		stdoutput.printf("filtering:\n\"%s\"\n\n",query);
 	}
 
+	// for timings...
+	uint64_t	startsec;
+	uint64_t	startusec;
+	getLatencyStart(&startsec,&startusec);
+
 	// apply filters
 	const char	*err=NULL;
 	int64_t		errn=0;
@@ -4093,6 +4390,7 @@ bool sqlrservercontroller::filterQuery(sqlrservercursor *cursor, bool before) {
 								pvt->_sqlrp,
 								query,
 								&err,&errn);
+	recordLatency(LATENCYSTAGE_FILTER,cursor,startsec,startusec);
 	if (!success) {
 		setError(cursor,err,errn,true);
 		raiseFilterViolationEvent(cursor);
@@ -4139,11 +4437,13 @@ sqlrservercursor *sqlrservercontroller::useCustomQueryCursor(
 
 	// copy the query that we just got into
 	// the custom query cursor's buffers
+	char	*customquerybuffer=
+		customcursor->allocateQueryBuffer(cursor->getQueryLength());
 	bytestring::copy(
-		customcursor->getQueryBuffer(),
+		customquerybuffer,
 		cursor->getQueryBuffer(),
 		cursor->getQueryLength());
-	customcursor->getQueryBuffer()[cursor->getQueryLength()]='\0';
+	customquerybuffer[cursor->getQueryLength()]='\0';
 	customcursor->setQueryLength(cursor->getQueryLength());
 
 	// set the custom cursor' state
@@ -4501,8 +4801,9 @@ bool sqlrservercontroller::prepareQuery(sqlrservercursor *cursor,
 
 	// copy query to cursor's query buffer if necessary
 	if (query!=cursor->getQueryBuffer()) {
-		bytestring::copy(cursor->getQueryBuffer(),query,querylen);
-		cursor->getQueryBuffer()[querylen]='\0';
+		char	*querybuffer=cursor->allocateQueryBuffer(querylen);
+		bytestring::copy(querybuffer,query,querylen);
+		querybuffer[querylen]='\0';
 		cursor->setQueryLength(querylen);
 	}
 
@@ -4609,10 +4910,13 @@ bool sqlrservercontroller::prepareQuery(sqlrservercursor *cursor,
 	// set the query start time (in case the prepare fails)
 	datetime	dt;
 	dt.getSystemDateAndTime();
-	cursor->setQueryStart(dt.getSeconds(),dt.getMicroseconds());
+	cursor->setQueryStart(dt.getEpoch(),dt.getMicroseconds());
 
 	// prepare the query
 	bool	success=cursor->prepareQuery(query,querylen);
+	recordLatency(LATENCYSTAGE_PREPARE,cursor,
+				cursor->getQueryStartSec(),
+				cursor->getQueryStartUSec());
 
 	// log result
 	raiseDebugMessageEvent((success)?"prepare query succeeded":
@@ -4623,7 +4927,7 @@ bool sqlrservercontroller::prepareQuery(sqlrservercursor *cursor,
 
 		// set the query end time
 		dt.getSystemDateAndTime();
-		cursor->setQueryEnd(dt.getSeconds(),
+		cursor->setQueryEnd(dt.getEpoch(),
 					dt.getMicroseconds());
 
 		// update query and error counts
@@ -4788,7 +5092,7 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 	// in case the prepare failed)
 	datetime	dt;
 	dt.getSystemDateAndTime();
-	cursor->setQueryStart(dt.getSeconds(),dt.getMicroseconds());
+	cursor->setQueryStart(dt.getEpoch(),dt.getMicroseconds());
 
 	// init result
 	bool	success=false;
@@ -4801,7 +5105,7 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 
 			// set the query end time
 			dt.getSystemDateAndTime();
-			cursor->setQueryEnd(dt.getSeconds(),
+			cursor->setQueryEnd(dt.getEpoch(),
 						dt.getMicroseconds());
 
 			if (success) {
@@ -4833,10 +5137,13 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 
 		// set the query start time (in case the prepare fails)
 		dt.getSystemDateAndTime();
-		cursor->setQueryStart(dt.getSeconds(),dt.getMicroseconds());
+		cursor->setQueryStart(dt.getEpoch(),dt.getMicroseconds());
 
 		// prepare the query
 		success=cursor->prepareQuery(query,querylen);
+		recordLatency(LATENCYSTAGE_PREPARE,cursor,
+					cursor->getQueryStartSec(),
+					cursor->getQueryStartUSec());
 
 		// log result
 		raiseDebugMessageEvent((success)?"prepare query succeeded":
@@ -4847,7 +5154,7 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 
 			// set the query end time
 			dt.getSystemDateAndTime();
-			cursor->setQueryEnd(dt.getSeconds(),
+			cursor->setQueryEnd(dt.getEpoch(),
 						dt.getMicroseconds());
 
 			// update query and error counts
@@ -4885,13 +5192,13 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 
 		// set the query start time (in case handleBinds fails)
 		dt.getSystemDateAndTime();
-		cursor->setQueryStart(dt.getSeconds(),dt.getMicroseconds());
+		cursor->setQueryStart(dt.getEpoch(),dt.getMicroseconds());
 
 		if (!handleBinds(cursor)) {
 
 			// set the query end time
 			dt.getSystemDateAndTime();
-			cursor->setQueryEnd(dt.getSeconds(),
+			cursor->setQueryEnd(dt.getEpoch(),
 						dt.getMicroseconds());
 
 			// update query and error counts
@@ -4923,7 +5230,7 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 
 	// (re)set the query start time
 	dt.getSystemDateAndTime();
-	cursor->setQueryStart(dt.getSeconds(),dt.getMicroseconds());
+	cursor->setQueryStart(dt.getEpoch(),dt.getMicroseconds());
 
 	if (pvt->_debugsql) {
 		stdoutput.printf("\n===================="
@@ -4938,7 +5245,25 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 	}
 
 	// execute the query
+	// (keeping track of which cursor is running it, and which query
+	// it is, in case the cancel thread needs to cancel it)
+	if (pvt->_cancelsock) {
+		pvt->_cancelmutex.lock();
+		pvt->_executingcursor=cursor;
+		pvt->_executingqueryid=pvt->_nextqueryid;
+		pvt->_nextqueryid=0;
+		pvt->_cancelmutex.unlock();
+	}
 	success=cursor->executeQuery(query,querylen);
+	if (pvt->_cancelsock) {
+		pvt->_cancelmutex.lock();
+		pvt->_executingcursor=NULL;
+		pvt->_executingqueryid=0;
+		pvt->_cancelmutex.unlock();
+	}
+	recordLatency(LATENCYSTAGE_EXECUTE,cursor,
+				cursor->getQueryStartSec(),
+				cursor->getQueryStartUSec());
 
 	// set flag indicating that the query has been executed
 	if (success) {
@@ -4947,7 +5272,7 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 
 	// set the query end time
 	dt.getSystemDateAndTime();
-	cursor->setQueryEnd(dt.getSeconds(),dt.getMicroseconds());
+	cursor->setQueryEnd(dt.getEpoch(),dt.getMicroseconds());
 
 	// special case intercepts...
 	// rather than actually intercepting these, we
@@ -4983,8 +5308,9 @@ bool sqlrservercontroller::executeQuery(sqlrservercursor *cursor,
 		raiseDebugMessageEvent(pvt->_debugstr.getString());
 	}
 
-	// reset total rows fetched
+	// reset total rows and bytes fetched
 	cursor->clearTotalRowsFetched();
+	cursor->clearTotalBytesFetched();
 
 	// update query and error counts
 	incrementQueryCounts(cursor->queryType(query,querylen));
@@ -6090,10 +6416,20 @@ void sqlrservercontroller::endSession() {
 
 	setState(SESSION_END);
 
+	// the next command will be from a different client
+	pvt->_lastcommandendsec=0;
+	pvt->_lastcommandendusec=0;
+
 	raiseDebugMessageEvent("aborting all cursors...");
 	for (int32_t i=0; i<pvt->_cursorcount; i++) {
 		if (pvt->_cur[i]) {
+			// let module datas see the last result set
+			// before the cursor's buffers are released
+			if (pvt->_sqlrmd) {
+				pvt->_sqlrmd->closeResultSet(pvt->_cur[i]);
+			}
 			pvt->_cur[i]->abort();
+			pvt->_cur[i]->releaseBuffers();
 		}
 	}
 	raiseDebugMessageEvent("done aborting all cursors");
@@ -6513,6 +6849,9 @@ void sqlrservercontroller::shutDown() {
 		deRegisterForHandoff();
 	}
 
+	// stop the cancel thread before the cursors that it cancels go away
+	stopCancelThread();
+
 	// close the cursors
 	closeCursors(true);
 
@@ -6611,6 +6950,36 @@ bool sqlrservercontroller::createSharedMemoryAndSemaphores(const char *id) {
 		return false;
 	}
 
+	// the segment is sized for the instance's maxconnections,
+	// so re-attach to the whole thing, as described by its layout
+	if (!sqlrshmLayoutIsValid(pvt->_shm)) {
+		stderror.printf("Shared memory segment was created by "
+				"an incompatible version of %s\n",SQL_RELAY);
+		delete pvt->_shmem;
+		pvt->_shmem=NULL;
+		pvt->_shm=NULL;
+		delete[] idfilename;
+		return false;
+	}
+	if (pvt->_shm->size>sizeof(sqlrshm)) {
+		uint64_t	size=pvt->_shm->size;
+		delete pvt->_shmem;
+		pvt->_shmem=new sharedmemory();
+		if (!pvt->_shmem->attach(file::generateKey(idfilename,1),
+								size)) {
+			char	*err=error::getErrorString();
+			stderror.printf("Couldn't attach to shared memory "
+					"segment: %s\n",err);
+			delete[] err;
+			delete pvt->_shmem;
+			pvt->_shmem=NULL;
+			pvt->_shm=NULL;
+			delete[] idfilename;
+			return false;
+		}
+		pvt->_shm=(sqlrshm *)pvt->_shmem->getPointer();
+	}
+
 	// connect to the semaphore set
 	raiseDebugMessageEvent("attaching to semaphores...");
 	pvt->_semset=new semaphoreset();
@@ -6698,6 +7067,8 @@ bool sqlrservercontroller::acquireAnnounceMutex() {
 	} else {
 		result=pvt->_semset->waitWithUndo(0);
 	}
+	pvt->_ttlreached=(!result &&
+			(error::getErrorNumber()==EAGAIN || alarmrang));
 	if (result) {
 		raiseDebugMessageEvent("done acquiring announce mutex");
 	} else {
@@ -6707,6 +7078,32 @@ bool sqlrservercontroller::acquireAnnounceMutex() {
 	return result;
 }
 
+bool sqlrservercontroller::keepIdleConnection() {
+
+	// only scaler-spawned connections are subject to
+	// the scaling policy, and only when their ttl was reached
+	if (!pvt->_scalerspawned || !pvt->_ttlreached) {
+		return false;
+	}
+
+	// The scaling policy may want to keep more connections around than
+	// are currently needed if it expects them to be needed again soon.
+	// The floor is the number of connections that it wants to keep.
+	// Connections that have already decided to exit, but haven't been
+	// reaped by the scaler yet, are still counted in totalconnections,
+	// so they're tracked separately to keep them all from exiting at once.
+	acquireConnectionCountMutex();
+	uint32_t	total=pvt->_shm->totalconnections;
+	uint32_t	retiring=pvt->_shm->scalerstats.retiring;
+	bool	keep=(((total>retiring)?total-retiring:0)<=
+				pvt->_shm->scalerstats.floor);
+	if (!keep) {
+		pvt->_shm->scalerstats.retiring++;
+	}
+	releaseConnectionCountMutex();
+	return keep;
+}
+
 void sqlrservercontroller::releaseAnnounceMutex() {
 	raiseDebugMessageEvent("releasing announce mutex");
 	pvt->_semset->signalWithUndo(0);
@@ -6792,12 +7189,14 @@ void sqlrservercontroller::initConnStats() {
 
 	// Find an available location in the connstats array.
 	// It shouldn't be possible for sqlr-start or sqlr-scaler to start
-	// more than MAXCONNECTIONS, so unless someone started one manually,
+	// more than maxconnections, so unless someone started one manually,
 	// it should always be possible to find an open one.
-	for (uint32_t i=0; i<MAXCONNECTIONS; i++) {
-		pvt->_connstats=&(pvt->_shm->connstats[i]);
+	for (uint32_t i=0; i<pvt->_shm->maxconnections; i++) {
+		pvt->_connstats=sqlrshmConnStats(pvt->_shm,i);
 		if (!pvt->_connstats->processid) {
 
+			pvt->_conntext=sqlrshmConnText(pvt->_shm,i);
+
 			pvt->_semset->signalWithUndo(9);
 
 			// initialize the connection stats
@@ -6807,6 +7206,8 @@ void sqlrservercontroller::initConnStats() {
 			pvt->_connstats->processid=process::getProcessId();
 			pvt->_connstats->loggedinsec=pvt->_loggedinsec;
 			pvt->_connstats->loggedinusec=pvt->_loggedinusec;
+			pvt->_connstats->cursorbuffermemory=
+						pvt->_cursorbuffermemory;
 			return;
 		}
 	}
@@ -6814,8 +7215,9 @@ void sqlrservercontroller::initConnStats() {
 	pvt->_semset->signalWithUndo(9);
 
 	// in case someone started a connection manually and
-	// exceeded MAXCONNECTIONS, set this NULL here
+	// exceeded maxconnections, set these NULL here
 	pvt->_connstats=NULL;
+	pvt->_conntext=NULL;
 }
 
 void sqlrservercontroller::clearConnStats() {
@@ -6823,6 +7225,7 @@ void sqlrservercontroller::clearConnStats() {
 		return;
 	}
 	bytestring::zero(pvt->_connstats,sizeof(struct sqlrconnstatistics));
+	bytestring::zero(pvt->_conntext,sizeof(struct sqlrconntext));
 }
 
 sqlrparser *sqlrservercontroller::newParser() {
@@ -7364,6 +7767,12 @@ bool sqlrservercontroller::bulkLoadExecuteQuery() {
 
 		bulkLoadInitBinds();
 
+		// If the cursor supports array binds, then buffer rows and
+		// execute them in groups, otherwise execute each row
+		// individually.
+		uint32_t	arraybindsize=
+				pvt->_bulkcursor->getArrayBindSize();
+
 		// run through the bulk data, binding and executing each row
 		uint64_t		errorcount=0;
 		singlylinkedlistnode<const unsigned char *>
@@ -7375,9 +7784,29 @@ bool sqlrservercontroller::bulkLoadExecuteQuery() {
 			bulkLoadBindRow(datanode->getValue(),
 					datalennode->getValue());
 
-			if (!executeQuery(pvt->_bulkcursor)) {
-				bulkLoadError();
-				errorcount++;
+			if (arraybindsize>1 &&
+				pvt->_bulkcursor->arrayBindRow()) {
+
+				// execute the array once it's full
+				if (pvt->_bulkcursor->getArrayBindRowCount()==
+								arraybindsize) {
+					errorcount+=bulkLoadExecuteArray();
+				}
+
+			} else {
+
+				// If the row couldn't be added to the array,
+				// then execute whatever was already buffered
+				// and fall back to executing rows individually.
+				if (arraybindsize>1) {
+					errorcount+=bulkLoadExecuteArray();
+					arraybindsize=0;
+				}
+
+				if (!executeQuery(pvt->_bulkcursor)) {
+					bulkLoadError();
+					errorcount++;
+				}
 			}
 
 
@@ -7393,6 +7822,17 @@ bool sqlrservercontroller::bulkLoadExecuteQuery() {
 			datanode=datanode->getNext();
 			datalennode=datalennode->getNext();
 		}
+
+		// execute any rows remaining in the array
+		if (success && arraybindsize>1) {
+			errorcount+=bulkLoadExecuteArray();
+			if (errorcount>pvt->_bulkmaxerrorcount) {
+				setError(
+			SQLR_ERROR_BULKLOADEXECUTE_TOO_MANY_ERRORS_STRING,
+			SQLR_ERROR_BULKLOADEXECUTE_TOO_MANY_ERRORS,true);
+				success=false;
+			}
+		}
 	}
 
 	// close the bulk cursor and clean up
@@ -7406,6 +7846,56 @@ bool sqlrservercontroller::bulkLoadExecuteQuery() {
 	return success;
 }
 
+uint64_t sqlrservercontroller::bulkLoadExecuteArray() {
+
+	uint32_t	rowcount=pvt->_bulkcursor->getArrayBindRowCount();
+	if (!rowcount) {
+		return 0;
+	}
+
+	if (pvt->_debugbulkload) {
+		stdoutput.printf("%d: bulk load execute array - %d rows\n",
+						process::getProcessId(),
+						rowcount);
+	}
+
+	// if the entire array failed, then count each row as an error
+	if (!pvt->_bulkcursor->executeArrayQuery(pvt->_bulkquery,
+						pvt->_bulkquerylen)) {
+		bulkLoadError();
+		return rowcount;
+	}
+
+	// otherwise store the errors for the individual rows that failed
+	uint32_t	errorcount=pvt->_bulkcursor->getArrayErrorCount();
+	for (uint32_t i=0; i<errorcount; i++) {
+
+		uint32_t	row;
+		int64_t		errnum;
+		const char	*error;
+		uint32_t	errorlength;
+		if (!pvt->_bulkcursor->getArrayError(i,&row,&errnum,
+							&error,&errorlength)) {
+			continue;
+		}
+
+		if (pvt->_debugbulkload) {
+			stdoutput.printf("%d: bulk load error (row %d)\n"
+						"%lld\n%.*s\n",
+						process::getProcessId(),
+						row,(long long)errnum,
+						errorlength,error);
+		}
+
+		if (!bulkLoadStoreError(errnum,error,errorlength,
+					pvt->_bulkerrorfieldtable,
+					pvt->_bulkerrorrowtable)) {
+			// FIXME: error...
+		}
+	}
+	return errorcount;
+}
+
 void sqlrservercontroller::bulkLoadInitBinds() {
 
 	// get the table, column names, and binds from the query...
@@ -7445,6 +7935,9 @@ void sqlrservercontroller::bulkLoadInitBinds() {
 					query.getStringLength()) &&
 					executeQuery(cur)) {
 
+			// size the input binds
+			setInputBindCount(pvt->_bulkcursor,binds.getLength());
+
 			memorypool		*bindpool=
 						getBindPool(pvt->_bulkcursor);
 			sqlrserverbindvar	*inbinds=
@@ -8029,7 +8522,7 @@ void sqlrservercontroller::setState(enum sqlrconnectionstate_t state) {
 	pvt->_connstats->state=state;
 	datetime	dt;
 	dt.getSystemDateAndTime();
-	pvt->_connstats->statestartsec=dt.getSeconds();
+	pvt->_connstats->statestartsec=dt.getEpoch();
 	pvt->_connstats->statestartusec=dt.getMicroseconds();
 }
 
@@ -8046,7 +8539,7 @@ void sqlrservercontroller::setClientSessionStartTime() {
 	}
 	datetime	dt;
 	dt.getSystemDateAndTime();
-	pvt->_connstats->clientsessionsec=dt.getSeconds();
+	pvt->_connstats->clientsessionsec=dt.getEpoch();
 	pvt->_connstats->clientsessionusec=dt.getMicroseconds();
 }
 
@@ -8059,8 +8552,8 @@ void sqlrservercontroller::setCurrentUser(const char *user,
 	if (len>USERSIZE-1) {
 		len=USERSIZE-1;
 	}
-	charstring::copy(pvt->_connstats->user,user,len);
-	pvt->_connstats->user[len]='\0';
+	charstring::copy(pvt->_conntext->user,user,len);
+	pvt->_conntext->user[len]='\0';
 }
 
 void sqlrservercontroller::setCurrentQuery(const char *query,
@@ -8072,8 +8565,8 @@ void sqlrservercontroller::setCurrentQuery(const char *query,
 	if (len>STATSQLTEXTLEN-1) {
 		len=STATSQLTEXTLEN-1;
 	}
-	charstring::copy(pvt->_connstats->sqltext,query,len);
-	pvt->_connstats->sqltext[len]='\0';
+	charstring::copy(pvt->_conntext->sqltext,query,len);
+	pvt->_conntext->sqltext[len]='\0';
 }
 
 void sqlrservercontroller::setClientInfo(const char *info,
@@ -8085,8 +8578,8 @@ void sqlrservercontroller::setClientInfo(const char *info,
 	if (len>STATCLIENTINFOLEN-1) {
 		len=STATCLIENTINFOLEN-1;
 	}
-	charstring::copy(pvt->_connstats->clientinfo,info,len);
-	pvt->_connstats->clientinfo[len]='\0';
+	charstring::copy(pvt->_conntext->clientinfo,info,len);
+	pvt->_conntext->clientinfo[len]='\0';
 }
 
 void sqlrservercontroller::setClientAddr() {
@@ -8097,31 +8590,31 @@ void sqlrservercontroller::setClientAddr() {
 		char	*clientaddrbuf=pvt->_clientsock->getPeerAddress();
 		if (clientaddrbuf) {
 			charstring::copy(
-				pvt->_connstats->clientaddr,clientaddrbuf);
+				pvt->_conntext->clientaddr,clientaddrbuf);
 			delete[] clientaddrbuf;
 		} else {
 			charstring::copy(
-				pvt->_connstats->clientaddr,"UNIX");
+				pvt->_conntext->clientaddr,"UNIX");
 		}
 	} else {
-		charstring::copy(pvt->_connstats->clientaddr,"internal");
+		charstring::copy(pvt->_conntext->clientaddr,"internal");
 	}
 }
 
 const char *sqlrservercontroller::getCurrentUser() {
-	return (pvt->_connstats)?pvt->_connstats->user:NULL;
+	return (pvt->_conntext)?pvt->_conntext->user:NULL;
 }
 
 const char *sqlrservercontroller::getCurrentQuery() {
-	return (pvt->_connstats)?pvt->_connstats->sqltext:NULL;
+	return (pvt->_conntext)?pvt->_conntext->sqltext:NULL;
 }
 
 const char *sqlrservercontroller::getClientInfo() {
-	return (pvt->_connstats)?pvt->_connstats->clientinfo:NULL;
+	return (pvt->_conntext)?pvt->_conntext->clientinfo:NULL;
 }
 
 const char *sqlrservercontroller::getClientAddr() {
-	return (pvt->_connstats)?pvt->_connstats->clientaddr:NULL;
+	return (pvt->_conntext)?pvt->_conntext->clientaddr:NULL;
 }
 
 void sqlrservercontroller::setInstanceDisabled(bool disabled) {
@@ -8270,6 +8763,58 @@ void sqlrservercontroller::incrementTotalErrors() {
 	pvt->_semset->signalWithUndo(9);
 }
 
+void sqlrservercontroller::getLatencyStart(uint64_t *sec, uint64_t *usec) {
+	if (!pvt->_latencyhistograms) {
+		*sec=0;
+		*usec=0;
+		return;
+	}
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	*sec=dt.getEpoch();
+	*usec=dt.getMicroseconds();
+}
+
+void sqlrservercontroller::recordLatency(sqlrlatencystage_t stage,
+						sqlrservercursor *cursor,
+						uint64_t startsec,
+						uint64_t startusec) {
+
+	// bail if histograms are disabled or there's no start time
+	if (!pvt->_latencyhistograms || !startsec) {
+		return;
+	}
+
+	// get the elapsed time (the histograms are updated atomically,
+	// so they don't need to be protected by a semaphore)
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	uint64_t	start=startsec*1000000+startusec;
+	uint64_t	end=((uint64_t)dt.getEpoch())*1000000+
+						dt.getMicroseconds();
+	if (end<start) {
+		return;
+	}
+	uint64_t	usec=end-start;
+
+	// record it for the instance as a whole...
+	latencyHistogramRecord(&(pvt->_shm->latency[0][stage]),usec);
+
+	// ...and for the type of query, if we're keeping those
+	if (!pvt->_querytypelatencyhistograms || !cursor) {
+		return;
+	}
+	sqlrquerytype_t	querytype=SQLRQUERYTYPE_ETC;
+	const char	*query=cursor->getQueryBuffer();
+	if (query) {
+		querytype=cursor->queryType(query,cursor->getQueryLength());
+		if (querytype>SQLRQUERYTYPE_ETC) {
+			querytype=SQLRQUERYTYPE_ETC;
+		}
+	}
+	latencyHistogramRecord(&(pvt->_shm->latency[querytype+1][stage]),usec);
+}
+
 void sqlrservercontroller::incrementAuthCount() {
 	if (!pvt->_connstats) {
 		return;
@@ -8717,7 +9262,7 @@ void sqlrservercontroller::addTransactionTempTableForTrunc(const char *table) {
 }
 
 bool sqlrservercontroller::logEnabled() {
-	return (pvt->_sqlrlg!=NULL);
+	return (pvt->_sqlrlg && pvt->_sqlrlg->wantDebugMessages());
 }
 
 bool sqlrservercontroller::notificationsEnabled() {
@@ -8725,7 +9270,7 @@ bool sqlrservercontroller::notificationsEnabled() {
 }
 
 void sqlrservercontroller::raiseDebugMessageEvent(const char *info) {
-	if (pvt->_sqlrlg) {
+	if (pvt->_sqlrlg && pvt->_sqlrlg->wantDebugMessages()) {
 		pvt->_sqlrlg->run(NULL,pvt->_conn,NULL,
 					SQLRLOGGER_LOGLEVEL_DEBUG,
 					SQLREVENT_DEBUG_MESSAGE,
@@ -9179,8 +9724,9 @@ bool sqlrservercontroller::fetchFromBindCursor(sqlrservercursor *cursor) {
 
 	bool	success=cursor->fetchFromBindCursor();
 	
-	// reset total rows fetched
+	// reset total rows and bytes fetched
 	cursor->clearTotalRowsFetched();
+	cursor->clearTotalBytesFetched();
 
 	if (success) {
 		success=handleResultSetHeader(cursor);
@@ -9848,8 +10394,21 @@ bool sqlrservercontroller::fetchRow(sqlrservercursor *cursor, bool *error) {
 		return false;
 	}
 
-	// bump total rows fetched
+	// record how long it took to get the first row
+	if (!cursor->getTotalRowsFetched()) {
+		recordLatency(LATENCYSTAGE_FIRSTROW,cursor,
+					cursor->getQueryEndSec(),
+					cursor->getQueryEndUSec());
+	}
+
+	// bump total rows and bytes fetched
+	// (lobs are fetched separately and aren't included)
 	cursor->incrementTotalRowsFetched();
+	uint64_t	bytes=0;
+	for (uint32_t i=0; i<colcount; i++) {
+		bytes+=pvt->_fieldlengths[i];
+	}
+	cursor->addTotalBytesFetched(bytes);
 
 	return true;
 }
@@ -10050,6 +10609,86 @@ char *sqlrservercontroller::getQueryBuffer(sqlrservercursor *cursor) {
 	return cursor->getQueryBuffer();
 }
 
+char *sqlrservercontroller::allocateQueryBuffer(sqlrservercursor *cursor,
+							uint32_t querylength) {
+	return cursor->allocateQueryBuffer(querylength);
+}
+
+char *sqlrservercontroller::allocateCursorBuffer(uint32_t size,
+							uint32_t *buffersize) {
+
+	// reuse the smallest idle buffer that's big enough, if there is one
+	linkedlistnode< sqlrcursorbuffer * >	*best=NULL;
+	for (linkedlistnode< sqlrcursorbuffer * >
+			*node=pvt->_idlecursorbuffers.getFirst();
+						node; node=node->getNext()) {
+		uint32_t	nodesize=node->getValue()->size;
+		if (nodesize>=size &&
+			(!best || nodesize<best->getValue()->size)) {
+			best=node;
+		}
+	}
+	if (best) {
+		sqlrcursorbuffer	*cb=best->getValue();
+		char			*buffer=cb->buffer;
+		*buffersize=cb->size;
+		pvt->_idlecursorbuffers.remove(best);
+		delete cb;
+		return buffer;
+	}
+
+	// Otherwise allocate a new one.  Round the size up to a power of 2 so
+	// that buffers given back by one cursor are likely to be the right
+	// size for another, and so that a buffer that grows a little at a
+	// time doesn't get reallocated every time.
+	uint32_t	newsize=MIN_CURSOR_BUFFER_SIZE;
+	while (newsize<size) {
+		if (newsize>=((uint32_t)1<<31)) {
+			newsize=size;
+			break;
+		}
+		newsize=newsize*2;
+	}
+	*buffersize=newsize;
+	pvt->_cursorbuffermemory+=newsize;
+	if (pvt->_connstats) {
+		pvt->_connstats->cursorbuffermemory=pvt->_cursorbuffermemory;
+	}
+	return new char[newsize];
+}
+
+void sqlrservercontroller::releaseCursorBuffer(char *buffer,
+							uint32_t buffersize) {
+
+	if (!buffer) {
+		return;
+	}
+
+	// keep the buffer around for another cursor to use
+	sqlrcursorbuffer	*cb=new sqlrcursorbuffer;
+	cb->buffer=buffer;
+	cb->size=buffersize;
+	pvt->_idlecursorbuffers.append(cb);
+
+	// if there are too many idle buffers, then free the oldest one
+	if (pvt->_idlecursorbuffers.getLength()>MAX_IDLE_CURSOR_BUFFERS) {
+		linkedlistnode< sqlrcursorbuffer * >	*first=
+					pvt->_idlecursorbuffers.getFirst();
+		cb=first->getValue();
+		pvt->_cursorbuffermemory-=cb->size;
+		delete[] cb->buffer;
+		delete cb;
+		pvt->_idlecursorbuffers.remove(first);
+	}
+	if (pvt->_connstats) {
+		pvt->_connstats->cursorbuffermemory=pvt->_cursorbuffermemory;
+	}
+}
+
+uint64_t sqlrservercontroller::getCursorBufferMemory() {
+	return pvt->_cursorbuffermemory;
+}
+
 uint32_t  sqlrservercontroller::getQueryLength(sqlrservercursor *cursor) {
 	return cursor->getQueryLength();
 }
@@ -10076,6 +10715,12 @@ const char *sqlrservercontroller::getTranslatedQuery(
 void sqlrservercontroller::setCommandStart(sqlrservercursor *cursor,
 						uint64_t sec, uint64_t usec) {
 	cursor->setCommandStart(sec,usec);
+
+	// record how long the client took to send
+	// this command after the previous one ended
+	recordLatency(LATENCYSTAGE_THINK,NULL,
+				pvt->_lastcommandendsec,
+				pvt->_lastcommandendusec);
 }
 
 uint64_t sqlrservercontroller::getCommandStartSec(sqlrservercursor *cursor) {
@@ -10089,6 +10734,26 @@ uint64_t sqlrservercontroller::getCommandStartUSec(sqlrservercursor *cursor) {
 void sqlrservercontroller::setCommandEnd(sqlrservercursor *cursor,
 						uint64_t sec, uint64_t usec) {
 	cursor->setCommandEnd(sec,usec);
+
+	// if the command ran a query, then record how long it took to send
+	// the result set back after the query was executed
+	uint64_t	queryendsec=cursor->getQueryEndSec();
+	uint64_t	queryendusec=cursor->getQueryEndUSec();
+	uint64_t	commandstartsec=cursor->getCommandStartSec();
+	if (queryendsec>commandstartsec ||
+		(queryendsec==commandstartsec &&
+		queryendusec>=cursor->getCommandStartUSec())) {
+		recordLatency(LATENCYSTAGE_SEND,cursor,
+					queryendsec,queryendusec);
+	}
+
+	pvt->_lastcommandendsec=sec;
+	pvt->_lastcommandendusec=usec;
+
+	// let the loggers know that the command is done
+	if (pvt->_sqlrlg) {
+		pvt->_sqlrlg->endCommand(cursor);
+	}
 }
 
 uint64_t sqlrservercontroller::getCommandEndSec(sqlrservercursor *cursor) {
@@ -10138,6 +10803,11 @@ uint64_t sqlrservercontroller::getTotalRowsFetched(sqlrservercursor *cursor) {
 	return cursor->getTotalRowsFetched();
 }
 
+uint64_t sqlrservercontroller::getTotalBytesFetched(
+					sqlrservercursor *cursor) {
+	return cursor->getTotalBytesFetched();
+}
+
 void sqlrservercontroller::clearError(sqlrservercursor *cursor) {
 	setError(cursor,NULL,0,true);
 }
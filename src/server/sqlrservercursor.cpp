@@ -22,7 +22,10 @@ class sqlrservercursorprivate {
 
 		uint16_t	_id;
 
+		sqlrservercontroller	*_cont;
+
 		char			*_querybuffer;
+		uint32_t		_querybuffersize;
 		uint32_t		_querylength;
 		sqlrquerystatus_t	_querystatus;
 		stringbuffer		_querywithfakeinputbinds;
@@ -36,12 +39,16 @@ class sqlrservercursorprivate {
 
 		uint16_t		_inbindcount;
 		sqlrserverbindvar	*_inbindvars;
+		uint32_t		_inbindbuffersize;
 		uint16_t		_outbindcount;
 		sqlrserverbindvar	*_outbindvars;
+		uint32_t		_outbindbuffersize;
 		uint16_t		_inoutbindcount;
 		sqlrserverbindvar	*_inoutbindvars;
+		uint32_t		_inoutbindbuffersize;
 
 		uint64_t	_totalrowsfetched;
+		uint64_t	_totalbytesfetched;
 
 		bool		_currentrowreformatted;
 
@@ -62,6 +69,7 @@ class sqlrservercursorprivate {
 		uint32_t	_maxerrorlength;
 
 		char		*_error;
+		uint32_t	_errorbuffersize;
 		uint32_t	_errorlength;
 		int64_t		_errnum;
 		bool		_liveconnection;
@@ -121,21 +129,28 @@ sqlrservercursor::sqlrservercursor(sqlrserverconnection *conn, uint16_t id) {
 
 	this->conn=conn;
 
+	pvt->_cont=conn->cont;
+
 	pvt->_maxerrorlength=conn->cont->getConfig()->getMaxErrorLength();
 
 	pvt->_bindmappings=new namevaluepairs;
 
+	// The query, bind and error buffers are allocated from the
+	// controller's cursor buffers when they're first needed, and grow
+	// from there, rather than being sized for the largest possible
+	// query, bind count and error up front.
+	pvt->_inbindvars=NULL;
+	pvt->_inbindbuffersize=0;
 	setInputBindCount(0);
-	pvt->_inbindvars=new sqlrserverbindvar[
-				conn->cont->getConfig()->getMaxBindCount()];
+	pvt->_outbindvars=NULL;
+	pvt->_outbindbuffersize=0;
 	setOutputBindCount(0);
-	pvt->_outbindvars=new sqlrserverbindvar[
-				conn->cont->getConfig()->getMaxBindCount()];
+	pvt->_inoutbindvars=NULL;
+	pvt->_inoutbindbuffersize=0;
 	setInputOutputBindCount(0);
-	pvt->_inoutbindvars=new sqlrserverbindvar[
-				conn->cont->getConfig()->getMaxBindCount()];
 
 	pvt->_totalrowsfetched=0;
+	pvt->_totalbytesfetched=0;
 
 	pvt->_currentrowreformatted=false;
 
@@ -157,15 +172,16 @@ sqlrservercursor::sqlrservercursor(sqlrserverconnection *conn, uint16_t id) {
 
 	setCreateTempTablePattern("(create|CREATE|declare|DECLARE)[ 	\\r\\n]+((global|GLOBAL|local|LOCAL)?[ 	\\r\\n]+)?(temp|TEMP|temporary|TEMPORARY)?[ 	\\r\\n]+(table|TABLE)[ 	\\r\\n]+");
 
-	pvt->_querybuffer=
-		new char[conn->cont->getConfig()->getMaxQuerySize()+1];
+	pvt->_querybuffer=NULL;
+	pvt->_querybuffersize=0;
 	setQueryLength(0);
 
 	setQueryStatus(SQLRQUERYSTATUS_ERROR);
 
 	setQueryTree(NULL);
 
-	pvt->_error=new char[pvt->_maxerrorlength+1];
+	pvt->_error=NULL;
+	pvt->_errorbuffersize=0;
 	pvt->_errorlength=0;
 	pvt->_errnum=0;
 	pvt->_liveconnection=true;
@@ -178,6 +194,7 @@ sqlrservercursor::sqlrservercursor(sqlrserverconnection *conn, uint16_t id) {
 	setCustomQueryCursor(NULL);
 
 	clearTotalRowsFetched();
+	clearTotalBytesFetched();
 
 	pvt->_id=id;
 
@@ -230,14 +247,10 @@ sqlrservercursor::sqlrservercursor(sqlrserverconnection *conn, uint16_t id) {
 }
 
 sqlrservercursor::~sqlrservercursor() {
-	delete[] pvt->_querybuffer;
+	releaseBuffers();
 	delete pvt->_querytree;
 	delete pvt->_bindmappings;
-	delete[] pvt->_inbindvars;
-	delete[] pvt->_outbindvars;
-	delete[] pvt->_inoutbindvars;
 	delete pvt->_customquerycursor;
-	delete[] pvt->_error;
 	deallocateColumnPointers();
 	deallocateFieldPointers();
 	delete pvt;
@@ -599,11 +612,50 @@ bool sqlrservercursor::executeQuery(const char *query, uint32_t length) {
 	return true;
 }
 
+bool sqlrservercursor::cancelQuery() {
+	// by default, queries can't be cancelled
+	return false;
+}
+
 bool sqlrservercursor::fetchFromBindCursor() {
 	// by default, do nothing...
 	return true;
 }
 
+uint32_t sqlrservercursor::getArrayBindSize() {
+	// by default, array binds aren't supported
+	return 0;
+}
+
+bool sqlrservercursor::arrayBindRow() {
+	// by default, array binds aren't supported
+	return false;
+}
+
+uint32_t sqlrservercursor::getArrayBindRowCount() {
+	// by default, array binds aren't supported
+	return 0;
+}
+
+bool sqlrservercursor::executeArrayQuery(const char *query, uint32_t length) {
+	// by default, array binds aren't supported
+	return false;
+}
+
+uint32_t sqlrservercursor::getArrayErrorCount() {
+	// by default, array binds aren't supported
+	return 0;
+}
+
+bool sqlrservercursor::getArrayError(uint32_t index,
+					uint32_t *row,
+					int64_t *errorcode,
+					const char **error,
+					uint32_t *errorlength) {
+	// by default, array binds aren't supported
+	return false;
+}
+
 bool sqlrservercursor::nextResultSet(bool *nextresultsetavailable) {
 	// by default, a next result set is not available
 	*nextresultsetavailable = false;
@@ -614,7 +666,7 @@ bool sqlrservercursor::queryIsNotSelect() {
 
 	// scan the query, bypassing whitespace and comments.
 	const char	*ptr=
-		conn->cont->skipWhitespaceAndComments(pvt->_querybuffer);
+		conn->cont->skipWhitespaceAndComments(getQueryBuffer());
 
 	// if the query is a select but not a select into then return false,
 	// otherwise return true
@@ -629,7 +681,7 @@ bool sqlrservercursor::queryIsCommitOrRollback() {
 
 	// scan the query, bypassing whitespace and comments.
 	const char	*ptr=
-		conn->cont->skipWhitespaceAndComments(pvt->_querybuffer);
+		conn->cont->skipWhitespaceAndComments(getQueryBuffer());
 
 	// if the query is a commit or rollback, return true
 	// otherwise return false
@@ -832,8 +884,8 @@ bool sqlrservercursor::fakeInputBinds() {
 	int64_t		bindindex=1;
 
 	// run through the querybuffer...
-	char		*ptr=pvt->_querybuffer;
-	const char	*endptr=pvt->_querybuffer+pvt->_querylength;
+	char		*ptr=getQueryBuffer();
+	const char	*endptr=ptr+pvt->_querylength;
 	char		prev='\0';
 	do {
 
@@ -1097,7 +1149,35 @@ memorypool *sqlrservercursor::getBindMappingsPool() {
 	return &pvt->_bindmappingspool;
 }
 
+static sqlrserverbindvar *allocateBinds(sqlrservercontroller *cont,
+						sqlrserverbindvar *binds,
+						uint32_t *buffersize,
+						uint16_t count,
+						uint16_t newcount) {
+
+	// bail if the buffer is already big enough
+	uint32_t	size=newcount*sizeof(sqlrserverbindvar);
+	if (size<=*buffersize) {
+		return binds;
+	}
+
+	// get a bigger buffer and copy the current binds into it
+	uint32_t		newsize;
+	sqlrserverbindvar	*newbinds=(sqlrserverbindvar *)
+				cont->allocateCursorBuffer(size,&newsize);
+	if (binds) {
+		bytestring::copy(newbinds,binds,
+				count*sizeof(sqlrserverbindvar));
+		cont->releaseCursorBuffer((char *)binds,*buffersize);
+	}
+	*buffersize=newsize;
+	return newbinds;
+}
+
 void sqlrservercursor::setInputBindCount(uint16_t inbindcount) {
+	pvt->_inbindvars=allocateBinds(pvt->_cont,pvt->_inbindvars,
+					&pvt->_inbindbuffersize,
+					pvt->_inbindcount,inbindcount);
 	pvt->_inbindcount=inbindcount;
 }
 
@@ -1110,6 +1190,9 @@ sqlrserverbindvar *sqlrservercursor::getInputBinds() {
 }
 
 void sqlrservercursor::setOutputBindCount(uint16_t outbindcount) {
+	pvt->_outbindvars=allocateBinds(pvt->_cont,pvt->_outbindvars,
+					&pvt->_outbindbuffersize,
+					pvt->_outbindcount,outbindcount);
 	pvt->_outbindcount=outbindcount;
 }
 
@@ -1122,6 +1205,10 @@ sqlrserverbindvar *sqlrservercursor::getOutputBinds() {
 }
 
 void sqlrservercursor::setInputOutputBindCount(uint16_t inoutbindcount) {
+	pvt->_inoutbindvars=allocateBinds(pvt->_cont,
+					pvt->_inoutbindvars,
+					&pvt->_inoutbindbuffersize,
+					pvt->_inoutbindcount,inoutbindcount);
 	pvt->_inoutbindcount=inoutbindcount;
 }
 
@@ -1144,6 +1231,64 @@ void sqlrservercursor::abort() {
 }
 
 char *sqlrservercursor::getQueryBuffer() {
+	return allocateQueryBuffer(0);
+}
+
+void sqlrservercursor::releaseBuffers() {
+
+	// give the query, bind and error buffers back to the controller so
+	// other cursors can use them while this one is idle
+	pvt->_cont->releaseCursorBuffer(pvt->_querybuffer,
+					pvt->_querybuffersize);
+	pvt->_querybuffer=NULL;
+	pvt->_querybuffersize=0;
+	pvt->_querylength=0;
+
+	pvt->_cont->releaseCursorBuffer((char *)pvt->_inbindvars,
+					pvt->_inbindbuffersize);
+	pvt->_inbindvars=NULL;
+	pvt->_inbindbuffersize=0;
+	pvt->_inbindcount=0;
+
+	pvt->_cont->releaseCursorBuffer((char *)pvt->_outbindvars,
+					pvt->_outbindbuffersize);
+	pvt->_outbindvars=NULL;
+	pvt->_outbindbuffersize=0;
+	pvt->_outbindcount=0;
+
+	pvt->_cont->releaseCursorBuffer((char *)pvt->_inoutbindvars,
+					pvt->_inoutbindbuffersize);
+	pvt->_inoutbindvars=NULL;
+	pvt->_inoutbindbuffersize=0;
+	pvt->_inoutbindcount=0;
+
+	pvt->_cont->releaseCursorBuffer(pvt->_error,pvt->_errorbuffersize);
+	pvt->_error=NULL;
+	pvt->_errorbuffersize=0;
+	pvt->_errorlength=0;
+}
+
+char *sqlrservercursor::allocateQueryBuffer(uint32_t querylength) {
+
+	// bail if the buffer is already big enough
+	if (pvt->_querybuffer && querylength<pvt->_querybuffersize) {
+		return pvt->_querybuffer;
+	}
+
+	// get a bigger buffer and copy the current query into it
+	uint32_t	newsize;
+	char		*newbuffer=pvt->_cont->allocateCursorBuffer(
+							querylength+1,&newsize);
+	if (pvt->_querybuffer) {
+		bytestring::copy(newbuffer,pvt->_querybuffer,
+						pvt->_querybuffersize);
+		pvt->_cont->releaseCursorBuffer(pvt->_querybuffer,
+						pvt->_querybuffersize);
+	} else {
+		newbuffer[0]='\0';
+	}
+	pvt->_querybuffer=newbuffer;
+	pvt->_querybuffersize=newsize;
 	return pvt->_querybuffer;
 }
 
@@ -1308,6 +1453,18 @@ void sqlrservercursor::incrementTotalRowsFetched() {
 	pvt->_totalrowsfetched++;
 }
 
+void sqlrservercursor::clearTotalBytesFetched() {
+	pvt->_totalbytesfetched=0;
+}
+
+uint64_t sqlrservercursor::getTotalBytesFetched() {
+	return pvt->_totalbytesfetched;
+}
+
+void sqlrservercursor::addTotalBytesFetched(uint64_t bytes) {
+	pvt->_totalbytesfetched+=bytes;
+}
+
 void sqlrservercursor::setCurrentRowReformatted(bool crr) {
 	pvt->_currentrowreformatted=crr;
 }
@@ -1317,6 +1474,12 @@ bool sqlrservercursor::getCurrentRowReformatted() {
 }
 
 char *sqlrservercursor::getErrorBuffer() {
+	if (!pvt->_error) {
+		pvt->_error=pvt->_cont->allocateCursorBuffer(
+						pvt->_maxerrorlength+1,
+						&pvt->_errorbuffersize);
+		pvt->_error[0]='\0';
+	}
 	return pvt->_error;
 }
 
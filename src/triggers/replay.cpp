@@ -617,13 +617,14 @@ void sqlrtrigger_replay::getColumnsFromDb(char *table,
 			const char	*q=
 				cont->getColumnListQuery(table,false);
 			// FIXME: clean up buffers to avoid SQL injection
-			// FIXME: bounds checking
-			char	*querybuffer=cont->getQueryBuffer(gclcur);
-			charstring::printf(querybuffer,
-					cont->getConfig()->getMaxQuerySize()+1,
-					q,table);
-			cont->setQueryLength(gclcur,
-					charstring::length(querybuffer));
+			stringbuffer	query;
+			query.writeFormatted(q,table);
+			uint32_t	querylen=query.getStringLength();
+			char	*querybuffer=
+				cont->allocateQueryBuffer(gclcur,querylen);
+			bytestring::copy(querybuffer,query.getString(),querylen);
+			querybuffer[querylen]='\0';
+			cont->setQueryLength(gclcur,querylen);
 			retval=cont->prepareQuery(gclcur,
 					cont->getQueryBuffer(gclcur),
 					cont->getQueryLength(gclcur),
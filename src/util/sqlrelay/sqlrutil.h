@@ -154,6 +154,8 @@ class SQLRUTIL_DLLSPEC sqlrconfig {
 		virtual int32_t		getTtl()=0;
 		virtual int32_t		getSoftTtl()=0;
 		virtual uint16_t	getMaxSessionCount()=0;
+		virtual const char	*getScalingPolicy()=0;
+		virtual const char	*getLatencyHistograms()=0;
 		virtual bool		getDynamicScaling()=0;
 
 		virtual const char	*getEndOfSession()=0;
@@ -217,6 +219,8 @@ class SQLRUTIL_DLLSPEC sqlrconfig {
 
 		virtual bool		getReLoginAtStart()=0;
 
+		virtual bool		getQueryCancellation()=0;
+
 		virtual bool		getFakeInputBindVariables()=0;
 		virtual const char	*getFakeInputBindVariablesDateFormat()=0;
 		virtual bool		getFakeInputBindVariablesUnicodeStrings()=0;
@@ -255,6 +259,7 @@ class SQLRUTIL_DLLSPEC sqlrconfig {
 		virtual domnode	*getPasswordEncryptions()=0;
 		virtual domnode	*getAuths()=0;
 		virtual domnode	*getModuleDatas()=0;
+		virtual domnode	*getAdmission()=0;
 
 		virtual linkedlist< connectstringcontainer * >
 						*getConnectStringList()=0;
@@ -0,0 +1,160 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#include "../../config.h"
+#include <sqlrelay/sqlrclient.h>
+#include <rudiments/charstring.h>
+#include <rudiments/process.h>
+#include <rudiments/datetime.h>
+#include <rudiments/snooze.h>
+#include <rudiments/stdio.h>
+
+// The admissiontest instance runs 1 connection, with 1 admission class that
+// queues at most 1 client, for at most 3 seconds.  The first client that
+// is waiting for a connection holds the admission turn, and the clients
+// behind it are queued.
+
+#define ADMISSIONREJECTED	900034
+#define ADMISSIONTIMEOUT	900035
+
+sqlrconnection	*con;
+sqlrcursor	*cur;
+sqlrconnection	*secondcon;
+sqlrcursor	*secondcur;
+
+void checkSuccess(int value, int success) {
+
+	if (value==success) {
+		stdoutput.printf("success ");
+	} else {
+		stdoutput.printf("failure %d!=%d\n",value,success);
+		delete cur;
+		delete con;
+		process::exit(1);
+	}
+}
+
+static int64_t getTime() {
+	datetime	dt;
+	dt.getSystemDateAndTime();
+	return ((int64_t)dt.getEpoch())*1000+dt.getMicroseconds()/1000;
+}
+
+static pid_t startClient(int64_t expectederror) {
+
+	// run a query in another process, which exits with 0 if the
+	// query succeeded, or failed with the expected error
+	pid_t	pid=process::fork();
+	if (!pid) {
+		sqlrconnection	childcon("sqlrelay",9000,"/tmp/test.socket",
+							"test","test",0,1);
+		sqlrcursor	childcur(&childcon);
+		bool	result=childcur.sendQuery("select 1");
+		bool	expected=(expectederror)?
+				(!result &&
+				childcur.errorNumber()==expectederror):
+				result;
+		childcon.endSession();
+		process::exit((expected)?0:1);
+	}
+	return pid;
+}
+
+static int32_t waitForClient(pid_t pid) {
+	childstatechange	childstate;
+	int32_t			exitstatus=1;
+	int32_t			signum=0;
+	bool			coredump=false;
+	process::getChildStateChange(pid,true,true,true,
+					&childstate,&exitstatus,
+					&signum,&coredump);
+	return exitstatus;
+}
+
+int	main(int argc, char **argv) {
+
+	// instantiation
+	con=new sqlrconnection("sqlrelay",9000,"/tmp/test.socket",
+							"test","test",0,1);
+	cur=new sqlrcursor(con);
+	secondcon=new sqlrconnection("sqlrelay",9000,"/tmp/test.socket",
+							"test","test",0,1);
+	secondcur=new sqlrcursor(secondcon);
+
+	// hold on to the only connection, and start a client that
+	// will hold the admission turn while it waits for it
+	stdoutput.printf("ADMITTED: \n");
+	checkSuccess(cur->sendQuery("select 1"),1);
+	pid_t	turnpid=startClient(0);
+	checkSuccess(turnpid>0,1);
+	snooze::macrosnooze(1);
+	stdoutput.printf("\n");
+
+	// a queued client should wait for maxqueuewait, then give up
+	stdoutput.printf("ADMISSION TIMEOUT: \n");
+	int64_t	start=getTime();
+	checkSuccess(secondcur->sendQuery("select 1"),0);
+	checkSuccess(secondcur->errorNumber(),ADMISSIONTIMEOUT);
+	int64_t	elapsed=getTime()-start;
+	checkSuccess(elapsed>=2500,1);
+	checkSuccess(elapsed<10000,1);
+	secondcon->endSession();
+	stdoutput.printf("\n");
+
+	// while another client is queued, the queue is full
+	// and a third client should be rejected right away
+	stdoutput.printf("ADMISSION REJECTED: \n");
+	pid_t	queuedpid=startClient(ADMISSIONTIMEOUT);
+	checkSuccess(queuedpid>0,1);
+	snooze::macrosnooze(1);
+	start=getTime();
+	checkSuccess(secondcur->sendQuery("select 1"),0);
+	checkSuccess(secondcur->errorNumber(),ADMISSIONREJECTED);
+	checkSuccess(getTime()-start<1000,1);
+	secondcon->endSession();
+	checkSuccess(waitForClient(queuedpid),0);
+	stdoutput.printf("\n");
+
+	// when the connection is released, the client holding the turn
+	// should get it, and then the queued client should get it
+	stdoutput.printf("ADMITTED FROM QUEUE: \n");
+	queuedpid=startClient(0);
+	checkSuccess(queuedpid>0,1);
+	snooze::macrosnooze(1);
+	con->endSession();
+	checkSuccess(waitForClient(turnpid),0);
+	checkSuccess(waitForClient(queuedpid),0);
+	stdoutput.printf("\n");
+
+	// The time that it took to admit a client from the queue shouldn't
+	// include the time that passed before the client was queued, and
+	// shouldn't be used once the queues have emptied.  A client queued
+	// behind the turn should wait, rather than being rejected because
+	// of an earlier backlog.
+	stdoutput.printf("ADMISSION ESTIMATE RESET: \n");
+	checkSuccess(cur->sendQuery("select 1"),1);
+	turnpid=startClient(0);
+	checkSuccess(turnpid>0,1);
+	snooze::macrosnooze(1);
+	checkSuccess(secondcur->sendQuery("select 1"),0);
+	checkSuccess(secondcur->errorNumber(),ADMISSIONTIMEOUT);
+	secondcon->endSession();
+	con->endSession();
+	checkSuccess(waitForClient(turnpid),0);
+	stdoutput.printf("\n");
+
+	// clients should be admitted right away again
+	stdoutput.printf("ADMITTED AFTER RELEASE: \n");
+	checkSuccess(secondcur->sendQuery("select 1"),1);
+	secondcon->endSession();
+	checkSuccess(cur->sendQuery("select 1"),1);
+	con->endSession();
+	stdoutput.printf("\n");
+
+	delete secondcur;
+	delete secondcon;
+	delete cur;
+	delete con;
+
+	return 0;
+}
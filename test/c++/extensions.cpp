@@ -388,6 +388,46 @@ int	main(int argc, char **argv) {
 	printf("\n\n");
 
 
+	printf("SQLRCMD FINGERPRINTS: \n");
+	// (a query is counted when its result set is closed, so running
+	// the next query counts the one before it)
+	checkSuccess(cur->sendQuery("select 'fingerprinttest' fingerprinttest from dual"),1);
+	checkSuccess(cur->sendQuery("select 'fingerprinttest' fingerprinttest from dual"),1);
+	checkSuccess(cur->sendQuery("sqlrcmd fingerprints"),1);
+	checkSuccess(cur->colCount(),10);
+	checkSuccess(cur->getColumnName((uint32_t)0),"FINGERPRINT");
+	checkSuccess(cur->getColumnName(1),"CALLS");
+	checkSuccess(cur->getColumnName(2),"ERRORS");
+	checkSuccess(cur->getColumnName(3),"ROWS");
+	checkSuccess(cur->getColumnName(4),"BYTES");
+	checkSuccess(cur->getColumnName(5),"TOTAL_USEC");
+	checkSuccess(cur->getColumnName(6),"AVG_USEC");
+	checkSuccess(cur->getColumnName(7),"MIN_USEC");
+	checkSuccess(cur->getColumnName(8),"MAX_USEC");
+	checkSuccess(cur->getColumnName(9),"STDDEV_USEC");
+	printf("\n");
+	found=false;
+	for (uint64_t i=0; i<cur->rowCount(); i++) {
+		if (charstring::contains(cur->getField(i,(uint32_t)0),
+							"fingerprinttest")) {
+			found=true;
+			row=i;
+			break;
+		}
+	}
+	checkSuccess(found,true);
+	checkSuccess(charstring::contains(cur->getField(row,(uint32_t)0),
+						"'fingerprinttest'"),false);
+	checkSuccess(cur->getFieldAsInteger(row,1)>=2,true);
+	checkSuccess(cur->getFieldAsInteger(row,2),0);
+	checkSuccess(cur->getFieldAsInteger(row,3)>=2,true);
+	// each row is the 15 byte string 'fingerprinttest'
+	checkSuccess(cur->getFieldAsInteger(row,4)>=30,true);
+	checkSuccess(cur->getFieldAsInteger(row,6)<=
+				cur->getFieldAsInteger(row,8),true);
+	printf("\n\n");
+
+
 	printf("SESSION QUERIES: Date Format\n");
 	checkSuccess(cur->sendQuery("select sysdate from dual"),1);
 	datetime	dt;
@@ -3,6 +3,7 @@
 
 #include <sqlrelay/sqlrclient.h>
 #include <rudiments/charstring.h>
+#include <rudiments/bytestring.h>
 #include <rudiments/sys.h>
 #include <rudiments/process.h>
 #include <rudiments/snooze.h>
@@ -91,6 +92,54 @@ void checkSuccess(double value, double success) {
 	}
 }
 
+// collects the lob segments that are handed to streamLob()
+struct lobstream {
+	uint64_t	row;
+	uint32_t	col;
+	char		*buffer;
+	uint64_t	buffersize;
+	uint64_t	length;
+	uint32_t	segments;
+	bool		inorder;
+	bool		done;
+	uint32_t	bailafter;
+};
+
+static void resetLobStream(lobstream *ls, uint64_t row, uint32_t col,
+						char *buffer, uint64_t buffersize) {
+	ls->row=row;
+	ls->col=col;
+	ls->buffer=buffer;
+	ls->buffersize=buffersize;
+	ls->length=0;
+	ls->segments=0;
+	ls->inorder=true;
+	ls->done=false;
+	ls->bailafter=0;
+}
+
+static bool streamLob(sqlrcursor *cursor, uint64_t row, uint32_t col,
+					uint64_t offset, const char *segment,
+					uint32_t length, void *data) {
+
+	lobstream	*ls=&(((lobstream *)data)[col]);
+	if (row!=ls->row) {
+		return true;
+	}
+	if (!segment) {
+		ls->done=true;
+		return true;
+	}
+	if (offset!=ls->length || offset+length>ls->buffersize) {
+		ls->inorder=false;
+		return false;
+	}
+	bytestring::copy(ls->buffer+offset,segment,length);
+	ls->length=offset+length;
+	ls->segments++;
+	return (!ls->bailafter || ls->segments<ls->bailafter);
+}
+
 int	main(int argc, char **argv) {
 
 	const char	*bindvars[6]={"1","2","3","4","5",NULL};
@@ -921,6 +970,90 @@ int	main(int argc, char **argv) {
 	cur->sendQuery("drop table testtable2");
 	stdoutput.printf("\n");
 
+	stdoutput.printf("LOB STREAMING: \n");
+	cur->sendQuery("drop table testtable2");
+	checkSuccess(cur->sendQuery("create table testtable2 (testnumber number, testclob clob, testblob blob)"),1);
+	const uint32_t	biglobsize=256*1024;
+	char	*bigclob=new char[biglobsize+1];
+	char	*bigblob=new char[biglobsize];
+	for (uint32_t i=0; i<biglobsize; i++) {
+		bigclob[i]='a'+i%26;
+		bigblob[i]=(char)(i%256);
+	}
+	bigclob[biglobsize]='\0';
+	cur->prepareQuery("insert into testtable2 values (:num,:clobval,:blobval)");
+	cur->inputBind("num",1);
+	cur->inputBindClob("clobval",bigclob,biglobsize);
+	cur->inputBindBlob("blobval",bigblob,biglobsize);
+	checkSuccess(cur->executeQuery(),1);
+	cur->clearBinds();
+	cur->inputBind("num",2);
+	cur->inputBindClob("clobval","hello",5);
+	cur->inputBindBlob("blobval","hello",5);
+	checkSuccess(cur->executeQuery(),1);
+	cur->clearBinds();
+
+	// buffered, the whole lobs should come through, binary data intact
+	checkSuccess(cur->sendQuery("select testclob, testblob, testnumber from testtable2 order by testnumber"),1);
+	checkSuccess(cur->getFieldLength(0,(uint32_t)0)==biglobsize,1);
+	checkSuccess(cur->getField(0,(uint32_t)0),bigclob);
+	checkSuccess(cur->getFieldLength(0,1)==biglobsize,1);
+	checkSuccess(!bytestring::compare(cur->getField(0,1),
+						bigblob,biglobsize),1);
+	checkSuccess(cur->getField(1,(uint32_t)0),"hello");
+	checkSuccess(cur->getField(1,1),"hello");
+
+	// streamed, the lobs should arrive in order, in more than one segment
+	char		*streamedclob=new char[biglobsize];
+	char		*streamedblob=new char[biglobsize];
+	lobstream	streams[2];
+	resetLobStream(&streams[0],0,0,streamedclob,biglobsize);
+	resetLobStream(&streams[1],0,1,streamedblob,biglobsize);
+	cur->setLobFieldStreamFunction(streamLob,streams);
+	checkSuccess(cur->sendQuery("select testclob, testblob, testnumber from testtable2 order by testnumber"),1);
+	checkSuccess(cur->rowCount(),2);
+	checkSuccess(streams[0].inorder,1);
+	checkSuccess(streams[0].done,1);
+	checkSuccess(streams[0].segments>1,1);
+	checkSuccess(streams[0].length==biglobsize,1);
+	checkSuccess(!bytestring::compare(streamedclob,bigclob,biglobsize),1);
+	checkSuccess(streams[1].inorder,1);
+	checkSuccess(streams[1].done,1);
+	checkSuccess(streams[1].segments>1,1);
+	checkSuccess(streams[1].length==biglobsize,1);
+	checkSuccess(!bytestring::compare(streamedblob,bigblob,biglobsize),1);
+	checkSuccess(cur->getFieldLength(0,(uint32_t)0),0);
+	checkSuccess(cur->getField(0,(uint32_t)0),"");
+	checkSuccess(cur->getField(0,2),"1");
+	checkSuccess(cur->getField(1,2),"2");
+
+	// if the stream function bails on a lob, the rest of it should be
+	// discarded and the rest of the result set should still come through
+	resetLobStream(&streams[0],0,0,streamedclob,biglobsize);
+	resetLobStream(&streams[1],0,1,streamedblob,biglobsize);
+	streams[0].bailafter=1;
+	checkSuccess(cur->sendQuery("select testclob, testblob, testnumber from testtable2 order by testnumber"),1);
+	checkSuccess(cur->rowCount(),2);
+	checkSuccess(streams[0].segments,1);
+	checkSuccess(streams[0].done,0);
+	checkSuccess(streams[1].done,1);
+	checkSuccess(streams[1].length==biglobsize,1);
+	checkSuccess(!bytestring::compare(streamedblob,bigblob,biglobsize),1);
+	checkSuccess(cur->getField(0,2),"1");
+	checkSuccess(cur->getField(1,2),"2");
+
+	// with streaming disabled, lobs should be buffered again
+	cur->setLobFieldStreamFunction(NULL,NULL);
+	checkSuccess(cur->sendQuery("select testclob from testtable2 order by testnumber"),1);
+	checkSuccess(cur->getFieldLength(0,(uint32_t)0)==biglobsize,1);
+	checkSuccess(cur->getField(0,(uint32_t)0),bigclob);
+	delete[] streamedblob;
+	delete[] streamedclob;
+	delete[] bigblob;
+	delete[] bigclob;
+	cur->sendQuery("drop table testtable2");
+	stdoutput.printf("\n");
+
 
 	stdoutput.printf("LONG OUTPUT BIND\n");
 	cur->sendQuery("drop table testtable2");
@@ -4,6 +4,9 @@
 #include <sqlrelay/sqlrclient.h>
 #include <rudiments/charstring.h>
 #include <rudiments/process.h>
+#include <rudiments/datetime.h>
+#include <rudiments/snooze.h>
+#include <rudiments/thread.h>
 #include <rudiments/stdio.h>
 
 sqlrconnection	*con;
@@ -63,6 +66,14 @@ void checkSuccess(double value, double success) {
 	}
 }
 
+static void cancelQuery(void *attr) {
+
+	// cancel the query that main() is waiting for, once it's had time
+	// to start
+	snooze::macrosnooze(3);
+	*((bool *)attr)=con->cancelQuery();
+}
+
 int	main(int argc, char **argv) {
 
 	const char	*subvars[4]={"var1","var2","var3",NULL};
@@ -816,6 +827,47 @@ int	main(int argc, char **argv) {
 	// drop existing table
 	cur->sendQuery("drop table testtable");
 
+	// query cancellation
+	stdoutput.printf("QUERY CANCELLATION: \n");
+	con->endSession();
+	con->setResponseTimeout(60,0);
+	checkSuccess(cur->sendQuery("select 1"),1);
+	pid_t	cancelpid=process::fork();
+	if (!cancelpid) {
+		// this process has a copy of the cancel key of the query
+		// above, which has finished, so it shouldn't be able to
+		// cancel the query below
+		snooze::macrosnooze(1);
+		process::exit((con->cancelQuery())?1:0);
+	}
+	checkSuccess(cancelpid>0,1);
+	thread	cancelthread;
+	bool	cancelled=false;
+	checkSuccess(cancelthread.spawn((void *(*)(void *))cancelQuery,
+						(void *)&cancelled,false),1);
+	datetime	querystart;
+	querystart.getSystemDateAndTime();
+	checkSuccess(cur->sendQuery("select pg_sleep(60)"),0);
+	checkSuccess(charstring::contains(cur->errorMessage(),"canceling statement"),1);
+	datetime	queryend;
+	queryend.getSystemDateAndTime();
+	checkSuccess(queryend.getEpoch()-querystart.getEpoch()<20,1);
+	int32_t	threadstatus;
+	cancelthread.wait(&threadstatus);
+	checkSuccess(cancelled,1);
+	childstatechange	cancelstate;
+	int32_t			cancelstatus=1;
+	int32_t			cancelsignum=0;
+	bool			cancelcoredump=false;
+	process::getChildStateChange(cancelpid,true,true,true,
+					&cancelstate,&cancelstatus,
+					&cancelsignum,&cancelcoredump);
+	checkSuccess(cancelstatus,0);
+	checkSuccess(cur->sendQuery("select 1"),1);
+	con->endSession();
+	con->setResponseTimeout(-1,-1);
+	stdoutput.printf("\n");
+
 	// invalid queries...
 	stdoutput.printf("INVALID QUERIES: \n");
 	checkSuccess(cur->sendQuery("select * from testtable order by testint"),0);
@@ -5,7 +5,11 @@
 #include <sqlrelay/sqlrclient.h>
 #include <rudiments/charstring.h>
 #include <rudiments/process.h>
+#include <rudiments/datetime.h>
+#include <rudiments/snooze.h>
+#include <rudiments/thread.h>
 #include <rudiments/stdio.h>
+#include <rudiments/stringbuffer.h>
 
 sqlrconnection	*con;
 sqlrcursor	*cur;
@@ -48,6 +52,14 @@ void checkSuccess(int value, int success) {
 	}
 }
 
+static void cancelQuery(void *attr) {
+
+	// cancel the query that main() is waiting for, once it's had time
+	// to start
+	snooze::macrosnooze(3);
+	*((bool *)attr)=con->cancelQuery();
+}
+
 int	main(int argc, char **argv) {
 
 	const char	*subvars[4]={"var1","var2","var3",NULL};
@@ -636,6 +648,30 @@ int	main(int argc, char **argv) {
 	checkSuccess(cur->getField(7,(uint32_t)0),NULL);
 	stdoutput.printf("\n");
 
+	// query buffers start small and grow, so run a small query and
+	// then progressively larger ones on the same cursor
+	stdoutput.printf("LARGE QUERIES: \n");
+	checkSuccess(cur->sendQuery("select 1"),1);
+	checkSuccess(cur->getField(0,(uint32_t)0),"1");
+	for (uint32_t size=100; size<=10000; size*=10) {
+		stringbuffer	largequery;
+		largequery.append("select count(*) from testtable "
+						"where testint in (1");
+		for (uint32_t i=2; i<=size; i++) {
+			largequery.append(',')->append(i);
+		}
+		largequery.append(") and testint<:1");
+		cur->prepareQuery(largequery.getString());
+		cur->inputBind("1",100);
+		checkSuccess(cur->executeQuery(),1);
+		checkSuccess(cur->getField(0,(uint32_t)0),"9");
+	}
+	checkSuccess(cur->getColumnList("testtable",NULL),1);
+	checkSuccess(cur->rowCount(),6);
+	checkSuccess(cur->sendQuery("select 1"),1);
+	checkSuccess(cur->getField(0,(uint32_t)0),"1");
+	stdoutput.printf("\n");
+
 	// drop existing table
 	cur->sendQuery("drop table testtable");
 
@@ -661,6 +697,47 @@ int	main(int argc, char **argv) {
 	checkSuccess(!charstring::length(cur->getField(0,(uint32_t)0)),0);
 	stdoutput.printf("\n");
 
+	// query cancellation
+	stdoutput.printf("QUERY CANCELLATION: \n");
+	con->endSession();
+	con->setResponseTimeout(60,0);
+	checkSuccess(cur->sendQuery("select 1"),1);
+	pid_t	cancelpid=process::fork();
+	if (!cancelpid) {
+		// this process has a copy of the cancel key of the query
+		// above, which has finished, so it shouldn't be able to
+		// cancel the query below
+		snooze::macrosnooze(1);
+		process::exit((con->cancelQuery())?1:0);
+	}
+	checkSuccess(cancelpid>0,1);
+	thread	cancelthread;
+	bool	cancelled=false;
+	checkSuccess(cancelthread.spawn((void *(*)(void *))cancelQuery,
+						(void *)&cancelled,false),1);
+	datetime	querystart;
+	querystart.getSystemDateAndTime();
+	checkSuccess(cur->sendQuery("with recursive counter(i) as (select 1 union all select i+1 from counter where i<1000000000) select count(*) from counter"),0);
+	checkSuccess(charstring::contains(cur->errorMessage(),"interrupt"),1);
+	datetime	queryend;
+	queryend.getSystemDateAndTime();
+	checkSuccess(queryend.getEpoch()-querystart.getEpoch()<20,1);
+	int32_t	threadstatus;
+	cancelthread.wait(&threadstatus);
+	checkSuccess(cancelled,1);
+	childstatechange	cancelstate;
+	int32_t			cancelstatus=1;
+	int32_t			cancelsignum=0;
+	bool			cancelcoredump=false;
+	process::getChildStateChange(cancelpid,true,true,true,
+					&cancelstate,&cancelstatus,
+					&cancelsignum,&cancelcoredump);
+	checkSuccess(cancelstatus,0);
+	checkSuccess(cur->sendQuery("select 1"),1);
+	con->endSession();
+	con->setResponseTimeout(-1,-1);
+	stdoutput.printf("\n");
+
 	// invalid queries...
 	stdoutput.printf("INVALID QUERIES: \n");
 	checkSuccess(cur->sendQuery("select * from testtable"),0);
@@ -0,0 +1,120 @@
+// Copyright (c) 1999-2018 David Muse
+// See the file COPYING for more information.
+
+#include "../../config.h"
+#include <sqlrelay/sqlrclient.h>
+#include <rudiments/charstring.h>
+#include <rudiments/process.h>
+#include <rudiments/datetime.h>
+#include <rudiments/snooze.h>
+#include <rudiments/stdio.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+	#define popen	_popen
+	#define pclose	_pclose
+#endif
+
+// The tracertest instance runs 1 connection, with the tracer logger tracing
+// every query.  A query that spans the top of a minute is run, and the trace
+// that sqlr-trace makes of it should still show when it ran, and for how long.
+
+sqlrconnection	*con;
+sqlrcursor	*cur;
+
+void checkSuccess(int value, int success) {
+
+	if (value==success) {
+		stdoutput.printf("success ");
+	} else {
+		stdoutput.printf("failure %d!=%d\n",value,success);
+		delete cur;
+		delete con;
+		process::exit(1);
+	}
+}
+
+static uint64_t getTime(datetime *dt) {
+	dt->getSystemDateAndTime();
+	return ((uint64_t)dt->getEpoch())*1000000+dt->getMicroseconds();
+}
+
+static uint64_t getValue(const char *event, const char *name) {
+	const char	*value=charstring::findFirst(event,name);
+	return (value)?charstring::toUnsignedInteger(
+				value+charstring::length(name)):0;
+}
+
+int	main(int argc, char **argv) {
+
+	// instantiation
+	con=new sqlrconnection("sqlrelay",9000,"/tmp/test.socket",
+							"test","test",0,1);
+	cur=new sqlrcursor(con);
+
+	// start the session before waiting for the minute to end
+	stdoutput.printf("QUERY ACROSS A MINUTE: \n");
+	checkSuccess(cur->sendQuery("select 1"),1);
+
+	// wait for the last second of the minute
+	datetime	dt;
+	for (;;) {
+		dt.getSystemDateAndTime();
+		if (dt.getSeconds()==59) {
+			break;
+		}
+		snooze::microsnooze(0,100000);
+	}
+
+	// run a query that takes a few seconds,
+	// and make sure that it spanned the minute
+	uint64_t	start=getTime(&dt);
+	checkSuccess(cur->sendQuery("with recursive tracercounter(i) as (select 1 union all select i+1 from tracercounter where i<50000000) select count(*) from tracercounter"),1);
+	uint64_t	end=getTime(&dt);
+	checkSuccess(start/60000000!=end/60000000,1);
+	con->endSession();
+	stdoutput.printf("\n");
+
+	// convert the trace files for the instance, and look for the query
+	// (the trace files of earlier runs might be there too, so the event
+	// has to be from while the query was running)
+	stdoutput.printf("TRACE: \n");
+	FILE	*trace=popen(SQLRTRACE" -id tracertest","r");
+	checkSuccess(trace!=NULL,1);
+	bool	foundquery=false;
+	bool	foundexecute=false;
+	char	event[4096];
+	while (fgets(event,sizeof(event),trace)) {
+
+		uint64_t	ts=getValue(event,"\"ts\":");
+		uint64_t	dur=getValue(event,"\"dur\":");
+		if (ts<start || ts+dur>end) {
+			continue;
+		}
+
+		// the query itself...
+		if (charstring::contains(event,"\"cat\":\"query\"") &&
+			charstring::contains(event,"tracercounter")) {
+			foundquery=true;
+
+			// (allow for the time that it took to
+			// send the query and get the result)
+			checkSuccess(dur+1000000>end-start,1);
+		}
+
+		// ...and its execute stage, which should cross the minute too
+		if (charstring::contains(event,"\"name\":\"execute\"") &&
+					ts/60000000!=(ts+dur)/60000000) {
+			foundexecute=true;
+		}
+	}
+	pclose(trace);
+	checkSuccess(foundquery,1);
+	checkSuccess(foundexecute,1);
+	stdoutput.printf("\n");
+
+	delete cur;
+	delete con;
+
+	return 0;
+}
@@ -332,6 +332,76 @@ int	main(int argc, char **argv) {
 	pgresult=PQexec(pgconn,query);
 	PQclear(pgresult);*/
 
+	stdoutput.printf("PQsendQuery/PQgetResult:\n");
+	checkSuccess(PQsendQuery(pgconn,"select 1 union all select 2"),1);
+	checkSuccess(PQsocket(pgconn)>=0,1);
+	checkSuccess(PQsendQuery(pgconn,"select 1"),0);
+	while (PQisBusy(pgconn)) {
+		checkSuccess(PQconsumeInput(pgconn),1);
+	}
+	pgresult=PQgetResult(pgconn);
+	checkSuccess(PQresultStatus(pgresult),PGRES_TUPLES_OK);
+	checkSuccess(PQntuples(pgresult),2);
+	checkSuccess(PQnfields(pgresult),1);
+	checkSuccess(PQgetvalue(pgresult,0,0),"1");
+	checkSuccess(PQgetvalue(pgresult,1,0),"2");
+	PQclear(pgresult);
+	checkSuccess(PQgetResult(pgconn)==NULL,1);
+	stdoutput.printf("\n");
+
+	stdoutput.printf("PQsetSingleRowMode:\n");
+	checkSuccess(PQsendQuery(pgconn,"select 1 union all select 2"),1);
+	checkSuccess(PQsetSingleRowMode(pgconn),1);
+	pgresult=PQgetResult(pgconn);
+	checkSuccess(PQresultStatus(pgresult),PGRES_SINGLE_TUPLE);
+	checkSuccess(PQntuples(pgresult),1);
+	checkSuccess(PQgetvalue(pgresult,0,0),"1");
+	PQclear(pgresult);
+	pgresult=PQgetResult(pgconn);
+	checkSuccess(PQresultStatus(pgresult),PGRES_SINGLE_TUPLE);
+	checkSuccess(PQgetvalue(pgresult,0,0),"2");
+	PQclear(pgresult);
+	pgresult=PQgetResult(pgconn);
+	checkSuccess(PQresultStatus(pgresult),PGRES_TUPLES_OK);
+	checkSuccess(PQntuples(pgresult),0);
+	PQclear(pgresult);
+	checkSuccess(PQgetResult(pgconn)==NULL,1);
+	stdoutput.printf("\n");
+
+	stdoutput.printf("PQsendQuery/PQgetResult error:\n");
+	checkSuccess(PQsendQuery(pgconn,"select * from nosuchtable"),1);
+	pgresult=PQgetResult(pgconn);
+	checkSuccess(PQresultStatus(pgresult),PGRES_FATAL_ERROR);
+	checkSuccess(charstring::isNullOrEmpty(
+				PQresultErrorMessage(pgresult)),0);
+	checkSuccess(PQntuples(pgresult),0);
+	checkSuccess(PQnfields(pgresult),0);
+	checkSuccess(PQbinaryTuples(pgresult),0);
+	checkSuccess(PQfname(pgresult,0),NULL);
+	checkSuccess(PQfnumber(pgresult,"testint"),-1);
+	checkSuccess(PQgetvalue(pgresult,0,0),NULL);
+	checkSuccess(PQgetlength(pgresult,0,0),0);
+	checkSuccess(PQgetisnull(pgresult,0,0),1);
+	checkSuccess(PQcmdTuples(pgresult),"");
+	PQclear(pgresult);
+	checkSuccess(PQgetResult(pgconn)==NULL,1);
+	stdoutput.printf("\n");
+
+	stdoutput.printf("PQexec during PQsendQuery:\n");
+	checkSuccess(PQsendQuery(pgconn,"select 1"),1);
+	pgresult=PQexec(pgconn,"select 2");
+	checkSuccess(PQresultStatus(pgresult),PGRES_TUPLES_OK);
+	checkSuccess(PQgetvalue(pgresult,0,0),"2");
+	PQclear(pgresult);
+	checkSuccess(PQgetResult(pgconn)==NULL,1);
+	checkSuccess(PQsendQuery(pgconn,"select 1"),1);
+	checkSuccess(PQisBusy(pgconn)>=0,1);
+	pgresult=PQexec(pgconn,"select 3");
+	checkSuccess(PQgetvalue(pgresult,0,0),"3");
+	PQclear(pgresult);
+	checkSuccess(PQgetResult(pgconn)==NULL,1);
+	stdoutput.printf("\n");
+
 	PQfinish(pgconn);
 
 	return 0;
@@ -725,4 +725,70 @@ checkSuccess(cur.sendQuery("create table testtable"),0);
 checkSuccess(cur.sendQuery("create table testtable"),0);
 console.log("\n");
 
-process.exit(0);
+// asynchronous api...
+async function asyncTests() {
+
+	console.log("ASYNC QUERIES: ");
+	cur.setResultSetBufferSize(0);
+	cur.sendQuery("drop table asynctable");
+	checkSuccess(cur.sendQuery("create table asynctable (col1 int)"),1);
+	for (var i=1; i<=10; i++) {
+		checkSuccess(cur.sendQuery("insert into asynctable values ("+i+")"),1);
+	}
+	checkSuccess(await cur.sendQueryAsync("select col1 from asynctable order by col1"),true);
+	var	rows=await cur.getRowsAsync(0,4);
+	checkSuccess(rows.length,4);
+	checkSuccess(rows[0][0],"1");
+	checkSuccess(rows[3][0],"4");
+	rows=await cur.getRowsAsync(8,100000000);
+	checkSuccess(rows.length,2);
+	checkSuccess(rows[1][0],"10");
+	rows=await cur.getRowsAsync(20,10);
+	checkSuccess(rows.length,0);
+	checkSuccess(await cur.sendQueryAsync("select * from nosuchtable"),false);
+	console.log();
+
+	console.log("ASYNC INVALID ARGUMENTS: ");
+	var	thrown=false;
+	try {
+		cur.getRowsAsync(0,-1);
+	} catch (e) {
+		thrown=(e instanceof RangeError);
+	}
+	checkSuccess(thrown,true);
+	thrown=false;
+	try {
+		cur.getRowsAsync(-1,1);
+	} catch (e) {
+		thrown=(e instanceof RangeError);
+	}
+	checkSuccess(thrown,true);
+	console.log();
+
+	console.log("ASYNC ROW BATCHES: ");
+	cur.setResultSetBufferSize(3);
+	checkSuccess(await cur.sendQueryAsync("select col1 from asynctable order by col1"),true);
+	var	batches=0;
+	var	total=0;
+	var	last=null;
+	for await (var batch of cur.rowBatches(4)) {
+		batches++;
+		total+=batch.length;
+		last=batch[batch.length-1][0];
+	}
+	checkSuccess(batches,3);
+	checkSuccess(total,10);
+	checkSuccess(last,"10");
+	cur.setResultSetBufferSize(0);
+	console.log("\n");
+
+	cur.sendQuery("drop table asynctable");
+}
+
+asyncTests().then(function() {
+	process.exit(0);
+}).catch(function(e) {
+	console.log(e);
+	console.log("failure ");
+	process.exit(1);
+});